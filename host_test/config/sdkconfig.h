@@ -0,0 +1,131 @@
+/**
+ * @file sdkconfig.h
+ * @author your name (you@domain.com)
+ * @brief Kconfig defaults for the host build
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * Mirrors the defaults of main/Kconfig.projbuild and sdkconfig.defaults.
+ * Every value can be overridden from CMake with a compile definition; a
+ * bool option is switched off by defining it to 0, which the firmware's
+ * `#if CONFIG_X` tests treat like an unset option. Choices pick their
+ * default only when no other member was defined.
+ */
+#pragma once
+
+#define CONFIG_IDF_TARGET_LINUX 1
+#ifndef CONFIG_FREERTOS_HZ
+#define CONFIG_FREERTOS_HZ 100
+#endif
+
+/* USB */
+#ifndef CONFIG_TINYUSB_AUDIO_CHANNELS
+#define CONFIG_TINYUSB_AUDIO_CHANNELS 2
+#endif
+#ifndef CONFIG_TINYUSB_CDC_RX_BUFSIZE
+#define CONFIG_TINYUSB_CDC_RX_BUFSIZE 512
+#endif
+#ifndef CONFIG_TINYUSB_CDC_TX_BUFSIZE
+#define CONFIG_TINYUSB_CDC_TX_BUFSIZE 2048
+#endif
+
+/* Audio source */
+#if !defined(CONFIG_AUDIO_SOURCE_I2S) && !defined(CONFIG_SIG_GEN_AUDIO_SOURCE) && !defined(CONFIG_AUDIO_SOURCE_FILE)
+#define CONFIG_AUDIO_SOURCE_I2S 1
+#endif
+#ifndef CONFIG_SIG_GEN_FREQ_LEFT
+#define CONFIG_SIG_GEN_FREQ_LEFT 1000
+#endif
+#ifndef CONFIG_SIG_GEN_FREQ_RIGHT
+#define CONFIG_SIG_GEN_FREQ_RIGHT 1000
+#endif
+#ifndef CONFIG_SIG_GEN_LEVEL_DBFS
+#define CONFIG_SIG_GEN_LEVEL_DBFS -6
+#endif
+#ifndef CONFIG_SIG_GEN_IMPULSE_INTERVAL_MS
+#define CONFIG_SIG_GEN_IMPULSE_INTERVAL_MS 500
+#endif
+#ifndef CONFIG_AUDIO_SOURCE_FILE_PATH
+#define CONFIG_AUDIO_SOURCE_FILE_PATH "capture.raw"
+#endif
+
+/* I2S capture */
+#ifndef CONFIG_AUDIO_PROCESS_IN_TASK
+#define CONFIG_AUDIO_PROCESS_IN_TASK 1
+#endif
+#ifndef CONFIG_AUDIO_PROCESS_TASK_PRIORITY
+#define CONFIG_AUDIO_PROCESS_TASK_PRIORITY 20
+#endif
+#ifndef CONFIG_AUDIO_PROCESS_TASK_CORE
+#define CONFIG_AUDIO_PROCESS_TASK_CORE 1
+#endif
+#ifndef CONFIG_AUDIO_I2S_TDM_SLOTS
+#define CONFIG_AUDIO_I2S_TDM_SLOTS 4
+#endif
+#ifndef CONFIG_AUDIO_CHANNEL_MAP
+#define CONFIG_AUDIO_CHANNEL_MAP ""
+#endif
+
+/* Playback */
+#ifndef CONFIG_AUDIO_PLAYBACK_PREBUFFER_MS
+#define CONFIG_AUDIO_PLAYBACK_PREBUFFER_MS 10
+#endif
+#if !defined(CONFIG_AUDIO_PLAYBACK_CONCEAL_SILENCE) && !defined(CONFIG_AUDIO_PLAYBACK_CONCEAL_REPEAT)
+#define CONFIG_AUDIO_PLAYBACK_CONCEAL_SILENCE 1
+#endif
+
+/* Processing */
+#ifndef CONFIG_AUDIO_SRC_CAPTURE_RATE
+#define CONFIG_AUDIO_SRC_CAPTURE_RATE 48000
+#endif
+#ifndef CONFIG_AUDIO_PCM_DITHER
+#define CONFIG_AUDIO_PCM_DITHER 1
+#endif
+#ifndef CONFIG_AUDIO_LEVEL_METER
+#define CONFIG_AUDIO_LEVEL_METER 1
+#endif
+#ifndef CONFIG_AUDIO_DSP_DC_BLOCK
+#define CONFIG_AUDIO_DSP_DC_BLOCK 1
+#endif
+#ifndef CONFIG_AUDIO_DSP_TILT_DB_X10
+#define CONFIG_AUDIO_DSP_TILT_DB_X10 0
+#endif
+#ifndef CONFIG_AUDIO_DSP_TILT_FREQ
+#define CONFIG_AUDIO_DSP_TILT_FREQ 1000
+#endif
+#ifndef CONFIG_AUDIO_DSP_GAIN_DB_X10
+#define CONFIG_AUDIO_DSP_GAIN_DB_X10 0
+#endif
+#if !defined(CONFIG_AUDIO_DSP_CHANNEL_STEREO) && !defined(CONFIG_AUDIO_DSP_CHANNEL_SWAP) && !defined(CONFIG_AUDIO_DSP_CHANNEL_MONO)
+#define CONFIG_AUDIO_DSP_CHANNEL_STEREO 1
+#endif
+
+/* Streaming */
+#ifndef CONFIG_AUDIO_LATENCY_PROFILE_DEFAULT
+#define CONFIG_AUDIO_LATENCY_PROFILE_DEFAULT 2
+#endif
+#ifndef CONFIG_USB_AUDIO_ZERO_COPY
+#define CONFIG_USB_AUDIO_ZERO_COPY 1
+#endif
+#if !defined(CONFIG_AUDIO_DRIFT_NONE) && !defined(CONFIG_AUDIO_DRIFT_CLOCK_STEER) && !defined(CONFIG_AUDIO_DRIFT_ASYNC_PACKETS)
+#define CONFIG_AUDIO_DRIFT_NONE 1
+#endif
+#ifndef CONFIG_AUDIO_CLOCK_STEER_MAX_PPM
+#define CONFIG_AUDIO_CLOCK_STEER_MAX_PPM 300
+#endif
+
+/* Diagnostics */
+#ifndef CONFIG_AUDIO_TELEMETRY_REPORT
+#define CONFIG_AUDIO_TELEMETRY_REPORT 1
+#endif
+#ifndef CONFIG_AUDIO_TELEMETRY_REPORT_INTERVAL_MS
+#define CONFIG_AUDIO_TELEMETRY_REPORT_INTERVAL_MS 1000
+#endif
+#ifndef CONFIG_AUDIO_RT_LOG_RECORDS
+#define CONFIG_AUDIO_RT_LOG_RECORDS 64
+#endif
+#ifndef CONFIG_AUDIO_RT_LOG_BURST
+#define CONFIG_AUDIO_RT_LOG_BURST 5
+#endif
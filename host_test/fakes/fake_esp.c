@@ -0,0 +1,147 @@
+/**
+ * @file fake_esp.c
+ * @author your name (you@domain.com)
+ * @brief Timer, cycle counter, logging and error helpers of the host build
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "driver/gpio.h"
+#include "esp_cpu.h"
+#include "esp_err.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "host_sim.h"
+
+#define MAX_LOG_TAGS 16
+
+typedef struct {
+    const char* tag;
+    esp_log_level_t level;
+} log_tag_level_t;
+
+typedef struct {
+    esp_log_level_t level; // Tags without their own level
+    log_tag_level_t tags[MAX_LOG_TAGS];
+    size_t num_tags;
+} log_ctx_t;
+
+static log_ctx_t log_ctx = { .level = ESP_LOG_INFO };
+
+int64_t esp_timer_get_time(void)
+{
+    return sim_time_ns() / 1000;
+}
+
+esp_cpu_cycle_count_t esp_cpu_get_cycle_count(void)
+{
+    return (esp_cpu_cycle_count_t)sim_host_ns();
+}
+
+void esp_log_level_set(const char* tag, esp_log_level_t level)
+{
+    if (strcmp(tag, "*") == 0) {
+        log_ctx.level = level;
+        log_ctx.num_tags = 0;
+        return;
+    }
+    for (size_t i = 0; i < log_ctx.num_tags; i++) {
+        if (strcmp(log_ctx.tags[i].tag, tag) == 0) {
+            log_ctx.tags[i].level = level;
+            return;
+        }
+    }
+    if (log_ctx.num_tags < MAX_LOG_TAGS) {
+        log_ctx.tags[log_ctx.num_tags++] = (log_tag_level_t) { .tag = tag, .level = level };
+    }
+}
+
+static esp_log_level_t tag_level(const char* tag)
+{
+    for (size_t i = 0; i < log_ctx.num_tags; i++) {
+        if (strcmp(log_ctx.tags[i].tag, tag) == 0) {
+            return log_ctx.tags[i].level;
+        }
+    }
+    return log_ctx.level;
+}
+
+void esp_log_write(esp_log_level_t level, const char* tag, const char* format, ...)
+{
+    static const char letters[] = { 'N', 'E', 'W', 'I', 'D', 'V' };
+    va_list args;
+
+    if (level > tag_level(tag)) {
+        return;
+    }
+    printf("%c (%lld) %s: ", letters[level], (long long)(sim_time_ns() / SIM_NS_PER_MS), tag);
+    va_start(args, format);
+    vprintf(format, args);
+    va_end(args);
+    putchar('\n');
+}
+
+const char* esp_err_to_name(esp_err_t code)
+{
+    switch (code) {
+    case ESP_OK:
+        return "ESP_OK";
+    case ESP_FAIL:
+        return "ESP_FAIL";
+    case ESP_ERR_NO_MEM:
+        return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG:
+        return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE:
+        return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_INVALID_SIZE:
+        return "ESP_ERR_INVALID_SIZE";
+    case ESP_ERR_NOT_FOUND:
+        return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_NOT_SUPPORTED:
+        return "ESP_ERR_NOT_SUPPORTED";
+    case ESP_ERR_TIMEOUT:
+        return "ESP_ERR_TIMEOUT";
+    default:
+        return "UNKNOWN ERROR";
+    }
+}
+
+void _esp_error_check_failed(esp_err_t rc, const char* file, int line, const char* function, const char* expression)
+{
+    fprintf(stderr, "ESP_ERROR_CHECK failed: esp_err_t 0x%x (%s) at %s:%d\nfunction: %s\nexpression: %s\n",
+        rc, esp_err_to_name(rc), file, line, function, expression);
+    abort();
+}
+
+size_t heap_caps_get_free_size(uint32_t caps)
+{
+    (void)caps;
+    return 0;
+}
+
+size_t heap_caps_get_minimum_free_size(uint32_t caps)
+{
+    (void)caps;
+    return 0;
+}
+
+size_t heap_caps_get_largest_free_block(uint32_t caps)
+{
+    (void)caps;
+    return 0;
+}
+
+esp_err_t gpio_input_enable(gpio_num_t gpio_num)
+{
+    (void)gpio_num;
+    return ESP_OK;
+}
@@ -0,0 +1,643 @@
+/**
+ * @file fake_freertos.c
+ * @author your name (you@domain.com)
+ * @brief Simulated time, events and a FreeRTOS scheduler for the host build
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * Tasks are ucontext coroutines. The scheduler always resumes the highest
+ * priority ready task, first come first served within a priority, and a
+ * task runs until it blocks; nothing preempts it. Time never passes while
+ * code runs, so a run is deterministic: the same configuration and
+ * arguments give the same stream every time.
+ */
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <ucontext.h>
+
+#include "host_sim.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/stream_buffer.h"
+#include "freertos/task.h"
+
+#define MAX_TASKS 32
+#define MAX_EVENTS 32
+#define TASK_STACK_BYTES (256 * 1024) // Host frames are larger than Xtensa ones, the requested depth is ignored
+#define TICK_NS (SIM_NS_PER_S / configTICK_RATE_HZ)
+#define NO_WAKE INT64_MAX
+
+typedef enum {
+    TASK_READY,
+    TASK_RUNNING,
+    TASK_BLOCKED,
+    TASK_DELETED,
+} task_state_t;
+
+struct fake_task {
+    ucontext_t context;
+    void* stack;
+    TaskFunction_t function;
+    void* param;
+    const char* name;
+    UBaseType_t priority;
+    task_state_t state;
+    uint64_t ready_seq; // Order tasks became ready in, FIFO within a priority
+    int64_t wake_ns; // Timeout or delay end, NO_WAKE if none
+    bool timed_out;
+    uint32_t notify_count;
+    bool waiting_notify;
+    struct fake_queue* waiting_queue;
+    sim_cost_t cost;
+};
+
+struct fake_queue {
+    uint8_t* storage;
+    size_t item_size;
+    size_t length;
+    size_t head;
+    size_t count;
+};
+
+struct fake_stream_buffer {
+    uint8_t* storage;
+    size_t length; // Capacity plus one, so a full buffer is not mistaken for an empty one
+    size_t head; // Next byte to write
+    size_t tail; // Next byte to read
+    size_t trigger_level;
+    atomic_flag lock; // Stands for the port spinlock of the critical sections
+    struct fake_task* waiting_to_receive; // Always NULL, nothing blocks
+    struct fake_task* waiting_to_send;
+};
+
+typedef struct {
+    int64_t at_ns;
+    uint64_t seq; // Events due at the same time run in the order they were scheduled
+    sim_event_cb_t cb;
+    void* arg;
+} sim_event_t;
+
+typedef struct {
+    int64_t now_ns;
+    int64_t stall_until_ns;
+    struct fake_task* tasks[MAX_TASKS];
+    size_t num_tasks;
+    struct fake_task* current; // NULL outside tasks
+    ucontext_t scheduler;
+    uint64_t ready_seq;
+    sim_event_t events[MAX_EVENTS];
+    size_t num_events;
+    uint64_t event_seq;
+} sim_ctx_t;
+
+static sim_ctx_t sim = { 0 };
+
+uint64_t sim_host_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * SIM_NS_PER_S + ts.tv_nsec;
+}
+
+void sim_cost_add(sim_cost_t* cost, uint64_t ns)
+{
+    cost->count++;
+    cost->total_ns += ns;
+    if (ns > cost->max_ns) {
+        cost->max_ns = ns;
+    }
+}
+
+int64_t sim_time_ns(void)
+{
+    return sim.now_ns;
+}
+
+static void fail(const char* what)
+{
+    fprintf(stderr, "host FreeRTOS: %s (task %s, t=%lld ns)\n", what, sim.current != NULL ? sim.current->name : "none",
+        (long long)sim.now_ns);
+    abort();
+}
+
+void sim_schedule(int64_t at_ns, sim_event_cb_t cb, void* arg)
+{
+    if (sim.num_events == MAX_EVENTS) {
+        fail("too many pending events");
+    }
+    sim.events[sim.num_events++] = (sim_event_t) {
+        .at_ns = at_ns < sim.now_ns ? sim.now_ns : at_ns,
+        .seq = sim.event_seq++,
+        .cb = cb,
+        .arg = arg,
+    };
+}
+
+void sim_cancel(sim_event_cb_t cb, void* arg)
+{
+    size_t kept = 0;
+    for (size_t i = 0; i < sim.num_events; i++) {
+        if (sim.events[i].cb != cb || sim.events[i].arg != arg) {
+            sim.events[kept++] = sim.events[i];
+        }
+    }
+    sim.num_events = kept;
+}
+
+void sim_stall_tasks(int64_t until_ns)
+{
+    if (until_ns > sim.stall_until_ns) {
+        sim.stall_until_ns = until_ns;
+    }
+}
+
+size_t sim_task_info(sim_task_info_t* info, size_t max)
+{
+    size_t n = 0;
+    for (size_t i = 0; i < sim.num_tasks && n < max; i++) {
+        info[n++] = (sim_task_info_t) { .name = sim.tasks[i]->name, .cost = sim.tasks[i]->cost };
+    }
+    return n;
+}
+
+static void make_ready(struct fake_task* task)
+{
+    task->state = TASK_READY;
+    task->ready_seq = sim.ready_seq++;
+    task->wake_ns = NO_WAKE;
+    task->waiting_notify = false;
+    task->waiting_queue = NULL;
+}
+
+static struct fake_task* next_ready(void)
+{
+    struct fake_task* next = NULL;
+    for (size_t i = 0; i < sim.num_tasks; i++) {
+        struct fake_task* task = sim.tasks[i];
+        if (task->state != TASK_READY) {
+            continue;
+        }
+        if (next == NULL || task->priority > next->priority
+            || (task->priority == next->priority && task->ready_seq < next->ready_seq)) {
+            next = task;
+        }
+    }
+    return next;
+}
+
+static void run_tasks(void)
+{
+    struct fake_task* task;
+
+    if (sim.now_ns < sim.stall_until_ns) {
+        return;
+    }
+    while ((task = next_ready()) != NULL) {
+        uint64_t start = sim_host_ns();
+        sim.current = task;
+        task->state = TASK_RUNNING;
+        swapcontext(&sim.scheduler, &task->context);
+        sim.current = NULL;
+        sim_cost_add(&task->cost, sim_host_ns() - start);
+        if (task->state == TASK_RUNNING) {
+            /* The task function returned */
+            task->state = TASK_DELETED;
+        }
+    }
+}
+
+/**
+ * @brief Switch from the current task back to the scheduler until something wakes it
+ *
+ */
+static void block(int64_t wake_ns)
+{
+    struct fake_task* task = sim.current;
+    if (task == NULL) {
+        fail("blocking call outside a task");
+    }
+    task->state = TASK_BLOCKED;
+    task->wake_ns = wake_ns;
+    task->timed_out = false;
+    swapcontext(&task->context, &sim.scheduler);
+}
+
+static int64_t timeout_ns(TickType_t ticks)
+{
+    if (ticks == portMAX_DELAY) {
+        return NO_WAKE;
+    }
+    /* Like the tick interrupt, a timeout ends on a tick boundary */
+    return (sim.now_ns / TICK_NS + ticks) * TICK_NS;
+}
+
+void sim_run_until(int64_t end_ns)
+{
+    while (1) {
+        run_tasks();
+
+        int64_t next_ns = end_ns;
+        for (size_t i = 0; i < sim.num_events; i++) {
+            if (sim.events[i].at_ns < next_ns) {
+                next_ns = sim.events[i].at_ns;
+            }
+        }
+        for (size_t i = 0; i < sim.num_tasks; i++) {
+            if (sim.tasks[i]->state == TASK_BLOCKED && sim.tasks[i]->wake_ns < next_ns) {
+                next_ns = sim.tasks[i]->wake_ns;
+            }
+        }
+        if (sim.stall_until_ns > sim.now_ns && sim.stall_until_ns < next_ns) {
+            next_ns = sim.stall_until_ns;
+        }
+        if (next_ns > sim.now_ns) {
+            sim.now_ns = next_ns;
+        }
+        if (sim.now_ns >= end_ns) {
+            return;
+        }
+
+        for (size_t i = 0; i < sim.num_tasks; i++) {
+            struct fake_task* task = sim.tasks[i];
+            if (task->state == TASK_BLOCKED && task->wake_ns <= sim.now_ns) {
+                make_ready(task);
+                task->timed_out = true;
+            }
+        }
+
+        /* Every event due now, in order; an event may schedule more */
+        while (1) {
+            size_t due = sim.num_events;
+            for (size_t i = 0; i < sim.num_events; i++) {
+                if (sim.events[i].at_ns <= sim.now_ns && (due == sim.num_events || sim.events[i].seq < sim.events[due].seq)) {
+                    due = i;
+                }
+            }
+            if (due == sim.num_events) {
+                break;
+            }
+            sim_event_t event = sim.events[due];
+            sim.events[due] = sim.events[--sim.num_events];
+            event.cb(event.arg);
+        }
+    }
+}
+
+static void task_entry(void)
+{
+    struct fake_task* task = sim.current;
+    task->function(task->param);
+}
+
+BaseType_t xTaskCreate(TaskFunction_t pxTaskCode, const char* pcName, uint32_t usStackDepth, void* pvParameters,
+    UBaseType_t uxPriority, TaskHandle_t* pxCreatedTask)
+{
+    (void)usStackDepth;
+
+    if (sim.num_tasks == MAX_TASKS) {
+        return pdFAIL;
+    }
+    struct fake_task* task = calloc(1, sizeof(*task));
+    if (task == NULL) {
+        return pdFAIL;
+    }
+    task->stack = malloc(TASK_STACK_BYTES);
+    if (task->stack == NULL) {
+        free(task);
+        return pdFAIL;
+    }
+    task->function = pxTaskCode;
+    task->param = pvParameters;
+    task->name = pcName;
+    task->priority = uxPriority;
+
+    getcontext(&task->context);
+    task->context.uc_stack.ss_sp = task->stack;
+    task->context.uc_stack.ss_size = TASK_STACK_BYTES;
+    task->context.uc_link = &sim.scheduler;
+    makecontext(&task->context, task_entry, 0);
+
+    make_ready(task);
+    sim.tasks[sim.num_tasks++] = task;
+    if (pxCreatedTask != NULL) {
+        *pxCreatedTask = task;
+    }
+    return pdPASS;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t pxTaskCode, const char* pcName, uint32_t usStackDepth, void* pvParameters,
+    UBaseType_t uxPriority, TaskHandle_t* pxCreatedTask, BaseType_t xCoreID)
+{
+    (void)xCoreID;
+    return xTaskCreate(pxTaskCode, pcName, usStackDepth, pvParameters, uxPriority, pxCreatedTask);
+}
+
+void vTaskDelete(TaskHandle_t xTask)
+{
+    struct fake_task* task = xTask != NULL ? xTask : sim.current;
+    task->state = TASK_DELETED;
+    if (task == sim.current) {
+        swapcontext(&task->context, &sim.scheduler);
+    }
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return sim.current;
+}
+
+void vTaskDelay(TickType_t xTicksToDelay)
+{
+    if (xTicksToDelay == 0) {
+        /* A yield: go behind the other ready tasks of the same priority */
+        make_ready(sim.current);
+        swapcontext(&sim.current->context, &sim.scheduler);
+        return;
+    }
+    block(timeout_ns(xTicksToDelay));
+}
+
+void vTaskDelayUntil(TickType_t* pxPreviousWakeTime, TickType_t xTimeIncrement)
+{
+    *pxPreviousWakeTime += xTimeIncrement;
+    int64_t wake_ns = (int64_t)*pxPreviousWakeTime * TICK_NS;
+    if (wake_ns > sim.now_ns) {
+        block(wake_ns);
+    }
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)(sim.now_ns / TICK_NS);
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t xTaskToNotify, BaseType_t* pxHigherPriorityTaskWoken)
+{
+    xTaskNotifyGive(xTaskToNotify);
+    if (pxHigherPriorityTaskWoken != NULL) {
+        *pxHigherPriorityTaskWoken = pdTRUE;
+    }
+}
+
+void xTaskNotifyGive(TaskHandle_t xTaskToNotify)
+{
+    xTaskToNotify->notify_count++;
+    if (xTaskToNotify->state == TASK_BLOCKED && xTaskToNotify->waiting_notify) {
+        make_ready(xTaskToNotify);
+    }
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t xClearCountOnExit, TickType_t xTicksToWait)
+{
+    struct fake_task* task = sim.current;
+
+    if (task->notify_count == 0 && xTicksToWait > 0) {
+        task->waiting_notify = true;
+        block(timeout_ns(xTicksToWait));
+    }
+
+    uint32_t count = task->notify_count;
+    if (count > 0) {
+        task->notify_count = xClearCountOnExit ? 0 : count - 1;
+    }
+    return count;
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t uxQueueLength, UBaseType_t uxItemSize)
+{
+    size_t bytes = (size_t)uxQueueLength * uxItemSize;
+    return xQueueCreateStatic(uxQueueLength, uxItemSize, malloc(bytes > 0 ? bytes : 1), NULL);
+}
+
+QueueHandle_t xQueueCreateStatic(UBaseType_t uxQueueLength, UBaseType_t uxItemSize, uint8_t* pucQueueStorage,
+    StaticQueue_t* pxStaticQueue)
+{
+    (void)pxStaticQueue;
+
+    struct fake_queue* queue = calloc(1, sizeof(*queue));
+    if (queue == NULL || pucQueueStorage == NULL) {
+        free(queue);
+        return NULL;
+    }
+    queue->storage = pucQueueStorage;
+    queue->item_size = uxItemSize;
+    queue->length = uxQueueLength;
+    return queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t xQueue, const void* pvItemToQueue, TickType_t xTicksToWait)
+{
+    (void)xTicksToWait;
+
+    if (xQueue->count == xQueue->length) {
+        return errQUEUE_FULL;
+    }
+    if (xQueue->item_size > 0) {
+        memcpy(xQueue->storage + ((xQueue->head + xQueue->count) % xQueue->length) * xQueue->item_size, pvItemToQueue,
+            xQueue->item_size);
+    }
+    xQueue->count++;
+
+    /* Wake the highest priority receiver */
+    struct fake_task* receiver = NULL;
+    for (size_t i = 0; i < sim.num_tasks; i++) {
+        struct fake_task* task = sim.tasks[i];
+        if (task->state == TASK_BLOCKED && task->waiting_queue == xQueue
+            && (receiver == NULL || task->priority > receiver->priority)) {
+            receiver = task;
+        }
+    }
+    if (receiver != NULL) {
+        make_ready(receiver);
+    }
+    return pdPASS;
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t xQueue, const void* pvItemToQueue, BaseType_t* pxHigherPriorityTaskWoken)
+{
+    BaseType_t ret = xQueueSend(xQueue, pvItemToQueue, 0);
+    if (pxHigherPriorityTaskWoken != NULL) {
+        *pxHigherPriorityTaskWoken = ret;
+    }
+    return ret;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t xQueue, void* pvBuffer, TickType_t xTicksToWait)
+{
+    if (xQueue->count == 0) {
+        if (xTicksToWait == 0) {
+            return pdFALSE;
+        }
+        sim.current->waiting_queue = xQueue;
+        block(timeout_ns(xTicksToWait));
+        if (xQueue->count == 0) {
+            return pdFALSE;
+        }
+    }
+
+    if (xQueue->item_size > 0) {
+        memcpy(pvBuffer, xQueue->storage + xQueue->head * xQueue->item_size, xQueue->item_size);
+    }
+    xQueue->head = (xQueue->head + 1) % xQueue->length;
+    xQueue->count--;
+    return pdTRUE;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    SemaphoreHandle_t mutex = xQueueCreate(1, 0);
+    if (mutex != NULL) {
+        mutex->count = 1;
+    }
+    return mutex;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t xQueue)
+{
+    return (UBaseType_t)xQueue->count;
+}
+
+StreamBufferHandle_t xStreamBufferCreate(size_t xBufferSizeBytes, size_t xTriggerLevelBytes)
+{
+    struct fake_stream_buffer* buffer = calloc(1, sizeof(*buffer));
+    if (buffer == NULL) {
+        return NULL;
+    }
+    buffer->length = xBufferSizeBytes + 1;
+    buffer->storage = malloc(buffer->length);
+    if (buffer->storage == NULL) {
+        free(buffer);
+        return NULL;
+    }
+    buffer->trigger_level = xTriggerLevelBytes > 0 ? xTriggerLevelBytes : 1;
+    atomic_flag_clear(&buffer->lock);
+    return buffer;
+}
+
+void vStreamBufferDelete(StreamBufferHandle_t xStreamBuffer)
+{
+    if (xStreamBuffer != NULL) {
+        free(xStreamBuffer->storage);
+        free(xStreamBuffer);
+    }
+}
+
+static void stream_buffer_lock(StreamBufferHandle_t buffer)
+{
+    while (atomic_flag_test_and_set_explicit(&buffer->lock, memory_order_acquire)) { }
+}
+
+static void stream_buffer_unlock(StreamBufferHandle_t buffer)
+{
+    atomic_flag_clear_explicit(&buffer->lock, memory_order_release);
+}
+
+size_t xStreamBufferBytesAvailable(StreamBufferHandle_t xStreamBuffer)
+{
+    size_t count = xStreamBuffer->length + xStreamBuffer->head - xStreamBuffer->tail;
+    if (count >= xStreamBuffer->length) {
+        count -= xStreamBuffer->length;
+    }
+    return count;
+}
+
+size_t xStreamBufferSpacesAvailable(StreamBufferHandle_t xStreamBuffer)
+{
+    size_t space = xStreamBuffer->length + xStreamBuffer->tail - xStreamBuffer->head - 1;
+    if (space >= xStreamBuffer->length) {
+        space -= xStreamBuffer->length;
+    }
+    return space;
+}
+
+size_t xStreamBufferSendFromISR(StreamBufferHandle_t xStreamBuffer, const void* pvTxData, size_t xDataLengthBytes,
+    BaseType_t* pxHigherPriorityTaskWoken)
+{
+    size_t space = xStreamBufferSpacesAvailable(xStreamBuffer);
+    size_t count = xDataLengthBytes < space ? xDataLengthBytes : space;
+
+    if (count > 0) {
+        size_t first = xStreamBuffer->length - xStreamBuffer->head;
+        first = count < first ? count : first;
+        memcpy(xStreamBuffer->storage + xStreamBuffer->head, pvTxData, first);
+        if (count > first) {
+            memcpy(xStreamBuffer->storage, (const uint8_t*)pvTxData + first, count - first);
+        }
+        xStreamBuffer->head += count;
+        if (xStreamBuffer->head >= xStreamBuffer->length) {
+            xStreamBuffer->head -= xStreamBuffer->length;
+        }
+    }
+
+    if (xStreamBufferBytesAvailable(xStreamBuffer) >= xStreamBuffer->trigger_level) {
+        stream_buffer_lock(xStreamBuffer);
+        if (xStreamBuffer->waiting_to_receive != NULL) {
+            make_ready(xStreamBuffer->waiting_to_receive);
+            xStreamBuffer->waiting_to_receive = NULL;
+        }
+        stream_buffer_unlock(xStreamBuffer);
+    }
+    if (pxHigherPriorityTaskWoken != NULL) {
+        *pxHigherPriorityTaskWoken = pdFALSE;
+    }
+    return count;
+}
+
+size_t xStreamBufferSend(StreamBufferHandle_t xStreamBuffer, const void* pvTxData, size_t xDataLengthBytes,
+    TickType_t xTicksToWait)
+{
+    (void)xTicksToWait;
+    return xStreamBufferSendFromISR(xStreamBuffer, pvTxData, xDataLengthBytes, NULL);
+}
+
+size_t xStreamBufferReceive(StreamBufferHandle_t xStreamBuffer, void* pvRxData, size_t xBufferLengthBytes,
+    TickType_t xTicksToWait)
+{
+    (void)xTicksToWait;
+
+    size_t available = xStreamBufferBytesAvailable(xStreamBuffer);
+    size_t count = xBufferLengthBytes < available ? xBufferLengthBytes : available;
+    if (count == 0) {
+        return 0;
+    }
+
+    size_t first = xStreamBuffer->length - xStreamBuffer->tail;
+    first = count < first ? count : first;
+    memcpy(pvRxData, xStreamBuffer->storage + xStreamBuffer->tail, first);
+    if (count > first) {
+        memcpy((uint8_t*)pvRxData + first, xStreamBuffer->storage, count - first);
+    }
+    xStreamBuffer->tail += count;
+    if (xStreamBuffer->tail >= xStreamBuffer->length) {
+        xStreamBuffer->tail -= xStreamBuffer->length;
+    }
+
+    stream_buffer_lock(xStreamBuffer);
+    if (xStreamBuffer->waiting_to_send != NULL) {
+        make_ready(xStreamBuffer->waiting_to_send);
+        xStreamBuffer->waiting_to_send = NULL;
+    }
+    stream_buffer_unlock(xStreamBuffer);
+    return count;
+}
+
+BaseType_t xStreamBufferReset(StreamBufferHandle_t xStreamBuffer)
+{
+    BaseType_t ret = pdFAIL;
+
+    stream_buffer_lock(xStreamBuffer);
+    if (xStreamBuffer->waiting_to_receive == NULL && xStreamBuffer->waiting_to_send == NULL) {
+        xStreamBuffer->head = 0;
+        xStreamBuffer->tail = 0;
+        ret = pdPASS;
+    }
+    stream_buffer_unlock(xStreamBuffer);
+    return ret;
+}
@@ -0,0 +1,477 @@
+/**
+ * @file fake_i2s.c
+ * @author your name (you@domain.com)
+ * @brief I2S channel driver and clock registers of the host build
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * Follows the IDF driver where the firmware depends on it: DMA buffers
+ * complete one descriptor at a time, on_recv runs before the buffer is
+ * queued for i2s_channel_read(), and that queue, desc_num deep, drops its
+ * oldest entry and reports on_recv_q_ovf when nobody reads it. A slave
+ * port completes together with the master whose clock it receives.
+ *
+ * The frame rate of a channel is its MCLK over the MCLK multiple, the MCLK
+ * being PLL_F160M through the fractional divider, so divider quantization
+ * and trimming through i2s_ll_rx_set_mclk() show up in the timing.
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "driver/i2s_std.h"
+#include "driver/i2s_tdm.h"
+#include "hal/i2s_ll.h"
+#include "host_sim.h"
+
+#define NUM_PORTS 2
+#define SCLK_HZ 160000000
+
+struct i2s_channel_obj_t {
+    int port;
+    i2s_dir_t dir;
+    i2s_role_t role;
+    i2s_comm_mode_t mode;
+    uint32_t desc_num;
+    uint32_t frame_num;
+    uint32_t slots;
+    uint32_t mclk_multiple;
+    double mclk_hz; // What the divider gives
+    int32_t* dma; // desc_num buffers of frame_num frames
+    uint32_t desc; // Buffer the DMA is working on
+    bool enabled;
+    double next_ns; // Completion of the buffer in flight
+    uint64_t frames; // Frames transferred since the channel was created
+    size_t preloaded; // Bytes preloaded since the channel was last disabled
+    uint32_t msg_count; // Completed buffers queued for i2s_channel_read()
+    i2s_event_callbacks_t callbacks;
+    void* user_data;
+    struct i2s_channel_obj_t* pair;
+};
+
+typedef struct {
+    struct i2s_channel_obj_t* rx[NUM_PORTS];
+    struct i2s_channel_obj_t* tx[NUM_PORTS];
+    fake_i2s_capture_cb_t capture;
+    fake_i2s_play_cb_t play;
+    sim_cost_t cost;
+} fake_i2s_ctx_t;
+
+static fake_i2s_ctx_t ctx = { 0 };
+
+i2s_dev_t I2S0 = { .port = 0 };
+i2s_dev_t I2S1 = { .port = 1 };
+
+uint32_t hal_utils_calc_clk_div_frac_accurate(const hal_utils_clk_info_t* clk_info, hal_utils_clk_div_t* clk_div)
+{
+    uint32_t integer = clk_info->src_freq_hz / clk_info->exp_freq_hz;
+    uint64_t remainder = clk_info->src_freq_hz - (uint64_t)integer * clk_info->exp_freq_hz;
+
+    if (integer < clk_info->min_integ || integer >= clk_info->max_integ) {
+        return 0;
+    }
+
+    /* Divider = integer + numerator / denominator, searched exhaustively like the IDF */
+    uint32_t best_num = 0;
+    uint32_t best_den = 1;
+    double best_err = (double)remainder / clk_info->exp_freq_hz;
+    for (uint32_t den = 2; den < clk_info->max_fract && best_err > 0; den++) {
+        uint32_t num = (uint32_t)((remainder * den + clk_info->exp_freq_hz / 2) / clk_info->exp_freq_hz);
+        if (num == 0 || num >= den) {
+            continue;
+        }
+        double err = (double)remainder / clk_info->exp_freq_hz - (double)num / den;
+        err = err < 0 ? -err : err;
+        if (err < best_err) {
+            best_err = err;
+            best_num = num;
+            best_den = den;
+        }
+    }
+
+    clk_div->integer = integer;
+    clk_div->numerator = best_num;
+    clk_div->denominator = best_den;
+    return (uint32_t)((double)clk_info->src_freq_hz / (integer + (double)best_num / best_den));
+}
+
+static double divider_hz(const hal_utils_clk_div_t* div)
+{
+    return (double)SCLK_HZ / (div->integer + (div->denominator > 0 ? (double)div->numerator / div->denominator : 0.0));
+}
+
+static void set_clock(struct i2s_channel_obj_t* chan, uint32_t sample_rate, uint32_t mclk_multiple)
+{
+    hal_utils_clk_info_t clk_info = {
+        .src_freq_hz = SCLK_HZ,
+        .exp_freq_hz = sample_rate * mclk_multiple,
+        .max_integ = I2S_LL_CLK_FRAC_DIV_N_MAX,
+        .min_integ = 1,
+        .max_fract = I2S_LL_CLK_FRAC_DIV_AB_MAX,
+    };
+    hal_utils_clk_div_t div = { 0 };
+
+    hal_utils_calc_clk_div_frac_accurate(&clk_info, &div);
+    chan->mclk_multiple = mclk_multiple;
+    chan->mclk_hz = divider_hz(&div);
+}
+
+/**
+ * @brief Channel whose clock times this one, the master's for a slave
+ *
+ */
+static const struct i2s_channel_obj_t* clock_of(const struct i2s_channel_obj_t* chan)
+{
+    if (chan->role == I2S_ROLE_SLAVE && ctx.rx[0] != NULL) {
+        return ctx.rx[0];
+    }
+    return chan;
+}
+
+double fake_i2s_rate(int port)
+{
+    const struct i2s_channel_obj_t* chan = ctx.rx[port];
+    if (chan == NULL || chan->mclk_multiple == 0) {
+        return 0;
+    }
+    chan = clock_of(chan);
+    return chan->mclk_hz / chan->mclk_multiple;
+}
+
+static double period_ns(const struct i2s_channel_obj_t* chan)
+{
+    const struct i2s_channel_obj_t* clock = clock_of(chan);
+    return chan->frame_num * 1e9 * clock->mclk_multiple / clock->mclk_hz;
+}
+
+static int32_t* buffer(struct i2s_channel_obj_t* chan, uint32_t desc)
+{
+    return chan->dma + (size_t)desc * chan->frame_num * chan->slots;
+}
+
+static size_t buffer_bytes(const struct i2s_channel_obj_t* chan)
+{
+    return (size_t)chan->frame_num * chan->slots * sizeof(int32_t);
+}
+
+static bool complete_rx(struct i2s_channel_obj_t* chan)
+{
+    int32_t* buf = buffer(chan, chan->desc);
+    bool woken = false;
+
+    if (ctx.capture != NULL) {
+        ctx.capture(chan->port, chan->frames, buf, chan->frame_num, chan->slots);
+    } else {
+        memset(buf, 0, buffer_bytes(chan));
+    }
+    chan->frames += chan->frame_num;
+    chan->desc = (chan->desc + 1) % chan->desc_num;
+
+    i2s_event_data_t event = { .data = &buf, .dma_buf = buf, .size = buffer_bytes(chan) };
+    if (chan->callbacks.on_recv != NULL) {
+        woken |= chan->callbacks.on_recv(chan, &event, chan->user_data);
+    }
+    if (chan->msg_count == chan->desc_num) {
+        chan->msg_count--;
+        if (chan->callbacks.on_recv_q_ovf != NULL) {
+            i2s_event_data_t ovf_event = { .data = NULL, .dma_buf = NULL, .size = buffer_bytes(chan) };
+            woken |= chan->callbacks.on_recv_q_ovf(chan, &ovf_event, chan->user_data);
+        }
+    }
+    chan->msg_count++;
+    return woken;
+}
+
+static bool complete_tx(struct i2s_channel_obj_t* chan)
+{
+    int32_t* buf = buffer(chan, chan->desc);
+    bool woken = false;
+
+    if (ctx.play != NULL) {
+        ctx.play(buf, chan->frame_num, chan->slots);
+    }
+    chan->frames += chan->frame_num;
+    chan->desc = (chan->desc + 1) % chan->desc_num;
+
+    i2s_event_data_t event = { .data = &buf, .dma_buf = buf, .size = buffer_bytes(chan) };
+    if (chan->callbacks.on_sent != NULL) {
+        woken |= chan->callbacks.on_sent(chan, &event, chan->user_data);
+    }
+    return woken;
+}
+
+static void dma_event(void* arg)
+{
+    struct i2s_channel_obj_t* chan = arg;
+    uint64_t start = sim_host_ns();
+
+    if (chan->dir == I2S_DIR_TX) {
+        complete_tx(chan);
+    } else {
+        complete_rx(chan);
+        for (int port = 0; port < NUM_PORTS; port++) {
+            struct i2s_channel_obj_t* slave = ctx.rx[port];
+            if (slave != NULL && slave != chan && slave->role == I2S_ROLE_SLAVE && slave->enabled) {
+                complete_rx(slave);
+            }
+        }
+    }
+    sim_cost_add(&ctx.cost, sim_host_ns() - start);
+
+    chan->next_ns += period_ns(chan);
+    sim_schedule((int64_t)chan->next_ns, dma_event, chan);
+}
+
+static struct i2s_channel_obj_t* new_channel(int port, i2s_dir_t dir, const i2s_chan_config_t* chan_cfg)
+{
+    struct i2s_channel_obj_t* chan = calloc(1, sizeof(*chan));
+    if (chan == NULL) {
+        return NULL;
+    }
+    chan->port = port;
+    chan->dir = dir;
+    chan->role = chan_cfg->role;
+    chan->mode = I2S_COMM_MODE_NONE;
+    chan->desc_num = chan_cfg->dma_desc_num;
+    chan->frame_num = chan_cfg->dma_frame_num;
+    return chan;
+}
+
+esp_err_t i2s_new_channel(const i2s_chan_config_t* chan_cfg, i2s_chan_handle_t* ret_tx_handle, i2s_chan_handle_t* ret_rx_handle)
+{
+    int port = chan_cfg->id;
+
+    if (port == I2S_NUM_AUTO) {
+        for (port = 0; port < NUM_PORTS; port++) {
+            if ((ret_rx_handle == NULL || ctx.rx[port] == NULL) && (ret_tx_handle == NULL || ctx.tx[port] == NULL)) {
+                break;
+            }
+        }
+    }
+    if (port >= NUM_PORTS || (ret_rx_handle != NULL && ctx.rx[port] != NULL) || (ret_tx_handle != NULL && ctx.tx[port] != NULL)) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    if (ret_rx_handle != NULL) {
+        ctx.rx[port] = *ret_rx_handle = new_channel(port, I2S_DIR_RX, chan_cfg);
+    }
+    if (ret_tx_handle != NULL) {
+        ctx.tx[port] = *ret_tx_handle = new_channel(port, I2S_DIR_TX, chan_cfg);
+    }
+    if (ret_rx_handle != NULL && ret_tx_handle != NULL) {
+        ctx.rx[port]->pair = ctx.tx[port];
+        ctx.tx[port]->pair = ctx.rx[port];
+    }
+    return ESP_OK;
+}
+
+esp_err_t i2s_del_channel(i2s_chan_handle_t handle)
+{
+    if (handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (handle->enabled) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (handle->pair != NULL) {
+        handle->pair->pair = NULL;
+    }
+    if (handle->dir == I2S_DIR_RX) {
+        ctx.rx[handle->port] = NULL;
+    } else {
+        ctx.tx[handle->port] = NULL;
+    }
+    free(handle->dma);
+    free(handle);
+    return ESP_OK;
+}
+
+esp_err_t i2s_channel_get_info(i2s_chan_handle_t handle, i2s_chan_info_t* chan_info)
+{
+    if (handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *chan_info = (i2s_chan_info_t) {
+        .id = (i2s_port_t)handle->port,
+        .role = handle->role,
+        .dir = handle->dir,
+        .mode = handle->mode,
+        .pair_chan = handle->pair,
+    };
+    return ESP_OK;
+}
+
+static esp_err_t init_mode(i2s_chan_handle_t handle, i2s_comm_mode_t mode, uint32_t slots, uint32_t sample_rate,
+    uint32_t mclk_multiple)
+{
+    if (handle == NULL || slots == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (handle->enabled) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    free(handle->dma);
+    handle->mode = mode;
+    handle->slots = slots;
+    handle->dma = calloc((size_t)handle->desc_num * handle->frame_num * slots, sizeof(int32_t));
+    if (handle->dma == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    set_clock(handle, sample_rate, mclk_multiple);
+    return ESP_OK;
+}
+
+esp_err_t i2s_channel_init_std_mode(i2s_chan_handle_t handle, const i2s_std_config_t* std_cfg)
+{
+    return init_mode(handle, I2S_COMM_MODE_STD, std_cfg->slot_cfg.slot_mode, std_cfg->clk_cfg.sample_rate_hz,
+        std_cfg->clk_cfg.mclk_multiple);
+}
+
+esp_err_t i2s_channel_init_tdm_mode(i2s_chan_handle_t handle, const i2s_tdm_config_t* tdm_cfg)
+{
+    uint32_t slots = tdm_cfg->slot_cfg.total_slot;
+    if (slots == 0) {
+        /* Up to the highest active slot, like the driver does */
+        for (uint32_t mask = tdm_cfg->slot_cfg.slot_mask; mask != 0; mask >>= 1) {
+            slots++;
+        }
+    }
+    return init_mode(handle, I2S_COMM_MODE_TDM, slots, tdm_cfg->clk_cfg.sample_rate_hz, tdm_cfg->clk_cfg.mclk_multiple);
+}
+
+static esp_err_t reconfig_clock(i2s_chan_handle_t handle, i2s_comm_mode_t mode, uint32_t sample_rate, uint32_t mclk_multiple)
+{
+    if (handle == NULL || handle->mode != mode) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (handle->enabled) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    set_clock(handle, sample_rate, mclk_multiple);
+    return ESP_OK;
+}
+
+esp_err_t i2s_channel_reconfig_std_clock(i2s_chan_handle_t handle, const i2s_std_clk_config_t* clk_cfg)
+{
+    return reconfig_clock(handle, I2S_COMM_MODE_STD, clk_cfg->sample_rate_hz, clk_cfg->mclk_multiple);
+}
+
+esp_err_t i2s_channel_reconfig_tdm_clock(i2s_chan_handle_t handle, const i2s_tdm_clk_config_t* clk_cfg)
+{
+    return reconfig_clock(handle, I2S_COMM_MODE_TDM, clk_cfg->sample_rate_hz, clk_cfg->mclk_multiple);
+}
+
+esp_err_t i2s_channel_enable(i2s_chan_handle_t handle)
+{
+    if (handle == NULL || handle->mode == I2S_COMM_MODE_NONE) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (handle->enabled) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    handle->enabled = true;
+    handle->desc = 0;
+    handle->msg_count = 0;
+    if (handle->role == I2S_ROLE_MASTER) {
+        handle->next_ns = sim_time_ns() + period_ns(handle);
+        sim_schedule((int64_t)handle->next_ns, dma_event, handle);
+    }
+    return ESP_OK;
+}
+
+esp_err_t i2s_channel_disable(i2s_chan_handle_t handle)
+{
+    if (handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!handle->enabled) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    handle->enabled = false;
+    handle->preloaded = 0;
+    sim_cancel(dma_event, handle);
+    return ESP_OK;
+}
+
+esp_err_t i2s_channel_preload_data(i2s_chan_handle_t tx_handle, const void* src, size_t size, size_t* bytes_loaded)
+{
+    if (tx_handle == NULL || tx_handle->dir != I2S_DIR_TX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (tx_handle->enabled) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    size_t total = buffer_bytes(tx_handle) * tx_handle->desc_num;
+    size_t n = total - tx_handle->preloaded < size ? total - tx_handle->preloaded : size;
+    memcpy((uint8_t*)tx_handle->dma + tx_handle->preloaded, src, n);
+    tx_handle->preloaded += n;
+    *bytes_loaded = n;
+    return ESP_OK;
+}
+
+esp_err_t i2s_channel_read(i2s_chan_handle_t handle, void* dest, size_t size, size_t* bytes_read, uint32_t timeout_ms)
+{
+    (void)timeout_ms;
+
+    /* Never blocks: returns the oldest queued buffer, or times out at once */
+    *bytes_read = 0;
+    if (handle == NULL || handle->dir != I2S_DIR_RX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (handle->msg_count == 0) {
+        return ESP_ERR_TIMEOUT;
+    }
+    uint32_t desc = (handle->desc + handle->desc_num - handle->msg_count) % handle->desc_num;
+    size_t n = size < buffer_bytes(handle) ? size : buffer_bytes(handle);
+    memcpy(dest, buffer(handle, desc), n);
+    handle->msg_count--;
+    *bytes_read = n;
+    return ESP_OK;
+}
+
+esp_err_t i2s_channel_register_event_callback(i2s_chan_handle_t handle, const i2s_event_callbacks_t* callbacks, void* user_data)
+{
+    if (handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (handle->enabled) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    handle->callbacks = *callbacks;
+    handle->user_data = user_data;
+    return ESP_OK;
+}
+
+void i2s_ll_rx_set_mclk(i2s_dev_t* hw, const hal_utils_clk_div_t* mclk_div)
+{
+    if (ctx.rx[hw->port] != NULL) {
+        ctx.rx[hw->port]->mclk_hz = divider_hz(mclk_div);
+    }
+}
+
+void i2s_ll_tx_set_mclk(i2s_dev_t* hw, const hal_utils_clk_div_t* mclk_div)
+{
+    if (ctx.tx[hw->port] != NULL) {
+        ctx.tx[hw->port]->mclk_hz = divider_hz(mclk_div);
+    }
+}
+
+void fake_i2s_set_capture(fake_i2s_capture_cb_t cb)
+{
+    ctx.capture = cb;
+}
+
+void fake_i2s_set_play(fake_i2s_play_cb_t cb)
+{
+    ctx.play = cb;
+}
+
+const sim_cost_t* fake_i2s_cost(void)
+{
+    return &ctx.cost;
+}
@@ -0,0 +1,323 @@
+/**
+ * @file fake_tinyusb.c
+ * @author your name (you@domain.com)
+ * @brief esp_tinyusb and a USB host, for the host build
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * The host clock ticks one start of frame per millisecond, ppm faster than
+ * the device's. While the audio interface streams, each frame's IN packet
+ * is whatever the pre-load callback wrote, and an OUT packet, if the
+ * simulation sends any and the device has a non-zero alternate setting on
+ * the OUT interface, goes to tud_audio_rx_done_post_read_cb() after the IN
+ * side is done. CDC traffic moves at every start of frame.
+ */
+#include <string.h>
+
+#include "host_sim.h"
+#include "sdkconfig.h"
+#include "tinyusb.h"
+#include "tusb.h"
+#include "tusb_audio.h"
+#include "tusb_cdc_acm.h"
+#include "tusb_tasks.h"
+
+#define EP_BUFFER_BYTES 2048 // Larger than any full-speed packet, so oversized writes show up as such
+#define CDC_PACKET_BYTES 64
+#define CDC_PACKETS_PER_FRAME 19 // Full-speed bulk bandwidth of an otherwise idle bus
+#define CDC_HOST_BUFFER_BYTES (64 * 1024)
+#define MAX_INTERFACES 8
+#define EP_OUT 0x01
+
+typedef struct {
+    tinyusb_config_cdcacm_t cfg;
+    bool installed;
+    uint8_t tx_fifo[CONFIG_TINYUSB_CDC_TX_BUFSIZE];
+    size_t tx_len;
+    uint8_t rx_packet[CDC_PACKET_BYTES];
+    size_t rx_len;
+    uint8_t host_buffer[CDC_HOST_BUFFER_BYTES]; // Host to device, not sent yet
+    size_t host_head;
+    size_t host_len;
+    fake_cdc_in_cb_t in_cb;
+} fake_cdc_t;
+
+typedef struct {
+    tinyusb_config_t config;
+    bool installed;
+    tinyusb_audio_config_t audio_cfg;
+    bool attached;
+    bool streaming;
+    double period_ns;
+    double next_ns;
+    uint8_t in_packet[EP_BUFFER_BYTES];
+    size_t in_len;
+    uint8_t out_packet[EP_BUFFER_BYTES];
+    size_t out_len;
+    size_t out_read;
+    fake_usb_in_cb_t in_cb;
+    fake_usb_out_cb_t out_source;
+    uint8_t out_itf;
+    uint8_t alt[MAX_INTERFACES]; // Alternate setting of each interface, as the device accepted it
+    uint8_t* control_data; // Response buffer of the GET request in progress
+    uint16_t control_len;
+    sim_cost_t cost;
+    fake_cdc_t cdc;
+} fake_usb_ctx_t;
+
+static fake_usb_ctx_t ctx = { 0 };
+
+esp_err_t tinyusb_driver_install(const tinyusb_config_t* config)
+{
+    ctx.config = *config;
+    ctx.installed = true;
+    return ESP_OK;
+}
+
+esp_err_t tusb_stop_task(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t tusb_audio_init(const tinyusb_audio_config_t* cfg)
+{
+    ctx.audio_cfg = *cfg;
+    return ESP_OK;
+}
+
+uint16_t tud_audio_write(const void* data, uint16_t len)
+{
+    size_t n = EP_BUFFER_BYTES - ctx.in_len < len ? EP_BUFFER_BYTES - ctx.in_len : len;
+    memcpy(ctx.in_packet + ctx.in_len, data, n);
+    ctx.in_len += n;
+    return (uint16_t)n;
+}
+
+uint16_t tud_audio_read(void* buffer, uint16_t bufsize)
+{
+    size_t n = ctx.out_len - ctx.out_read < bufsize ? ctx.out_len - ctx.out_read : bufsize;
+    memcpy(buffer, ctx.out_packet + ctx.out_read, n);
+    ctx.out_read += n;
+    return (uint16_t)n;
+}
+
+bool tud_audio_buffer_and_schedule_control_xfer(uint8_t rhport, tusb_control_request_t const* p_request, void* data, uint16_t len)
+{
+    (void)rhport;
+    if (ctx.control_data == NULL) {
+        return false;
+    }
+    ctx.control_len = len < p_request->wLength ? len : p_request->wLength;
+    memcpy(ctx.control_data, data, ctx.control_len);
+    return true;
+}
+
+bool fake_usb_control(const tusb_control_request_t* request, uint8_t* data)
+{
+    if (request->bmRequestType_bit.type == TUSB_REQ_TYPE_STANDARD) {
+        uint8_t itf = TU_U16_LOW(request->wIndex);
+        if (request->bRequest != TUSB_REQ_SET_INTERFACE || itf >= MAX_INTERFACES || tud_audio_set_itf_cb == NULL
+            || !tud_audio_set_itf_cb(0, request)) {
+            return false;
+        }
+        ctx.alt[itf] = TU_U16_LOW(request->wValue);
+        return true;
+    }
+    if (request->bmRequestType_bit.type != TUSB_REQ_TYPE_CLASS) {
+        return false;
+    }
+    if (request->bmRequestType_bit.direction == TUSB_DIR_OUT) {
+        return tud_audio_set_req_entity_cb != NULL && tud_audio_set_req_entity_cb(0, request, data);
+    }
+
+    /* A GET the device does not answer stalls like one it rejects */
+    ctx.control_data = data;
+    ctx.control_len = 0;
+    bool ok = tud_audio_get_req_entity_cb != NULL && tud_audio_get_req_entity_cb(0, request) && ctx.control_len > 0;
+    ctx.control_data = NULL;
+    return ok;
+}
+
+esp_err_t tusb_cdc_acm_init(const tinyusb_config_cdcacm_t* cfg)
+{
+    ctx.cdc.cfg = *cfg;
+    ctx.cdc.installed = true;
+    return ESP_OK;
+}
+
+esp_err_t tinyusb_cdcacm_read(tinyusb_cdcacm_itf_t itf, uint8_t* out_buf, size_t out_buf_sz, size_t* rx_data_size)
+{
+    if (itf != TINYUSB_CDC_ACM_0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    size_t n = ctx.cdc.rx_len < out_buf_sz ? ctx.cdc.rx_len : out_buf_sz;
+    memcpy(out_buf, ctx.cdc.rx_packet, n);
+    memmove(ctx.cdc.rx_packet, ctx.cdc.rx_packet + n, ctx.cdc.rx_len - n);
+    ctx.cdc.rx_len -= n;
+    *rx_data_size = n;
+    return ESP_OK;
+}
+
+size_t tinyusb_cdcacm_write_queue(tinyusb_cdcacm_itf_t itf, const uint8_t* in_buf, size_t in_size)
+{
+    if (itf != TINYUSB_CDC_ACM_0) {
+        return 0;
+    }
+    size_t n = sizeof(ctx.cdc.tx_fifo) - ctx.cdc.tx_len < in_size ? sizeof(ctx.cdc.tx_fifo) - ctx.cdc.tx_len : in_size;
+    memcpy(ctx.cdc.tx_fifo + ctx.cdc.tx_len, in_buf, n);
+    ctx.cdc.tx_len += n;
+    return n;
+}
+
+esp_err_t tinyusb_cdcacm_write_flush(tinyusb_cdcacm_itf_t itf, uint32_t timeout_ticks)
+{
+    (void)timeout_ticks;
+    /* Everything queued leaves at the next start of frame */
+    return itf == TINYUSB_CDC_ACM_0 ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+uint32_t tud_cdc_n_write_available(uint8_t itf)
+{
+    return itf == TINYUSB_CDC_ACM_0 ? (uint32_t)(sizeof(ctx.cdc.tx_fifo) - ctx.cdc.tx_len) : 0;
+}
+
+static void cdc_frame(void)
+{
+    fake_cdc_t* cdc = &ctx.cdc;
+
+    if (!cdc->installed) {
+        return;
+    }
+
+    /* Device to host */
+    size_t n = cdc->tx_len < CDC_PACKETS_PER_FRAME * CDC_PACKET_BYTES ? cdc->tx_len : CDC_PACKETS_PER_FRAME * CDC_PACKET_BYTES;
+    if (n > 0) {
+        if (cdc->in_cb != NULL) {
+            cdc->in_cb(cdc->tx_fifo, n);
+        }
+        memmove(cdc->tx_fifo, cdc->tx_fifo + n, cdc->tx_len - n);
+        cdc->tx_len -= n;
+    }
+
+    /* Host to device, one receive callback per packet */
+    for (int packet = 0; packet < CDC_PACKETS_PER_FRAME && cdc->host_len > 0 && cdc->rx_len == 0; packet++) {
+        size_t len = cdc->host_len < CDC_PACKET_BYTES ? cdc->host_len : CDC_PACKET_BYTES;
+        for (size_t i = 0; i < len; i++) {
+            cdc->rx_packet[i] = cdc->host_buffer[(cdc->host_head + i) % CDC_HOST_BUFFER_BYTES];
+        }
+        cdc->host_head = (cdc->host_head + len) % CDC_HOST_BUFFER_BYTES;
+        cdc->host_len -= len;
+        cdc->rx_len = len;
+        if (cdc->cfg.callback_rx != NULL) {
+            cdcacm_event_t event = { .type = CDC_EVENT_RX };
+            cdc->cfg.callback_rx(cdc->cfg.cdc_port, &event);
+        }
+    }
+}
+
+static void start_of_frame(void* arg)
+{
+    (void)arg;
+    uint64_t start = sim_host_ns();
+
+    if (ctx.streaming) {
+        ctx.in_len = 0;
+        if (ctx.audio_cfg.on_pre_callback != NULL) {
+            ctx.audio_cfg.on_pre_callback();
+        }
+        if (ctx.audio_cfg.on_post_callback != NULL) {
+            ctx.audio_cfg.on_post_callback();
+        }
+        uint8_t out_alt = ctx.alt[ctx.out_itf];
+        if (ctx.out_source != NULL && out_alt != 0) {
+            ctx.out_len = ctx.out_source(ctx.out_packet, sizeof(ctx.out_packet));
+            ctx.out_read = 0;
+            if (ctx.out_len > 0 && tud_audio_rx_done_post_read_cb != NULL) {
+                tud_audio_rx_done_post_read_cb(0, (uint16_t)ctx.out_len, 0, EP_OUT, out_alt);
+            }
+        }
+    }
+    cdc_frame();
+    sim_cost_add(&ctx.cost, sim_host_ns() - start);
+
+    if (ctx.streaming && ctx.in_cb != NULL) {
+        ctx.in_cb(ctx.in_packet, ctx.in_len);
+    }
+
+    ctx.next_ns += ctx.period_ns;
+    sim_schedule((int64_t)ctx.next_ns, start_of_frame, NULL);
+}
+
+void fake_usb_set_in(fake_usb_in_cb_t cb)
+{
+    ctx.in_cb = cb;
+}
+
+void fake_usb_set_out(uint8_t itf, fake_usb_out_cb_t source)
+{
+    ctx.out_itf = itf < MAX_INTERFACES ? itf : 0;
+    ctx.out_source = source;
+}
+
+void fake_usb_attach(double ppm)
+{
+    fake_usb_detach();
+    ctx.attached = true;
+    ctx.period_ns = SIM_NS_PER_MS / (1.0 + ppm * 1e-6);
+    ctx.next_ns = sim_time_ns() + ctx.period_ns;
+    sim_schedule((int64_t)ctx.next_ns, start_of_frame, NULL);
+}
+
+void fake_usb_detach(void)
+{
+    if (ctx.attached) {
+        sim_cancel(start_of_frame, NULL);
+        ctx.attached = false;
+    }
+    ctx.streaming = false;
+}
+
+void fake_usb_stream(bool on)
+{
+    ctx.streaming = on;
+}
+
+const sim_cost_t* fake_usb_cost(void)
+{
+    return &ctx.cost;
+}
+
+const tinyusb_config_t* fake_usb_config(void)
+{
+    return ctx.installed ? &ctx.config : NULL;
+}
+
+void fake_cdc_set_in(fake_cdc_in_cb_t cb)
+{
+    ctx.cdc.in_cb = cb;
+}
+
+size_t fake_cdc_send(const uint8_t* data, size_t size)
+{
+    fake_cdc_t* cdc = &ctx.cdc;
+    size_t n = CDC_HOST_BUFFER_BYTES - cdc->host_len < size ? CDC_HOST_BUFFER_BYTES - cdc->host_len : size;
+
+    for (size_t i = 0; i < n; i++) {
+        cdc->host_buffer[(cdc->host_head + cdc->host_len + i) % CDC_HOST_BUFFER_BYTES] = data[i];
+    }
+    cdc->host_len += n;
+    return n;
+}
+
+void fake_cdc_set_line_state(bool dtr, bool rts)
+{
+    if (ctx.cdc.cfg.callback_line_state_changed != NULL) {
+        cdcacm_event_t event = {
+            .type = CDC_EVENT_LINE_STATE_CHANGED,
+            .line_state_changed_data = { .dtr = dtr, .rts = rts },
+        };
+        ctx.cdc.cfg.callback_line_state_changed(ctx.cdc.cfg.cdc_port, &event);
+    }
+}
@@ -0,0 +1,16 @@
+/**
+ * @file gpio.h
+ * @author your name (you@domain.com)
+ * @brief GPIO driver calls the firmware makes, no-ops on the host
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+
+#include "esp_err.h"
+#include "hal/gpio_types.h"
+
+esp_err_t gpio_input_enable(gpio_num_t gpio_num);
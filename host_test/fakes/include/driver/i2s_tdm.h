@@ -0,0 +1,79 @@
+/**
+ * @file i2s_tdm.h
+ * @author your name (you@domain.com)
+ * @brief TDM mode of the host I2S driver
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+
+#include "driver/i2s_types.h"
+
+typedef struct {
+    uint32_t sample_rate_hz;
+    i2s_clock_src_t clk_src;
+    i2s_mclk_multiple_t mclk_multiple;
+    uint32_t bclk_div;
+} i2s_tdm_clk_config_t;
+
+typedef struct {
+    i2s_data_bit_width_t data_bit_width;
+    i2s_slot_bit_width_t slot_bit_width;
+    i2s_slot_mode_t slot_mode;
+    uint32_t slot_mask;
+    uint32_t ws_width;
+    bool ws_pol;
+    bool bit_shift;
+    bool left_align;
+    bool big_endian;
+    bool bit_order_lsb;
+    bool skip_mask;
+    uint32_t total_slot;
+} i2s_tdm_slot_config_t;
+
+typedef struct {
+    gpio_num_t mclk;
+    gpio_num_t bclk;
+    gpio_num_t ws;
+    gpio_num_t dout;
+    gpio_num_t din;
+    struct {
+        uint32_t mclk_inv : 1;
+        uint32_t bclk_inv : 1;
+        uint32_t ws_inv : 1;
+    } invert_flags;
+} i2s_tdm_gpio_config_t;
+
+typedef struct {
+    i2s_tdm_clk_config_t clk_cfg;
+    i2s_tdm_slot_config_t slot_cfg;
+    i2s_tdm_gpio_config_t gpio_cfg;
+} i2s_tdm_config_t;
+
+#define I2S_TDM_CLK_DEFAULT_CONFIG(rate) { \
+    .sample_rate_hz = rate,                \
+    .clk_src = I2S_CLK_SRC_DEFAULT,        \
+    .mclk_multiple = I2S_MCLK_MULTIPLE_256, \
+    .bclk_div = 8,                         \
+}
+
+#define I2S_TDM_PHILIPS_SLOT_DEFAULT_CONFIG(bits_per_sample, mono_or_stereo, mask) { \
+    .data_bit_width = (bits_per_sample),                                             \
+    .slot_bit_width = I2S_SLOT_BIT_WIDTH_AUTO,                                       \
+    .slot_mode = (mono_or_stereo),                                                   \
+    .slot_mask = (mask),                                                             \
+    .ws_width = 0,                                                                   \
+    .ws_pol = false,                                                                 \
+    .bit_shift = true,                                                               \
+    .left_align = false,                                                             \
+    .big_endian = false,                                                             \
+    .bit_order_lsb = false,                                                          \
+    .skip_mask = false,                                                              \
+    .total_slot = 0,                                                                 \
+}
+
+esp_err_t i2s_channel_init_tdm_mode(i2s_chan_handle_t handle, const i2s_tdm_config_t* tdm_cfg);
+esp_err_t i2s_channel_reconfig_tdm_clock(i2s_chan_handle_t handle, const i2s_tdm_clk_config_t* clk_cfg);
@@ -0,0 +1,121 @@
+/**
+ * @file i2s_types.h
+ * @author your name (you@domain.com)
+ * @brief I2S channel driver of the host build
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ *
+ * Implemented by host_test/fakes/fake_i2s.c: DMA buffers complete on
+ * simulated time at the rate the clock configuration and the MCLK divider
+ * give, and the event callbacks run from the completion events.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "hal/gpio_types.h"
+
+typedef struct i2s_channel_obj_t* i2s_chan_handle_t;
+
+typedef enum {
+    I2S_NUM_0 = 0,
+    I2S_NUM_1 = 1,
+    I2S_NUM_AUTO,
+} i2s_port_t;
+
+typedef enum {
+    I2S_ROLE_MASTER,
+    I2S_ROLE_SLAVE,
+} i2s_role_t;
+
+typedef enum {
+    I2S_DIR_RX = 1,
+    I2S_DIR_TX = 2,
+} i2s_dir_t;
+
+typedef enum {
+    I2S_COMM_MODE_STD,
+    I2S_COMM_MODE_TDM,
+    I2S_COMM_MODE_NONE,
+} i2s_comm_mode_t;
+
+typedef enum {
+    I2S_DATA_BIT_WIDTH_8BIT = 8,
+    I2S_DATA_BIT_WIDTH_16BIT = 16,
+    I2S_DATA_BIT_WIDTH_24BIT = 24,
+    I2S_DATA_BIT_WIDTH_32BIT = 32,
+} i2s_data_bit_width_t;
+
+typedef enum {
+    I2S_SLOT_BIT_WIDTH_AUTO = 0,
+    I2S_SLOT_BIT_WIDTH_8BIT = 8,
+    I2S_SLOT_BIT_WIDTH_16BIT = 16,
+    I2S_SLOT_BIT_WIDTH_24BIT = 24,
+    I2S_SLOT_BIT_WIDTH_32BIT = 32,
+} i2s_slot_bit_width_t;
+
+typedef enum {
+    I2S_SLOT_MODE_MONO = 1,
+    I2S_SLOT_MODE_STEREO = 2,
+} i2s_slot_mode_t;
+
+typedef enum {
+    I2S_CLK_SRC_DEFAULT,
+    I2S_CLK_SRC_PLL_160M,
+} i2s_clock_src_t;
+
+typedef enum {
+    I2S_MCLK_MULTIPLE_128 = 128,
+    I2S_MCLK_MULTIPLE_256 = 256,
+    I2S_MCLK_MULTIPLE_384 = 384,
+    I2S_MCLK_MULTIPLE_512 = 512,
+} i2s_mclk_multiple_t;
+
+#define I2S_GPIO_UNUSED GPIO_NUM_NC
+
+typedef struct {
+    void* data; // Before IDF 5.4: address of the descriptor's buffer pointer
+    void* dma_buf; // IDF 5.4: the buffer itself
+    size_t size;
+} i2s_event_data_t;
+
+typedef bool (*i2s_isr_callback_t)(i2s_chan_handle_t handle, i2s_event_data_t* event, void* user_ctx);
+
+typedef struct {
+    i2s_isr_callback_t on_recv;
+    i2s_isr_callback_t on_recv_q_ovf;
+    i2s_isr_callback_t on_sent;
+    i2s_isr_callback_t on_send_q_ovf;
+} i2s_event_callbacks_t;
+
+typedef struct {
+    i2s_port_t id;
+    i2s_role_t role;
+    uint32_t dma_desc_num;
+    uint32_t dma_frame_num;
+    bool auto_clear;
+    int intr_priority;
+} i2s_chan_config_t;
+
+typedef struct {
+    i2s_port_t id;
+    i2s_role_t role;
+    i2s_dir_t dir;
+    i2s_comm_mode_t mode;
+    i2s_chan_handle_t pair_chan;
+} i2s_chan_info_t;
+
+esp_err_t i2s_new_channel(const i2s_chan_config_t* chan_cfg, i2s_chan_handle_t* ret_tx_handle, i2s_chan_handle_t* ret_rx_handle);
+esp_err_t i2s_del_channel(i2s_chan_handle_t handle);
+esp_err_t i2s_channel_get_info(i2s_chan_handle_t handle, i2s_chan_info_t* chan_info);
+esp_err_t i2s_channel_enable(i2s_chan_handle_t handle);
+esp_err_t i2s_channel_disable(i2s_chan_handle_t handle);
+esp_err_t i2s_channel_preload_data(i2s_chan_handle_t tx_handle, const void* src, size_t size, size_t* bytes_loaded);
+esp_err_t i2s_channel_read(i2s_chan_handle_t handle, void* dest, size_t size, size_t* bytes_read, uint32_t timeout_ms);
+esp_err_t i2s_channel_register_event_callback(i2s_chan_handle_t handle, const i2s_event_callbacks_t* callbacks, void* user_data);
@@ -0,0 +1,15 @@
+/**
+ * @file esp_attr.h
+ * @author your name (you@domain.com)
+ * @brief Placement attributes, meaningless on the host
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define WORD_ALIGNED_ATTR __attribute__((aligned(4)))
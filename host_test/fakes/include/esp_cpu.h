@@ -0,0 +1,21 @@
+/**
+ * @file esp_cpu.h
+ * @author your name (you@domain.com)
+ * @brief Host cycle counter
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ *
+ * Counts host nanoseconds instead of CPU cycles, so the cycle figures in the
+ * telemetry of a host run are host nanoseconds. They compare runs and
+ * configurations with each other, not with the target.
+ */
+#pragma once
+
+#include <stdint.h>
+
+typedef uint32_t esp_cpu_cycle_count_t;
+
+esp_cpu_cycle_count_t esp_cpu_get_cycle_count(void);
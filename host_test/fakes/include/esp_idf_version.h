@@ -0,0 +1,14 @@
+/**
+ * @file esp_idf_version.h
+ * @author your name (you@domain.com)
+ * @brief IDF version the host fakes follow
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+
+#define ESP_IDF_VERSION_VAL(major, minor, patch) (((major) << 16) | ((minor) << 8) | (patch))
+#define ESP_IDF_VERSION ESP_IDF_VERSION_VAL(5, 4, 0)
@@ -0,0 +1,19 @@
+/**
+ * @file esp_timer.h
+ * @author your name (you@domain.com)
+ * @brief Host esp_timer, reads the simulated clock
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * @brief Microseconds of simulated time since the simulation started
+ *
+ */
+int64_t esp_timer_get_time(void);
@@ -0,0 +1,38 @@
+/**
+ * @file FreeRTOS.h
+ * @author your name (you@domain.com)
+ * @brief Host FreeRTOS, a deterministic scheduler on simulated time
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ *
+ * Tasks are coroutines run by host_test/fakes/fake_freertos.c. A task runs
+ * until it blocks, the highest priority ready task goes next, and no time
+ * passes while tasks run; simulated time only advances between events.
+ * Event callbacks (the fake DMA and USB interrupts) run outside any task.
+ */
+#pragma once
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "sdkconfig.h"
+
+#include "freertos/portmacro.h"
+
+#define configTICK_RATE_HZ CONFIG_FREERTOS_HZ
+#define configASSERT(x) assert(x)
+
+#define pdFALSE ((BaseType_t)0)
+#define pdTRUE ((BaseType_t)1)
+#define pdPASS pdTRUE
+#define pdFAIL pdFALSE
+#define errQUEUE_FULL ((BaseType_t)0)
+
+#define pdMS_TO_TICKS(xTimeInMs) ((TickType_t)(((TickType_t)(xTimeInMs) * (TickType_t)configTICK_RATE_HZ) / (TickType_t)1000U))
+#define portTICK_PERIOD_MS ((TickType_t)1000 / configTICK_RATE_HZ)
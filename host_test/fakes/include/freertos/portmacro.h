@@ -0,0 +1,33 @@
+/**
+ * @file portmacro.h
+ * @author your name (you@domain.com)
+ * @brief Port types of the host FreeRTOS
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+
+#include <stdint.h>
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+#define tskNO_AFFINITY ((BaseType_t)0x7fffffff)
+
+/* Tasks woken from an event callback run as soon as it returns */
+#define portYIELD_FROM_ISR(...) ((void)0)
+
+/* Nothing preempts a coroutine, critical sections need no lock */
+typedef struct {
+    int unused;
+} portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED { 0 }
+#define portENTER_CRITICAL(mux) ((void)(mux))
+#define portEXIT_CRITICAL(mux) ((void)(mux))
+#define portENTER_CRITICAL_ISR(mux) ((void)(mux))
+#define portEXIT_CRITICAL_ISR(mux) ((void)(mux))
@@ -0,0 +1,31 @@
+/**
+ * @file queue.h
+ * @author your name (you@domain.com)
+ * @brief Queues of the host FreeRTOS
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ *
+ * Receivers block with a timeout, senders never block: a send to a full
+ * queue fails at once whatever its timeout.
+ */
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct fake_queue* QueueHandle_t;
+typedef QueueHandle_t QueueSetHandle_t;
+
+typedef struct {
+    void* reserved[8];
+} StaticQueue_t;
+
+QueueHandle_t xQueueCreate(UBaseType_t uxQueueLength, UBaseType_t uxItemSize);
+QueueHandle_t xQueueCreateStatic(UBaseType_t uxQueueLength, UBaseType_t uxItemSize, uint8_t* pucQueueStorage,
+    StaticQueue_t* pxStaticQueue);
+BaseType_t xQueueSend(QueueHandle_t xQueue, const void* pvItemToQueue, TickType_t xTicksToWait);
+BaseType_t xQueueSendFromISR(QueueHandle_t xQueue, const void* pvItemToQueue, BaseType_t* pxHigherPriorityTaskWoken);
+BaseType_t xQueueReceive(QueueHandle_t xQueue, void* pvBuffer, TickType_t xTicksToWait);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t xQueue);
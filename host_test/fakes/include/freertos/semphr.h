@@ -0,0 +1,24 @@
+/**
+ * @file semphr.h
+ * @author your name (you@domain.com)
+ * @brief Mutexes of the host FreeRTOS
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ *
+ * A mutex is a queue of one empty item, as in FreeRTOS: taking receives
+ * the item and giving sends it back.
+ */
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
+typedef QueueHandle_t SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+
+#define xSemaphoreTake(xSemaphore, xBlockTime) xQueueReceive((xSemaphore), NULL, (xBlockTime))
+#define xSemaphoreGive(xSemaphore) xQueueSend((xSemaphore), NULL, 0)
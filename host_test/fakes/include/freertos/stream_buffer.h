@@ -0,0 +1,34 @@
+/**
+ * @file stream_buffer.h
+ * @author your name (you@domain.com)
+ * @brief Stream buffers of the host FreeRTOS
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ *
+ * Only what the capture path used before the audio ring replaced it, kept
+ * as the baseline of the ring's benchmark. Sends and receives copy the way
+ * FreeRTOS's stream_buffer.c does: byte indices into storage one byte larger
+ * than the capacity, wrapped by comparison, and a spinlock taken after each
+ * transfer to check for a waiting task. Nothing blocks: the timeouts are
+ * ignored.
+ */
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct fake_stream_buffer* StreamBufferHandle_t;
+
+StreamBufferHandle_t xStreamBufferCreate(size_t xBufferSizeBytes, size_t xTriggerLevelBytes);
+void vStreamBufferDelete(StreamBufferHandle_t xStreamBuffer);
+size_t xStreamBufferSend(StreamBufferHandle_t xStreamBuffer, const void* pvTxData, size_t xDataLengthBytes,
+    TickType_t xTicksToWait);
+size_t xStreamBufferSendFromISR(StreamBufferHandle_t xStreamBuffer, const void* pvTxData, size_t xDataLengthBytes,
+    BaseType_t* pxHigherPriorityTaskWoken);
+size_t xStreamBufferReceive(StreamBufferHandle_t xStreamBuffer, void* pvRxData, size_t xBufferLengthBytes,
+    TickType_t xTicksToWait);
+size_t xStreamBufferBytesAvailable(StreamBufferHandle_t xStreamBuffer);
+size_t xStreamBufferSpacesAvailable(StreamBufferHandle_t xStreamBuffer);
+BaseType_t xStreamBufferReset(StreamBufferHandle_t xStreamBuffer);
@@ -0,0 +1,34 @@
+/**
+ * @file hal_utils.h
+ * @author your name (you@domain.com)
+ * @brief Fractional clock divider search
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+
+#include <stdint.h>
+
+typedef struct {
+    uint32_t src_freq_hz;
+    uint32_t exp_freq_hz;
+    uint32_t max_integ;
+    uint32_t min_integ;
+    uint32_t max_fract;
+} hal_utils_clk_info_t;
+
+typedef struct {
+    uint32_t integer;
+    uint32_t denominator;
+    uint32_t numerator;
+} hal_utils_clk_div_t;
+
+/**
+ * @brief Divider closest to the expected frequency, the fraction's denominator below max_fract
+ *
+ * @return the frequency the divider gives, 0 if the integer part is out of range
+ */
+uint32_t hal_utils_calc_clk_div_frac_accurate(const hal_utils_clk_info_t* clk_info, hal_utils_clk_div_t* clk_div);
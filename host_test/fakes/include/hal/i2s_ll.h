@@ -0,0 +1,32 @@
+/**
+ * @file i2s_ll.h
+ * @author your name (you@domain.com)
+ * @brief I2S register access of the host build
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ *
+ * Writing the MCLK divider of a controller changes the rate its fake DMA
+ * completes at, as the hardware would.
+ */
+#pragma once
+
+#include <stdint.h>
+
+#include "hal/hal_utils.h"
+
+typedef struct {
+    int port;
+} i2s_dev_t;
+
+extern i2s_dev_t I2S0;
+extern i2s_dev_t I2S1;
+
+#define I2S_LL_GET_HW(num) (((num) == 0) ? (&I2S0) : (&I2S1))
+#define I2S_LL_CLK_FRAC_DIV_N_MAX 256
+#define I2S_LL_CLK_FRAC_DIV_AB_MAX 64
+
+void i2s_ll_rx_set_mclk(i2s_dev_t* hw, const hal_utils_clk_div_t* mclk_div);
+void i2s_ll_tx_set_mclk(i2s_dev_t* hw, const hal_utils_clk_div_t* mclk_div);
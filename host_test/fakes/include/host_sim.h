@@ -0,0 +1,158 @@
+/**
+ * @file host_sim.h
+ * @author your name (you@domain.com)
+ * @brief Control of the simulated time and the fake peripherals
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * Simulated time only moves in sim_run_until(), from one event to the next.
+ * Events stand for interrupts: they run outside any task, and the tasks they
+ * wake run right after them. Costs are host time spent in firmware code, in
+ * nanoseconds.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "tinyusb.h"
+
+#define SIM_NS_PER_MS 1000000LL
+#define SIM_NS_PER_S 1000000000LL
+
+typedef void (*sim_event_cb_t)(void* arg);
+
+typedef struct {
+    uint64_t count;
+    uint64_t total_ns;
+    uint64_t max_ns;
+} sim_cost_t;
+
+typedef struct {
+    const char* name;
+    sim_cost_t cost; // One entry per time the task ran until it blocked
+} sim_task_info_t;
+
+int64_t sim_time_ns(void);
+
+/**
+ * @brief Run cb at at_ns; an event for the past runs at once
+ *
+ */
+void sim_schedule(int64_t at_ns, sim_event_cb_t cb, void* arg);
+
+/**
+ * @brief Drop the pending events with this callback and argument
+ *
+ */
+void sim_cancel(sim_event_cb_t cb, void* arg);
+
+/**
+ * @brief Run events and tasks until simulated time reaches end_ns
+ *
+ */
+void sim_run_until(int64_t end_ns);
+
+/**
+ * @brief Keep every task from running until until_ns, as if the CPU were busy elsewhere
+ *
+ * Events still run, and the tasks they wake run once the stall is over.
+ */
+void sim_stall_tasks(int64_t until_ns);
+
+size_t sim_task_info(sim_task_info_t* info, size_t max);
+
+void sim_cost_add(sim_cost_t* cost, uint64_t ns);
+uint64_t sim_host_ns(void);
+
+/*
+ * Fake I2S. Capture buffers are filled by the capture callback when the DMA
+ * completes them; played buffers are handed to the play callback.
+ */
+typedef void (*fake_i2s_capture_cb_t)(int port, uint64_t frame, int32_t* slots, size_t frames, size_t slots_per_frame);
+typedef void (*fake_i2s_play_cb_t)(const int32_t* slots, size_t frames, size_t slots_per_frame);
+
+void fake_i2s_set_capture(fake_i2s_capture_cb_t cb);
+void fake_i2s_set_play(fake_i2s_play_cb_t cb);
+
+/**
+ * @brief Frame rate of a controller, as its MCLK divider gives it
+ *
+ */
+double fake_i2s_rate(int port);
+
+/**
+ * @brief Host time spent in the DMA event callbacks
+ *
+ */
+const sim_cost_t* fake_i2s_cost(void);
+
+/*
+ * Fake USB host. Once attached, one start of frame per millisecond of the
+ * host clock, which runs ppm faster than the device's. Audio packets only
+ * move while the host streams.
+ */
+typedef void (*fake_usb_in_cb_t)(const uint8_t* packet, size_t size);
+typedef size_t (*fake_usb_out_cb_t)(uint8_t* packet, size_t max);
+
+void fake_usb_set_in(fake_usb_in_cb_t cb);
+
+/**
+ * @brief Send an OUT packet every frame while interface itf has a non-zero alternate setting
+ *
+ * source fills the packet; the device takes it in tud_audio_rx_done_post_read_cb().
+ */
+void fake_usb_set_out(uint8_t itf, fake_usb_out_cb_t source);
+
+void fake_usb_attach(double ppm);
+void fake_usb_detach(void);
+
+/**
+ * @brief Start or stop the audio streaming interface, as a SET_INTERFACE would
+ *
+ */
+void fake_usb_stream(bool on);
+
+/**
+ * @brief Send a control request to the audio function, as the host does during enumeration
+ *
+ * SET_INTERFACE goes to tud_audio_set_itf_cb(), class requests to an entity
+ * to tud_audio_set_req_entity_cb() or tud_audio_get_req_entity_cb().
+ *
+ * @param data the wLength bytes sent with a SET, or room for the response to a GET
+ * @return false if the device stalled the request
+ */
+bool fake_usb_control(const tusb_control_request_t* request, uint8_t* data);
+
+/**
+ * @brief Host time spent in the start-of-frame callbacks
+ *
+ */
+const sim_cost_t* fake_usb_cost(void);
+
+/**
+ * @brief What the firmware passed to tinyusb_driver_install(), NULL before
+ *
+ */
+const tinyusb_config_t* fake_usb_config(void);
+
+/*
+ * Fake USB host, CDC side. Bytes the host sends go over in 64-byte bulk
+ * packets at the next starts of frame, one receive callback per packet.
+ * Bytes the device queues reach the in callback at the next start of frame.
+ */
+typedef void (*fake_cdc_in_cb_t)(const uint8_t* data, size_t size);
+
+void fake_cdc_set_in(fake_cdc_in_cb_t cb);
+
+/**
+ * @brief Queue bytes for the device
+ *
+ * @return bytes queued, less than size if the host buffer is full
+ */
+size_t fake_cdc_send(const uint8_t* data, size_t size);
+
+void fake_cdc_set_line_state(bool dtr, bool rts);
@@ -0,0 +1,11 @@
+/**
+ * @file portable.h
+ * @author your name (you@domain.com)
+ * @brief Included by the firmware, nothing to declare on the host
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
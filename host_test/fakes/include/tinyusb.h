@@ -0,0 +1,29 @@
+/**
+ * @file tinyusb.h
+ * @author your name (you@domain.com)
+ * @brief Driver installation of esp_tinyusb, host build
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "tusb.h"
+
+typedef struct {
+    const tusb_desc_device_t* device_descriptor;
+    const char** string_descriptor;
+    int string_descriptor_count;
+    bool external_phy;
+    const uint8_t* configuration_descriptor;
+    bool self_powered;
+    int vbus_monitor_io;
+} tinyusb_config_t;
+
+esp_err_t tinyusb_driver_install(const tinyusb_config_t* config);
@@ -0,0 +1,103 @@
+/**
+ * @file tusb.h
+ * @author your name (you@domain.com)
+ * @brief The parts of TinyUSB the firmware uses directly, host build
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * Types and constants match TinyUSB. The audio class callbacks are declared
+ * weak, as TinyUSB does, and host_test/fakes/fake_tinyusb.c calls those the
+ * firmware implements when the simulated host sends a request.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define TU_ATTR_PACKED __attribute__((packed))
+#define TU_ATTR_WEAK __attribute__((weak))
+#define TU_U16_HIGH(u16) ((uint8_t)(((u16) >> 8) & 0x00ff))
+#define TU_U16_LOW(u16) ((uint8_t)((u16) & 0x00ff))
+
+typedef enum {
+    TUSB_DESC_DEVICE = 0x01,
+    TUSB_DESC_CONFIGURATION = 0x02,
+    TUSB_DESC_STRING = 0x03,
+    TUSB_DESC_INTERFACE = 0x04,
+    TUSB_DESC_ENDPOINT = 0x05,
+    TUSB_DESC_INTERFACE_ASSOCIATION = 0x0B,
+    TUSB_DESC_CS_INTERFACE = 0x24,
+    TUSB_DESC_CS_ENDPOINT = 0x25,
+} tusb_desc_type_t;
+
+typedef enum {
+    TUSB_CLASS_AUDIO = 1,
+    TUSB_CLASS_CDC = 2,
+    TUSB_CLASS_CDC_DATA = 10,
+    TUSB_CLASS_MISC = 0xEF,
+} tusb_class_code_t;
+
+typedef enum {
+    TUSB_REQ_SET_INTERFACE = 0x0B,
+} tusb_request_code_t;
+
+typedef enum {
+    TUSB_REQ_TYPE_STANDARD = 0,
+    TUSB_REQ_TYPE_CLASS,
+} tusb_request_type_t;
+
+typedef enum {
+    TUSB_REQ_RCPT_DEVICE = 0,
+    TUSB_REQ_RCPT_INTERFACE,
+    TUSB_REQ_RCPT_ENDPOINT,
+} tusb_request_recipient_t;
+
+typedef enum {
+    TUSB_DIR_OUT = 0,
+    TUSB_DIR_IN = 1,
+} tusb_dir_t;
+
+typedef struct TU_ATTR_PACKED {
+    uint8_t bLength;
+    uint8_t bDescriptorType;
+    uint16_t bcdUSB;
+    uint8_t bDeviceClass;
+    uint8_t bDeviceSubClass;
+    uint8_t bDeviceProtocol;
+    uint8_t bMaxPacketSize0;
+    uint16_t idVendor;
+    uint16_t idProduct;
+    uint16_t bcdDevice;
+    uint8_t iManufacturer;
+    uint8_t iProduct;
+    uint8_t iSerialNumber;
+    uint8_t bNumConfigurations;
+} tusb_desc_device_t;
+
+typedef struct TU_ATTR_PACKED {
+    union {
+        struct TU_ATTR_PACKED {
+            uint8_t recipient : 5;
+            uint8_t type : 2;
+            uint8_t direction : 1;
+        } bmRequestType_bit;
+        uint8_t bmRequestType;
+    };
+    uint8_t bRequest;
+    uint16_t wValue;
+    uint16_t wIndex;
+    uint16_t wLength;
+} tusb_control_request_t;
+
+/**
+ * @brief Answer a GET request: the fake copies the response for the simulated host
+ *
+ */
+bool tud_audio_buffer_and_schedule_control_xfer(uint8_t rhport, tusb_control_request_t const* p_request, void* data, uint16_t len);
+
+TU_ATTR_WEAK bool tud_audio_set_itf_cb(uint8_t rhport, tusb_control_request_t const* p_request);
+TU_ATTR_WEAK bool tud_audio_set_req_entity_cb(uint8_t rhport, tusb_control_request_t const* p_request, uint8_t* pBuff);
+TU_ATTR_WEAK bool tud_audio_get_req_entity_cb(uint8_t rhport, tusb_control_request_t const* p_request);
+TU_ATTR_WEAK bool tud_audio_rx_done_post_read_cb(uint8_t rhport, uint16_t n_bytes_received, uint8_t func_id, uint8_t ep_out, uint8_t cur_alt_setting);
@@ -0,0 +1,30 @@
+/**
+ * @file tusb_audio.h
+ * @author your name (you@domain.com)
+ * @brief Audio class API of the esp_tinyusb fork, host build
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * Implemented by host_test/fakes/fake_tinyusb.c. Every start of frame runs
+ * the pre-load callback, which writes the packet sent in that frame, then
+ * the post-load callback.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+typedef esp_err_t (*tusb_audio_cb_t)(void);
+
+typedef struct {
+    tusb_audio_cb_t on_post_callback;
+    tusb_audio_cb_t on_pre_callback;
+} tinyusb_audio_config_t;
+
+esp_err_t tusb_audio_init(const tinyusb_audio_config_t* cfg);
+uint16_t tud_audio_write(const void* data, uint16_t len);
+uint16_t tud_audio_read(void* buffer, uint16_t bufsize);
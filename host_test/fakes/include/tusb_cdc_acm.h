@@ -0,0 +1,65 @@
+/**
+ * @file tusb_cdc_acm.h
+ * @author your name (you@domain.com)
+ * @brief CDC-ACM class of esp_tinyusb, host build
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ *
+ * Implemented by host_test/fakes/fake_tinyusb.c. The receive callback runs
+ * once per bulk packet the host sends; queued bytes leave at the next start
+ * of frame.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+typedef enum {
+    TINYUSB_USBDEV_0,
+} tinyusb_usbdev_t;
+
+typedef enum {
+    TINYUSB_CDC_ACM_0 = 0,
+    TINYUSB_CDC_ACM_1,
+} tinyusb_cdcacm_itf_t;
+
+typedef enum {
+    CDC_EVENT_RX,
+    CDC_EVENT_RX_WANTED_CHAR,
+    CDC_EVENT_LINE_STATE_CHANGED,
+    CDC_EVENT_LINE_CODING_CHANGED,
+} cdcacm_event_type_t;
+
+typedef struct {
+    cdcacm_event_type_t type;
+    union {
+        struct {
+            bool dtr;
+            bool rts;
+        } line_state_changed_data;
+    };
+} cdcacm_event_t;
+
+typedef void (*tusb_cdcacm_callback_t)(int itf, cdcacm_event_t* event);
+
+typedef struct {
+    tinyusb_usbdev_t usb_dev;
+    tinyusb_cdcacm_itf_t cdc_port;
+    size_t rx_unread_buf_sz;
+    tusb_cdcacm_callback_t callback_rx;
+    tusb_cdcacm_callback_t callback_rx_wanted_char;
+    tusb_cdcacm_callback_t callback_line_state_changed;
+    tusb_cdcacm_callback_t callback_line_coding_changed;
+} tinyusb_config_cdcacm_t;
+
+esp_err_t tusb_cdc_acm_init(const tinyusb_config_cdcacm_t* cfg);
+esp_err_t tinyusb_cdcacm_read(tinyusb_cdcacm_itf_t itf, uint8_t* out_buf, size_t out_buf_sz, size_t* rx_data_size);
+size_t tinyusb_cdcacm_write_queue(tinyusb_cdcacm_itf_t itf, const uint8_t* in_buf, size_t in_size);
+esp_err_t tinyusb_cdcacm_write_flush(tinyusb_cdcacm_itf_t itf, uint32_t timeout_ticks);
+uint32_t tud_cdc_n_write_available(uint8_t itf);
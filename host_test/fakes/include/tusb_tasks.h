@@ -0,0 +1,15 @@
+/**
+ * @file tusb_tasks.h
+ * @author your name (you@domain.com)
+ * @brief TinyUSB task control of esp_tinyusb, host build
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+
+#include "esp_err.h"
+
+esp_err_t tusb_stop_task(void);
@@ -0,0 +1,802 @@
+/**
+ * @file pipeline_sim.c
+ * @author your name (you@domain.com)
+ * @brief Run the firmware against the fake I2S and USB host for simulated minutes or hours
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * app_main() runs unchanged as the "main" task. Every I2S slot carries a
+ * counter, slot s of capture frame f being (f + s * 0x100000) mod 2^24 in
+ * the top 24 bits, so the IN packets can be checked frame by frame: any
+ * frame that is neither the next frame nor silence is a glitch. Channel c
+ * is expected to carry the slot CONFIG_AUDIO_CHANNEL_MAP assigns it. The check
+ * is skipped for 16-bit samples and whenever resampling or the DSP chain
+ * change the samples. Periodic lines trace the ring fill level and the
+ * counters; the summary gives the CPU time of every task and callback.
+ *
+ * With CONFIG_AUDIO_PLAYBACK and --playback, the host also streams OUT
+ * packets carrying a counter the same way, and the frames reaching the DAC
+ * are checked likewise: after the first, each is the next one or silence,
+ * and a silent run may only end where the host resumed after a gap. The
+ * delay from the host sending a frame to the DAC playing it is taken at
+ * every start of playback and must be the same each time.
+ *
+ * With --switch-format the host cycles the IN interface through the 24 and
+ * 32-bit alternate settings, so frames change size mid-stream. Every packet
+ * after a switch must be whole frames of the new format carrying consistent
+ * counters; the check relocks after the silence of the new prebuffer.
+ *
+ * With --stop the host sends STREAM_STOP over the CDC port and STREAM_START
+ * some time later. The stream pauses in silence and resumes from the
+ * newest audio, without overruns however long it stayed stopped.
+ *
+ * With CONFIG_AUDIO_SOURCE_FILE the sim first writes the file the firmware
+ * replays: REPLAY_FRAMES frames counting the same way, channel c carrying
+ * slot c. The counter then wraps with the file each time it loops.
+ */
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "audio_pipeline/pcm_convert.h"
+#include "audio_pipeline/telemetry.h"
+#include "config/audio_config.h"
+#include "host_sim.h"
+#include "usb/cdc_frame.h"
+#include "usb/usb_audio.h"
+#include "usb/usb_cdc.h"
+#include "usb/usb_descriptors.h"
+
+#include "esp_log.h"
+
+#define SLOT_STEP 0x100000
+#define COUNTER_MASK 0xFFFFFF
+#define HOST_ENUMERATION_MS 100 // Host selects rate and format this long after boot
+#define REPLAY_FRAMES 0x10000 // Power of two dividing SLOT_STEP, so slots stay apart when the counter wraps
+
+#if CONFIG_AUDIO_SOURCE_FILE
+#define CAPTURE_COUNTER_MASK (REPLAY_FRAMES - 1)
+#else
+#define CAPTURE_COUNTER_MASK COUNTER_MASK
+#endif
+
+#if !CONFIG_AUDIO_SRC && !CONFIG_AUDIO_DSP_CHAIN
+#define CHECK_SAMPLES 1
+#else
+#define CHECK_SAMPLES 0
+#endif
+
+typedef enum {
+    EXPECT_CLEAN,
+    EXPECT_UNDERRUNS,
+    EXPECT_PLAYBACK_UNDERRUNS, // Capture clean, one playback underrun per OUT gap
+} sim_expect_t;
+
+typedef struct {
+    uint64_t frames;
+    uint64_t silent_frames;
+    uint64_t glitch_frames;
+    uint64_t glitches; // Runs of glitch frames
+    bool locked; // Seen a first audio frame
+    bool in_glitch;
+    bool in_silence; // Silent since the last audio frame
+    uint32_t next_counter;
+    uint32_t counter_mask; // Counters wrap at this plus one
+} stream_check_t;
+
+typedef struct {
+    /* Options */
+    double minutes;
+    double usb_ppm;
+    uint8_t alt;
+    uint32_t sample_rate;
+    int stall_ms;
+    double stall_period_s;
+    double report_s;
+    bool verbose;
+    sim_expect_t expect;
+
+    bool playback;
+    int out_gap_ms;
+    double out_gap_period_s;
+    double switch_period_s;
+    int stop_ms;
+    double stop_period_s;
+
+    /* IN stream check */
+    size_t bytes_per_sample;
+    uint64_t packets;
+    uint64_t bad_packets; // Not whole frames, or larger than the largest packet
+    stream_check_t in;
+    uint32_t format_switches;
+    uint32_t stops; // STREAM_STOP commands sent
+    uint8_t cdc_seq;
+    uint8_t channel_map[NUM_CHANNELS]; // I2S slot expected in each USB channel
+    uint64_t cdc_bytes;
+
+    /* OUT stream and playback check */
+    uint32_t out_counter; // Counter of the next frame the host sends
+    double out_frames_due; // Fraction of a frame carried over to the next packet
+    int64_t out_gap_end_ns;
+    uint32_t out_gaps; // Gaps the host left in the OUT stream
+    stream_check_t play;
+    uint32_t play_starts; // Starts of playback, the first and one after every silent run
+    uint32_t play_delay_min; // Frames from the host sending a frame to the DAC playing it, at each start
+    uint32_t play_delay_max;
+} sim_ctx_t;
+
+static sim_ctx_t sim = {
+    .minutes = 1.0,
+    .alt = 3,
+    .sample_rate = SAMPLE_RATE,
+    .report_s = 10.0,
+    .expect = EXPECT_CLEAN,
+    .in = { .counter_mask = CAPTURE_COUNTER_MASK },
+    .play = { .counter_mask = COUNTER_MASK },
+    .play_delay_min = UINT32_MAX,
+};
+
+static const size_t alt_bytes_per_sample[] = { 0, 2, 3, 4, 4 };
+
+void app_main(void);
+
+static void capture(int port, uint64_t frame, int32_t* slots, size_t frames, size_t slots_per_frame)
+{
+    for (size_t i = 0; i < frames; i++) {
+        for (size_t s = 0; s < slots_per_frame; s++) {
+            uint32_t slot = port * slots_per_frame + s;
+            uint32_t value = (uint32_t)(frame + i + slot * SLOT_STEP) & COUNTER_MASK;
+            slots[i * slots_per_frame + s] = (int32_t)(value << 8);
+        }
+    }
+}
+
+#if CONFIG_AUDIO_SOURCE_FILE
+/**
+ * @brief Write the file the firmware replays, before app_main() opens it
+ *
+ */
+static bool write_replay_file(void)
+{
+    FILE* file = fopen(CONFIG_AUDIO_SOURCE_FILE_PATH, "wb");
+    if (file == NULL) {
+        fprintf(stderr, "Cannot create %s\n", CONFIG_AUDIO_SOURCE_FILE_PATH);
+        return false;
+    }
+    for (uint32_t frame = 0; frame < REPLAY_FRAMES; frame++) {
+        uint8_t bytes[NUM_CHANNELS * sizeof(int32_t)];
+        for (uint32_t ch = 0; ch < NUM_CHANNELS; ch++) {
+            uint32_t value = ((frame + ch * SLOT_STEP) & COUNTER_MASK) << 8;
+            for (int b = 0; b < 4; b++) {
+                bytes[ch * sizeof(int32_t) + b] = (uint8_t)(value >> (8 * b));
+            }
+        }
+        fwrite(bytes, sizeof(bytes), 1, file);
+    }
+    return fclose(file) == 0;
+}
+#endif
+
+static uint32_t decode_sample(const uint8_t* sample)
+{
+    if (sim.bytes_per_sample == 3) {
+        return sample[0] | sample[1] << 8 | (uint32_t)sample[2] << 16;
+    }
+    uint32_t value;
+    memcpy(&value, sample, sizeof(value));
+    return value >> 8;
+}
+
+/**
+ * @brief Check one frame of counters against the stream so far
+ *
+ * @param values counter of each channel, the top 24 bits of its sample
+ * @param map slot expected in each channel
+ * @param may_pause silence and a jump after it are expected, as in playback around a gap
+ * @return true if audio starts with this frame, after silence or as the first
+ */
+static bool check_frame(stream_check_t* check, const uint32_t* values, const uint8_t* map, bool may_pause)
+{
+    bool silent = true;
+    bool consistent = true;
+    uint32_t counter = (values[0] - map[0] * SLOT_STEP) & check->counter_mask;
+
+    for (size_t ch = 0; ch < NUM_CHANNELS; ch++) {
+        silent &= values[ch] == 0;
+        consistent &= values[ch] == ((counter + map[ch] * SLOT_STEP) & COUNTER_MASK);
+    }
+
+    check->frames++;
+    if (silent && (!check->locked || check->in_glitch || may_pause)) {
+        check->silent_frames++;
+        check->in_silence = true;
+        return false;
+    }
+    if (consistent && (!check->locked || counter == check->next_counter || (may_pause && check->in_silence))) {
+        bool started = !check->locked || check->in_silence;
+        check->locked = true;
+        check->in_glitch = false;
+        check->in_silence = false;
+        check->next_counter = (counter + 1) & check->counter_mask;
+        return started;
+    }
+
+    check->glitch_frames++;
+    check->in_silence = false;
+    if (!check->in_glitch) {
+        check->glitches++;
+        check->in_glitch = true;
+        if (sim.verbose) {
+            printf("%10.3f s glitch: frame %06lx, expected %06lx\n",
+                sim_time_ns() / (double)SIM_NS_PER_S, (unsigned long)counter, (unsigned long)check->next_counter);
+        }
+    }
+    if (consistent) {
+        /* Resume the check from whatever the stream continues with */
+        check->next_counter = (counter + 1) & check->counter_mask;
+    }
+    return false;
+}
+
+static void usb_in(const uint8_t* packet, size_t size)
+{
+    size_t frame_bytes = sim.bytes_per_sample * NUM_CHANNELS;
+
+    sim.packets++;
+    if (size % frame_bytes != 0 || size > MAX_AUDIO_BYTES_PER_MS) {
+        sim.bad_packets++;
+        return;
+    }
+    if (CHECK_SAMPLES && sim.bytes_per_sample >= 3) {
+        for (size_t offset = 0; offset < size; offset += frame_bytes) {
+            uint32_t values[NUM_CHANNELS];
+            for (size_t ch = 0; ch < NUM_CHANNELS; ch++) {
+                values[ch] = decode_sample(packet + offset + ch * sim.bytes_per_sample);
+            }
+            check_frame(&sim.in, values, sim.channel_map, sim.stop_ms > 0);
+        }
+    }
+}
+
+#if CONFIG_AUDIO_PLAYBACK
+static const audio_format_t alt_formats[] = {
+    PCM_FORMAT_UNKNOWN, PCM_FORMAT_16BIT, PCM_FORMAT_24BIT_32BIT, PCM_FORMAT_24BIT_IN_32BIT, PCM_FORMAT_32BIT,
+};
+
+/**
+ * @brief Host: one OUT packet per frame of its clock, counters continuing across gaps as if packets were lost
+ *
+ */
+static size_t usb_out(uint8_t* packet, size_t max)
+{
+    static int32_t words[MAX_AUDIO_BYTES_PER_MS / sizeof(int32_t)];
+
+    sim.out_frames_due += sim.sample_rate / 1000.0;
+    size_t frames = (size_t)sim.out_frames_due;
+    sim.out_frames_due -= frames;
+
+    for (size_t i = 0; i < frames; i++) {
+        for (size_t ch = 0; ch < NUM_CHANNELS; ch++) {
+            uint32_t value = (sim.out_counter + i + ch * SLOT_STEP) & COUNTER_MASK;
+            words[i * NUM_CHANNELS + ch] = (int32_t)(value << 8);
+        }
+    }
+    sim.out_counter = (sim.out_counter + frames) & COUNTER_MASK;
+
+    if (sim_time_ns() < sim.out_gap_end_ns || frames * NUM_CHANNELS * sim.bytes_per_sample > max) {
+        return 0;
+    }
+    return pcm_convert(alt_formats[sim.alt], words, packet, frames * NUM_CHANNELS, NULL);
+}
+
+static void out_gap(void* arg)
+{
+    (void)arg;
+    int64_t now = sim_time_ns();
+    sim.out_gap_end_ns = now + sim.out_gap_ms * SIM_NS_PER_MS;
+    sim.out_gaps++;
+    sim_schedule(now + (int64_t)(sim.out_gap_period_s * SIM_NS_PER_S), out_gap, NULL);
+}
+
+/**
+ * @brief DAC: check what the TX DMA played, and the delay at every start of playback
+ *
+ */
+static void play(const int32_t* slots, size_t frames, size_t slots_per_frame)
+{
+    static const uint8_t identity[] = { 0, 1, 2, 3, 4, 5, 6, 7 }; // USB channel n plays on slot n
+    _Static_assert(NUM_CHANNELS <= sizeof(identity), "identity map too short");
+
+    if (!CHECK_SAMPLES || sim.bytes_per_sample < 3) {
+        return;
+    }
+    for (size_t i = 0; i < frames; i++, slots += slots_per_frame) {
+        uint32_t values[NUM_CHANNELS];
+        for (size_t ch = 0; ch < NUM_CHANNELS; ch++) {
+            values[ch] = (uint32_t)slots[ch] >> 8;
+        }
+        if (check_frame(&sim.play, values, identity, true)) {
+            /* Frames since this one was sent, counted from the end of the block it was played in */
+            uint32_t delay = (sim.out_counter - values[0] - (frames - i)) & COUNTER_MASK;
+            sim.play_starts++;
+            sim.play_delay_min = delay < sim.play_delay_min ? delay : sim.play_delay_min;
+            sim.play_delay_max = delay > sim.play_delay_max ? delay : sim.play_delay_max;
+        }
+    }
+}
+#endif
+
+static void cdc_in(const uint8_t* data, size_t size)
+{
+    (void)data;
+    sim.cdc_bytes += size;
+}
+
+static void send_command(cdc_cmd_t cmd)
+{
+    uint8_t frame[CDC_FRAME_HEADER_SIZE + CDC_FRAME_CRC_SIZE];
+    size_t size = cdc_frame_encode(cmd, sim.cdc_seq++, NULL, 0, frame, sizeof(frame));
+    fake_cdc_send(frame, size);
+}
+
+static void stream_start(void* arg)
+{
+    (void)arg;
+    send_command(CDC_CMD_STREAM_START);
+}
+
+/**
+ * @brief Host: stop the stream over the CDC port, and start it again stop_ms later
+ *
+ */
+static void stream_stop(void* arg)
+{
+    (void)arg;
+    int64_t now = sim_time_ns();
+    send_command(CDC_CMD_STREAM_STOP);
+    sim.stops++;
+    sim_schedule(now + sim.stop_ms * SIM_NS_PER_MS, stream_start, NULL);
+    sim_schedule(now + (int64_t)(sim.stop_period_s * SIM_NS_PER_S), stream_stop, NULL);
+}
+
+static void stall(void* arg)
+{
+    (void)arg;
+    int64_t now = sim_time_ns();
+    sim_stall_tasks(now + sim.stall_ms * SIM_NS_PER_MS);
+    sim_schedule(now + (int64_t)(sim.stall_period_s * SIM_NS_PER_S), stall, NULL);
+}
+
+/**
+ * @brief Send a control request the device must accept, like ESP_ERROR_CHECK for the host side
+ *
+ */
+static void control(const tusb_control_request_t* request, uint8_t* data)
+{
+    if (!fake_usb_control(request, data)) {
+        fprintf(stderr, "Control request %02x to %04x stalled\n", request->bRequest, request->wIndex);
+        abort();
+    }
+}
+
+static void set_interface(uint8_t itf, uint8_t alt)
+{
+    const tusb_control_request_t request = {
+        .bmRequestType_bit = { .recipient = TUSB_REQ_RCPT_INTERFACE, .type = TUSB_REQ_TYPE_STANDARD, .direction = TUSB_DIR_OUT },
+        .bRequest = TUSB_REQ_SET_INTERFACE,
+        .wValue = alt,
+        .wIndex = itf,
+    };
+    control(&request, NULL);
+}
+
+static tusb_control_request_t entity_request(tusb_dir_t dir, uint8_t request, uint8_t entity, uint8_t selector, uint16_t len)
+{
+    return (tusb_control_request_t) {
+        .bmRequestType_bit = { .recipient = TUSB_REQ_RCPT_INTERFACE, .type = TUSB_REQ_TYPE_CLASS, .direction = dir },
+        .bRequest = request,
+        .wValue = selector << 8,
+        .wIndex = entity << 8 | ITF_NUM_AUDIO_CONTROL,
+        .wLength = len,
+    };
+}
+
+static uint32_t get32(const uint8_t* p)
+{
+    return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+/**
+ * @brief Set the clock source rate, then read it back and find it among the ranges offered
+ *
+ */
+static void set_sample_rate(uint32_t sample_rate)
+{
+    uint8_t data[256] = { sample_rate & 0xFF, (sample_rate >> 8) & 0xFF, (sample_rate >> 16) & 0xFF, sample_rate >> 24 };
+    tusb_control_request_t request = entity_request(TUSB_DIR_OUT, UAC2_REQ_CUR, UAC2_ENTITY_CLOCK, UAC2_CS_SAM_FREQ_CONTROL, 4);
+    control(&request, data);
+
+    request = entity_request(TUSB_DIR_IN, UAC2_REQ_CUR, UAC2_ENTITY_CLOCK, UAC2_CS_SAM_FREQ_CONTROL, 4);
+    control(&request, data);
+    uint32_t current = get32(data);
+
+    request = entity_request(TUSB_DIR_IN, UAC2_REQ_RANGE, UAC2_ENTITY_CLOCK, UAC2_CS_SAM_FREQ_CONTROL, sizeof(data));
+    control(&request, data);
+    bool offered = false;
+    size_t ranges = data[0] | data[1] << 8;
+    for (size_t i = 0; i < ranges && 2 + 12 * (i + 1) <= sizeof(data); i++) {
+        offered |= get32(data + 2 + 12 * i) <= sample_rate && sample_rate <= get32(data + 6 + 12 * i);
+    }
+
+    if (current != sample_rate || !offered) {
+        fprintf(stderr, "Clock source reports %lu Hz, %s %lu Hz\n", (unsigned long)current,
+            offered ? "set to" : "not offering", (unsigned long)sample_rate);
+        abort();
+    }
+}
+
+/**
+ * @brief Restore volume and mute like a host at enumeration: unity and unmuted on every channel, read back
+ *
+ */
+static void set_unity_gain(void)
+{
+    uint8_t data[8];
+    tusb_control_request_t request = entity_request(TUSB_DIR_IN, UAC2_REQ_RANGE, UAC2_ENTITY_FEATURE_UNIT, UAC2_FU_VOLUME_CONTROL, 8);
+    control(&request, data);
+    int16_t min = (int16_t)(data[2] | data[3] << 8);
+    int16_t max = (int16_t)(data[4] | data[5] << 8);
+    bool ok = min < 0 && max >= 0;
+
+    for (uint8_t ch = 0; ch <= NUM_CHANNELS; ch++) {
+        memset(data, 0, sizeof(data));
+        request = entity_request(TUSB_DIR_OUT, UAC2_REQ_CUR, UAC2_ENTITY_FEATURE_UNIT, UAC2_FU_VOLUME_CONTROL, 2);
+        request.wValue |= ch;
+        control(&request, data);
+        request = entity_request(TUSB_DIR_OUT, UAC2_REQ_CUR, UAC2_ENTITY_FEATURE_UNIT, UAC2_FU_MUTE_CONTROL, 1);
+        request.wValue |= ch;
+        control(&request, data);
+
+        memset(data, 0xFF, sizeof(data));
+        request = entity_request(TUSB_DIR_IN, UAC2_REQ_CUR, UAC2_ENTITY_FEATURE_UNIT, UAC2_FU_VOLUME_CONTROL, 2);
+        request.wValue |= ch;
+        control(&request, data);
+        ok &= data[0] == 0 && data[1] == 0;
+        request = entity_request(TUSB_DIR_IN, UAC2_REQ_CUR, UAC2_ENTITY_FEATURE_UNIT, UAC2_FU_MUTE_CONTROL, 1);
+        request.wValue |= ch;
+        control(&request, data);
+        ok &= data[0] == 0;
+    }
+
+    if (!ok) {
+        fprintf(stderr, "Feature unit does not read back unity gain, volume range %d..%d\n", min, max);
+        abort();
+    }
+}
+
+/**
+ * @brief Host: move the IN interface to the next of the 24 and 32-bit alternate settings, through alt 0
+ *
+ */
+static void switch_format(void* arg)
+{
+    (void)arg;
+    uint8_t alt = sim.alt < 4 ? sim.alt + 1 : 2;
+
+    set_interface(ITF_NUM_AUDIO_STREAMING_IN, 0);
+    set_interface(ITF_NUM_AUDIO_STREAMING_IN, alt);
+    sim.alt = alt;
+    sim.bytes_per_sample = alt_bytes_per_sample[alt];
+    sim.in.locked = false;
+    sim.format_switches++;
+    sim_schedule(sim_time_ns() + (int64_t)(sim.switch_period_s * SIM_NS_PER_S), switch_format, NULL);
+}
+
+static void usb_host_task(void* pvParam)
+{
+    (void)pvParam;
+    vTaskDelay(pdMS_TO_TICKS(HOST_ENUMERATION_MS));
+
+    fake_usb_attach(sim.usb_ppm);
+    set_sample_rate(sim.sample_rate);
+    set_unity_gain();
+    set_interface(ITF_NUM_AUDIO_STREAMING_IN, sim.alt);
+#if CONFIG_AUDIO_PLAYBACK
+    if (sim.playback) {
+        set_interface(ITF_NUM_AUDIO_STREAMING_OUT, sim.alt);
+        fake_usb_set_out(ITF_NUM_AUDIO_STREAMING_OUT, usb_out);
+    }
+#endif
+    fake_usb_stream(true);
+
+    vTaskDelete(NULL);
+}
+
+static void report(const telemetry_snapshot_t* t)
+{
+    double bytes_per_ms = sim.sample_rate / 1000.0 * NUM_CHANNELS * sizeof(int32_t);
+
+    printf("%10.1f s fill %6.2f ms (%6.2f..%6.2f) underruns %lu overruns %lu dma overflows %lu gaps %lu glitches %llu\n",
+        sim_time_ns() / (double)SIM_NS_PER_S,
+        t->fill_last / bytes_per_ms, t->fill_window_min / bytes_per_ms, t->fill_window_max / bytes_per_ms,
+        (unsigned long)t->underruns, (unsigned long)t->overruns, (unsigned long)t->dma_overflows,
+        (unsigned long)t->gaps, (unsigned long long)sim.in.glitches);
+}
+
+static void print_cost(const char* name, const sim_cost_t* cost, double seconds)
+{
+    printf("  %-20s %10llu runs %9.2f us avg %9.2f us max %7.3f %% cpu\n", name,
+        (unsigned long long)cost->count,
+        cost->count > 0 ? cost->total_ns / 1000.0 / cost->count : 0.0,
+        cost->max_ns / 1000.0,
+        seconds > 0 ? cost->total_ns / (seconds * 1e7) : 0.0);
+}
+
+/**
+ * @brief Slot of each USB channel, as the firmware reads CONFIG_AUDIO_CHANNEL_MAP
+ *
+ * Only I2S capture is remapped, the other sources write USB channels directly.
+ */
+static bool parse_channel_map(void)
+{
+#if !CONFIG_AUDIO_SOURCE_I2S
+    for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+        sim.channel_map[ch] = (uint8_t)ch;
+    }
+    return true;
+#endif
+    const char* spec = CONFIG_AUDIO_CHANNEL_MAP;
+
+    for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+        long slot = ch % AUDIO_I2S_SLOTS;
+        if (*spec != '\0') {
+            char* end;
+            slot = strtol(spec, &end, 10);
+            if (end == spec || slot < 0 || slot >= AUDIO_I2S_SLOTS) {
+                return false;
+            }
+            spec = *end == ',' ? end + 1 : end;
+        }
+        sim.channel_map[ch] = (uint8_t)slot;
+    }
+    return true;
+}
+
+static int parse_alt(const char* format)
+{
+    static const char* names[] = { NULL, "16", "24", "24in32", "32" };
+    for (int alt = 1; alt < 5; alt++) {
+        if (strcmp(format, names[alt]) == 0) {
+            return alt;
+        }
+    }
+    return -1;
+}
+
+static void usage(const char* prog)
+{
+    fprintf(stderr,
+        "usage: %s [--minutes M] [--usb-ppm PPM] [--format 16|24|24in32|32] [--rate HZ]\n"
+        "          [--stall MS:PERIOD_S] [--report S] [--verbose]\n"
+        "          [--playback] [--out-gap MS:PERIOD_S] [--switch-format PERIOD_S] [--stop MS:PERIOD_S]\n"
+        "          [--expect clean|underruns|playback-underruns]\n",
+        prog);
+}
+
+static bool parse_args(int argc, char** argv)
+{
+    static const struct option options[] = {
+        { "minutes", required_argument, NULL, 'm' },
+        { "usb-ppm", required_argument, NULL, 'p' },
+        { "format", required_argument, NULL, 'f' },
+        { "rate", required_argument, NULL, 'r' },
+        { "stall", required_argument, NULL, 's' },
+        { "report", required_argument, NULL, 'R' },
+        { "verbose", no_argument, NULL, 'v' },
+        { "expect", required_argument, NULL, 'e' },
+        { "playback", no_argument, NULL, 'P' },
+        { "out-gap", required_argument, NULL, 'g' },
+        { "switch-format", required_argument, NULL, 'S' },
+        { "stop", required_argument, NULL, 'x' },
+        { "help", no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 },
+    };
+    int opt;
+    int alt;
+
+    while ((opt = getopt_long(argc, argv, "", options, NULL)) != -1) {
+        switch (opt) {
+        case 'm':
+            sim.minutes = atof(optarg);
+            break;
+        case 'p':
+            sim.usb_ppm = atof(optarg);
+            break;
+        case 'f':
+            alt = parse_alt(optarg);
+            if (alt < 0) {
+                return false;
+            }
+            sim.alt = (uint8_t)alt;
+            break;
+        case 'r':
+            sim.sample_rate = (uint32_t)atol(optarg);
+            break;
+        case 's':
+            if (sscanf(optarg, "%d:%lf", &sim.stall_ms, &sim.stall_period_s) != 2 || sim.stall_period_s <= 0) {
+                return false;
+            }
+            break;
+        case 'R':
+            sim.report_s = atof(optarg);
+            break;
+        case 'v':
+            sim.verbose = true;
+            break;
+        case 'P':
+            sim.playback = true;
+            break;
+        case 'g':
+            if (sscanf(optarg, "%d:%lf", &sim.out_gap_ms, &sim.out_gap_period_s) != 2 || sim.out_gap_period_s <= 0) {
+                return false;
+            }
+            break;
+        case 'S':
+            sim.switch_period_s = atof(optarg);
+            if (sim.switch_period_s <= 0) {
+                return false;
+            }
+            break;
+        case 'x':
+            if (sscanf(optarg, "%d:%lf", &sim.stop_ms, &sim.stop_period_s) != 2 || sim.stop_ms <= 0
+                || sim.stop_period_s * 1000 <= sim.stop_ms) {
+                return false;
+            }
+            break;
+        case 'e':
+            if (strcmp(optarg, "clean") == 0) {
+                sim.expect = EXPECT_CLEAN;
+            } else if (strcmp(optarg, "underruns") == 0) {
+                sim.expect = EXPECT_UNDERRUNS;
+            } else if (strcmp(optarg, "playback-underruns") == 0) {
+                sim.expect = EXPECT_PLAYBACK_UNDERRUNS;
+            } else {
+                return false;
+            }
+            break;
+        default:
+            return false;
+        }
+    }
+#if !CONFIG_AUDIO_PLAYBACK
+    if (sim.playback) {
+        fprintf(stderr, "--playback needs CONFIG_AUDIO_PLAYBACK\n");
+        return false;
+    }
+#endif
+    if (sim.switch_period_s > 0 && (sim.playback || sim.alt < 2)) {
+        fprintf(stderr, "--switch-format starts from a 24 or 32-bit format and leaves playback alone\n");
+        return false;
+    }
+    return optind == argc && sim.minutes > 0 && sim.report_s > 0;
+}
+
+int main(int argc, char** argv)
+{
+    if (!parse_args(argc, argv) || !parse_channel_map()) {
+        usage(argv[0]);
+        return 2;
+    }
+    sim.bytes_per_sample = alt_bytes_per_sample[sim.alt];
+#if CONFIG_AUDIO_SOURCE_FILE
+    if (!write_replay_file()) {
+        return 2;
+    }
+#endif
+    esp_log_level_set("*", sim.verbose ? ESP_LOG_INFO : ESP_LOG_WARN);
+
+    fake_i2s_set_capture(capture);
+    fake_usb_set_in(usb_in);
+    fake_cdc_set_in(cdc_in);
+    xTaskCreate((TaskFunction_t)app_main, "main", 4096, NULL, 1, NULL);
+    xTaskCreate(usb_host_task, "usb host", 4096, NULL, 5, NULL);
+    if (sim.stall_ms > 0) {
+        sim_schedule((int64_t)(sim.stall_period_s * SIM_NS_PER_S), stall, NULL);
+    }
+    if (sim.switch_period_s > 0) {
+        sim_schedule((int64_t)(sim.switch_period_s * SIM_NS_PER_S), switch_format, NULL);
+    }
+    if (sim.stop_ms > 0) {
+        sim_schedule((int64_t)(sim.stop_period_s * SIM_NS_PER_S), stream_stop, NULL);
+    }
+#if CONFIG_AUDIO_PLAYBACK
+    fake_i2s_set_play(play);
+    if (sim.playback && sim.out_gap_ms > 0) {
+        sim_schedule((int64_t)(sim.out_gap_period_s * SIM_NS_PER_S), out_gap, NULL);
+    }
+#endif
+
+    telemetry_snapshot_t t;
+    int64_t end = (int64_t)(sim.minutes * 60 * SIM_NS_PER_S);
+    int64_t step = (int64_t)(sim.report_s * SIM_NS_PER_S);
+    for (int64_t now = 0; now < end;) {
+        now = now + step < end ? now + step : end;
+        sim_run_until(now);
+        telemetry_get_snapshot(&t);
+        report(&t);
+    }
+
+    double seconds = end / (double)SIM_NS_PER_S;
+    printf("\n%.1f s at %lu Hz, %u-byte samples, host %+.1f ppm, I2S %.3f Hz\n",
+        seconds, (unsigned long)sim.sample_rate, (unsigned)sim.bytes_per_sample, sim.usb_ppm, fake_i2s_rate(0));
+    printf("  packets %llu (%llu bad), blocks %lu, short reads %lu, latency %lu..%lu us\n",
+        (unsigned long long)sim.packets, (unsigned long long)sim.bad_packets, (unsigned long)t.blocks,
+        (unsigned long)t.short_reads, (unsigned long)t.latency_min_us, (unsigned long)t.latency_max_us);
+    const bool checked = CHECK_SAMPLES && sim.bytes_per_sample >= 3;
+    if (checked) {
+        printf("  frames %llu, silent %llu, glitches %llu (%llu frames), format switches %lu, stops %lu\n",
+            (unsigned long long)sim.in.frames, (unsigned long long)sim.in.silent_frames,
+            (unsigned long long)sim.in.glitches, (unsigned long long)sim.in.glitch_frames,
+            (unsigned long)sim.format_switches, (unsigned long)sim.stops);
+    }
+    printf("  underruns %lu, overruns %lu, dma overflows %lu, gaps %lu, recoveries %lu, resyncs %lu, cdc %llu bytes\n",
+        (unsigned long)t.underruns, (unsigned long)t.overruns, (unsigned long)t.dma_overflows, (unsigned long)t.gaps,
+        (unsigned long)t.recoveries, (unsigned long)t.resyncs, (unsigned long long)sim.cdc_bytes);
+    if (sim.playback) {
+        printf("  playback: blocks %lu, concealed %lu, underruns %lu, overruns %lu, host gaps %lu\n",
+            (unsigned long)t.playback_blocks, (unsigned long)t.playback_concealed,
+            (unsigned long)t.playback_underruns, (unsigned long)t.playback_overruns, (unsigned long)sim.out_gaps);
+    }
+    if (sim.playback && checked) {
+        printf("  played frames %llu, silent %llu, glitches %llu (%llu frames), starts %lu, delay %lu..%lu frames\n",
+            (unsigned long long)sim.play.frames, (unsigned long long)sim.play.silent_frames,
+            (unsigned long long)sim.play.glitches, (unsigned long long)sim.play.glitch_frames,
+            (unsigned long)sim.play_starts, (unsigned long)sim.play_delay_min, (unsigned long)sim.play_delay_max);
+    }
+
+    printf("CPU time:\n");
+    sim_task_info_t tasks[32];
+    size_t num_tasks = sim_task_info(tasks, sizeof(tasks) / sizeof(tasks[0]));
+    for (size_t i = 0; i < num_tasks; i++) {
+        print_cost(tasks[i].name, &tasks[i].cost, seconds);
+    }
+    print_cost("I2S DMA events", fake_i2s_cost(), seconds);
+    print_cost("USB frames", fake_usb_cost(), seconds);
+
+    bool clean = sim.bad_packets == 0 && sim.in.glitches == 0 && sim.in.locked == checked
+        && t.underruns == 0 && t.overruns == 0 && t.dma_overflows == 0 && t.gaps == 0
+        && (sim.switch_period_s == 0 || sim.format_switches > 0) && (sim.stop_ms == 0 || sim.stops > 0);
+
+    /*
+     * Every start of playback has the same frames queued, but which host
+     * packet is the newest by the time the first of them plays depends on
+     * where the start falls between two packets.
+     */
+    uint32_t frames_per_packet = (sim.sample_rate + 999) / 1000;
+    bool playback_clean = !sim.playback
+        || (t.playback_overruns == 0 && sim.play.glitches == 0 && sim.play.locked == checked
+            && (!checked || (sim.play_starts == t.playback_underruns + 1 && sim.play_delay_max - sim.play_delay_min <= frames_per_packet)));
+
+    bool pass;
+    switch (sim.expect) {
+    case EXPECT_CLEAN:
+        pass = clean && playback_clean && t.playback_underruns == 0;
+        break;
+    case EXPECT_UNDERRUNS:
+        pass = sim.bad_packets == 0 && t.underruns > 0;
+        break;
+    default:
+        /* The last gap may still be running when the simulation ends */
+        pass = clean && playback_clean && sim.out_gaps > 0 && t.playback_underruns + 1 >= sim.out_gaps
+            && t.playback_underruns <= sim.out_gaps;
+        break;
+    }
+    printf("%s\n", pass ? "PASS" : "FAIL");
+    return pass ? 0 : 1;
+}
@@ -0,0 +1,55 @@
+/**
+ * @file test.h
+ * @author your name (you@domain.com)
+ * @brief Minimal assertions for the host unit tests
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * A failed check reports itself and the test carries on, so one run shows
+ * every failure. main() runs each case with RUN_TEST() and returns
+ * TEST_RESULT() to ctest.
+ */
+#pragma once
+
+#include <math.h>
+#include <stdio.h>
+
+static int test_failures = 0;
+
+#define TEST_CHECK(cond)                                                      \
+    do {                                                                      \
+        if (!(cond)) {                                                        \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);   \
+            test_failures++;                                                  \
+        }                                                                     \
+    } while (0)
+
+#define TEST_CHECK_EQ(actual, expected)                                                         \
+    do {                                                                                        \
+        long long a_ = (long long)(actual), e_ = (long long)(expected);                         \
+        if (a_ != e_) {                                                                         \
+            printf("%s:%d: %s is %lld, expected %lld\n", __FILE__, __LINE__, #actual, a_, e_);  \
+            test_failures++;                                                                    \
+        }                                                                                       \
+    } while (0)
+
+#define TEST_CHECK_NEAR(actual, expected, tolerance)                                              \
+    do {                                                                                          \
+        double a_ = (actual), e_ = (expected);                                                    \
+        if (!(fabs(a_ - e_) <= (tolerance))) {                                                    \
+            printf("%s:%d: %s is %g, expected %g +- %g\n", __FILE__, __LINE__, #actual, a_, e_,   \
+                (double)(tolerance));                                                             \
+            test_failures++;                                                                      \
+        }                                                                                         \
+    } while (0)
+
+#define RUN_TEST(fn)                                   \
+    do {                                               \
+        int before_ = test_failures;                   \
+        fn();                                          \
+        printf("%-40s %s\n", #fn, test_failures == before_ ? "ok" : "FAILED"); \
+    } while (0)
+
+#define TEST_RESULT() (test_failures == 0 ? 0 : 1)
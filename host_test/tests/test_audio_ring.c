@@ -0,0 +1,350 @@
+/**
+ * @file test_audio_ring.c
+ * @author your name (you@domain.com)
+ * @brief Wrap-around, partial transfer and concurrency tests of the audio ring
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * The benchmark at the end runs the same transfers through the FreeRTOS
+ * stream buffer the ring replaced, the way the capture path used it: sent
+ * from the ISR and received without waiting.
+ */
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "audio_pipeline/audio_ring.h"
+#include "freertos/stream_buffer.h"
+#include "test.h"
+
+#define STRESS_BYTES (4 * 1024 * 1024)
+#define BENCH_ROUNDS 200000
+#define BENCH_BLOCK_BYTES 2560 // One DMA block of 320 stereo frames
+#define BENCH_PACKET_BYTES 384 // One 1 ms packet at 48 kHz stereo
+
+static void fill_pattern(uint8_t* data, size_t len, uint32_t start)
+{
+    for (size_t i = 0; i < len; i++) {
+        data[i] = (uint8_t)((start + i) * 7);
+    }
+}
+
+static bool check_pattern(const uint8_t* data, size_t len, uint32_t start)
+{
+    for (size_t i = 0; i < len; i++) {
+        if (data[i] != (uint8_t)((start + i) * 7)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void init_at(audio_ring_t* ring, size_t capacity, size_t start)
+{
+    TEST_CHECK_EQ(audio_ring_init(ring, capacity, "test"), ESP_OK);
+    atomic_store(&ring->head, start);
+    atomic_store(&ring->tail, start);
+}
+
+static void test_capacity_rounds_up(void)
+{
+    audio_ring_t ring;
+
+    TEST_CHECK_EQ(audio_ring_init(&ring, 100, "test"), ESP_OK);
+    TEST_CHECK_EQ(ring.capacity, 128);
+    TEST_CHECK_EQ(ring.mask, 127);
+    TEST_CHECK_EQ(audio_ring_fill(&ring), 0);
+    TEST_CHECK_EQ(audio_ring_free(&ring), 128);
+    TEST_CHECK_EQ((uintptr_t)ring.buffer % AUDIO_RING_CACHE_LINE, 0);
+}
+
+static void test_partial_write_when_full(void)
+{
+    audio_ring_t ring;
+    uint8_t data[100];
+
+    init_at(&ring, 64, 0);
+    fill_pattern(data, sizeof(data), 0);
+
+    TEST_CHECK_EQ(audio_ring_write(&ring, data, 40), 40);
+    TEST_CHECK_EQ(audio_ring_write(&ring, data + 40, 60), 24);
+    TEST_CHECK_EQ(audio_ring_fill(&ring), 64);
+    TEST_CHECK_EQ(audio_ring_free(&ring), 0);
+    TEST_CHECK_EQ(audio_ring_write(&ring, data, 1), 0);
+
+    uint8_t out[100];
+    TEST_CHECK_EQ(audio_ring_read(&ring, out, sizeof(out)), 64);
+    TEST_CHECK(check_pattern(out, 64, 0));
+}
+
+static void test_partial_read_when_short(void)
+{
+    audio_ring_t ring;
+    uint8_t data[16];
+    uint8_t out[32];
+
+    init_at(&ring, 64, 0);
+    fill_pattern(data, sizeof(data), 5);
+    audio_ring_write(&ring, data, sizeof(data));
+
+    TEST_CHECK_EQ(audio_ring_read(&ring, out, sizeof(out)), 16);
+    TEST_CHECK(check_pattern(out, 16, 5));
+    TEST_CHECK_EQ(audio_ring_read(&ring, out, sizeof(out)), 0);
+    TEST_CHECK_EQ(audio_ring_fill(&ring), 0);
+}
+
+static void test_wrap_at_every_offset(void)
+{
+    uint8_t data[48];
+    uint8_t out[48];
+
+    fill_pattern(data, sizeof(data), 11);
+    for (size_t start = 0; start < 64; start++) {
+        audio_ring_t ring;
+        init_at(&ring, 64, start);
+
+        TEST_CHECK_EQ(audio_ring_write(&ring, data, sizeof(data)), sizeof(data));
+        memset(out, 0, sizeof(out));
+        TEST_CHECK_EQ(audio_ring_read(&ring, out, sizeof(out)), sizeof(out));
+        TEST_CHECK(check_pattern(out, sizeof(out), 11));
+    }
+}
+
+static void test_peek_stops_at_wrap(void)
+{
+    audio_ring_t ring;
+    uint8_t data[32];
+    const uint8_t* peeked;
+
+    init_at(&ring, 64, 48);
+    fill_pattern(data, sizeof(data), 3);
+    audio_ring_write(&ring, data, sizeof(data));
+
+    size_t first = audio_ring_peek(&ring, &peeked, sizeof(data));
+    TEST_CHECK_EQ(first, 16);
+    TEST_CHECK(check_pattern(peeked, first, 3));
+    audio_ring_consume(&ring, first);
+
+    size_t second = audio_ring_peek(&ring, &peeked, sizeof(data));
+    TEST_CHECK_EQ(second, 16);
+    TEST_CHECK(peeked == ring.buffer);
+    TEST_CHECK(check_pattern(peeked, second, 3 + 16));
+    audio_ring_consume(&ring, second);
+
+    TEST_CHECK_EQ(audio_ring_peek(&ring, &peeked, sizeof(data)), 0);
+}
+
+static void test_counters_wrap_around(void)
+{
+    audio_ring_t ring;
+    uint8_t data[40];
+    uint8_t out[40];
+
+    /* The free-running counters overflow in the middle of the transfer */
+    init_at(&ring, 64, SIZE_MAX - 20);
+    fill_pattern(data, sizeof(data), 1);
+
+    TEST_CHECK_EQ(audio_ring_write(&ring, data, sizeof(data)), sizeof(data));
+    TEST_CHECK_EQ(audio_ring_fill(&ring), sizeof(data));
+    TEST_CHECK_EQ(audio_ring_free(&ring), 64 - sizeof(data));
+    TEST_CHECK_EQ(audio_ring_read(&ring, out, sizeof(out)), sizeof(out));
+    TEST_CHECK(check_pattern(out, sizeof(out), 1));
+    TEST_CHECK_EQ(audio_ring_fill(&ring), 0);
+}
+
+static void test_flush(void)
+{
+    audio_ring_t ring;
+    uint8_t data[24] = { 0 };
+
+    init_at(&ring, 64, 0);
+    audio_ring_write(&ring, data, sizeof(data));
+    audio_ring_flush(&ring);
+    TEST_CHECK_EQ(audio_ring_fill(&ring), 0);
+    TEST_CHECK_EQ(audio_ring_free(&ring), 64);
+}
+
+typedef struct {
+    audio_ring_t* ring;
+    bool ok;
+} stress_ctx_t;
+
+static void* stress_producer(void* arg)
+{
+    stress_ctx_t* stress = arg;
+    uint8_t chunk[700];
+    uint32_t written = 0;
+    uint32_t seed = 1;
+
+    while (written < STRESS_BYTES) {
+        seed = seed * 1103515245 + 12345;
+        size_t len = 1 + (seed >> 16) % sizeof(chunk);
+        if (len > STRESS_BYTES - written) {
+            len = STRESS_BYTES - written;
+        }
+        fill_pattern(chunk, len, written);
+        size_t put = audio_ring_write(stress->ring, chunk, len);
+        if (put < len) {
+            sched_yield(); // Let the consumer run when there is only one CPU
+        }
+        written += put;
+    }
+    return NULL;
+}
+
+static void* stress_consumer(void* arg)
+{
+    stress_ctx_t* stress = arg;
+    uint8_t chunk[500];
+    uint32_t read = 0;
+    uint32_t seed = 7;
+
+    stress->ok = true;
+    while (read < STRESS_BYTES) {
+        seed = seed * 1103515245 + 12345;
+        size_t len = 1 + (seed >> 16) % sizeof(chunk);
+        size_t got = audio_ring_read(stress->ring, chunk, len);
+        if (!check_pattern(chunk, got, read)) {
+            stress->ok = false;
+            return NULL;
+        }
+        if (got < len) {
+            sched_yield();
+        }
+        read += got;
+    }
+    return NULL;
+}
+
+/**
+ * @brief A producer and a consumer thread with unrelated chunk sizes see the byte stream intact
+ *
+ */
+static void test_concurrent_producer_consumer(void)
+{
+    audio_ring_t ring;
+    stress_ctx_t stress = { .ring = &ring };
+    pthread_t producer;
+    pthread_t consumer;
+
+    init_at(&ring, 4096, 0);
+    pthread_create(&consumer, NULL, stress_consumer, &stress);
+    pthread_create(&producer, NULL, stress_producer, &stress);
+    pthread_join(producer, NULL);
+    pthread_join(consumer, NULL);
+
+    TEST_CHECK(stress.ok);
+    TEST_CHECK_EQ(audio_ring_fill(&ring), 0);
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+typedef struct {
+    const char* name;
+    size_t (*write)(void* buffer, const void* data, size_t len);
+    size_t (*read)(void* buffer, void* data, size_t len);
+    size_t (*fill)(void* buffer);
+} bench_buffer_t;
+
+static size_t ring_write(void* buffer, const void* data, size_t len)
+{
+    return audio_ring_write(buffer, data, len);
+}
+
+static size_t ring_read(void* buffer, void* data, size_t len)
+{
+    return audio_ring_read(buffer, data, len);
+}
+
+static size_t ring_fill(void* buffer)
+{
+    return audio_ring_fill(buffer);
+}
+
+static size_t stream_write(void* buffer, const void* data, size_t len)
+{
+    BaseType_t woken = pdFALSE;
+    return xStreamBufferSendFromISR(buffer, data, len, &woken);
+}
+
+static size_t stream_read(void* buffer, void* data, size_t len)
+{
+    return xStreamBufferReceive(buffer, data, len, 0);
+}
+
+static size_t stream_fill(void* buffer)
+{
+    return xStreamBufferBytesAvailable(buffer);
+}
+
+static void bench(const bench_buffer_t* ops, void* buffer)
+{
+    static uint8_t block[BENCH_BLOCK_BYTES];
+    static uint8_t packet[BENCH_PACKET_BYTES];
+    uint64_t write_total = 0, write_max = 0;
+    uint64_t read_total = 0, read_max = 0;
+    uint64_t reads = 0;
+
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        uint64_t start = now_ns();
+        size_t written = ops->write(buffer, block, sizeof(block));
+        uint64_t ns = now_ns() - start;
+        TEST_CHECK_EQ(written, sizeof(block));
+        write_total += ns;
+        write_max = ns > write_max ? ns : write_max;
+
+        while (ops->fill(buffer) >= sizeof(packet)) {
+            start = now_ns();
+            ops->read(buffer, packet, sizeof(packet));
+            ns = now_ns() - start;
+            read_total += ns;
+            read_max = ns > read_max ? ns : read_max;
+            reads++;
+        }
+    }
+    printf("  %-13s block write %.1f ns avg, %llu ns max; packet read %.1f ns avg, %llu ns max\n", ops->name,
+        (double)write_total / BENCH_ROUNDS, (unsigned long long)write_max,
+        (double)read_total / reads, (unsigned long long)read_max);
+}
+
+/**
+ * @brief Cost and jitter of one block write and one packet read, as the I2S and USB sides see them
+ *
+ */
+static void bench_block_write_packet_read(void)
+{
+    static const bench_buffer_t ring_ops = { "audio ring", ring_write, ring_read, ring_fill };
+    static const bench_buffer_t stream_ops = { "stream buffer", stream_write, stream_read, stream_fill };
+    audio_ring_t ring;
+
+    init_at(&ring, 16384, 0);
+    bench(&ring_ops, &ring);
+
+    StreamBufferHandle_t stream = xStreamBufferCreate(16384, BENCH_PACKET_BYTES);
+    TEST_CHECK(stream != NULL);
+    bench(&stream_ops, stream);
+    vStreamBufferDelete(stream);
+}
+
+int main(void)
+{
+    RUN_TEST(test_capacity_rounds_up);
+    RUN_TEST(test_partial_write_when_full);
+    RUN_TEST(test_partial_read_when_short);
+    RUN_TEST(test_wrap_at_every_offset);
+    RUN_TEST(test_peek_stops_at_wrap);
+    RUN_TEST(test_counters_wrap_around);
+    RUN_TEST(test_flush);
+    RUN_TEST(test_concurrent_producer_consumer);
+    RUN_TEST(bench_block_write_packet_read);
+    return TEST_RESULT();
+}
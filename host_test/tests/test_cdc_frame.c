@@ -0,0 +1,307 @@
+/**
+ * @file test_cdc_frame.c
+ * @author your name (you@domain.com)
+ * @brief Split-packet, resynchronisation and fuzz tests of the CDC frame parser
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * Built with the address and undefined-behaviour sanitizers, so the fuzz
+ * cases also catch any out-of-bounds access on hostile input.
+ */
+#include <stdbool.h>
+#include <string.h>
+
+#include "test.h"
+#include "usb/cdc_frame.h"
+
+#define USB_PACKET_BYTES 64
+#define MAX_FRAMES 64
+#define FUZZ_ROUNDS 2000
+
+typedef struct {
+    cdc_frame_t frames[MAX_FRAMES];
+    uint8_t payloads[MAX_FRAMES][CDC_FRAME_MAX_PAYLOAD];
+    size_t count;
+} received_t;
+
+static received_t received;
+
+static uint32_t rng_state = 1;
+
+static uint32_t rng(void)
+{
+    rng_state = rng_state * 1664525 + 1013904223;
+    return rng_state >> 8;
+}
+
+static void on_frame(const cdc_frame_t* frame, void* arg)
+{
+    received_t* r = arg;
+    if (r->count < MAX_FRAMES) {
+        memcpy(r->payloads[r->count], frame->payload, frame->len);
+        r->frames[r->count] = *frame;
+        r->frames[r->count].payload = r->payloads[r->count];
+        r->count++;
+    }
+}
+
+static bool same_frame(const cdc_frame_t* frame, uint8_t type, uint8_t seq, const uint8_t* payload, size_t len)
+{
+    return frame->type == type && frame->seq == seq && frame->len == len && memcmp(frame->payload, payload, len) == 0;
+}
+
+/**
+ * @brief Three frames of different lengths back to back, and what they carry
+ *
+ */
+typedef struct {
+    uint8_t bytes[3 * CDC_FRAME_MAX_SIZE];
+    size_t size;
+    uint8_t payload[CDC_FRAME_MAX_PAYLOAD];
+    size_t lens[3];
+} stream_t;
+
+static void build_stream(stream_t* s, size_t len0, size_t len1, size_t len2)
+{
+    s->size = 0;
+    s->lens[0] = len0;
+    s->lens[1] = len1;
+    s->lens[2] = len2;
+    for (size_t i = 0; i < sizeof(s->payload); i++) {
+        s->payload[i] = (uint8_t)(i * 31 + 7);
+    }
+    for (int f = 0; f < 3; f++) {
+        s->size += cdc_frame_encode(0x10 + f, f, s->payload, s->lens[f], s->bytes + s->size, sizeof(s->bytes) - s->size);
+    }
+}
+
+static void check_stream_received(const stream_t* s)
+{
+    TEST_CHECK_EQ(received.count, 3);
+    for (int f = 0; f < 3 && f < (int)received.count; f++) {
+        TEST_CHECK(same_frame(&received.frames[f], 0x10 + f, f, s->payload, s->lens[f]));
+    }
+}
+
+static void test_crc_check_value(void)
+{
+    TEST_CHECK_EQ(cdc_frame_crc16(0xFFFF, (const uint8_t*)"123456789", 9), 0x29B1);
+}
+
+static void test_encode_limits(void)
+{
+    static uint8_t payload[CDC_FRAME_MAX_PAYLOAD + 1];
+    static uint8_t out[CDC_FRAME_MAX_SIZE + 1];
+
+    TEST_CHECK_EQ(cdc_frame_encode(1, 0, payload, CDC_FRAME_MAX_PAYLOAD, out, sizeof(out)), CDC_FRAME_MAX_SIZE);
+    TEST_CHECK_EQ(cdc_frame_encode(1, 0, payload, CDC_FRAME_MAX_PAYLOAD + 1, out, sizeof(out)), 0);
+    TEST_CHECK_EQ(cdc_frame_encode(1, 0, payload, 10, out, 10 + CDC_FRAME_HEADER_SIZE + CDC_FRAME_CRC_SIZE - 1), 0);
+}
+
+/**
+ * @brief Frames split between two calls at every possible position
+ *
+ */
+static void test_split_at_every_byte(void)
+{
+    static stream_t s;
+    cdc_frame_parser_t parser = { 0 };
+
+    build_stream(&s, 0, 1, 70);
+    for (size_t split = 0; split <= s.size; split++) {
+        received.count = 0;
+        cdc_frame_parser_reset(&parser);
+        cdc_frame_parse(&parser, s.bytes, split, on_frame, &received);
+        cdc_frame_parse(&parser, s.bytes + split, s.size - split, on_frame, &received);
+        check_stream_received(&s);
+    }
+}
+
+/**
+ * @brief Frames delivered one byte at a time and in 64-byte USB packets, incl. a maximum-size frame
+ *
+ */
+static void test_byte_and_packet_chunks(void)
+{
+    static stream_t s;
+    cdc_frame_parser_t parser = { 0 };
+
+    build_stream(&s, CDC_FRAME_MAX_PAYLOAD, 63, 64);
+
+    received.count = 0;
+    cdc_frame_parser_reset(&parser);
+    for (size_t i = 0; i < s.size; i++) {
+        cdc_frame_parse(&parser, s.bytes + i, 1, on_frame, &received);
+    }
+    check_stream_received(&s);
+
+    received.count = 0;
+    cdc_frame_parser_reset(&parser);
+    for (size_t i = 0; i < s.size; i += USB_PACKET_BYTES) {
+        size_t n = s.size - i < USB_PACKET_BYTES ? s.size - i : USB_PACKET_BYTES;
+        cdc_frame_parse(&parser, s.bytes + i, n, on_frame, &received);
+    }
+    check_stream_received(&s);
+}
+
+static void test_garbage_before_frame(void)
+{
+    static stream_t s;
+    cdc_frame_parser_t parser = { 0 };
+    static const uint8_t garbage[] = { 0x00, 0x12, 0xFF, 0x5A, 0x33 };
+
+    build_stream(&s, 4, 5, 6);
+    received.count = 0;
+    cdc_frame_parser_reset(&parser);
+    cdc_frame_parse(&parser, garbage, sizeof(garbage), on_frame, &received);
+    cdc_frame_parse(&parser, s.bytes, s.size, on_frame, &received);
+    check_stream_received(&s);
+    TEST_CHECK_EQ(parser.dropped_bytes, sizeof(garbage));
+}
+
+static void test_crc_error_is_dropped(void)
+{
+    static stream_t s;
+    cdc_frame_parser_t parser = { 0 };
+
+    build_stream(&s, 8, 8, 8);
+    s.bytes[CDC_FRAME_HEADER_SIZE + 3] ^= 0x01; // Payload of the first frame
+
+    received.count = 0;
+    cdc_frame_parser_reset(&parser);
+    cdc_frame_parse(&parser, s.bytes, s.size, on_frame, &received);
+    TEST_CHECK_EQ(parser.crc_errors, 1);
+    TEST_CHECK_EQ(received.count, 2);
+    if (received.count == 2) {
+        TEST_CHECK(same_frame(&received.frames[0], 0x11, 1, s.payload, 8));
+        TEST_CHECK(same_frame(&received.frames[1], 0x12, 2, s.payload, 8));
+    }
+}
+
+static void test_oversized_frame_is_rejected(void)
+{
+    static stream_t s;
+    cdc_frame_parser_t parser = { 0 };
+    const uint8_t oversized[] = { CDC_FRAME_SOF, 0x01, 0x00, (CDC_FRAME_MAX_PAYLOAD + 1) & 0xFF, (CDC_FRAME_MAX_PAYLOAD + 1) >> 8 };
+
+    build_stream(&s, 2, 3, 4);
+    received.count = 0;
+    cdc_frame_parser_reset(&parser);
+    cdc_frame_parse(&parser, oversized, sizeof(oversized), on_frame, &received);
+    cdc_frame_parse(&parser, s.bytes, s.size, on_frame, &received);
+    TEST_CHECK_EQ(parser.length_errors, 1);
+    check_stream_received(&s);
+}
+
+/**
+ * @brief A reset drops a half-received frame, as when the port is reopened
+ *
+ */
+static void test_reset_drops_partial_frame(void)
+{
+    static stream_t s;
+    cdc_frame_parser_t parser = { 0 };
+
+    build_stream(&s, 20, 20, 20);
+    received.count = 0;
+    cdc_frame_parser_reset(&parser);
+    cdc_frame_parse(&parser, s.bytes, 10, on_frame, &received);
+    cdc_frame_parser_reset(&parser);
+    cdc_frame_parse(&parser, s.bytes, s.size, on_frame, &received);
+    check_stream_received(&s);
+}
+
+/**
+ * @brief Random bytes in random chunks: nothing is delivered unless its CRC holds
+ *
+ */
+static void fuzz_random_bytes(void)
+{
+    static uint8_t data[4096];
+    cdc_frame_parser_t parser = { 0 };
+    size_t total = 0;
+
+    cdc_frame_parser_reset(&parser);
+    for (int round = 0; round < FUZZ_ROUNDS; round++) {
+        size_t len = rng() % sizeof(data);
+        for (size_t i = 0; i < len; i++) {
+            /* Plenty of start-of-frame bytes and short lengths, so the parser gets past the header */
+            uint32_t r = rng();
+            data[i] = r % 4 == 0 ? CDC_FRAME_SOF : r % 4 == 1 ? (uint8_t)(r >> 8) % 8 : (uint8_t)(r >> 8);
+        }
+        received.count = 0;
+        cdc_frame_parse(&parser, data, len, on_frame, &received);
+        total += len;
+
+        for (size_t f = 0; f < received.count; f++) {
+            TEST_CHECK(received.frames[f].len <= CDC_FRAME_MAX_PAYLOAD);
+        }
+        TEST_CHECK(parser.state <= CDC_PARSE_CRC);
+    }
+    printf("  %zu random bytes: %lu frames, %lu crc errors, %lu length errors, %lu bytes skipped\n", total,
+        (unsigned long)parser.frames, (unsigned long)parser.crc_errors, (unsigned long)parser.length_errors,
+        (unsigned long)parser.dropped_bytes);
+}
+
+/**
+ * @brief Valid frames with random bit errors: every delivered frame is one that was sent
+ *
+ */
+static void fuzz_bit_errors(void)
+{
+    static stream_t s;
+    cdc_frame_parser_t parser = { 0 };
+    uint32_t delivered = 0;
+    uint32_t intact = 0;
+
+    for (int round = 0; round < FUZZ_ROUNDS; round++) {
+        build_stream(&s, rng() % 40, rng() % 40, rng() % 40);
+        bool corrupted = rng() % 2 == 0;
+        if (corrupted) {
+            size_t bit = rng() % (s.size * 8);
+            s.bytes[bit / 8] ^= 1 << (bit % 8);
+        } else {
+            intact++;
+        }
+
+        received.count = 0;
+        for (size_t i = 0; i < s.size;) {
+            size_t n = 1 + rng() % USB_PACKET_BYTES;
+            n = n < s.size - i ? n : s.size - i;
+            cdc_frame_parse(&parser, s.bytes + i, n, on_frame, &received);
+            i += n;
+        }
+        for (size_t f = 0; f < received.count; f++) {
+            const cdc_frame_t* frame = &received.frames[f];
+            int index = frame->type - 0x10;
+            TEST_CHECK(index >= 0 && index < 3 && frame->seq == index);
+            if (index >= 0 && index < 3) {
+                TEST_CHECK(same_frame(frame, 0x10 + index, index, s.payload, s.lens[index]));
+            }
+        }
+        delivered += received.count;
+
+        /* Whatever the corruption left half-parsed, the next session starts clean */
+        cdc_frame_parser_reset(&parser);
+    }
+    printf("  %d streams, %lu intact: %lu frames delivered, %lu crc errors\n", FUZZ_ROUNDS, (unsigned long)intact,
+        (unsigned long)delivered, (unsigned long)parser.crc_errors);
+    TEST_CHECK(delivered >= 3 * intact);
+}
+
+int main(void)
+{
+    RUN_TEST(test_crc_check_value);
+    RUN_TEST(test_encode_limits);
+    RUN_TEST(test_split_at_every_byte);
+    RUN_TEST(test_byte_and_packet_chunks);
+    RUN_TEST(test_garbage_before_frame);
+    RUN_TEST(test_crc_error_is_dropped);
+    RUN_TEST(test_oversized_frame_is_rejected);
+    RUN_TEST(test_reset_drops_partial_frame);
+    RUN_TEST(fuzz_random_bytes);
+    RUN_TEST(fuzz_bit_errors);
+    return TEST_RESULT();
+}
@@ -0,0 +1,187 @@
+/**
+ * @file test_clock_steer.c
+ * @author your name (you@domain.com)
+ * @brief Convergence and jitter of the clock steering loop against a model of the ring
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * The model steps once per USB frame: the host takes 48 frames, and the I2S
+ * clock, off by its crystal error plus the applied trim, completes a DMA
+ * block of 320 frames whenever enough time has passed. The loop sees the
+ * fill level after each packet, as it does on the device.
+ *
+ * The fill only changes in whole blocks, so each control period's average
+ * moves by a few frames depending on where the block arrivals fall, and
+ * the trim dithers by some ppm around the crystal error it cancels. The
+ * tests bound that jitter instead of expecting a constant trim.
+ */
+#include <math.h>
+
+#include "audio_pipeline/clock_steer.h"
+#include "esp_err.h"
+#include "sdkconfig.h"
+#include "test.h"
+
+#define RATE 48000
+#define FRAMES_PER_MS (RATE / 1000)
+#define BLOCK_FRAMES 320
+#define TARGET_FRAMES (40 * FRAMES_PER_MS)
+#define SETTLED_FRAMES 2.0 // Largest mean fill error over one second that counts as locked
+#define SETTLE_MAX_S 180
+#define TRIM_JITTER_MAX_PPM 20.0 // Standard deviation of the trim once locked
+
+typedef struct {
+    double crystal_ppm; // I2S clock error against the host
+    double trim_ppm; // Applied by the loop
+    double captured; // Frames the I2S clock has produced, incl. the block in progress
+    double fill; // Frames in the ring
+} plant_t;
+
+static plant_t plant;
+
+esp_err_t audio_source_trim_ppm(float ppm)
+{
+    plant.trim_ppm = ppm;
+    return ESP_OK;
+}
+
+void audio_pipeline_set_src_trim_ppm(float ppm)
+{
+    plant.trim_ppm = ppm;
+}
+
+typedef struct {
+    double settle_s; // First second after which the mean error stayed below SETTLED_FRAMES, -1 if never
+    double final_error; // Mean fill error over the last second
+    double trim_mean; // Over the last 10 s
+    double trim_jitter; // Standard deviation over the last 10 s
+    double fill_min; // Over the last 10 s, in frames
+    double fill_max;
+} run_result_t;
+
+static void start(double crystal_ppm, double fill)
+{
+    plant = (plant_t) { .crystal_ppm = crystal_ppm, .fill = fill };
+    clock_steer_reset(TARGET_FRAMES);
+}
+
+/**
+ * @brief Step the model and the loop for the given number of milliseconds
+ *
+ */
+static run_result_t run(int ms)
+{
+    run_result_t result = { .settle_s = -1, .fill_min = 1e9, .fill_max = -1e9 };
+    double second_error = 0;
+    double trim_sum = 0;
+    double trim_sq = 0;
+    int trim_count = 0;
+
+    for (int t = 1; t <= ms; t++) {
+        double before = floor(plant.captured / BLOCK_FRAMES);
+        plant.captured += FRAMES_PER_MS * (1.0 + (plant.crystal_ppm + plant.trim_ppm) * 1e-6);
+        plant.fill += (floor(plant.captured / BLOCK_FRAMES) - before) * BLOCK_FRAMES;
+        plant.fill -= FRAMES_PER_MS;
+
+        clock_steer_update((uint32_t)plant.fill);
+
+        second_error += plant.fill - TARGET_FRAMES;
+        if (t % 1000 == 0) {
+            double mean_error = second_error / 1000;
+            if (fabs(mean_error) >= SETTLED_FRAMES) {
+                result.settle_s = -1;
+            } else if (result.settle_s < 0) {
+                result.settle_s = t / 1000.0;
+            }
+            result.final_error = mean_error;
+            second_error = 0;
+        }
+        if (t > ms - 10000) {
+            trim_sum += plant.trim_ppm;
+            trim_sq += plant.trim_ppm * plant.trim_ppm;
+            trim_count++;
+            result.fill_min = fmin(result.fill_min, plant.fill);
+            result.fill_max = fmax(result.fill_max, plant.fill);
+        }
+    }
+    result.trim_mean = trim_sum / trim_count;
+    result.trim_jitter = sqrt(fmax(0, trim_sq / trim_count - result.trim_mean * result.trim_mean));
+    return result;
+}
+
+static void report(const char* name, const run_result_t* r)
+{
+    printf("  %-24s settled after %5.0f s, error %+6.2f frames, trim %+8.2f ppm (jitter %.3f), fill %.0f..%.0f\n",
+        name, r->settle_s, r->final_error, r->trim_mean, r->trim_jitter, r->fill_min, r->fill_max);
+}
+
+/**
+ * @brief A constant crystal error is cancelled exactly, and the fill returns to the target
+ *
+ */
+static void test_converges_on_crystal_error(void)
+{
+    static const double errors[] = { 100, -100, 250, -250 };
+
+    for (size_t i = 0; i < sizeof(errors) / sizeof(errors[0]); i++) {
+        start(errors[i], TARGET_FRAMES);
+        run_result_t r = run(300 * 1000);
+        char name[32];
+        snprintf(name, sizeof(name), "crystal %+.0f ppm", errors[i]);
+        report(name, &r);
+
+        TEST_CHECK(r.settle_s > 0 && r.settle_s < SETTLE_MAX_S);
+        TEST_CHECK_NEAR(r.final_error, 0, SETTLED_FRAMES);
+        TEST_CHECK_NEAR(r.trim_mean, -errors[i], 1.0);
+        TEST_CHECK(r.trim_jitter < TRIM_JITTER_MAX_PPM);
+    }
+}
+
+/**
+ * @brief Starting a block off target neither rings nor lets the ring run dry
+ *
+ */
+static void test_recovers_from_fill_offset(void)
+{
+    start(0, TARGET_FRAMES + 2 * BLOCK_FRAMES);
+    run_result_t r = run(300 * 1000);
+    report("fill +2 blocks", &r);
+    TEST_CHECK(r.settle_s > 0 && r.settle_s < SETTLE_MAX_S);
+    TEST_CHECK_NEAR(r.trim_mean, 0, 1.0);
+
+    start(0, TARGET_FRAMES - BLOCK_FRAMES);
+    double lowest = 1e9;
+    for (int s = 0; s < 300; s++) {
+        run(1000);
+        lowest = fmin(lowest, plant.fill);
+    }
+    TEST_CHECK(lowest > FRAMES_PER_MS);
+}
+
+/**
+ * @brief An error beyond the trim range saturates, and the loop recovers without windup once it is back in range
+ *
+ */
+static void test_saturation_and_recovery(void)
+{
+    start(2 * CONFIG_AUDIO_CLOCK_STEER_MAX_PPM, TARGET_FRAMES);
+    run(30 * 1000);
+    TEST_CHECK_NEAR(clock_steer_get_ppm(), -CONFIG_AUDIO_CLOCK_STEER_MAX_PPM, 0.01);
+
+    /* The ring has filled up meanwhile; drain back to the target from there */
+    plant.crystal_ppm = 100;
+    run_result_t r = run(600 * 1000);
+    report("after saturation", &r);
+    TEST_CHECK(r.settle_s > 0);
+    TEST_CHECK_NEAR(r.trim_mean, -100, 1.0);
+}
+
+int main(void)
+{
+    RUN_TEST(test_converges_on_crystal_error);
+    RUN_TEST(test_recovers_from_fill_offset);
+    RUN_TEST(test_saturation_and_recovery);
+    return TEST_RESULT();
+}
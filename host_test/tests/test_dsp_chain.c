@@ -0,0 +1,128 @@
+/**
+ * @file test_dsp_chain.c
+ * @author your name (you@domain.com)
+ * @brief Interleaving and channel mode kernels of the DSP chain against their definitions
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * Blocks of every length up to MAX_FRAMES go through the chain with their
+ * input and output aligned and not, in place and not. Built with
+ * PIE_SIMD_MODEL, the aligned stereo cases run the PIE kernels on the C
+ * model of the instructions.
+ */
+#include <string.h>
+
+#include "audio_pipeline/dsp_chain.h"
+#include "test.h"
+
+#define MAX_FRAMES 64
+#define MAX_TEST_CHANNELS 4
+
+static _Alignas(16) int32_t in[MAX_FRAMES * MAX_TEST_CHANNELS + 4];
+static _Alignas(16) int32_t out[MAX_FRAMES * MAX_TEST_CHANNELS + 4];
+static int32_t expected[MAX_FRAMES * MAX_TEST_CHANNELS];
+
+static uint32_t rng_state = 1;
+
+/* High bits only, the low bits of the LCG repeat with a short period */
+static uint32_t rng(void)
+{
+    rng_state = rng_state * 1664525 + 1013904223;
+    return rng_state >> 8;
+}
+
+static void fill_random(int32_t* samples, size_t count)
+{
+    static const int32_t extremes[] = { INT32_MIN, INT32_MAX, INT32_MIN + 1, INT32_MAX - 1, -1, 0, 1 };
+
+    for (size_t i = 0; i < count; i++) {
+        samples[i] = rng() % 8 == 0 ? extremes[rng() % 7] : (int32_t)(rng() << 8);
+    }
+}
+
+static void expect(dsp_channel_mode_t mode, const int32_t* x, size_t channels, size_t frames)
+{
+    for (size_t i = 0; i < frames; i++) {
+        const int32_t* f = &x[i * channels];
+        int32_t* e = &expected[i * channels];
+        memcpy(e, f, channels * sizeof(int32_t));
+        if (mode == DSP_CHANNEL_SWAP) {
+            e[0] = f[1];
+            e[1] = f[0];
+        } else if (mode == DSP_CHANNEL_MONO) {
+            e[0] = e[1] = (int32_t)(((int64_t)f[0] + f[1]) >> 1);
+        }
+    }
+}
+
+/**
+ * @brief Run one channel mode over every length, alignment and in-place combination
+ *
+ * @return number of blocks whose output differs from the definition
+ */
+static size_t check_mode(dsp_channel_mode_t mode, size_t channels)
+{
+    dsp_chain_t chain;
+    size_t failures = 0;
+
+    TEST_CHECK_EQ(dsp_chain_init(&chain, channels, MAX_FRAMES, 48000), ESP_OK);
+    TEST_CHECK_EQ(dsp_chain_add_channel_mode(&chain, mode), ESP_OK);
+
+    for (size_t frames = 1; frames <= MAX_FRAMES; frames++) {
+        const size_t samples = frames * channels;
+        for (size_t offset = 0; offset < 4; offset++) {
+            int32_t* x = in + offset;
+            int32_t* y = out + (offset + 1) % 4;
+
+            fill_random(x, samples);
+            expect(mode, x, channels, frames);
+            y[samples] = 0x5A5A5A5A;
+            dsp_chain_process(&chain, x, y, frames);
+            failures += memcmp(y, expected, samples * sizeof(int32_t)) != 0 || y[samples] != 0x5A5A5A5A;
+
+            dsp_chain_process(&chain, x, x, frames);
+            failures += memcmp(x, expected, samples * sizeof(int32_t)) != 0;
+        }
+    }
+    return failures;
+}
+
+static void test_stereo_pass_through(void)
+{
+    TEST_CHECK_EQ(check_mode(DSP_CHANNEL_STEREO, 2), 0);
+}
+
+static void test_swap(void)
+{
+    TEST_CHECK_EQ(check_mode(DSP_CHANNEL_SWAP, 2), 0);
+}
+
+/**
+ * @brief The mono mix is the floor of the mean, full scale included
+ *
+ */
+static void test_mono_matches_definition(void)
+{
+    TEST_CHECK_EQ(check_mode(DSP_CHANNEL_MONO, 2), 0);
+}
+
+/**
+ * @brief With more than two channels only the first two are mixed, the rest pass through
+ *
+ */
+static void test_mono_four_channels(void)
+{
+    TEST_CHECK_EQ(check_mode(DSP_CHANNEL_MONO, 4), 0);
+    TEST_CHECK_EQ(check_mode(DSP_CHANNEL_STEREO, 3), 0);
+}
+
+int main(void)
+{
+    RUN_TEST(test_stereo_pass_through);
+    RUN_TEST(test_swap);
+    RUN_TEST(test_mono_matches_definition);
+    RUN_TEST(test_mono_four_channels);
+    return TEST_RESULT();
+}
@@ -0,0 +1,422 @@
+/**
+ * @file test_level_meter.c
+ * @author your name (you@domain.com)
+ * @brief Known-signal vectors for the peak, RMS, hold and clip meters
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * Signals are fed in DMA-sized blocks, and each measurement covers whole RMS
+ * windows, so every reading below is of one known signal.
+ *
+ * Built with PIE_SIMD_MODEL, the aligned blocks run the PIE kernel on the C
+ * model of the instructions, and random blocks check it against the scalar
+ * definition of every reading.
+ */
+#include <math.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+
+#include "audio_pipeline/level_meter.h"
+#include "test.h"
+
+#define BLOCK_FRAMES 320
+#define WINDOW_FRAMES (SAMPLE_RATE / 1000 * LEVEL_METER_WINDOW_MS)
+#define HOLD_FRAMES (SAMPLE_RATE / 1000 * LEVEL_METER_HOLD_MS)
+#define SINE_HZ 1000.0 // A whole number of periods per window
+#define DB_TOLERANCE_X10 1 // Tenths of a dB
+#define CONCURRENT_WINDOWS 2000
+
+_Static_assert(WINDOW_FRAMES % BLOCK_FRAMES == 0, "the tests feed whole windows of whole blocks");
+
+typedef enum {
+    SIGNAL_SILENCE,
+    SIGNAL_SINE,
+    SIGNAL_SQUARE, // +-amplitude, alternating every sample
+    SIGNAL_DC,
+} signal_t;
+
+typedef struct {
+    signal_t signal;
+    double amplitude[NUM_CHANNELS]; // Linear, 1.0 is INT32_MAX
+} channel_signal_t;
+
+static _Alignas(16) int32_t block[BLOCK_FRAMES * NUM_CHANNELS + 1];
+static uint64_t position; // Frames fed so far
+
+static int32_t sample(const channel_signal_t* s, int ch, uint64_t n)
+{
+    double a = s->amplitude[ch];
+    switch (s->signal) {
+    case SIGNAL_SINE:
+        return (int32_t)lround(a * INT32_MAX * sin(2 * M_PI * SINE_HZ * n / SAMPLE_RATE));
+    case SIGNAL_SQUARE:
+        return n % 2 ? (int32_t)lround(a * INT32_MAX) : (int32_t)lround(-a * INT32_MAX);
+    case SIGNAL_DC:
+        return a <= -1.0 ? INT32_MIN : (int32_t)lround(a * INT32_MAX);
+    default:
+        return 0;
+    }
+}
+
+static void feed(const channel_signal_t* s, uint32_t frames)
+{
+    for (uint32_t done = 0; done < frames; done += BLOCK_FRAMES) {
+        for (int i = 0; i < BLOCK_FRAMES; i++) {
+            for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+                block[i * NUM_CHANNELS + ch] = sample(s, ch, position + i);
+            }
+        }
+        level_meter_process(block, BLOCK_FRAMES);
+        position += BLOCK_FRAMES;
+    }
+}
+
+/**
+ * @brief Feed one window of the signal and return what it published
+ *
+ */
+static level_meter_reading_t measure(signal_t signal, double amplitude)
+{
+    channel_signal_t s = { .signal = signal };
+    level_meter_reading_t reading;
+
+    for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+        s.amplitude[ch] = amplitude;
+    }
+    feed(&s, WINDOW_FRAMES);
+    level_meter_get(&reading);
+    return reading;
+}
+
+/**
+ * @brief Silence for longer than the hold time, so no earlier peak is held
+ *
+ */
+static void settle(void)
+{
+    channel_signal_t silence = { .signal = SIGNAL_SILENCE };
+    feed(&silence, HOLD_FRAMES + 2 * WINDOW_FRAMES);
+}
+
+static int32_t db_x10(double amplitude)
+{
+    return (int32_t)lround(200.0 * log10(amplitude));
+}
+
+static void test_dbfs_conversion(void)
+{
+    TEST_CHECK_EQ(level_meter_to_dbfs_x10(INT32_MAX), 0);
+    TEST_CHECK_NEAR(level_meter_to_dbfs_x10(INT32_MAX / 2), -60, DB_TOLERANCE_X10);
+    TEST_CHECK_NEAR(level_meter_to_dbfs_x10(INT32_MAX / 10), -200, DB_TOLERANCE_X10);
+    TEST_CHECK_NEAR(level_meter_to_dbfs_x10(1), -1866, DB_TOLERANCE_X10);
+    TEST_CHECK_EQ(level_meter_to_dbfs_x10(0), level_meter_to_dbfs_x10(1));
+}
+
+/**
+ * @brief Sines at several levels: the peak is the amplitude, the RMS 3.01 dB below it
+ *
+ */
+static void test_sine_levels(void)
+{
+    static const double levels_db[] = { 0, -6, -20, -60, -80 };
+
+    settle();
+    for (size_t l = 0; l < sizeof(levels_db) / sizeof(levels_db[0]); l++) {
+        double amplitude = pow(10, levels_db[l] / 20) * 0.9999;
+        level_meter_reading_t r = measure(SIGNAL_SINE, amplitude);
+        for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+            const level_meter_channel_t* m = &r.channel[ch];
+            TEST_CHECK_NEAR(level_meter_to_dbfs_x10(m->peak), db_x10(amplitude), DB_TOLERANCE_X10);
+            TEST_CHECK_NEAR(level_meter_to_dbfs_x10(m->rms), db_x10(amplitude / sqrt(2)), DB_TOLERANCE_X10);
+        }
+        printf("  sine %5.0f dBFS: peak %6.1f dB, rms %6.1f dB\n", levels_db[l],
+            level_meter_to_dbfs_x10(r.channel[0].peak) / 10.0, level_meter_to_dbfs_x10(r.channel[0].rms) / 10.0);
+    }
+}
+
+static void test_square_and_silence(void)
+{
+    settle();
+    level_meter_reading_t r = measure(SIGNAL_SQUARE, 0.5);
+    for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+        TEST_CHECK_NEAR(r.channel[ch].rms, INT32_MAX / 2.0, 256);
+        TEST_CHECK_NEAR(r.channel[ch].peak, INT32_MAX / 2.0, 1);
+    }
+
+    r = measure(SIGNAL_SILENCE, 0);
+    for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+        TEST_CHECK_EQ(r.channel[ch].rms, 0);
+        TEST_CHECK_EQ(r.channel[ch].peak, 0);
+    }
+}
+
+/**
+ * @brief Negative full scale has a magnitude of 2^31 and counts as clipping
+ *
+ */
+static void test_negative_full_scale(void)
+{
+    uint32_t clips_before[NUM_CHANNELS];
+    level_meter_reading_t r;
+
+    settle();
+    level_meter_get(&r);
+    for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+        clips_before[ch] = r.channel[ch].clips;
+    }
+
+    r = measure(SIGNAL_DC, -1.0);
+    for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+        TEST_CHECK_EQ(r.channel[ch].peak, 0x80000000u);
+        TEST_CHECK_NEAR(r.channel[ch].rms, 0x80000000u, 256);
+        TEST_CHECK_EQ(r.channel[ch].clips - clips_before[ch], WINDOW_FRAMES);
+    }
+}
+
+/**
+ * @brief Clipping counts samples at the 24-bit full scale and beyond, and nothing below
+ *
+ */
+static void test_clip_threshold(void)
+{
+    level_meter_reading_t before, after;
+
+    settle();
+    level_meter_get(&before);
+    for (int i = 0; i < BLOCK_FRAMES * NUM_CHANNELS; i++) {
+        block[i] = 0;
+    }
+    block[0] = LEVEL_METER_CLIP_THRESHOLD;
+    block[1 * NUM_CHANNELS] = LEVEL_METER_CLIP_THRESHOLD - 1;
+    block[2 * NUM_CHANNELS] = -LEVEL_METER_CLIP_THRESHOLD;
+    block[3 * NUM_CHANNELS] = -LEVEL_METER_CLIP_THRESHOLD + 1;
+    block[4 * NUM_CHANNELS] = INT32_MAX;
+    level_meter_process(block, BLOCK_FRAMES);
+    position += BLOCK_FRAMES;
+
+    channel_signal_t silence = { .signal = SIGNAL_SILENCE };
+    feed(&silence, WINDOW_FRAMES - BLOCK_FRAMES);
+    level_meter_get(&after);
+
+    TEST_CHECK_EQ(after.channel[0].clips - before.channel[0].clips, 3);
+    for (int ch = 1; ch < NUM_CHANNELS; ch++) {
+        TEST_CHECK_EQ(after.channel[ch].clips - before.channel[ch].clips, 0);
+    }
+}
+
+/**
+ * @brief Channels are metered independently
+ *
+ */
+static void test_channels_independent(void)
+{
+    channel_signal_t s = { .signal = SIGNAL_SINE };
+    level_meter_reading_t r;
+
+    settle();
+    for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+        s.amplitude[ch] = 0.5 / (1 << ch);
+    }
+    feed(&s, WINDOW_FRAMES);
+    level_meter_get(&r);
+    for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+        TEST_CHECK_NEAR(level_meter_to_dbfs_x10(r.channel[ch].peak), db_x10(s.amplitude[ch]), DB_TOLERANCE_X10);
+    }
+}
+
+/**
+ * @brief A burst is held for the hold time after the window that saw it, then released
+ *
+ */
+static void test_peak_hold(void)
+{
+    level_meter_reading_t r;
+    uint32_t burst_peak;
+
+    settle();
+    r = measure(SIGNAL_SINE, 0.5);
+    burst_peak = r.channel[0].peak;
+
+    /* Quiet windows within the hold time keep the burst's peak held, but not as the window peak */
+    uint32_t held_frames = WINDOW_FRAMES;
+    while (held_frames + WINDOW_FRAMES < HOLD_FRAMES) {
+        r = measure(SIGNAL_SINE, 0.01);
+        held_frames += WINDOW_FRAMES;
+        TEST_CHECK_EQ(r.channel[0].peak_hold, burst_peak);
+        TEST_CHECK(r.channel[0].peak < burst_peak / 10);
+    }
+
+    /* By a full hold time after the burst, the hold has followed the quiet signal down */
+    r = measure(SIGNAL_SINE, 0.01);
+    r = measure(SIGNAL_SINE, 0.01);
+    TEST_CHECK(r.channel[0].peak_hold < burst_peak / 10);
+}
+
+/**
+ * @brief The window and hold times follow the sample rate
+ *
+ */
+static void test_sample_rate(void)
+{
+    level_meter_reading_t before, after;
+    channel_signal_t s = { .signal = SIGNAL_DC, .amplitude = { 0.25 } };
+
+    settle();
+    level_meter_set_sample_rate(2 * SAMPLE_RATE);
+    level_meter_get(&before);
+    feed(&s, WINDOW_FRAMES);
+    level_meter_get(&after);
+    TEST_CHECK_EQ(after.channel[0].peak, before.channel[0].peak); // Half a window at the new rate
+
+    feed(&s, WINDOW_FRAMES);
+    level_meter_get(&after);
+    TEST_CHECK_NEAR(after.channel[0].peak, 0.25 * INT32_MAX, 1);
+    level_meter_set_sample_rate(SAMPLE_RATE);
+}
+
+static uint32_t rng_state = 1;
+
+/* High bits only, the low bits of the LCG repeat with a short period */
+static uint32_t rng(void)
+{
+    rng_state = rng_state * 1664525 + 1013904223;
+    return rng_state >> 8;
+}
+
+typedef enum {
+    RANDOM_WITH_EXTREMES, // Full scale, clip thresholds and their neighbours mixed in
+    RANDOM_PLAIN,
+    RANDOM_POSITIVE, // So the peak is a positive sample's
+    RANDOM_NEGATIVE, // And a negative one's
+} random_kind_t;
+
+static int32_t random_sample(random_kind_t kind, uint32_t block_index)
+{
+    static const int32_t extremes[] = { INT32_MIN, INT32_MAX, LEVEL_METER_CLIP_THRESHOLD, -LEVEL_METER_CLIP_THRESHOLD,
+        LEVEL_METER_CLIP_THRESHOLD - 1, -LEVEL_METER_CLIP_THRESHOLD + 1, -1, 0 };
+
+    if (kind == RANDOM_WITH_EXTREMES && rng() % 8 == 0) {
+        return extremes[rng() % 8];
+    }
+    /* Scaled per block so quiet and loud blocks both occur */
+    int32_t x = (int32_t)(rng() << 8) >> (block_index % 24);
+    if (kind == RANDOM_POSITIVE && x < 0) {
+        return ~x;
+    }
+    return kind == RANDOM_NEGATIVE && x > 0 ? -x : x;
+}
+
+/**
+ * @brief Random blocks of every length, aligned and not, read exactly as the scalar definition
+ *
+ * Peaks, clip counts and the RMS (the floor of the root of the mean square of
+ * the top 24 bits) are computed here from the samples fed over one window.
+ */
+static void test_random_matches_definition(void)
+{
+    for (random_kind_t kind = RANDOM_WITH_EXTREMES; kind <= RANDOM_NEGATIVE; kind++) {
+        level_meter_reading_t before, after;
+        uint32_t peak[NUM_CHANNELS] = { 0 };
+        uint32_t clips[NUM_CHANNELS] = { 0 };
+        uint64_t sum[NUM_CHANNELS] = { 0 };
+        uint32_t fed = 0;
+
+        settle();
+        level_meter_get(&before);
+        for (uint32_t n = 0; fed < WINDOW_FRAMES; n++) {
+            uint32_t frames = n % 4 == 0 ? BLOCK_FRAMES : rng() % BLOCK_FRAMES + 1;
+            if (frames > WINDOW_FRAMES - fed) {
+                frames = WINDOW_FRAMES - fed;
+            }
+            int32_t* x = block + n % 2; // 16-byte aligned and not
+            for (uint32_t i = 0; i < frames * NUM_CHANNELS; i++) {
+                x[i] = random_sample(kind, n);
+                int ch = i % NUM_CHANNELS;
+                uint32_t mag = x[i] < 0 ? 0u - (uint32_t)x[i] : (uint32_t)x[i];
+                int64_t top = x[i] >> 8;
+                peak[ch] = mag > peak[ch] ? mag : peak[ch];
+                clips[ch] += mag >= LEVEL_METER_CLIP_THRESHOLD;
+                sum[ch] += top * top;
+            }
+            level_meter_process(x, frames);
+            fed += frames;
+        }
+        position += WINDOW_FRAMES;
+        level_meter_get(&after);
+
+        for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+            uint64_t mean = sum[ch] / WINDOW_FRAMES;
+            uint64_t root = (uint64_t)sqrtl((long double)mean);
+            while (root * root > mean) {
+                root--;
+            }
+            while ((root + 1) * (root + 1) <= mean) {
+                root++;
+            }
+            TEST_CHECK_EQ(after.channel[ch].peak, peak[ch]);
+            TEST_CHECK_EQ(after.channel[ch].clips - before.channel[ch].clips, clips[ch]);
+            TEST_CHECK_EQ(after.channel[ch].rms, (uint32_t)root << 8);
+        }
+    }
+}
+
+static volatile bool reader_done;
+
+/**
+ * @brief Reader: every channel of a published reading comes from the same window
+ *
+ */
+static void* concurrent_reader(void* arg)
+{
+    bool* consistent = arg;
+    level_meter_reading_t r;
+
+    *consistent = true;
+    while (!reader_done) {
+        level_meter_get(&r);
+        for (int ch = 1; ch < NUM_CHANNELS; ch++) {
+            if (r.channel[ch].peak != r.channel[0].peak || r.channel[ch].rms != r.channel[0].rms) {
+                *consistent = false;
+            }
+        }
+        sched_yield();
+    }
+    return NULL;
+}
+
+static void test_concurrent_reader(void)
+{
+    pthread_t reader;
+    bool consistent;
+
+    settle();
+    reader_done = false;
+    pthread_create(&reader, NULL, concurrent_reader, &consistent);
+    for (int w = 0; w < CONCURRENT_WINDOWS; w++) {
+        measure(SIGNAL_DC, (w % 100 + 1) / 100.0);
+        if (w % 16 == 0) {
+            sched_yield();
+        }
+    }
+    reader_done = true;
+    pthread_join(reader, NULL);
+    TEST_CHECK(consistent);
+}
+
+int main(void)
+{
+    RUN_TEST(test_dbfs_conversion);
+    RUN_TEST(test_sine_levels);
+    RUN_TEST(test_square_and_silence);
+    RUN_TEST(test_negative_full_scale);
+    RUN_TEST(test_clip_threshold);
+    RUN_TEST(test_channels_independent);
+    RUN_TEST(test_peak_hold);
+    RUN_TEST(test_sample_rate);
+    RUN_TEST(test_random_matches_definition);
+    RUN_TEST(test_concurrent_reader);
+    return TEST_RESULT();
+}
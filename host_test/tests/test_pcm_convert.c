@@ -0,0 +1,318 @@
+/**
+ * @file test_pcm_convert.c
+ * @author your name (you@domain.com)
+ * @brief Format conversion and channel map kernels against their references
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * Every USB format is converted at every sample count up to 64 and at
+ * every output alignment a sample of it may have, so both the word-wide
+ * kernels and the reference tails run. The channel map is checked for every
+ * channel and slot count the firmware can be built with.
+ *
+ * Built with PIE_SIMD_MODEL, the 16-byte aligned cases run the PIE kernels
+ * on the C model of the instructions.
+ */
+#include <string.h>
+#include <time.h>
+
+#include "audio_pipeline/pcm_convert.h"
+#include "test.h"
+
+#define MAX_SAMPLES 64
+#define MAX_SLOTS 16 // Two TDM ports of 8 slots
+#define MAX_USB_CHANNELS 8
+#define REMAP_FRAMES 37
+#define BENCH_BLOCKS 20000
+#define BENCH_FRAMES 320
+
+static const audio_format_t formats[] = {
+    PCM_FORMAT_16BIT,
+    PCM_FORMAT_24BIT_32BIT,
+    PCM_FORMAT_24BIT_IN_32BIT,
+    PCM_FORMAT_32BIT,
+};
+static const char* const format_names[] = { "16", "24", "24in32", "32" };
+static const size_t format_bytes[] = { 2, 3, 4, 4 };
+
+static uint32_t rng_state = 1;
+
+static uint32_t rng(void)
+{
+    rng_state = rng_state * 1664525 + 1013904223;
+    return rng_state;
+}
+
+static void fill_random(int32_t* samples, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        samples[i] = (int32_t)rng();
+    }
+    /* Make sure the extremes are in every run */
+    if (count > 1) {
+        samples[0] = INT32_MIN;
+        samples[count - 1] = INT32_MAX;
+    }
+}
+
+/**
+ * @brief Bytes of one sample as the USB host reads them, computed without the kernels
+ *
+ */
+static void expected_sample(audio_format_t format, int32_t s, uint8_t* out)
+{
+    uint32_t u = (uint32_t)s;
+    switch (format) {
+    case PCM_FORMAT_16BIT:
+        out[0] = u >> 16;
+        out[1] = u >> 24;
+        break;
+    case PCM_FORMAT_24BIT_32BIT:
+        out[0] = u >> 8;
+        out[1] = u >> 16;
+        out[2] = u >> 24;
+        break;
+    case PCM_FORMAT_24BIT_IN_32BIT:
+        out[0] = 0;
+        out[1] = u >> 8;
+        out[2] = u >> 16;
+        out[3] = u >> 24;
+        break;
+    case PCM_FORMAT_32BIT:
+        out[0] = u;
+        out[1] = u >> 8;
+        out[2] = u >> 16;
+        out[3] = u >> 24;
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+ * @brief Every format, sample count and output alignment, without dither, in place and not
+ *
+ */
+static void test_convert_matches_layout(void)
+{
+    static _Alignas(16) int32_t in[MAX_SAMPLES];
+    static uint8_t expected[MAX_SAMPLES * 4];
+    static _Alignas(16) union {
+        int32_t words[MAX_SAMPLES + 1];
+        uint8_t bytes[(MAX_SAMPLES + 1) * 4];
+    } out;
+
+    for (size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); f++) {
+        size_t failures = 0;
+        for (size_t samples = 0; samples <= MAX_SAMPLES; samples++) {
+            fill_random(in, samples);
+            for (size_t i = 0; i < samples; i++) {
+                expected_sample(formats[f], in[i], &expected[i * format_bytes[f]]);
+            }
+            const size_t bytes = samples * format_bytes[f];
+
+            /* Packed 24-bit samples may start at any byte, the others are naturally aligned */
+            const size_t align = format_bytes[f] == 3 ? 1 : format_bytes[f];
+            for (size_t offset = 0; offset < 4; offset += align) {
+                memset(out.bytes, 0xEE, sizeof(out.bytes));
+                size_t written = pcm_convert(formats[f], in, out.bytes + offset, samples, NULL);
+                failures += written != bytes || memcmp(out.bytes + offset, expected, bytes) != 0;
+                failures += offset + bytes < sizeof(out.bytes) && out.bytes[offset + bytes] != 0xEE;
+            }
+
+            memcpy(out.words, in, samples * sizeof(int32_t));
+            pcm_convert(formats[f], out.words, out.words, samples, NULL);
+            failures += memcmp(out.bytes, expected, bytes) != 0;
+        }
+        if (failures) {
+            printf("  format %s: %zu mismatches\n", format_names[f], failures);
+        }
+        TEST_CHECK_EQ(failures, 0);
+    }
+}
+
+/**
+ * @brief Dithered 16-bit output is the reference kernel's, sample for sample, for the same seed
+ *
+ */
+static void test_dither_matches_reference(void)
+{
+    static int32_t in[MAX_SAMPLES];
+    static int16_t expected[MAX_SAMPLES];
+    static int16_t out[MAX_SAMPLES + 1];
+
+    for (size_t samples = 0; samples <= MAX_SAMPLES; samples++) {
+        fill_random(in, samples);
+        for (size_t offset = 0; offset < 2; offset++) { // Word-aligned and not
+            pcm_dither_t ref = { .seed = 12345 };
+            pcm_dither_t dut = { .seed = 12345 };
+            pcm_convert_16_ref(in, expected, samples, &ref);
+            pcm_convert(PCM_FORMAT_16BIT, in, out + offset, samples, &dut);
+            TEST_CHECK(memcmp(out + offset, expected, samples * sizeof(int16_t)) == 0);
+            TEST_CHECK_EQ(dut.seed, ref.seed);
+        }
+    }
+
+    /* Dither never wraps full scale around */
+    int32_t extremes[2] = { INT32_MAX, INT32_MIN };
+    pcm_dither_t dither = { .seed = 1 };
+    for (int i = 0; i < 1000; i++) {
+        pcm_convert(PCM_FORMAT_16BIT, extremes, out, 2, &dither);
+        TEST_CHECK(out[0] >= INT16_MAX - 1);
+        TEST_CHECK(out[1] <= INT16_MIN + 1);
+    }
+}
+
+/**
+ * @brief Unpacking what was converted gives the samples back, to the format's resolution
+ *
+ */
+static void test_unpack_round_trip(void)
+{
+    static const uint32_t masks[] = { 0xFFFF0000u, 0xFFFFFF00u, 0xFFFFFF00u, 0xFFFFFFFFu };
+    static int32_t in[MAX_SAMPLES];
+    static int32_t packed[MAX_SAMPLES];
+    static int32_t out[MAX_SAMPLES];
+
+    for (size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); f++) {
+        fill_random(in, MAX_SAMPLES);
+        size_t bytes = pcm_convert(formats[f], in, packed, MAX_SAMPLES, NULL);
+
+        /* A trailing partial sample is ignored */
+        TEST_CHECK_EQ(pcm_unpack(formats[f], packed, bytes + format_bytes[f] - 1, out), MAX_SAMPLES);
+        for (size_t i = 0; i < MAX_SAMPLES; i++) {
+            TEST_CHECK_EQ((uint32_t)out[i], (uint32_t)in[i] & masks[f]);
+        }
+    }
+}
+
+/**
+ * @brief A fade out scales every channel alike, never reaches silence or full scale, and keeps the format
+ *
+ */
+static void test_fade(void)
+{
+    enum { FRAMES = 8, CHANNELS = 3 };
+    static int32_t in[FRAMES * CHANNELS];
+    static int32_t packed[FRAMES * CHANNELS];
+    static int32_t out[FRAMES * CHANNELS];
+
+    for (size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); f++) {
+        for (int i = 0; i < FRAMES * CHANNELS; i++) {
+            in[i] = (i % CHANNELS == 1 ? -1 : 1) * 0x40000000;
+        }
+        pcm_convert(formats[f], in, packed, FRAMES * CHANNELS, NULL);
+        pcm_fade(formats[f], packed, FRAMES, CHANNELS, false);
+        pcm_unpack(formats[f], packed, FRAMES * CHANNELS * format_bytes[f], out);
+
+        for (int i = 0; i < FRAMES; i++) {
+            int64_t expected = (int64_t)0x40000000 * (FRAMES - i) / (FRAMES + 1);
+            TEST_CHECK_NEAR(out[i * CHANNELS], expected, 0x10000);
+            TEST_CHECK_NEAR(out[i * CHANNELS + 1], -expected, 0x10000);
+            TEST_CHECK_EQ(out[i * CHANNELS + 2], out[i * CHANNELS]);
+        }
+        TEST_CHECK(out[0] < 0x40000000);
+        TEST_CHECK(out[(FRAMES - 1) * CHANNELS] > 0);
+        if (formats[f] == PCM_FORMAT_24BIT_IN_32BIT) {
+            TEST_CHECK_EQ(out[CHANNELS] & 0xFF, 0);
+        }
+    }
+}
+
+/**
+ * @brief Gather for every channel and slot count, with identity, reversed, random and repeated maps
+ *
+ */
+static void test_remap_all_layouts(void)
+{
+    static int32_t in[REMAP_FRAMES * MAX_SLOTS];
+    static int32_t out[REMAP_FRAMES * MAX_USB_CHANNELS + 1];
+    size_t failures = 0;
+
+    for (size_t i = 0; i < sizeof(in) / sizeof(in[0]); i++) {
+        in[i] = (int32_t)i;
+    }
+
+    for (size_t slots = 1; slots <= MAX_SLOTS; slots++) {
+        for (size_t channels = 1; channels <= MAX_USB_CHANNELS; channels++) {
+            for (int kind = 0; kind < 4; kind++) {
+                uint8_t map[MAX_USB_CHANNELS];
+                for (size_t c = 0; c < channels; c++) {
+                    switch (kind) {
+                    case 0:
+                        map[c] = c % slots;
+                        break;
+                    case 1:
+                        map[c] = (slots - 1 - c % slots);
+                        break;
+                    case 2:
+                        map[c] = rng() % slots;
+                        break;
+                    default:
+                        map[c] = slots - 1; // One slot fanned out to every channel
+                        break;
+                    }
+                }
+
+                out[REMAP_FRAMES * channels] = 0x5A5A5A5A;
+                pcm_remap(in, slots, map, channels, out, REMAP_FRAMES);
+                for (size_t i = 0; i < REMAP_FRAMES; i++) {
+                    for (size_t c = 0; c < channels; c++) {
+                        failures += out[i * channels + c] != in[i * slots + map[c]];
+                    }
+                }
+                failures += out[REMAP_FRAMES * channels] != 0x5A5A5A5A;
+            }
+        }
+    }
+    TEST_CHECK_EQ(failures, 0);
+}
+
+static double elapsed_ns(const struct timespec* start)
+{
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (end.tv_sec - start->tv_sec) * 1e9 + (end.tv_nsec - start->tv_nsec);
+}
+
+/**
+ * @brief Cost per sample of each format, and of the gather for the common layouts
+ *
+ */
+static void bench_cost(void)
+{
+    static _Alignas(16) int32_t in[BENCH_FRAMES * 8];
+    static _Alignas(16) int32_t out[BENCH_FRAMES * 8];
+    static const uint8_t map[] = { 1, 0, 3, 2 };
+    struct timespec start;
+
+    fill_random(in, BENCH_FRAMES * 8);
+    for (size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); f++) {
+        pcm_dither_t dither = { .seed = 1 };
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (int b = 0; b < BENCH_BLOCKS; b++) {
+            pcm_convert(formats[f], in, out, BENCH_FRAMES * 2, formats[f] == PCM_FORMAT_16BIT ? &dither : NULL);
+        }
+        printf("  convert %-7s %.2f ns per sample\n", format_names[f], elapsed_ns(&start) / (BENCH_BLOCKS * BENCH_FRAMES * 2.0));
+    }
+    for (size_t channels = 2; channels <= 4; channels += 2) {
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (int b = 0; b < BENCH_BLOCKS; b++) {
+            pcm_remap(in, 8, map, channels, out, BENCH_FRAMES);
+        }
+        printf("  remap 8 slots -> %zu channels %.2f ns per frame\n", channels, elapsed_ns(&start) / (BENCH_BLOCKS * (double)BENCH_FRAMES));
+    }
+}
+
+int main(void)
+{
+    RUN_TEST(test_convert_matches_layout);
+    RUN_TEST(test_dither_matches_reference);
+    RUN_TEST(test_unpack_round_trip);
+    RUN_TEST(test_fade);
+    RUN_TEST(test_remap_all_layouts);
+    RUN_TEST(bench_cost);
+    return TEST_RESULT();
+}
@@ -0,0 +1,233 @@
+/**
+ * @file test_src_polyphase.c
+ * @author your name (you@domain.com)
+ * @brief THD+N, passband, aliasing and cost of the polyphase resampler
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * The reference is the ideal sine at the output rate: a sine, a cosine and
+ * DC at the test frequency are fitted to the settled output by least
+ * squares, and whatever the fit leaves is distortion and noise. The fit uses
+ * the ratio the converter actually runs at, its 8.24 step, so the few parts
+ * per billion the step is rounded by do not count as noise.
+ */
+#include <math.h>
+#include <string.h>
+#include <time.h>
+
+#include "audio_pipeline/src_polyphase.h"
+#include "test.h"
+
+#define BLOCKS 150 // One second at 48 kHz
+#define SETTLE_FRAMES 256 // Output skipped before measuring, the filter history starts silent
+#define AMPLITUDE 0.5 // Of full scale, -6 dBFS
+#define BENCH_BLOCKS 3000
+
+static src_t src;
+static int32_t in[AUDIO_DMA_FRAME_NUM * NUM_CHANNELS];
+static int32_t out[BLOCKS * SRC_MAX_OUT_FRAMES(AUDIO_DMA_FRAME_NUM) * NUM_CHANNELS];
+
+typedef struct {
+    double gain_db; // Level of the fitted sine relative to the input
+    double thd_n_db; // Residual relative to the fitted sine
+} tone_result_t;
+
+/**
+ * @brief Resample one second of a sine and return the number of output frames
+ *
+ */
+static size_t resample_tone(uint32_t in_rate, uint32_t out_rate, double freq)
+{
+    size_t out_frames = 0;
+    uint64_t n = 0;
+
+    TEST_CHECK_EQ(src_init(&src, in_rate, out_rate), ESP_OK);
+    for (int b = 0; b < BLOCKS; b++) {
+        for (size_t i = 0; i < AUDIO_DMA_FRAME_NUM; i++, n++) {
+            double v = AMPLITUDE * sin(2.0 * M_PI * freq * n / in_rate);
+            for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+                in[i * NUM_CHANNELS + ch] = (int32_t)lround(v * INT32_MAX);
+            }
+        }
+        out_frames += src_process(&src, in, AUDIO_DMA_FRAME_NUM, &out[out_frames * NUM_CHANNELS]);
+    }
+    return out_frames;
+}
+
+/**
+ * @brief Solve the 3x3 normal equations of the sine, cosine and DC fit
+ *
+ */
+static void solve3(double a[3][3], double b[3], double x[3])
+{
+    for (int col = 0; col < 3; col++) {
+        for (int row = col + 1; row < 3; row++) {
+            double f = a[row][col] / a[col][col];
+            for (int k = col; k < 3; k++) {
+                a[row][k] -= f * a[col][k];
+            }
+            b[row] -= f * b[col];
+        }
+    }
+    for (int row = 2; row >= 0; row--) {
+        double s = b[row];
+        for (int k = row + 1; k < 3; k++) {
+            s -= a[row][k] * x[k];
+        }
+        x[row] = s / a[row][row];
+    }
+}
+
+static tone_result_t measure_tone(uint32_t in_rate, uint32_t out_rate, double freq)
+{
+    size_t frames = resample_tone(in_rate, out_rate, freq);
+    tone_result_t result = { 0 };
+    double w = 2.0 * M_PI * freq / in_rate * src.step / (1 << 24); // Radians per output frame
+
+    for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+        double a[3][3] = { { 0 } };
+        double b[3] = { 0 };
+        double x[3];
+
+        for (size_t i = SETTLE_FRAMES; i < frames; i++) {
+            double basis[3] = { sin(w * i), cos(w * i), 1.0 };
+            double y = out[i * NUM_CHANNELS + ch] / (double)INT32_MAX;
+            for (int r = 0; r < 3; r++) {
+                for (int c = 0; c < 3; c++) {
+                    a[r][c] += basis[r] * basis[c];
+                }
+                b[r] += basis[r] * y;
+            }
+        }
+        solve3(a, b, x);
+
+        double residual = 0;
+        for (size_t i = SETTLE_FRAMES; i < frames; i++) {
+            double fit = x[0] * sin(w * i) + x[1] * cos(w * i) + x[2];
+            double e = out[i * NUM_CHANNELS + ch] / (double)INT32_MAX - fit;
+            residual += e * e;
+        }
+        double amplitude = hypot(x[0], x[1]);
+        double signal_rms = amplitude / sqrt(2.0);
+        double noise_rms = sqrt(residual / (frames - SETTLE_FRAMES));
+
+        /* Report the worse channel */
+        double gain_db = 20.0 * log10(amplitude / AMPLITUDE);
+        double thd_n_db = 20.0 * log10(noise_rms / signal_rms);
+        if (ch == 0 || fabs(gain_db) > fabs(result.gain_db)) {
+            result.gain_db = gain_db;
+        }
+        if (ch == 0 || thd_n_db > result.thd_n_db) {
+            result.thd_n_db = thd_n_db;
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief Level of a tone above the output band, as it aliases into it
+ *
+ */
+static double measure_alias_db(uint32_t in_rate, uint32_t out_rate, double freq)
+{
+    size_t frames = resample_tone(in_rate, out_rate, freq);
+    double sum = 0;
+
+    for (size_t i = SETTLE_FRAMES; i < frames; i++) {
+        double y = out[i * NUM_CHANNELS] / (double)INT32_MAX;
+        sum += y * y;
+    }
+    return 20.0 * log10(sqrt(sum / (frames - SETTLE_FRAMES)) / (AMPLITUDE / sqrt(2.0)));
+}
+
+static void test_thd_n(void)
+{
+    static const struct {
+        uint32_t in_rate;
+        uint32_t out_rate;
+    } ratios[] = { { 48000, 44100 }, { 44100, 48000 }, { 48000, 96000 }, { 96000, 48000 } };
+
+    for (size_t r = 0; r < sizeof(ratios) / sizeof(ratios[0]); r++) {
+        tone_result_t t = measure_tone(ratios[r].in_rate, ratios[r].out_rate, 997.0);
+        printf("  %5lu -> %5lu Hz, 997 Hz: gain %+.4f dB, THD+N %.1f dB\n",
+            (unsigned long)ratios[r].in_rate, (unsigned long)ratios[r].out_rate, t.gain_db, t.thd_n_db);
+        TEST_CHECK_NEAR(t.gain_db, 0, 0.01);
+        TEST_CHECK(t.thd_n_db < -100);
+    }
+}
+
+static void test_passband(void)
+{
+    static const double freqs[] = { 20, 100, 1000, 5000, 10000, 15000 };
+
+    for (size_t f = 0; f < sizeof(freqs) / sizeof(freqs[0]); f++) {
+        tone_result_t t = measure_tone(48000, 44100, freqs[f]);
+        printf("  48000 -> 44100 Hz, %5.0f Hz: gain %+.4f dB, THD+N %.1f dB\n", freqs[f], t.gain_db, t.thd_n_db);
+        TEST_CHECK_NEAR(t.gain_db, 0, 0.1);
+        TEST_CHECK(t.thd_n_db < -90);
+    }
+}
+
+static void test_aliasing(void)
+{
+    /*
+     * Above the 22.05 kHz output Nyquist frequency, these fold back to 20.1
+     * and 17.1 kHz. The first is still in the transition band of the short
+     * filter, which starts at 91 % of the output Nyquist frequency; the second
+     * must be in the stopband.
+     */
+    double transition = measure_alias_db(96000, 44100, 24000);
+    double stopband = measure_alias_db(96000, 44100, 27000);
+    printf("  96000 -> 44100 Hz, 24000 Hz: %.1f dB, 27000 Hz: %.1f dB\n", transition, stopband);
+    TEST_CHECK(transition < -20);
+    TEST_CHECK(stopband < -50);
+}
+
+static void test_output_frame_count(void)
+{
+    static const uint32_t rates[][2] = { { 48000, 44100 }, { 44100, 48000 }, { 48000, 96000 } };
+
+    for (size_t r = 0; r < sizeof(rates) / sizeof(rates[0]); r++) {
+        size_t frames = resample_tone(rates[r][0], rates[r][1], 1000);
+        double expected = (double)BLOCKS * AUDIO_DMA_FRAME_NUM * rates[r][1] / rates[r][0];
+        TEST_CHECK_NEAR(frames, expected, 1.0);
+    }
+
+    /* A trim shifts the ratio by that many ppm */
+    TEST_CHECK_EQ(src_init(&src, 48000, 48000), ESP_OK);
+    src_set_trim_ppb(&src, 500000);
+    size_t frames = 0;
+    memset(in, 0, sizeof(in));
+    for (int b = 0; b < 10 * BLOCKS; b++) {
+        frames += src_process(&src, in, AUDIO_DMA_FRAME_NUM, out);
+    }
+    TEST_CHECK_NEAR(frames, 10.0 * BLOCKS * AUDIO_DMA_FRAME_NUM * (1 + 500e-6), 2.0);
+}
+
+static void bench_cost_per_frame(void)
+{
+    struct timespec start, end;
+    size_t frames = 0;
+
+    src_init(&src, 48000, 44100);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int b = 0; b < BENCH_BLOCKS; b++) {
+        frames += src_process(&src, in, AUDIO_DMA_FRAME_NUM, out);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double ns = (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+    printf("  48000 -> 44100 Hz: %.1f ns per output frame, %d channels, %d taps\n", ns / frames, NUM_CHANNELS, SRC_TAPS);
+}
+
+int main(void)
+{
+    RUN_TEST(test_thd_n);
+    RUN_TEST(test_passband);
+    RUN_TEST(test_aliasing);
+    RUN_TEST(test_output_frame_count);
+    RUN_TEST(bench_cost_per_frame);
+    return TEST_RESULT();
+}
@@ -0,0 +1,284 @@
+/**
+ * @file test_tap_codec.c
+ * @author your name (you@domain.com)
+ * @brief Round trip of the tap codec through a host-side decoder
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * The decoder follows the format described in tap_codec.h, not the encoder,
+ * so a round trip checks the two against each other. Every block must come
+ * back bit exact and within TAP_CODEC_MAX_BLOCK_SIZE.
+ */
+#include <math.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include "audio_pipeline/tap_codec.h"
+#include "test.h"
+
+#define BENCH_BLOCKS 20000
+
+typedef struct {
+    const uint8_t* data;
+    const uint8_t* end;
+    size_t bit; // Bits consumed from data
+    bool overrun;
+} bit_reader_t;
+
+static uint32_t get_bits(bit_reader_t* br, int n)
+{
+    uint32_t value = 0;
+    for (int i = 0; i < n; i++, br->bit++) {
+        const uint8_t* byte = br->data + br->bit / 8;
+        if (byte >= br->end) {
+            br->overrun = true;
+            return 0;
+        }
+        value = (value << 1) | ((*byte >> (7 - br->bit % 8)) & 1);
+    }
+    return value;
+}
+
+static int32_t sign_extend(uint32_t value, int width)
+{
+    return width == 32 ? (int32_t)value : (int32_t)(value << (32 - width)) >> (32 - width);
+}
+
+static int64_t predict(const int32_t* x, size_t i, int order)
+{
+    switch (order) {
+    case 1:
+        return x[i - 1];
+    case 2:
+        return 2 * (int64_t)x[i - 1] - x[i - 2];
+    case 3:
+        return 3 * (int64_t)x[i - 1] - 3 * (int64_t)x[i - 2] + x[i - 3];
+    case 4:
+        return 4 * (int64_t)x[i - 1] - 6 * (int64_t)x[i - 2] + 4 * (int64_t)x[i - 3] - x[i - 4];
+    default:
+        return 0;
+    }
+}
+
+/**
+ * @brief Decode one block into interleaved samples
+ *
+ * @return number of bytes consumed, or 0 if the block is malformed
+ */
+static size_t decode(const uint8_t* in, size_t size, int32_t* samples, size_t* frames, size_t* channels, uint32_t* frame_index)
+{
+    if (size < TAP_CODEC_HEADER_SIZE) {
+        return 0;
+    }
+    *frame_index = in[0] | (in[1] << 8) | (in[2] << 16) | ((uint32_t)in[3] << 24);
+    *frames = in[4] | (in[5] << 8);
+    *channels = in[6];
+    if (*frames == 0 || *frames > TAP_CODEC_MAX_FRAMES || *channels == 0 || *channels > TAP_CODEC_MAX_CHANNELS) {
+        return 0;
+    }
+
+    bit_reader_t br = { .data = in + TAP_CODEC_HEADER_SIZE, .end = in + size };
+    for (size_t ch = 0; ch < *channels; ch++) {
+        int32_t x[TAP_CODEC_MAX_FRAMES];
+        int order = get_bits(&br, 3);
+        int shift = get_bits(&br, 5);
+        int width = 32 - shift;
+
+        if (order == TAP_CODEC_ORDER_VERBATIM) {
+            for (size_t i = 0; i < *frames; i++) {
+                x[i] = sign_extend(get_bits(&br, width), width);
+            }
+        } else if (order <= TAP_CODEC_MAX_ORDER) {
+            for (int i = 0; i < order; i++) {
+                x[i] = sign_extend(get_bits(&br, width), width);
+            }
+            int k = get_bits(&br, 5);
+            for (size_t i = order; i < *frames && !br.overrun; i++) {
+                uint32_t q = 0;
+                while (q < TAP_CODEC_RICE_ESCAPE && get_bits(&br, 1)) {
+                    q++;
+                }
+                uint32_t u = q < TAP_CODEC_RICE_ESCAPE ? (q << k) | get_bits(&br, k) : get_bits(&br, 32);
+                int64_t r = u & 1 ? -(int64_t)(u >> 1) - 1 : (int64_t)(u >> 1);
+                x[i] = (int32_t)(predict(x, i, order) + r);
+            }
+        } else {
+            return 0;
+        }
+        for (size_t i = 0; i < *frames; i++) {
+            samples[i * *channels + ch] = (int32_t)((uint32_t)x[i] << shift);
+        }
+    }
+    if (br.overrun) {
+        return 0;
+    }
+    return TAP_CODEC_HEADER_SIZE + (br.bit + 7) / 8;
+}
+
+static uint32_t rng_state = 1;
+
+static uint32_t rng(void)
+{
+    rng_state = rng_state * 1664525 + 1013904223;
+    return rng_state;
+}
+
+/**
+ * @brief Encode, decode and compare one block
+ *
+ * @return encoded size, or 0 if the round trip failed
+ */
+static size_t round_trip(const int32_t* samples, size_t frames, size_t channels)
+{
+    static uint8_t encoded[TAP_CODEC_MAX_BLOCK_SIZE(TAP_CODEC_MAX_FRAMES, TAP_CODEC_MAX_CHANNELS)];
+    static int32_t decoded[TAP_CODEC_MAX_FRAMES * TAP_CODEC_MAX_CHANNELS];
+    const uint32_t index = rng();
+
+    size_t size = tap_codec_encode(samples, frames, channels, index, encoded);
+    bool fits = size > 0 && size <= TAP_CODEC_MAX_BLOCK_SIZE(frames, channels);
+    TEST_CHECK(fits);
+    if (!fits) {
+        return 0;
+    }
+
+    size_t got_frames, got_channels;
+    uint32_t got_index;
+    size_t used = decode(encoded, size, decoded, &got_frames, &got_channels, &got_index);
+    bool ok = used == size && got_frames == frames && got_channels == channels && got_index == index
+        && memcmp(decoded, samples, frames * channels * sizeof(int32_t)) == 0;
+    TEST_CHECK(ok);
+    return ok ? size : 0;
+}
+
+typedef enum {
+    SIGNAL_SILENCE,
+    SIGNAL_SINE_24, // -6 dBFS 1 kHz sine, 24 bits in the top of 32
+    SIGNAL_NOISE_32, // Full-scale white noise, incompressible
+    SIGNAL_CUBIC, // Exactly predicted by order 4
+    SIGNAL_EXTREMES, // Alternating full-scale steps, residuals beyond 32 bits
+    SIGNAL_COUNT,
+} signal_t;
+
+static const char* const signal_names[SIGNAL_COUNT] = { "silence", "sine 24-bit", "noise 32-bit", "cubic", "extremes" };
+
+static void generate(signal_t signal, int32_t* samples, size_t frames, size_t channels, uint32_t start)
+{
+    for (size_t i = 0; i < frames; i++) {
+        uint32_t n = start + i;
+        for (size_t ch = 0; ch < channels; ch++) {
+            int32_t* s = &samples[i * channels + ch];
+            switch (signal) {
+            case SIGNAL_SILENCE:
+                *s = 0;
+                break;
+            case SIGNAL_SINE_24:
+                *s = (int32_t)lround(0.5 * 8388607 * sin(2 * M_PI * 1000 * n / 48000.0 + ch)) * 256;
+                break;
+            case SIGNAL_NOISE_32:
+                *s = (int32_t)rng();
+                break;
+            case SIGNAL_CUBIC: {
+                int64_t t = (int64_t)(n % 1000) - 500 + ch;
+                *s = (int32_t)(t * t * t * 16 - t * 3000);
+                break;
+            }
+            case SIGNAL_EXTREMES:
+                *s = (n + ch) % 2 ? INT32_MAX : INT32_MIN;
+                break;
+            default:
+                break;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Every frame count and channel count the codec accepts, for each kind of signal
+ *
+ */
+static void test_round_trip_all_shapes(void)
+{
+    static int32_t samples[TAP_CODEC_MAX_FRAMES * TAP_CODEC_MAX_CHANNELS];
+
+    for (int signal = 0; signal < SIGNAL_COUNT; signal++) {
+        size_t failures = 0;
+        for (size_t channels = 1; channels <= TAP_CODEC_MAX_CHANNELS; channels++) {
+            for (size_t frames = 1; frames <= TAP_CODEC_MAX_FRAMES; frames++) {
+                generate(signal, samples, frames, channels, rng() % 48000);
+                failures += round_trip(samples, frames, channels) == 0;
+            }
+        }
+        TEST_CHECK_EQ(failures, 0);
+    }
+}
+
+/**
+ * @brief Samples with a few low bits set among many zero ones, and the extremes of each shift
+ *
+ */
+static void test_round_trip_shifts(void)
+{
+    int32_t samples[TAP_CODEC_MAX_FRAMES * 2];
+
+    for (int shift = 0; shift < 32; shift++) {
+        for (size_t i = 0; i < TAP_CODEC_MAX_FRAMES * 2; i++) {
+            int32_t v = (int32_t)(rng() >> shift);
+            samples[i] = (int32_t)((uint32_t)v << shift);
+        }
+        samples[0] = INT32_MIN;
+        samples[1] = (int32_t)(UINT32_MAX << shift);
+        TEST_CHECK(round_trip(samples, TAP_CODEC_MAX_FRAMES, 2) > 0);
+    }
+}
+
+static void test_invalid_arguments(void)
+{
+    static int32_t samples[(TAP_CODEC_MAX_FRAMES + 1) * (TAP_CODEC_MAX_CHANNELS + 1)];
+    static uint8_t out[TAP_CODEC_MAX_BLOCK_SIZE(TAP_CODEC_MAX_FRAMES + 1, TAP_CODEC_MAX_CHANNELS + 1)];
+
+    TEST_CHECK_EQ(tap_codec_encode(samples, 0, 2, 0, out), 0);
+    TEST_CHECK_EQ(tap_codec_encode(samples, TAP_CODEC_MAX_FRAMES + 1, 2, 0, out), 0);
+    TEST_CHECK_EQ(tap_codec_encode(samples, 16, 0, 0, out), 0);
+    TEST_CHECK_EQ(tap_codec_encode(samples, 16, TAP_CODEC_MAX_CHANNELS + 1, 0, out), 0);
+}
+
+/**
+ * @brief Compression ratio per signal and encoder cost, full blocks of stereo
+ *
+ */
+static void bench_ratio_and_cost(void)
+{
+    static int32_t samples[TAP_CODEC_MAX_FRAMES * 2];
+    static uint8_t out[TAP_CODEC_MAX_BLOCK_SIZE(TAP_CODEC_MAX_FRAMES, 2)];
+
+    for (int signal = 0; signal < SIGNAL_COUNT; signal++) {
+        size_t encoded = 0;
+        struct timespec start, end;
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (int b = 0; b < BENCH_BLOCKS; b++) {
+            if (b % 256 == 0) {
+                generate(signal, samples, TAP_CODEC_MAX_FRAMES, 2, b * TAP_CODEC_MAX_FRAMES);
+            }
+            encoded += tap_codec_encode(samples, TAP_CODEC_MAX_FRAMES, 2, b, out);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        double ns = (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+        double raw = (double)BENCH_BLOCKS * sizeof(samples);
+        printf("  %-12s %5.1f %% of raw, %.1f ns per frame\n", signal_names[signal], 100.0 * encoded / raw,
+            ns / ((double)BENCH_BLOCKS * TAP_CODEC_MAX_FRAMES));
+    }
+}
+
+int main(void)
+{
+    RUN_TEST(test_round_trip_all_shapes);
+    RUN_TEST(test_round_trip_shifts);
+    RUN_TEST(test_invalid_arguments);
+    RUN_TEST(bench_ratio_and_cost);
+    return TEST_RESULT();
+}
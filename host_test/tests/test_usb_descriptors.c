@@ -0,0 +1,209 @@
+/**
+ * @file test_usb_descriptors.c
+ * @author your name (you@domain.com)
+ * @brief Structure of the configuration descriptor, as a host parses it
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * Walks the descriptor the way enumeration does: every length must add up,
+ * every entity a unit or terminal refers to must exist, and every audio
+ * endpoint must hold the largest packet of its format without exceeding
+ * the full-speed isochronous limit.
+ */
+#include <stdbool.h>
+#include <string.h>
+
+#include "test.h"
+#include "usb/usb_descriptors.h"
+
+#define UAC2_AC_INPUT_TERMINAL 0x02
+#define UAC2_AC_OUTPUT_TERMINAL 0x03
+#define UAC2_AC_FEATURE_UNIT 0x06
+#define UAC2_AC_CLOCK_SOURCE 0x0A
+#define UAC2_AS_FORMAT_TYPE 0x02
+#define UAC2_SUBCLASS_AUDIOCONTROL 0x01
+#define UAC2_SUBCLASS_AUDIOSTREAMING 0x02
+#define MAX_ENTITIES 16
+
+static const uint8_t* config;
+
+static uint16_t get16(const uint8_t* p)
+{
+    return p[0] | p[1] << 8;
+}
+
+static void test_device_and_strings(void)
+{
+    const tusb_desc_device_t* device = usb_descriptors_device();
+    int count;
+    const char** strings = usb_descriptors_strings(&count);
+
+    TEST_CHECK_EQ(device->bLength, 18);
+    TEST_CHECK_EQ(device->bDescriptorType, TUSB_DESC_DEVICE);
+    TEST_CHECK_EQ(device->bDeviceClass, TUSB_CLASS_MISC);
+    TEST_CHECK_EQ(device->bNumConfigurations, 1);
+    TEST_CHECK(device->iManufacturer < count && device->iProduct < count && device->iSerialNumber < count);
+    TEST_CHECK(strings[0][0] == 0x09 && strings[0][1] == 0x04);
+}
+
+/**
+ * @brief Descriptor lengths add up to wTotalLength and the lengths in the header
+ *
+ */
+static void test_lengths(void)
+{
+    TEST_CHECK_EQ(config[0], 9);
+    TEST_CHECK_EQ(config[1], TUSB_DESC_CONFIGURATION);
+    TEST_CHECK_EQ(get16(config + 2), USB_CONFIG_DESC_LEN);
+    TEST_CHECK_EQ(config[4], ITF_NUM_TOTAL);
+
+    size_t offset = 0;
+    size_t count = 0;
+    while (offset < USB_CONFIG_DESC_LEN && config[offset] >= 2) {
+        offset += config[offset];
+        count++;
+    }
+    TEST_CHECK_EQ(offset, USB_CONFIG_DESC_LEN);
+    printf("  %zu descriptors, %d bytes\n", count, USB_CONFIG_DESC_LEN);
+
+    /* The audio function runs from its IAD to the next IAD */
+    const uint8_t* iad = config + 9;
+    TEST_CHECK_EQ(iad[1], TUSB_DESC_INTERFACE_ASSOCIATION);
+    TEST_CHECK_EQ(iad[2], ITF_NUM_AUDIO_CONTROL);
+    const uint8_t* next_iad = iad + USB_DESC_IAD_LEN + USB_AUDIO_FUNC_DESC_LEN;
+    TEST_CHECK_EQ(next_iad[1], TUSB_DESC_INTERFACE_ASSOCIATION);
+    TEST_CHECK_EQ(next_iad[2], ITF_NUM_CDC);
+    TEST_CHECK_EQ(iad[3], ITF_NUM_CDC - ITF_NUM_AUDIO_CONTROL);
+
+    /* The AC header counts itself and every unit and terminal after it */
+    const uint8_t* header = iad + USB_DESC_IAD_LEN + USB_DESC_INTERFACE_LEN;
+    TEST_CHECK_EQ(header[1], TUSB_DESC_CS_INTERFACE);
+    size_t cs_len = 0;
+    for (const uint8_t* p = header; p[1] == TUSB_DESC_CS_INTERFACE; p += p[0]) {
+        cs_len += p[0];
+    }
+    TEST_CHECK_EQ(get16(header + 6), cs_len);
+}
+
+/**
+ * @brief Every entity referred to as a source or clock is declared
+ *
+ */
+static void test_entities(void)
+{
+    bool declared[256] = { false };
+    uint8_t references[MAX_ENTITIES];
+    size_t num_references = 0;
+    int interface_subclass = -1;
+
+    for (size_t offset = 0; offset < USB_CONFIG_DESC_LEN; offset += config[offset]) {
+        const uint8_t* d = config + offset;
+        if (d[1] == TUSB_DESC_INTERFACE) {
+            interface_subclass = d[5] == TUSB_CLASS_AUDIO ? d[6] : -1;
+            continue;
+        }
+        if (d[1] != TUSB_DESC_CS_INTERFACE || interface_subclass != UAC2_SUBCLASS_AUDIOCONTROL) {
+            continue;
+        }
+        switch (d[2]) {
+        case UAC2_AC_CLOCK_SOURCE:
+            declared[d[3]] = true;
+            break;
+        case UAC2_AC_INPUT_TERMINAL:
+            declared[d[3]] = true;
+            references[num_references++] = d[7]; // bCSourceID
+            TEST_CHECK_EQ(d[8], NUM_CHANNELS);
+            break;
+        case UAC2_AC_FEATURE_UNIT:
+            declared[d[3]] = true;
+            references[num_references++] = d[4]; // bSourceID
+            TEST_CHECK_EQ(d[0], 6 + (NUM_CHANNELS + 1) * 4);
+            break;
+        case UAC2_AC_OUTPUT_TERMINAL:
+            declared[d[3]] = true;
+            references[num_references++] = d[7]; // bSourceID
+            references[num_references++] = d[8]; // bCSourceID
+            break;
+        default:
+            break;
+        }
+    }
+
+    TEST_CHECK(declared[UAC2_ENTITY_CLOCK] && declared[UAC2_ENTITY_FEATURE_UNIT]);
+#if CONFIG_AUDIO_PLAYBACK
+    TEST_CHECK(declared[UAC2_ENTITY_PLAYBACK_INPUT_TERMINAL] && declared[UAC2_ENTITY_PLAYBACK_OUTPUT_TERMINAL]);
+#endif
+    TEST_CHECK(num_references > 0);
+    for (size_t i = 0; i < num_references; i++) {
+        TEST_CHECK(declared[references[i]]);
+    }
+}
+
+/**
+ * @brief Each streaming interface has every alt, and each alt's endpoint fits its largest packet
+ *
+ */
+static void test_streaming_endpoints(void)
+{
+    int alts_in = 0;
+    int alts_out = 0;
+    int interface = -1;
+    int alt = -1;
+    int subslot = 0;
+    int bits = 0;
+
+    for (size_t offset = 0; offset < USB_CONFIG_DESC_LEN; offset += config[offset]) {
+        const uint8_t* d = config + offset;
+        if (d[1] == TUSB_DESC_INTERFACE) {
+            bool streaming = d[5] == TUSB_CLASS_AUDIO && d[6] == UAC2_SUBCLASS_AUDIOSTREAMING;
+            interface = streaming ? d[2] : -1;
+            alt = d[3];
+            if (interface == ITF_NUM_AUDIO_STREAMING_IN) {
+                TEST_CHECK_EQ(alt, alts_in);
+                TEST_CHECK_EQ(d[4], alt == 0 ? 0 : 1);
+                alts_in++;
+            }
+#if CONFIG_AUDIO_PLAYBACK
+            if (interface == ITF_NUM_AUDIO_STREAMING_OUT) {
+                TEST_CHECK_EQ(alt, alts_out);
+                TEST_CHECK_EQ(d[4], alt == 0 ? 0 : 1);
+                alts_out++;
+            }
+#endif
+        } else if (interface >= 0 && d[1] == TUSB_DESC_CS_INTERFACE && d[2] == UAC2_AS_FORMAT_TYPE) {
+            subslot = d[4];
+            bits = d[5];
+            TEST_CHECK(bits <= subslot * 8);
+        } else if (interface >= 0 && d[1] == TUSB_DESC_ENDPOINT) {
+            uint16_t size = get16(d + 4);
+            TEST_CHECK_EQ(d[3] & 0x03, 0x01); // Isochronous
+            TEST_CHECK(size >= (MAX_SAMPLE_RATE / 1000 + 1) * NUM_CHANNELS * subslot);
+            TEST_CHECK(size <= USB_FS_ISO_MAX_PACKET);
+            if (interface == ITF_NUM_AUDIO_STREAMING_IN) {
+                TEST_CHECK_EQ(d[2], EP_AUDIO_IN);
+            } else {
+                TEST_CHECK_EQ(d[2], EP_AUDIO_OUT);
+            }
+        }
+    }
+    TEST_CHECK_EQ(alts_in, USB_AUDIO_ALT_COUNT);
+#if CONFIG_AUDIO_PLAYBACK
+    TEST_CHECK_EQ(alts_out, USB_AUDIO_ALT_COUNT);
+#else
+    TEST_CHECK_EQ(alts_out, 0);
+#endif
+}
+
+int main(void)
+{
+    usb_descriptors_init();
+    config = usb_descriptors_configuration();
+
+    RUN_TEST(test_device_and_strings);
+    RUN_TEST(test_lengths);
+    RUN_TEST(test_entities);
+    RUN_TEST(test_streaming_endpoints);
+    return TEST_RESULT();
+}
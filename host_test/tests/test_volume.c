@@ -0,0 +1,270 @@
+/**
+ * @file test_volume.c
+ * @author your name (you@domain.com)
+ * @brief Gain, ramp, mute and saturation vectors for the volume stage
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * Every test starts and ends with all channels at unity and no ramp running.
+ */
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "audio_pipeline/volume.h"
+#include "test.h"
+
+#define BLOCK_FRAMES 320
+#define DC_LEVEL 0x40000000 // Half of full scale
+#define BENCH_BLOCKS 20000
+
+static int32_t in[BLOCK_FRAMES * NUM_CHANNELS];
+static int32_t out[BLOCK_FRAMES * NUM_CHANNELS];
+
+static void fill_dc(int32_t* samples, size_t frames, int32_t level)
+{
+    for (size_t i = 0; i < frames * NUM_CHANNELS; i++) {
+        samples[i] = level;
+    }
+}
+
+static void set_all(int32_t gain)
+{
+    for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+        volume_set_gain(ch, gain);
+    }
+}
+
+/**
+ * @brief Back to unity, with the ramp run out
+ *
+ */
+static void restore_unity(void)
+{
+    set_all(VOLUME_UNITY);
+    fill_dc(in, BLOCK_FRAMES, 0);
+    volume_process(in, out, BLOCK_FRAMES);
+    TEST_CHECK(!volume_process(in, out, BLOCK_FRAMES));
+}
+
+static void test_db_conversion(void)
+{
+    TEST_CHECK_EQ(volume_db_q8_to_gain(0), VOLUME_UNITY);
+    TEST_CHECK_NEAR(volume_db_q8_to_gain(-6 * 256), VOLUME_UNITY * 0.501187, VOLUME_UNITY * 1e-5);
+    TEST_CHECK_NEAR(volume_db_q8_to_gain(6 * 256), VOLUME_UNITY * 1.995262, VOLUME_UNITY * 1e-5);
+    TEST_CHECK_NEAR(volume_db_q8_to_gain(-20 * 256), VOLUME_UNITY * 0.1, VOLUME_UNITY * 1e-5);
+    TEST_CHECK_NEAR(volume_db_q8_to_gain(-1), VOLUME_UNITY * 0.999550, VOLUME_UNITY * 1e-5);
+    TEST_CHECK_EQ(volume_db_q8_to_gain(-127 * 256), 7); // 2^24 * 10^-6.35
+    TEST_CHECK_EQ(volume_db_q8_to_gain(INT16_MAX), INT32_MAX);
+}
+
+/**
+ * @brief At unity the stage reports that it did nothing and leaves the output alone
+ *
+ */
+static void test_unity_is_bypassed(void)
+{
+    fill_dc(in, BLOCK_FRAMES, DC_LEVEL);
+    fill_dc(out, BLOCK_FRAMES, 12345);
+    TEST_CHECK(!volume_process(in, out, BLOCK_FRAMES));
+    TEST_CHECK_EQ(out[0], 12345);
+    TEST_CHECK_EQ(out[BLOCK_FRAMES * NUM_CHANNELS - 1], 12345);
+}
+
+/**
+ * @brief A step in gain ramps linearly over VOLUME_RAMP_FRAMES, then holds exactly
+ *
+ */
+static void test_ramp_shape(void)
+{
+    const int32_t half = VOLUME_UNITY / 2;
+    const int64_t step = (int64_t)DC_LEVEL * (VOLUME_UNITY - half) / VOLUME_UNITY / VOLUME_RAMP_FRAMES;
+
+    set_all(half);
+    fill_dc(in, BLOCK_FRAMES, DC_LEVEL);
+    TEST_CHECK(volume_process(in, out, BLOCK_FRAMES));
+
+    for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+        int32_t previous = DC_LEVEL;
+        int64_t largest_step = 0;
+        for (int i = 0; i < VOLUME_RAMP_FRAMES; i++) {
+            int32_t y = out[i * NUM_CHANNELS + ch];
+            TEST_CHECK(y < previous);
+            largest_step = fmax(largest_step, previous - y);
+            previous = y;
+        }
+        TEST_CHECK_NEAR(largest_step, step, 1);
+        TEST_CHECK_EQ(out[(VOLUME_RAMP_FRAMES - 1) * NUM_CHANNELS + ch], DC_LEVEL / 2);
+        TEST_CHECK_EQ(out[(BLOCK_FRAMES - 1) * NUM_CHANNELS + ch], DC_LEVEL / 2);
+    }
+
+    TEST_CHECK(volume_process(in, out, BLOCK_FRAMES));
+    TEST_CHECK_EQ(out[0], DC_LEVEL / 2);
+    restore_unity();
+}
+
+/**
+ * @brief Mute reaches exact digital silence, and unmuting ramps back up from it
+ *
+ */
+static void test_mute_and_unmute(void)
+{
+    set_all(0);
+    fill_dc(in, BLOCK_FRAMES, DC_LEVEL);
+    volume_process(in, out, BLOCK_FRAMES);
+    TEST_CHECK(out[0] > 0);
+    TEST_CHECK_EQ(out[(VOLUME_RAMP_FRAMES - 1) * NUM_CHANNELS], 0);
+
+    volume_process(in, out, BLOCK_FRAMES);
+    for (int i = 0; i < BLOCK_FRAMES * NUM_CHANNELS; i++) {
+        TEST_CHECK_EQ(out[i], 0);
+    }
+
+    set_all(VOLUME_UNITY);
+    volume_process(in, out, BLOCK_FRAMES);
+    TEST_CHECK(out[0] < DC_LEVEL / VOLUME_RAMP_FRAMES * 2);
+    TEST_CHECK_EQ(out[(VOLUME_RAMP_FRAMES - 1) * NUM_CHANNELS], DC_LEVEL);
+    TEST_CHECK(!volume_process(in, out, BLOCK_FRAMES));
+}
+
+/**
+ * @brief Gain above unity saturates instead of wrapping, at both ends
+ *
+ */
+static void test_saturation(void)
+{
+    set_all(volume_db_q8_to_gain(12 * 256));
+    for (int i = 0; i < BLOCK_FRAMES; i++) {
+        for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+            in[i * NUM_CHANNELS + ch] = i % 2 ? INT32_MAX - 1000 : INT32_MIN + 1000;
+        }
+    }
+    volume_process(in, out, BLOCK_FRAMES);
+    volume_process(in, out, BLOCK_FRAMES);
+    for (int i = 0; i < BLOCK_FRAMES; i++) {
+        TEST_CHECK_EQ(out[i * NUM_CHANNELS], i % 2 ? INT32_MAX : INT32_MIN);
+    }
+
+    /* Small signals are amplified exactly, negative ones rounding toward minus infinity */
+    set_all(2 * VOLUME_UNITY);
+    volume_process(in, out, BLOCK_FRAMES);
+    in[0] = -3;
+    in[NUM_CHANNELS] = 3;
+    volume_process(in, out, BLOCK_FRAMES);
+    TEST_CHECK_EQ(out[0], -6);
+    TEST_CHECK_EQ(out[NUM_CHANNELS], 6);
+    restore_unity();
+}
+
+/**
+ * @brief Each channel follows its own gain
+ *
+ */
+static void test_channels_independent(void)
+{
+    for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+        volume_set_gain(ch, VOLUME_UNITY >> ch);
+    }
+    fill_dc(in, BLOCK_FRAMES, DC_LEVEL);
+    volume_process(in, out, BLOCK_FRAMES);
+    for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+        TEST_CHECK_EQ(out[(BLOCK_FRAMES - 1) * NUM_CHANNELS + ch], DC_LEVEL >> ch);
+    }
+    restore_unity();
+}
+
+/**
+ * @brief The output does not depend on how the stream is cut into blocks, and works in place
+ *
+ */
+static void test_block_size_independent(void)
+{
+    static const size_t block_sizes[] = { 1, 7, 100, BLOCK_FRAMES };
+    static int32_t reference[BLOCK_FRAMES * NUM_CHANNELS];
+    static int32_t signal[BLOCK_FRAMES * NUM_CHANNELS];
+
+    for (int i = 0; i < BLOCK_FRAMES * NUM_CHANNELS; i++) {
+        signal[i] = (int32_t)(sin(i * 0.01) * DC_LEVEL);
+    }
+
+    for (size_t b = 0; b < sizeof(block_sizes) / sizeof(block_sizes[0]); b++) {
+        memcpy(in, signal, sizeof(in));
+        set_all(volume_db_q8_to_gain(-10 * 256));
+        for (size_t done = 0; done < BLOCK_FRAMES; done += block_sizes[b]) {
+            size_t n = BLOCK_FRAMES - done < block_sizes[b] ? BLOCK_FRAMES - done : block_sizes[b];
+            volume_process(&in[done * NUM_CHANNELS], &in[done * NUM_CHANNELS], n);
+        }
+        if (b == 0) {
+            memcpy(reference, in, sizeof(reference));
+        } else {
+            TEST_CHECK(memcmp(in, reference, sizeof(reference)) == 0);
+        }
+        restore_unity();
+    }
+}
+
+/**
+ * @brief A new target in the middle of a ramp turns around from the current gain, without a jump
+ *
+ */
+static void test_retarget_mid_ramp(void)
+{
+    fill_dc(in, BLOCK_FRAMES, DC_LEVEL);
+    set_all(0);
+    volume_process(in, out, VOLUME_RAMP_FRAMES / 2);
+    int32_t midway = out[(VOLUME_RAMP_FRAMES / 2 - 1) * NUM_CHANNELS];
+    TEST_CHECK_NEAR(midway, DC_LEVEL / 2, DC_LEVEL / VOLUME_RAMP_FRAMES);
+
+    set_all(VOLUME_UNITY);
+    volume_process(in, out, BLOCK_FRAMES);
+    TEST_CHECK(abs(out[0] - midway) <= DC_LEVEL / VOLUME_RAMP_FRAMES);
+    TEST_CHECK_EQ(out[(VOLUME_RAMP_FRAMES - 1) * NUM_CHANNELS], DC_LEVEL);
+    TEST_CHECK(!volume_process(in, out, BLOCK_FRAMES));
+}
+
+static void test_invalid_arguments(void)
+{
+    volume_set_gain(NUM_CHANNELS, 0);
+    fill_dc(in, BLOCK_FRAMES, DC_LEVEL);
+    TEST_CHECK(!volume_process(in, out, BLOCK_FRAMES));
+
+    volume_set_gain(0, -VOLUME_UNITY);
+    volume_process(in, out, BLOCK_FRAMES);
+    TEST_CHECK_EQ(out[(BLOCK_FRAMES - 1) * NUM_CHANNELS], 0);
+    restore_unity();
+}
+
+static void bench_cost_per_frame(void)
+{
+    struct timespec start, end;
+
+    set_all(volume_db_q8_to_gain(-10 * 256));
+    fill_dc(in, BLOCK_FRAMES, DC_LEVEL);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int b = 0; b < BENCH_BLOCKS; b++) {
+        volume_process(in, out, BLOCK_FRAMES);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    restore_unity();
+
+    double ns = (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+    printf("  %.2f ns per frame, %d channels\n", ns / ((double)BENCH_BLOCKS * BLOCK_FRAMES), NUM_CHANNELS);
+}
+
+int main(void)
+{
+    RUN_TEST(test_db_conversion);
+    RUN_TEST(test_unity_is_bypassed);
+    RUN_TEST(test_ramp_shape);
+    RUN_TEST(test_mute_and_unmute);
+    RUN_TEST(test_saturation);
+    RUN_TEST(test_channels_independent);
+    RUN_TEST(test_block_size_independent);
+    RUN_TEST(test_retarget_mid_ramp);
+    RUN_TEST(test_invalid_arguments);
+    RUN_TEST(bench_cost_per_frame);
+    return TEST_RESULT();
+}
@@ -0,0 +1,78 @@
+/**
+ * @file audio_arena.c
+ * @author your name (you@domain.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include "audio_arena.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "config/audio_config.h"
+#include "esp_attr.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+
+#define MAX_ENTRIES 16
+
+static const char* TAG = "audio-arena";
+
+typedef struct {
+    const char* name;
+    size_t size;
+} arena_entry_t;
+
+typedef struct {
+    size_t used;
+    bool sealed;
+    size_t num_entries;
+    arena_entry_t entries[MAX_ENTRIES];
+} arena_ctx_t;
+
+/* Internal RAM even when .bss may go to PSRAM, so every buffer is DMA-capable */
+static DRAM_ATTR uint8_t arena[AUDIO_ARENA_BYTES] __attribute__((aligned(AUDIO_ARENA_ALIGN)));
+static arena_ctx_t ctx = { 0 };
+
+void* audio_arena_alloc(const char* name, size_t size)
+{
+    size_t rounded = AUDIO_ARENA_ROUND(size);
+
+    if (ctx.sealed) {
+        ESP_LOGE(TAG, "%s: %u bytes requested after boot", name, (unsigned)size);
+        return NULL;
+    }
+    if (rounded > sizeof(arena) - ctx.used) {
+        ESP_LOGE(TAG, "%s: %u bytes requested, %u left", name, (unsigned)size, (unsigned)(sizeof(arena) - ctx.used));
+        return NULL;
+    }
+
+    void* buffer = arena + ctx.used;
+    ctx.used += rounded;
+    if (ctx.num_entries < MAX_ENTRIES) {
+        ctx.entries[ctx.num_entries++] = (arena_entry_t) { .name = name, .size = rounded };
+    }
+    return buffer;
+}
+
+void audio_arena_seal(void)
+{
+    ctx.sealed = true;
+}
+
+void audio_arena_log_budget(void)
+{
+    ESP_LOGI(TAG, "Arena %u of %u bytes used", (unsigned)ctx.used, (unsigned)sizeof(arena));
+    for (size_t i = 0; i < ctx.num_entries; i++) {
+        ESP_LOGI(TAG, "  %-16s %6u", ctx.entries[i].name, (unsigned)ctx.entries[i].size);
+    }
+    ESP_LOGI(TAG, "I2S DMA (driver) %u bytes", (unsigned)AUDIO_I2S_DMA_TOTAL_BYTES);
+    ESP_LOGI(TAG, "Internal heap %u bytes free, %u minimum, largest block %u",
+        (unsigned)heap_caps_get_free_size(MALLOC_CAP_INTERNAL),
+        (unsigned)heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL),
+        (unsigned)heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL));
+}
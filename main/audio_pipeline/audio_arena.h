@@ -0,0 +1,46 @@
+/**
+ * @file audio_arena.h
+ * @author your name (you@domain.com)
+ * @brief Boot-time arena for every audio buffer
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * Rings, scratch blocks and USB staging buffers are carved from one static
+ * arena in internal, DMA-capable RAM instead of the heap. Its size is the sum
+ * of the buffers the configuration needs (AUDIO_ARENA_BYTES), so the audio
+ * footprint is fixed at build time and the heap cannot fragment under the
+ * stream. Carving is only allowed while booting: once audio_arena_seal() has
+ * been called every further request fails.
+ *
+ * The I2S DMA buffers belong to the IDF driver, which allocates them when the
+ * channels are created; they are listed in the budget report but are not part
+ * of the arena.
+ */
+#pragma once
+
+#include <stddef.h>
+
+/**
+ * @brief Carve a buffer from the arena, aligned to AUDIO_ARENA_ALIGN
+ *
+ * Boot only, from the task that runs app_main.
+ *
+ * @param name shown in the budget report
+ * @param size bytes
+ * @return the buffer, or NULL if the arena is exhausted or sealed
+ */
+void* audio_arena_alloc(const char* name, size_t size);
+
+/**
+ * @brief End of boot, refuse any further carving
+ *
+ */
+void audio_arena_seal(void);
+
+/**
+ * @brief Log every carved buffer, the driver-owned DMA buffers and what is left of the heap
+ *
+ */
+void audio_arena_log_budget(void);
@@ -10,83 +10,723 @@
  */
 
 #include "audio_pipeline.h"
+#include "audio_arena.h"
 #include "audio_pipeline_msg.h"
+#include "audio_ring.h"
 #include "config/audio_config.h"
+#include "dsp_chain.h"
 #include "i2s/i2s.h"
+#include "latency.h"
+#include "level_meter.h"
+#include "pcm_convert.h"
+#include "rt_log.h"
+#include "src_polyphase.h"
+#include "telemetry.h"
+#include "volume.h"
 
 #include "esp_err.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/portmacro.h"
 #include "freertos/queue.h"
 
+#include "esp_check.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "portable.h"
+#include "sdkconfig.h"
+#include <inttypes.h>
+#include <math.h>
+#include <stdatomic.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MSG_QUEUE_LEN 10
 
 typedef struct {
     QueueHandle_t msg_queue;
+    StaticQueue_t msg_queue_buffer;
+    uint8_t msg_storage[MSG_QUEUE_LEN * sizeof(audio_pipeline_message_t)];
     audio_config_t audio_config;
-    uint8_t* audio_buffer;
+    uint8_t* convert_buffer; // Converted block
+    int32_t* work_buffer; // Processed block at the capture rate
+    audio_format_t format; // Owned by the producer
+    atomic_int format_pending; // Format to switch to at the next block, or FORMAT_PENDING_NONE
+    atomic_size_t format_start; // Ring position of the first block in the format the producer last switched to
+    audio_format_t format_requested; // Owned by the consumer
+    bool format_switching; // Owned by the consumer: blocks in the old format may still be queued
+    pcm_dither_t dither;
+    audio_pipeline_message_t state; // Owned by the consumer
+    atomic_bool streaming; // state is not PIPELINE_STATE_STOPPED, published for the producer
+    size_t recovery_debt; // Bytes sent as silence since the ring ran dry. Owned by the consumer.
+    audio_latency_profile_t profile; // Owned by the consumer
+    atomic_int profile_pending; // Profile to switch to at the next packet, or PROFILE_PENDING_NONE
+#if CONFIG_AUDIO_SRC
+    int32_t* src_buffer; // Resampled block
+    src_t* src_active; // NULL when capture and USB rates match. Owned by the producer.
+    atomic_int src_pending; // Instance to switch to at the next block
+    atomic_int src_trim_ppb; // Latest trim, applied by the producer at the next block
+    int32_t src_trim_applied_ppb; // Trim of src_active. Owned by the producer.
+#endif
+#if CONFIG_AUDIO_DSP_CHAIN
+    dsp_chain_t dsp_chain;
+#endif
+#if CONFIG_AUDIO_TAP
+    _Atomic(audio_ring_t*) tap;
+#endif
+    /* Owned by the producer */
+    uint32_t captured_frames; // Stream position at the capture rate, concealed gaps included
+    int32_t splice_hold[NUM_CHANNELS]; // Last captured frame, concealment fades out from it
+    uint32_t splice_ramp; // Frames of the fade out already written, up to AUDIO_SPLICE_FADE_FRAMES
+    bool splice_pending; // Crossfade the next block in from the concealment
+    int32_t splice_buffer[AUDIO_SPLICE_FADE_FRAMES * NUM_CHANNELS];
+    uint8_t channel_map[NUM_CHANNELS]; // I2S slot feeding each USB channel
+    bool remap; // False when the map is the identity or the source is not I2S
 } pipeline_ctx_t;
 
 static pipeline_ctx_t ctx = { 0 };
+static audio_ring_t ring;
+
+#define PROFILE_PENDING_NONE -1
+#define FORMAT_PENDING_NONE -1
+
+static const uint32_t latency_profile_ms[AUDIO_LATENCY_PROFILE_COUNT] = {
+    [AUDIO_LATENCY_LOW] = AUDIO_LATENCY_LOW_MS,
+    [AUDIO_LATENCY_BALANCED] = AUDIO_LATENCY_BALANCED_MS,
+    [AUDIO_LATENCY_SAFE] = AUDIO_LATENCY_SAFE_MS,
+};
+
+static const char* const latency_profile_names[AUDIO_LATENCY_PROFILE_COUNT] = {
+    [AUDIO_LATENCY_LOW] = "low-latency",
+    [AUDIO_LATENCY_BALANCED] = "balanced",
+    [AUDIO_LATENCY_SAFE] = "safe",
+};
+
+#if CONFIG_AUDIO_SRC
+#define SRC_PENDING_NONE -1
+#define SRC_PENDING_BYPASS 2
+
+/* Double-buffered so a new ratio can be prepared while the producer runs the old one */
+static src_t src_instances[2];
+
+_Static_assert(AUDIO_SRC_MAX_OUT_FRAMES >= SRC_MAX_OUT_FRAMES(AUDIO_DMA_FRAME_NUM), "Resampled block buffers too small");
+#endif
 
 static const char* TAG = "audio-pipeline";
 
+#if CONFIG_AUDIO_DSP_CHAIN
+#define DSP_DC_BLOCK_SHIFT 10
+
+static esp_err_t dsp_chain_setup(const audio_config_t* audio_config)
+{
+    dsp_chain_t* chain = &ctx.dsp_chain;
+    ESP_RETURN_ON_ERROR(dsp_chain_init(chain, NUM_CHANNELS, AUDIO_DMA_FRAME_NUM, audio_config->i2s_sample_rate), TAG, "DSP chain");
+
+#if CONFIG_AUDIO_DSP_DC_BLOCK
+    ESP_RETURN_ON_ERROR(dsp_chain_add_dc_block(chain, DSP_DC_BLOCK_SHIFT), TAG, "DC block");
+#endif
+
+    if (CONFIG_AUDIO_DSP_TILT_DB_X10 != 0) {
+        const float half_tilt_db = CONFIG_AUDIO_DSP_TILT_DB_X10 / 20.0f;
+        const dsp_biquad_design_t low = {
+            .type = DSP_BIQUAD_LOWSHELF,
+            .freq = CONFIG_AUDIO_DSP_TILT_FREQ,
+            .q = 0.7071f,
+            .gain_db = -half_tilt_db,
+        };
+        const dsp_biquad_design_t high = {
+            .type = DSP_BIQUAD_HIGHSHELF,
+            .freq = CONFIG_AUDIO_DSP_TILT_FREQ,
+            .q = 0.7071f,
+            .gain_db = half_tilt_db,
+        };
+        ESP_RETURN_ON_ERROR(dsp_chain_add_biquad(chain, &low), TAG, "Tilt low shelf");
+        ESP_RETURN_ON_ERROR(dsp_chain_add_biquad(chain, &high), TAG, "Tilt high shelf");
+    }
+
+    if (CONFIG_AUDIO_DSP_GAIN_DB_X10 != 0) {
+        ESP_RETURN_ON_ERROR(dsp_chain_add_gain(chain, CONFIG_AUDIO_DSP_GAIN_DB_X10 / 10.0f), TAG, "Gain");
+    }
+
+#if CONFIG_AUDIO_DSP_CHANNEL_SWAP
+    ESP_RETURN_ON_ERROR(dsp_chain_add_channel_mode(chain, DSP_CHANNEL_SWAP), TAG, "Channel swap");
+#elif CONFIG_AUDIO_DSP_CHANNEL_MONO
+    ESP_RETURN_ON_ERROR(dsp_chain_add_channel_mode(chain, DSP_CHANNEL_MONO), TAG, "Mono sum");
+#endif
+
+    ESP_LOGI(TAG, "DSP chain with %zu stages", chain->num_stages);
+    return ESP_OK;
+}
+#endif
+
+#if CONFIG_AUDIO_SOURCE_I2S
+/**
+ * @brief Parse CONFIG_AUDIO_CHANNEL_MAP, a comma-separated slot per USB channel
+ *
+ * An empty map assigns slot n to USB channel n, wrapping around when there
+ * are more USB channels than slots.
+ */
+static esp_err_t channel_map_setup(void)
+{
+    const char* spec = CONFIG_AUDIO_CHANNEL_MAP;
+
+    for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+        long slot = ch % AUDIO_I2S_SLOTS;
+        if (CONFIG_AUDIO_CHANNEL_MAP[0] != '\0') {
+            char* end;
+            slot = strtol(spec, &end, 10);
+            if (end == spec || slot < 0 || slot >= AUDIO_I2S_SLOTS || (*end != ',' && *end != '\0')) {
+                ESP_LOGE(TAG, "Channel map \"%s\" needs %d slots below %d", CONFIG_AUDIO_CHANNEL_MAP, NUM_CHANNELS, AUDIO_I2S_SLOTS);
+                return ESP_ERR_INVALID_ARG;
+            }
+            spec = *end == ',' ? end + 1 : end;
+        }
+        ctx.channel_map[ch] = slot;
+    }
+    if (*spec != '\0') {
+        ESP_LOGE(TAG, "Channel map \"%s\" has more than %d entries", CONFIG_AUDIO_CHANNEL_MAP, NUM_CHANNELS);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    ctx.remap = NUM_CHANNELS != AUDIO_I2S_SLOTS;
+    for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+        ctx.remap |= ctx.channel_map[ch] != ch;
+    }
+    if (ctx.remap) {
+        ESP_LOGI(TAG, "Mapping %d I2S slots to %d USB channels", AUDIO_I2S_SLOTS, NUM_CHANNELS);
+    }
+    return ESP_OK;
+}
+#endif
+
 esp_err_t audio_pipeline_init(audio_config_t* audio_config)
 {
-    esp_err_t ret = ESP_FAIL;
+    /* Before anything can change state, posts made while the queue is missing are lost */
+    ctx.msg_queue = xQueueCreateStatic(MSG_QUEUE_LEN, sizeof(audio_pipeline_message_t), ctx.msg_storage, &ctx.msg_queue_buffer);
+
+    esp_err_t ret = audio_ring_init(&ring, audio_config->ring_total_size, "audio ring");
+
+    if (ret == ESP_OK) {
+        audio_config->ring = &ring;
+        ESP_LOGI(TAG, "Created audio ring size: %zu bytes", ring.capacity);
+        telemetry_init(ring.capacity);
+        latency_init(&ring);
+    }
+
+#if CONFIG_AUDIO_SOURCE_I2S
+    ESP_RETURN_ON_ERROR(channel_map_setup(), TAG, "Failed to set up the channel map");
+#endif
+
+    ctx.work_buffer = audio_arena_alloc("work block", AUDIO_BLOCK_BYTES);
+    if (ctx.work_buffer == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
 
-    audio_config->stream_buffer_handle = xStreamBufferCreate(
-        audio_config->stream_buffer_total_size,
-        audio_config->audio_bytes_per_ms);
-    
-    if (audio_config->stream_buffer_handle != NULL) {
-        ret = ESP_OK;
-        ESP_LOGI(TAG, "Created streambuffer size: %lu bytes", audio_config->stream_buffer_total_size);
+#if CONFIG_AUDIO_DSP_CHAIN
+    ESP_RETURN_ON_ERROR(dsp_chain_setup(audio_config), TAG, "Failed to set up the DSP chain");
+#endif
+
+#if CONFIG_AUDIO_SRC
+    ctx.src_buffer = audio_arena_alloc("src block", AUDIO_OUT_BLOCK_BYTES);
+    if (ctx.src_buffer == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    atomic_init(&ctx.src_pending, SRC_PENDING_NONE);
+    atomic_init(&ctx.src_trim_ppb, 0);
+    ctx.src_trim_applied_ppb = 0;
+    ctx.src_active = NULL;
+    if (audio_config->i2s_sample_rate != audio_config->sample_rate) {
+        ESP_RETURN_ON_ERROR(src_init(&src_instances[0], audio_config->i2s_sample_rate, audio_config->sample_rate),
+            TAG, "Unsupported resampling ratio");
+        ctx.src_active = &src_instances[0];
     }
-    
+#endif
+
+    ctx.convert_buffer = audio_arena_alloc("convert block", AUDIO_OUT_BLOCK_BYTES);
+    if (ctx.convert_buffer == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    ctx.dither.seed = 0x12345678;
+    ctx.format = audio_config->audio_format;
+    ctx.format_requested = audio_config->audio_format;
+    atomic_init(&ctx.format_pending, FORMAT_PENDING_NONE);
+    atomic_init(&ctx.format_start, 0);
+    ctx.state = PIPELINE_STATE_STOPPED;
+    atomic_init(&ctx.streaming, false);
+    ctx.profile = CONFIG_AUDIO_LATENCY_PROFILE_DEFAULT;
+    atomic_init(&ctx.profile_pending, PROFILE_PENDING_NONE);
     ctx.audio_config = *audio_config;
-    
+#if CONFIG_AUDIO_LEVEL_METER
+    level_meter_set_sample_rate(audio_config->i2s_sample_rate);
+#endif
+
     return ret;
 }
 
-void audio_pipeline_task(void* pvParams)
+#if CONFIG_AUDIO_TAP
+static void tap_write(const int32_t* samples, size_t num_samples)
 {
-    ctx.msg_queue = xQueueCreate( 10, sizeof(audio_pipeline_message_t) );
-    if (ctx.msg_queue != NULL) {
-        ESP_LOGI(TAG, "Message queue created");
+    audio_ring_t* tap = atomic_load_explicit(&ctx.tap, memory_order_acquire);
+    size_t frames = num_samples / NUM_CHANNELS;
+
+    if (tap != NULL) {
+        audio_tap_record_t record = {
+            .frame_index = ctx.captured_frames,
+            .frames = frames,
+        };
+        size_t size = num_samples * sizeof(int32_t);
+        if (audio_ring_free(tap) >= sizeof(record) + size) {
+            audio_ring_write(tap, &record, sizeof(record));
+            audio_ring_write(tap, samples, size);
+        }
     }
+}
 
-    ctx.audio_buffer = (uint8_t*)pvPortMalloc(ctx.audio_config.i2s_dma_size);
-    size_t bytes_read = 0;
+void audio_pipeline_set_tap(audio_ring_t* tap)
+{
+    atomic_store_explicit(&ctx.tap, tap, memory_order_release);
+}
+#endif
 
-    while (1) {
-        // Send to buffer
+/**
+ * @brief Producer side: switch to a requested format between two blocks
+ *
+ * Records where in the ring the new format starts, so the consumer can
+ * drop whatever was written before without relying on when it flushed.
+ */
+static void apply_format_pending(void)
+{
+    int pending = atomic_load_explicit(&ctx.format_pending, memory_order_acquire);
+    if (pending == FORMAT_PENDING_NONE) {
+        return;
+    }
+    ctx.format = pending;
+    atomic_store_explicit(&ctx.format_start, atomic_load_explicit(&ctx.audio_config.ring->head, memory_order_relaxed),
+        memory_order_relaxed);
+    /* Fails if yet another format was requested meanwhile, the next block picks that up */
+    atomic_compare_exchange_strong_explicit(&ctx.format_pending, &pending, FORMAT_PENDING_NONE,
+        memory_order_release, memory_order_relaxed);
+}
+
+/**
+ * @return false if the block did not reach the ring
+ */
+static bool write_block(const int32_t* samples, size_t num_samples)
+{
+    apply_format_pending();
+    audio_format_t format = ctx.format;
+
+#if CONFIG_AUDIO_TAP
+    tap_write(samples, num_samples);
+#endif
+
+#if CONFIG_AUDIO_LEVEL_METER
+    level_meter_process(samples, num_samples / NUM_CHANNELS);
+#endif
+
+#if CONFIG_AUDIO_DSP_CHAIN
+    if (ctx.dsp_chain.num_stages > 0) {
+        dsp_chain_process(&ctx.dsp_chain, samples, ctx.work_buffer, num_samples / NUM_CHANNELS);
+        samples = ctx.work_buffer;
+    }
+#endif
+
+    if (volume_process(samples, ctx.work_buffer, num_samples / NUM_CHANNELS)) {
+        samples = ctx.work_buffer;
+    }
+
+#if CONFIG_AUDIO_SRC
+    int pending = atomic_exchange(&ctx.src_pending, SRC_PENDING_NONE);
+    if (pending != SRC_PENDING_NONE) {
+        ctx.src_active = pending == SRC_PENDING_BYPASS ? NULL : &src_instances[pending];
+    }
+
+    if (ctx.src_active != NULL) {
+        /* A new instance starts at its nominal ratio, so it takes the current trim whatever it was */
+        int32_t trim = atomic_load_explicit(&ctx.src_trim_ppb, memory_order_relaxed);
+        if (trim != ctx.src_trim_applied_ppb || pending != SRC_PENDING_NONE) {
+            src_set_trim_ppb(ctx.src_active, trim);
+            ctx.src_trim_applied_ppb = trim;
+        }
+        size_t frames = src_process(ctx.src_active, samples, num_samples / NUM_CHANNELS, ctx.src_buffer);
+        samples = ctx.src_buffer;
+        num_samples = frames * NUM_CHANNELS;
+    }
+#endif
+
+    /* Nobody drains the ring while stopped, and starting flushes it anyway */
+    if (!atomic_load_explicit(&ctx.streaming, memory_order_acquire)) {
+        return false;
+    }
+
+    const void* block = samples;
+    size_t block_size = num_samples * sizeof(int32_t);
+
+    if (format != PCM_FORMAT_32BIT) {
+#if CONFIG_AUDIO_PCM_DITHER
+        pcm_dither_t* dither = &ctx.dither;
+#else
+        pcm_dither_t* dither = NULL;
+#endif
+        block_size = pcm_convert(format, samples, ctx.convert_buffer, num_samples, dither);
+        block = ctx.convert_buffer;
+    }
+
+    /* All or nothing: a partial write could end mid-frame and shift every later frame on the wire */
+    if (audio_ring_free(ctx.audio_config.ring) < block_size) {
+        telemetry_record_overrun(block_size);
+        rt_log(RT_LOG_OVERRUN, block_size, 0, 0);
+        return false;
+    }
+    audio_ring_write(ctx.audio_config.ring, block, block_size);
+    return true;
+}
+
+/**
+ * @brief Gain of the fade out from splice_hold at a frame of the splice, in 1/(AUDIO_SPLICE_FADE_FRAMES + 1)
+ *
+ */
+static inline uint32_t hold_gain(uint32_t pos)
+{
+    return pos < AUDIO_SPLICE_FADE_FRAMES ? AUDIO_SPLICE_FADE_FRAMES - pos : 0;
+}
+
+/**
+ * @brief Concealment for missing frames: the last captured frame fading to silence
+ *
+ */
+static void conceal(int32_t* out, size_t frames)
+{
+    for (size_t i = 0; i < frames; i++) {
+        uint32_t gain = hold_gain(ctx.splice_ramp + i);
+        for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+            *out++ = (int32_t)((int64_t)ctx.splice_hold[ch] * gain / (AUDIO_SPLICE_FADE_FRAMES + 1));
+        }
+    }
+    ctx.splice_ramp = ctx.splice_ramp + frames < AUDIO_SPLICE_FADE_FRAMES ? ctx.splice_ramp + frames : AUDIO_SPLICE_FADE_FRAMES;
+}
+
+/**
+ * @brief Crossfade from the concealment into the first frames after a gap
+ *
+ * The concealment keeps fading out underneath while the new block fades in,
+ * so the sum never exceeds either signal's level.
+ *
+ * @return number of frames written to splice_buffer
+ */
+static size_t splice_in(const int32_t* samples, size_t frames)
+{
+    size_t n = frames < AUDIO_SPLICE_FADE_FRAMES ? frames : AUDIO_SPLICE_FADE_FRAMES;
+    int32_t* out = ctx.splice_buffer;
+
+    for (size_t i = 0; i < n; i++) {
+        uint32_t old_gain = hold_gain(ctx.splice_ramp + i);
+        uint32_t new_gain = i + 1;
+        for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+            int64_t mix = (int64_t)ctx.splice_hold[ch] * old_gain + (int64_t)*samples++ * new_gain;
+            *out++ = (int32_t)(mix / (AUDIO_SPLICE_FADE_FRAMES + 1));
+        }
+    }
+    ctx.splice_pending = false;
+    return n;
+}
+
+bool audio_pipeline_write_block(const int32_t* samples, size_t num_samples)
+{
+    size_t frames = num_samples / NUM_CHANNELS;
+    bool written = false;
+    if (frames == 0) {
+        return false;
+    }
+
+    /* Saved first, processing the crossfaded head reuses the work buffer, which may be the input */
+    int32_t last[NUM_CHANNELS];
+    memcpy(last, samples + (frames - 1) * NUM_CHANNELS, sizeof(last));
+
+    if (ctx.splice_pending) {
+        size_t n = splice_in(samples, frames);
+        written = write_block(ctx.splice_buffer, n * NUM_CHANNELS);
+        ctx.captured_frames += n;
+        samples += n * NUM_CHANNELS;
+        frames -= n;
+    }
+    if (frames > 0) {
+        written = write_block(samples, frames * NUM_CHANNELS);
+        ctx.captured_frames += frames;
+    }
+
+    memcpy(ctx.splice_hold, last, sizeof(last));
+    return written;
+}
+
+void audio_pipeline_write_gap(size_t frames)
+{
+    if (frames > AUDIO_SPLICE_MAX_GAP_MS * ctx.audio_config.i2s_sample_rate / 1000) {
+        /* Too long to hide, the USB side resynchronises when it runs dry */
+        telemetry_record_gap(ctx.captured_frames, frames, false);
+        rt_log(RT_LOG_CAPTURE_LOST, ctx.captured_frames, frames, 0);
+        return;
+    }
+    telemetry_record_gap(ctx.captured_frames, frames, true);
+    rt_log(RT_LOG_CAPTURE_GAP, ctx.captured_frames, frames, 0);
+
+    if (!ctx.splice_pending) {
+        ctx.splice_ramp = 0;
+    }
+    while (frames > 0) {
+        size_t n = frames < AUDIO_DMA_FRAME_NUM ? frames : AUDIO_DMA_FRAME_NUM;
+        conceal(ctx.work_buffer, n);
+        write_block(ctx.work_buffer, n * NUM_CHANNELS);
+        ctx.captured_frames += n;
+        frames -= n;
+    }
+    ctx.splice_pending = true;
+}
+
+bool audio_pipeline_write_capture(const int32_t* slots, size_t num_slots)
+{
+    if (!ctx.remap) {
+        return audio_pipeline_write_block(slots, num_slots);
+    }
+
+    size_t frames = num_slots / AUDIO_I2S_SLOTS;
+    if (frames > AUDIO_DMA_FRAME_NUM) {
+        frames = AUDIO_DMA_FRAME_NUM;
+    }
+    pcm_remap(slots, AUDIO_I2S_SLOTS, ctx.channel_map, NUM_CHANNELS, ctx.work_buffer, frames);
+    return audio_pipeline_write_block(ctx.work_buffer, frames * NUM_CHANNELS);
+}
+
+esp_err_t audio_pipeline_set_format(audio_format_t format)
+{
+    if (format == PCM_FORMAT_UNKNOWN || format > PCM_FORMAT_24BIT_IN_32BIT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (format != ctx.format_requested) {
+        ctx.format_requested = format;
+        ctx.format_switching = true;
+        atomic_store_explicit(&ctx.format_pending, format, memory_order_release);
+        rt_log(RT_LOG_FORMAT, format, 0, 0);
+        audio_pipeline_flush();
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief Consumer side: once the producer has switched format, drop what it wrote before
+ *
+ * @return false while the producer has not picked up the switch yet
+ */
+static bool finish_format_switch(void)
+{
+    if (atomic_load_explicit(&ctx.format_pending, memory_order_acquire) != FORMAT_PENDING_NONE) {
+        return false;
+    }
 
-        i2s_read(ctx.audio_buffer, &bytes_read);
+    audio_ring_t* ring = ctx.audio_config.ring;
+    size_t stale = atomic_load_explicit(&ctx.format_start, memory_order_relaxed)
+        - atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    /* Anything the flush or a later one already dropped leaves nothing to skip */
+    if (stale <= audio_ring_fill(ring)) {
+        audio_ring_consume(ring, stale);
+    }
+    ctx.format_switching = false;
+    return true;
+}
+
+static void set_state(audio_pipeline_message_t state)
+{
+    if (state != ctx.state) {
+        ctx.state = state;
+        atomic_store_explicit(&ctx.streaming, state != PIPELINE_STATE_STOPPED, memory_order_release);
+        audio_pipeline_msg_post(state);
+    }
+}
 
-        size_t bytes_written = xStreamBufferSend(
-            ctx.audio_config.stream_buffer_handle,
-            ctx.audio_buffer,
-            ctx.audio_config.i2s_dma_size,
-            0);
+void audio_pipeline_start(void)
+{
+    if (ctx.state == PIPELINE_STATE_STOPPED) {
+        audio_ring_flush(ctx.audio_config.ring);
+        set_state(PIPELINE_STATE_BUFFERING);
+    }
+}
+
+void audio_pipeline_stop(void)
+{
+    set_state(PIPELINE_STATE_STOPPED);
+}
 
-        if (bytes_written != ctx.audio_config.i2s_dma_size) {
-            ESP_LOGE(TAG, "bytes_written != i2s_dma_size");
+audio_pipeline_message_t audio_pipeline_update_state(size_t fill, size_t packet_len, audio_splice_t* splice)
+{
+    *splice = (audio_splice_t) { .kind = AUDIO_SPLICE_NONE };
+
+    if (ctx.format_switching) {
+        if (!finish_format_switch()) {
+            return ctx.state;
         }
+        fill = audio_ring_fill(ctx.audio_config.ring);
+    }
 
+    int profile = atomic_exchange(&ctx.profile_pending, PROFILE_PENDING_NONE);
+    if (profile != PROFILE_PENDING_NONE && (audio_latency_profile_t)profile != ctx.profile) {
+        ctx.profile = profile;
+        rt_log(RT_LOG_LATENCY_PROFILE, profile, latency_profile_ms[profile], 0);
+        audio_pipeline_flush();
+        telemetry_reset_latency();
+        fill = 0;
+    }
+
+    switch (ctx.state) {
+    case PIPELINE_STATE_BUFFERING:
+        /* packet_len is one millisecond of audio */
+        if (fill >= packet_len * latency_profile_ms[ctx.profile]) {
+            set_state(PIPELINE_STATE_RUNNING);
+        }
+        break;
+    case PIPELINE_STATE_RUNNING:
+        if (fill < packet_len) {
+            telemetry_record_underrun(packet_len - fill);
+            rt_log(RT_LOG_UNDERRUN, packet_len - fill, 0, 0);
+            audio_pipeline_msg_post(PIPELINE_STATUS_UNDERRUN);
+            ctx.recovery_debt = packet_len - fill;
+            splice->kind = AUDIO_SPLICE_FADE_OUT;
+            set_state(PIPELINE_STATE_RECOVERING);
+        }
+        break;
+    case PIPELINE_STATE_RECOVERING:
+        if (fill >= ctx.recovery_debt + packet_len) {
+            /* Skip what the host already got as silence, the next frame is the one due now */
+            audio_ring_consume(ctx.audio_config.ring, ctx.recovery_debt);
+            splice->kind = AUDIO_SPLICE_FADE_IN;
+            splice->skipped = ctx.recovery_debt;
+            set_state(PIPELINE_STATE_RUNNING);
+        } else if ((ctx.recovery_debt += packet_len) > packet_len * latency_profile_ms[ctx.profile]) {
+            /* Catching up would eat the whole prebuffer, start over instead */
+            telemetry_record_resync();
+            rt_log(RT_LOG_RESYNC, ctx.recovery_debt, 0, 0);
+            set_state(PIPELINE_STATE_BUFFERING);
+        }
+        break;
+    default:
+        break;
+    }
+    return ctx.state;
+}
 
-        // audio_pipeline_message_t message;
-        // xQueueReceive(ctx.msg_queue, &message, portMAX_DELAY);
-        // ESP_LOGI(TAG, "Mesage ID: %lu", message);
+esp_err_t audio_pipeline_set_latency_profile(audio_latency_profile_t profile)
+{
+    if (profile >= AUDIO_LATENCY_PROFILE_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    ESP_LOGI(TAG, "Latency profile %s (%" PRIu32 " ms) requested", latency_profile_names[profile], latency_profile_ms[profile]);
+    atomic_store(&ctx.profile_pending, profile);
+    return ESP_OK;
+}
+
+uint32_t audio_pipeline_get_latency_ms(void)
+{
+    return latency_profile_ms[ctx.profile];
+}
+
+void audio_pipeline_set_capture_rate(uint32_t sample_rate)
+{
+    ctx.audio_config.i2s_sample_rate = sample_rate;
+#if CONFIG_AUDIO_LEVEL_METER
+    level_meter_set_sample_rate(sample_rate);
+#endif
+#if CONFIG_AUDIO_DSP_CHAIN
+    dsp_chain_set_sample_rate(&ctx.dsp_chain, sample_rate);
+#endif
+}
+
+#if CONFIG_AUDIO_DSP_CHAIN
+dsp_chain_t* audio_pipeline_get_dsp_chain(void)
+{
+    return &ctx.dsp_chain;
+}
+
+void audio_pipeline_log_dsp_stats(void)
+{
+    dsp_chain_log_stats(&ctx.dsp_chain);
+}
+#endif
+
+#if CONFIG_AUDIO_SRC
+esp_err_t audio_pipeline_set_output_rate(uint32_t sample_rate)
+{
+    if (atomic_load(&ctx.src_pending) != SRC_PENDING_NONE) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    int next = SRC_PENDING_BYPASS;
+    if (sample_rate != ctx.audio_config.i2s_sample_rate) {
+        /* The producer only switches instances when it picks up src_pending, so the inactive one is free */
+        next = ctx.src_active == &src_instances[0] ? 1 : 0;
+        ESP_RETURN_ON_ERROR(src_init(&src_instances[next], ctx.audio_config.i2s_sample_rate, sample_rate),
+            TAG, "Unsupported resampling ratio");
+    }
+
+    ESP_LOGI(TAG, "Resampling %" PRIu32 " Hz -> %" PRIu32 " Hz", ctx.audio_config.i2s_sample_rate, sample_rate);
+    ctx.audio_config.sample_rate = sample_rate;
+    atomic_store(&ctx.src_pending, next);
+    return ESP_OK;
+}
+
+void audio_pipeline_set_src_trim_ppm(float ppm)
+{
+    /* The producer owns the active instance and applies this between two blocks */
+    atomic_store_explicit(&ctx.src_trim_ppb, (int32_t)lroundf(ppm * 1000.0f), memory_order_relaxed);
+}
+#endif
+
+static const char* message_name(audio_pipeline_message_t msg)
+{
+    switch (msg) {
+    case PIPELINE_STATUS_OVERRUN:
+        return "overrun";
+    case PIPELINE_STATUS_UNDERRUN:
+        return "underrun";
+    case PIPELINE_STATE_STOPPED:
+        return "stopped";
+    case PIPELINE_STATE_BUFFERING:
+        return "buffering";
+    case PIPELINE_STATE_RUNNING:
+        return "running";
+    case PIPELINE_STATE_RECOVERING:
+        return "recovering";
+    default:
+        return "status";
+    }
+}
+
+void audio_pipeline_monitor_task(void* pvParams)
+{
+    audio_pipeline_message_t state = PIPELINE_STATE_STOPPED;
+    int64_t since_us = esp_timer_get_time();
+
+    while (1) {
+        audio_pipeline_message_t msg;
+        xQueueReceive(ctx.msg_queue, &msg, portMAX_DELAY);
+
+        int64_t now_us = esp_timer_get_time();
+        if (msg < PIPELINE_STATE_STOPPED) {
+            ESP_LOGW(TAG, "%s (%u) while %s", message_name(msg), msg, message_name(state));
+            continue;
+        }
+        ESP_LOGI(TAG, "State %s -> %s after %" PRIu32 " ms", message_name(state), message_name(msg),
+            (uint32_t)((now_us - since_us) / 1000));
+        state = msg;
+        since_us = now_us;
     }
 }
 
 void audio_pipeline_msg_post(audio_pipeline_message_t msg)
 {
     if (ctx.msg_queue != NULL) {
-        xQueueSend(ctx.msg_queue, (void*)msg, 0);
+        xQueueSend(ctx.msg_queue, &msg, 0);
     }
 }
 
@@ -94,25 +734,24 @@ void audio_pipeline_msg_post_from_isr(audio_pipeline_message_t msg)
 {
     BaseType_t xHigherPriorityTaskWoken = pdFALSE;
     if (ctx.msg_queue != NULL) {
-        xQueueSendFromISR(ctx.msg_queue, (void*)msg, &xHigherPriorityTaskWoken);
+        xQueueSendFromISR(ctx.msg_queue, &msg, &xHigherPriorityTaskWoken);
     }
 
     if (xHigherPriorityTaskWoken) {
-        // TODO: yield
+        portYIELD_FROM_ISR();
     }
 }
 
 esp_err_t audio_pipeline_flush(void)
 {
-    esp_err_t ret = ESP_FAIL;
-
-    if (ctx.audio_config.stream_buffer_handle == NULL) {
+    if (ctx.audio_config.ring == NULL) {
         return ESP_FAIL;
     }
 
-    ESP_LOGW(TAG, "Flushing pipeline");
-    if (xStreamBufferReset(ctx.audio_config.stream_buffer_handle) == pdTRUE) {
-        ret = ESP_OK;
+    rt_log(RT_LOG_FLUSH, 0, 0, 0);
+    audio_ring_flush(ctx.audio_config.ring);
+    if (ctx.state == PIPELINE_STATE_RUNNING || ctx.state == PIPELINE_STATE_RECOVERING) {
+        set_state(PIPELINE_STATE_BUFFERING);
     }
-    return ret;
+    return ESP_OK;
 }
\ No newline at end of file
@@ -11,10 +11,198 @@
 
 #pragma once
 
+#include <stdbool.h>
+
+#include "audio_pipeline_msg.h"
 #include "config/audio_config.h"
+#include "dsp_chain.h"
+
+/**
+ * Named buffering depths. The USB side holds back until the ring has been
+ * prebuffered to the profile's depth. On underrun it sends silence until the
+ * late audio arrives and skips as many frames as it sent, so the stream stays
+ * time-aligned; only a gap longer than the depth makes it prebuffer again.
+ */
+typedef enum {
+    AUDIO_LATENCY_LOW, // 10 ms, just above one DMA block
+    AUDIO_LATENCY_BALANCED, // 40 ms
+    AUDIO_LATENCY_SAFE, // 150 ms, centered in the 300 ms ring
+    AUDIO_LATENCY_PROFILE_COUNT,
+} audio_latency_profile_t;
+
+/**
+ * Fade the consumer applies to the packet it is about to send
+ */
+typedef enum {
+    AUDIO_SPLICE_NONE,
+    AUDIO_SPLICE_FADE_OUT, // The ring ran dry: fade out the frames left, then silence
+    AUDIO_SPLICE_FADE_IN, // Late audio arrived and the frames sent as silence were skipped
+} audio_splice_kind_t;
+
+typedef struct {
+    audio_splice_kind_t kind;
+    size_t skipped; // Bytes dropped from the ring to catch up, with AUDIO_SPLICE_FADE_IN
+} audio_splice_t;
 
 esp_err_t audio_pipeline_init(audio_config_t* audio_config);
 
+/**
+ * @brief Convert one block of captured 32-bit samples to the current format and queue it for USB
+ *
+ * Called from the I2S receive callback.
+ *
+ * @param samples interleaved 32-bit I2S words
+ * @param num_samples number of words (frames * channels)
+ * @return true if the last frame reached the ring, false if it was dropped on
+ *         overrun or while stopped. Only then may its capture time be stamped.
+ */
+bool audio_pipeline_write_block(const int32_t* samples, size_t num_samples);
+
+/**
+ * @brief Fill frames the source lost, so later audio keeps its place in the stream
+ *
+ * Writes the last captured frame fading to silence in place of the missing
+ * frames, and the next block crossfades in from it. Gaps longer than
+ * AUDIO_SPLICE_MAX_GAP_MS are only counted. Called from the producer, before
+ * the first block after the gap.
+ *
+ * @param frames number of frames lost at the capture rate
+ */
+void audio_pipeline_write_gap(size_t frames);
+
+/**
+ * @brief Map one block of captured I2S slots to the USB channels and queue it
+ *
+ * Applies CONFIG_AUDIO_CHANNEL_MAP, then continues as audio_pipeline_write_block().
+ * The mapping is skipped when every USB channel comes from the slot of the same number.
+ *
+ * @param slots interleaved 32-bit I2S words, AUDIO_I2S_SLOTS per frame
+ * @param num_slots number of words (frames * AUDIO_I2S_SLOTS)
+ * @return as audio_pipeline_write_block()
+ */
+bool audio_pipeline_write_capture(const int32_t* slots, size_t num_slots);
+
+/**
+ * @brief Change the sample format delivered to USB
+ *
+ * The producer switches at its next block, and records where in the ring
+ * the new format starts. Until then the consumer keeps prebuffering, then
+ * drops everything queued before that point, so no block in the old format
+ * is ever sent in the new one. Must be called from the ring consumer (USB) context.
+ *
+ * @param format new format
+ * @return ESP_OK, or ESP_ERR_INVALID_ARG for an unknown format
+ */
+esp_err_t audio_pipeline_set_format(audio_format_t format);
+
+/**
+ * @brief Resample captured audio to a new USB sample rate
+ *
+ * The filter is prepared in the caller's context and swapped in at the next
+ * captured block. Only available with CONFIG_AUDIO_SRC.
+ *
+ * @param sample_rate rate delivered to USB, the capture rate is unchanged
+ * @return ESP_OK, ESP_ERR_INVALID_ARG for an unsupported ratio, or
+ *         ESP_ERR_INVALID_STATE if the previous change has not been picked up yet
+ */
+esp_err_t audio_pipeline_set_output_rate(uint32_t sample_rate);
+
+/**
+ * @brief Fine-tune the resampling ratio, e.g. to track drift between capture and USB clocks
+ *
+ * Callable from any task; the producer applies the latest value at the next
+ * block, also to an instance switched in by audio_pipeline_set_output_rate().
+ *
+ * @param ppm output rate deviation, positive produces more output frames
+ */
+void audio_pipeline_set_src_trim_ppm(float ppm);
+
+/**
+ * @brief Discard all buffered audio and prebuffer again. Must be called from the ring consumer (USB) context.
+ *
+ */
 esp_err_t audio_pipeline_flush(void);
 
-void audio_pipeline_task(void* pvParams);
+/**
+ * @brief Start/stop the consumer state machine (STOPPED <-> BUFFERING)
+ *
+ * While stopped the producer still feeds the tap and the level meter but
+ * leaves the ring alone, so a stopped stream does not count overruns.
+ */
+void audio_pipeline_start(void);
+void audio_pipeline_stop(void);
+
+/**
+ * @brief Advance the buffering state machine. Called by the consumer once per USB packet.
+ *
+ * @param fill bytes currently in the ring
+ * @param packet_len bytes the next packet needs
+ * @param splice set to the fade to apply to this packet
+ * @return PIPELINE_STATE_RUNNING if the packet should be taken from the ring,
+ *         PIPELINE_STATE_RECOVERING with AUDIO_SPLICE_FADE_OUT if the frames left should be taken,
+ *         otherwise silence should be sent
+ */
+audio_pipeline_message_t audio_pipeline_update_state(size_t fill, size_t packet_len, audio_splice_t* splice);
+
+/**
+ * @brief Select a latency profile. Applied by the consumer at the next packet,
+ *        which flushes the ring and prebuffers to the new depth.
+ *
+ * @return ESP_OK, or ESP_ERR_INVALID_ARG for an unknown profile
+ */
+esp_err_t audio_pipeline_set_latency_profile(audio_latency_profile_t profile);
+
+/**
+ * @brief Target buffering depth of the active latency profile
+ *
+ */
+uint32_t audio_pipeline_get_latency_ms(void);
+
+/**
+ * @brief Tell the pipeline the capture rate changed, so rate dependent stages follow
+ *
+ */
+void audio_pipeline_set_capture_rate(uint32_t sample_rate);
+
+#if CONFIG_AUDIO_DSP_CHAIN
+/**
+ * @brief Processing chain set up from Kconfig, for adding stages at boot
+ *
+ * Stages may only be added before capture starts.
+ */
+dsp_chain_t* audio_pipeline_get_dsp_chain(void);
+
+/**
+ * @brief Log the cycle cost of every processing stage
+ *
+ */
+void audio_pipeline_log_dsp_stats(void);
+#endif
+
+#if CONFIG_AUDIO_TAP
+/**
+ * Record header preceding every captured block in the tap ring
+ */
+typedef struct {
+    uint32_t frame_index; // Stream position of the first frame, counts dropped blocks too
+    uint32_t frames;
+} audio_tap_record_t;
+
+/**
+ * @brief Copy raw captured blocks into a ring for the capture tap
+ *
+ * Blocks that do not fit whole are dropped, leaving a gap in frame_index.
+ * The caller must be the only consumer of the ring.
+ *
+ * @param tap ring receiving audio_tap_record_t headers followed by interleaved
+ *            int32 samples, or NULL to stop
+ */
+void audio_pipeline_set_tap(audio_ring_t* tap);
+#endif
+
+/**
+ * @brief Consume the pipeline message queue: log state transitions with the
+ * time spent in the previous state, and status reports such as underruns
+ *
+ */
+void audio_pipeline_monitor_task(void* pvParams);
@@ -23,6 +23,7 @@ typedef enum {
     PIPELINE_STATE_STOPPED,
     PIPELINE_STATE_BUFFERING,
     PIPELINE_STATE_RUNNING,
+    PIPELINE_STATE_RECOVERING, // Ran dry while streaming, sending silence until the late audio arrives
 } audio_pipeline_message_t;
 
 void audio_pipeline_msg_post(audio_pipeline_message_t msg);
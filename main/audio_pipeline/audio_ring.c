@@ -0,0 +1,115 @@
+/**
+ * @file audio_ring.c
+ * @author your name (you@domain.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include "audio_ring.h"
+
+#include <string.h>
+
+#include "audio_arena.h"
+
+static size_t round_up_pow2(size_t n)
+{
+    size_t p = 1;
+    while (p < n) {
+        p <<= 1;
+    }
+    return p;
+}
+
+esp_err_t audio_ring_init(audio_ring_t* ring, size_t min_capacity, const char* name)
+{
+    size_t capacity = round_up_pow2(min_capacity);
+
+    ring->buffer = audio_arena_alloc(name, capacity);
+    if (ring->buffer == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    ring->capacity = capacity;
+    ring->mask = capacity - 1;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    return ESP_OK;
+}
+
+size_t audio_ring_write(audio_ring_t* ring, const void* data, size_t len)
+{
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    size_t space = ring->capacity - (head - tail);
+
+    if (len > space) {
+        len = space;
+    }
+
+    size_t offset = head & ring->mask;
+    size_t first = ring->capacity - offset;
+    if (first > len) {
+        first = len;
+    }
+    memcpy(ring->buffer + offset, data, first);
+    memcpy(ring->buffer, (const uint8_t*)data + first, len - first);
+
+    atomic_store_explicit(&ring->head, head + len, memory_order_release);
+    return len;
+}
+
+size_t audio_ring_read(audio_ring_t* ring, void* data, size_t len)
+{
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    size_t available = head - tail;
+
+    if (len > available) {
+        len = available;
+    }
+
+    size_t offset = tail & ring->mask;
+    size_t first = ring->capacity - offset;
+    if (first > len) {
+        first = len;
+    }
+    memcpy(data, ring->buffer + offset, first);
+    memcpy((uint8_t*)data + first, ring->buffer, len - first);
+
+    atomic_store_explicit(&ring->tail, tail + len, memory_order_release);
+    return len;
+}
+
+size_t audio_ring_peek(audio_ring_t* ring, const uint8_t** data, size_t len)
+{
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    size_t available = head - tail;
+    size_t offset = tail & ring->mask;
+    size_t contiguous = ring->capacity - offset;
+
+    if (len > available) {
+        len = available;
+    }
+    if (len > contiguous) {
+        len = contiguous;
+    }
+
+    *data = ring->buffer + offset;
+    return len;
+}
+
+void audio_ring_consume(audio_ring_t* ring, size_t len)
+{
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    atomic_store_explicit(&ring->tail, tail + len, memory_order_release);
+}
+
+void audio_ring_flush(audio_ring_t* ring)
+{
+    size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    atomic_store_explicit(&ring->tail, head, memory_order_release);
+}
@@ -0,0 +1,99 @@
+/**
+ * @file audio_ring.h
+ * @author your name (you@domain.com)
+ * @brief Lock-free single-producer/single-consumer byte ring for audio data
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * One context (the audio source) writes, one context (the TinyUSB task) reads.
+ * Head and tail are free-running byte counters, so the fill level is simply
+ * head - tail and no slot has to be sacrificed to tell full from empty.
+ * Neither side takes a lock or enters a critical section.
+ */
+#pragma once
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+/* Keep producer and consumer indices on separate cache lines */
+#define AUDIO_RING_CACHE_LINE 64
+
+typedef struct {
+    _Alignas(AUDIO_RING_CACHE_LINE) atomic_size_t head; // Written by producer only
+    _Alignas(AUDIO_RING_CACHE_LINE) atomic_size_t tail; // Written by consumer only
+    _Alignas(AUDIO_RING_CACHE_LINE) uint8_t* buffer;
+    size_t capacity; // Power of two
+    size_t mask;
+} audio_ring_t;
+
+/**
+ * @brief Carve the ring storage from the audio arena
+ *
+ * @param ring ring to initialize
+ * @param min_capacity requested size in bytes, rounded up to a power of two
+ * @param name shown in the arena budget report
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if the storage could not be allocated
+ */
+esp_err_t audio_ring_init(audio_ring_t* ring, size_t min_capacity, const char* name);
+
+/**
+ * @brief Producer side: copy as many bytes as fit into the ring
+ *
+ * @return number of bytes written
+ */
+size_t audio_ring_write(audio_ring_t* ring, const void* data, size_t len);
+
+/**
+ * @brief Consumer side: copy up to len bytes out of the ring
+ *
+ * @return number of bytes read
+ */
+size_t audio_ring_read(audio_ring_t* ring, void* data, size_t len);
+
+/**
+ * @brief Consumer side: get a pointer to readable data without copying it
+ *
+ * Only the contiguous part up to the end of the storage is returned, so a
+ * region that wraps needs two peek/consume rounds.
+ *
+ * @param data set to the first readable byte
+ * @param len maximum number of bytes wanted
+ * @return number of bytes readable at data
+ */
+size_t audio_ring_peek(audio_ring_t* ring, const uint8_t** data, size_t len);
+
+/**
+ * @brief Consumer side: release bytes previously obtained with audio_ring_peek
+ *
+ */
+void audio_ring_consume(audio_ring_t* ring, size_t len);
+
+/**
+ * @brief Consumer side: discard everything currently in the ring
+ *
+ */
+void audio_ring_flush(audio_ring_t* ring);
+
+/**
+ * @brief Number of bytes available for reading
+ *
+ */
+static inline size_t audio_ring_fill(audio_ring_t* ring)
+{
+    return atomic_load_explicit(&ring->head, memory_order_acquire)
+        - atomic_load_explicit(&ring->tail, memory_order_acquire);
+}
+
+/**
+ * @brief Number of bytes that can be written without dropping data
+ *
+ */
+static inline size_t audio_ring_free(audio_ring_t* ring)
+{
+    return ring->capacity - audio_ring_fill(ring);
+}
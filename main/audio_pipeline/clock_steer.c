@@ -0,0 +1,89 @@
+/**
+ * @file clock_steer.c
+ * @author your name (you@domain.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include "clock_steer.h"
+
+#include "sdkconfig.h"
+
+#include "audio_pipeline.h"
+#include "rt_log.h"
+#include "audio_source/audio_source.h"
+
+#define CONTROL_PERIOD_MS 100
+
+/*
+ * Fill dynamics: d(fill)/dt = sample_rate * ppm * 1e-6 frames/s.
+ * At 48 kHz these gains give a critically damped loop with a ~20 s time constant.
+ */
+#define KP_PPM_PER_FRAME 2.0f
+#define KI_PPM_PER_FRAME_S 0.05f
+
+typedef struct {
+    uint32_t target_frames;
+    uint32_t fill_sum;
+    uint32_t fill_count;
+    float integral; // frame * s
+    float ppm;
+} clock_steer_ctx_t;
+
+static clock_steer_ctx_t ctx = { 0 };
+
+/* With the resampler in the path its ratio is the finer actuator */
+static void apply_trim(float ppm)
+{
+#if CONFIG_AUDIO_SRC
+    audio_pipeline_set_src_trim_ppm(ppm);
+#else
+    audio_source_trim_ppm(ppm);
+#endif
+}
+
+void clock_steer_reset(uint32_t target_frames)
+{
+    ctx.target_frames = target_frames;
+    ctx.fill_sum = 0;
+    ctx.fill_count = 0;
+    ctx.integral = 0;
+    ctx.ppm = 0;
+    apply_trim(0);
+}
+
+void clock_steer_update(uint32_t fill_frames)
+{
+    ctx.fill_sum += fill_frames;
+    if (++ctx.fill_count < CONTROL_PERIOD_MS) {
+        return;
+    }
+
+    float error = (float)ctx.fill_sum / ctx.fill_count - (float)ctx.target_frames;
+    ctx.fill_sum = 0;
+    ctx.fill_count = 0;
+
+    /* Ring filling up means I2S runs fast, so the correction has the opposite sign */
+    float ppm = -(KP_PPM_PER_FRAME * error + KI_PPM_PER_FRAME_S * (ctx.integral + error * CONTROL_PERIOD_MS / 1000.0f));
+
+    /* Anti-windup: stop integrating while the actuator is saturated */
+    if (ppm > CONFIG_AUDIO_CLOCK_STEER_MAX_PPM) {
+        ppm = CONFIG_AUDIO_CLOCK_STEER_MAX_PPM;
+    } else if (ppm < -CONFIG_AUDIO_CLOCK_STEER_MAX_PPM) {
+        ppm = -CONFIG_AUDIO_CLOCK_STEER_MAX_PPM;
+    } else {
+        ctx.integral += error * CONTROL_PERIOD_MS / 1000.0f;
+    }
+
+    ctx.ppm = ppm;
+    apply_trim(ppm);
+    rt_log(RT_LOG_CLOCK_TRIM, (uint32_t)(int32_t)(error * 10.0f), (uint32_t)(int32_t)(ppm * 10.0f), 0);
+}
+
+float clock_steer_get_ppm(void)
+{
+    return ctx.ppm;
+}
@@ -0,0 +1,40 @@
+/**
+ * @file clock_steer.h
+ * @author your name (you@domain.com)
+ * @brief Locks the I2S master clock to the USB SOF clock
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * The USB side drains exactly one packet per SOF, so the ring fill level
+ * integrates the rate difference between the free-running I2S clock and the
+ * host. A PI controller averages the fill over a control period (to remove
+ * the DMA block sawtooth) and trims the I2S MCLK by a few ppm to hold it at
+ * the target depth. With the resampler enabled the resampling ratio is
+ * trimmed instead.
+ */
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * @brief Restart the loop, e.g. when streaming (re)starts after prebuffering
+ *
+ * @param target_frames ring fill level to hold, in frames
+ */
+void clock_steer_reset(uint32_t target_frames);
+
+/**
+ * @brief Feed the fill level seen at one SOF. Called once per USB packet.
+ *
+ * @param fill_frames ring fill level in frames
+ */
+void clock_steer_update(uint32_t fill_frames);
+
+/**
+ * @brief Trim currently applied to the I2S clock
+ *
+ * @return correction in ppm, positive means faster
+ */
+float clock_steer_get_ppm(void);
@@ -0,0 +1,464 @@
+/**
+ * @file dsp_chain.c
+ * @author your name (you@domain.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include "dsp_chain.h"
+
+#include <inttypes.h>
+#include <math.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "audio_arena.h"
+#include "esp_cpu.h"
+#include "esp_log.h"
+#include "pie_simd.h"
+
+#define BIQUAD_FRAC_BITS 28
+#define GAIN_FRAC_BITS 24
+#define CYCLES_EMA_SHIFT 4
+
+/* Cycles per frame and channel each stage is expected to stay below */
+#define BUDGET_DC_BLOCK 12
+#define BUDGET_BIQUAD 32
+#define BUDGET_GAIN 10
+#define BUDGET_CHANNEL_MODE 6
+
+static const char* TAG = "dsp-chain";
+
+static const char* const stage_names[] = {
+    [DSP_STAGE_DC_BLOCK] = "dc-block",
+    [DSP_STAGE_BIQUAD] = "biquad",
+    [DSP_STAGE_GAIN] = "gain",
+    [DSP_STAGE_CHANNEL_MODE] = "channel-mode",
+};
+
+static inline int32_t sat32(int64_t x)
+{
+    if (x > INT32_MAX) {
+        return INT32_MAX;
+    }
+    if (x < INT32_MIN) {
+        return INT32_MIN;
+    }
+    return (int32_t)x;
+}
+
+static inline int32_t to_q(float x, int frac_bits)
+{
+    return sat32(llroundf(x * (float)(1 << frac_bits)));
+}
+
+/* RBJ audio EQ cookbook */
+static void biquad_design(const dsp_biquad_design_t* d, uint32_t sample_rate, dsp_biquad_coeffs_t* c)
+{
+    const float A = powf(10.0f, d->gain_db / 40.0f);
+    const float w0 = 2.0f * (float)M_PI * d->freq / (float)sample_rate;
+    const float cosw = cosf(w0);
+    const float alpha = sinf(w0) / (2.0f * d->q);
+    const float sqA = 2.0f * sqrtf(A) * alpha;
+    float b0, b1, b2, a0, a1, a2;
+
+    switch (d->type) {
+    case DSP_BIQUAD_LOWPASS:
+        b0 = (1.0f - cosw) / 2.0f;
+        b1 = 1.0f - cosw;
+        b2 = b0;
+        a0 = 1.0f + alpha;
+        a1 = -2.0f * cosw;
+        a2 = 1.0f - alpha;
+        break;
+    case DSP_BIQUAD_HIGHPASS:
+        b0 = (1.0f + cosw) / 2.0f;
+        b1 = -(1.0f + cosw);
+        b2 = b0;
+        a0 = 1.0f + alpha;
+        a1 = -2.0f * cosw;
+        a2 = 1.0f - alpha;
+        break;
+    case DSP_BIQUAD_PEAKING:
+        b0 = 1.0f + alpha * A;
+        b1 = -2.0f * cosw;
+        b2 = 1.0f - alpha * A;
+        a0 = 1.0f + alpha / A;
+        a1 = -2.0f * cosw;
+        a2 = 1.0f - alpha / A;
+        break;
+    case DSP_BIQUAD_LOWSHELF:
+        b0 = A * ((A + 1.0f) - (A - 1.0f) * cosw + sqA);
+        b1 = 2.0f * A * ((A - 1.0f) - (A + 1.0f) * cosw);
+        b2 = A * ((A + 1.0f) - (A - 1.0f) * cosw - sqA);
+        a0 = (A + 1.0f) + (A - 1.0f) * cosw + sqA;
+        a1 = -2.0f * ((A - 1.0f) + (A + 1.0f) * cosw);
+        a2 = (A + 1.0f) + (A - 1.0f) * cosw - sqA;
+        break;
+    case DSP_BIQUAD_HIGHSHELF:
+    default:
+        b0 = A * ((A + 1.0f) + (A - 1.0f) * cosw + sqA);
+        b1 = -2.0f * A * ((A - 1.0f) + (A + 1.0f) * cosw);
+        b2 = A * ((A + 1.0f) + (A - 1.0f) * cosw - sqA);
+        a0 = (A + 1.0f) - (A - 1.0f) * cosw + sqA;
+        a1 = 2.0f * ((A - 1.0f) - (A + 1.0f) * cosw);
+        a2 = (A + 1.0f) - (A - 1.0f) * cosw - sqA;
+        break;
+    }
+
+    c->b0 = to_q(b0 / a0, BIQUAD_FRAC_BITS);
+    c->b1 = to_q(b1 / a0, BIQUAD_FRAC_BITS);
+    c->b2 = to_q(b2 / a0, BIQUAD_FRAC_BITS);
+    c->a1 = to_q(a1 / a0, BIQUAD_FRAC_BITS);
+    c->a2 = to_q(a2 / a0, BIQUAD_FRAC_BITS);
+}
+
+esp_err_t dsp_chain_init(dsp_chain_t* chain, size_t channels, size_t max_frames, uint32_t sample_rate)
+{
+    if (channels == 0 || channels > DSP_MAX_CHANNELS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(chain, 0, sizeof(*chain));
+    chain->channels = channels;
+    chain->max_frames = max_frames;
+    chain->sample_rate = sample_rate;
+
+    int32_t* planar = audio_arena_alloc("dsp planar", channels * max_frames * sizeof(int32_t));
+    if (planar == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    for (size_t ch = 0; ch < channels; ch++) {
+        chain->planar[ch] = planar + ch * max_frames;
+    }
+    return ESP_OK;
+}
+
+static dsp_stage_t* add_stage(dsp_chain_t* chain, dsp_stage_type_t type, uint32_t budget_cycles)
+{
+    if (chain->num_stages == DSP_MAX_STAGES) {
+        return NULL;
+    }
+
+    dsp_stage_t* stage = &chain->stages[chain->num_stages++];
+    memset(stage, 0, sizeof(*stage));
+    stage->type = type;
+    stage->budget_cycles = budget_cycles;
+    return stage;
+}
+
+esp_err_t dsp_chain_add_dc_block(dsp_chain_t* chain, int shift)
+{
+    if (shift < 1 || shift > 20) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    dsp_stage_t* stage = add_stage(chain, DSP_STAGE_DC_BLOCK, BUDGET_DC_BLOCK * chain->channels);
+    if (stage == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    stage->dc_block.shift = shift;
+    return ESP_OK;
+}
+
+esp_err_t dsp_chain_add_biquad(dsp_chain_t* chain, const dsp_biquad_design_t* design)
+{
+    if (design->freq <= 0.0f || design->freq >= chain->sample_rate / 2 || design->q <= 0.0f) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    dsp_stage_t* stage = add_stage(chain, DSP_STAGE_BIQUAD, BUDGET_BIQUAD * chain->channels);
+    if (stage == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    stage->biquad.design = *design;
+    biquad_design(design, chain->sample_rate, &stage->biquad.coeffs[0]);
+    atomic_init(&stage->biquad.active, 0);
+    return ESP_OK;
+}
+
+esp_err_t dsp_chain_add_gain(dsp_chain_t* chain, float gain_db)
+{
+    float gain = powf(10.0f, gain_db / 20.0f);
+    if (gain >= (float)(1 << (31 - GAIN_FRAC_BITS))) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    dsp_stage_t* stage = add_stage(chain, DSP_STAGE_GAIN, BUDGET_GAIN * chain->channels);
+    if (stage == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    stage->gain_q24 = to_q(gain, GAIN_FRAC_BITS);
+    return ESP_OK;
+}
+
+esp_err_t dsp_chain_add_channel_mode(dsp_chain_t* chain, dsp_channel_mode_t mode)
+{
+    if (chain->channels < 2) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    dsp_stage_t* stage = add_stage(chain, DSP_STAGE_CHANNEL_MODE, BUDGET_CHANNEL_MODE);
+    if (stage == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    stage->channel_mode = mode;
+    return ESP_OK;
+}
+
+void dsp_chain_set_sample_rate(dsp_chain_t* chain, uint32_t sample_rate)
+{
+    chain->sample_rate = sample_rate;
+
+    for (size_t i = 0; i < chain->num_stages; i++) {
+        dsp_stage_t* stage = &chain->stages[i];
+        if (stage->type != DSP_STAGE_BIQUAD) {
+            continue;
+        }
+        int next = !atomic_load(&stage->biquad.active);
+        biquad_design(&stage->biquad.design, sample_rate, &stage->biquad.coeffs[next]);
+        atomic_store(&stage->biquad.active, next);
+    }
+}
+
+static void dc_block(dsp_stage_t* stage, int32_t* x, size_t ch, size_t frames)
+{
+    const int shift = stage->dc_block.shift;
+    int64_t dc = stage->dc_block.dc[ch];
+
+    for (size_t i = 0; i < frames; i++) {
+        dc += (((int64_t)x[i] << 16) - dc) >> shift;
+        x[i] = sat32((int64_t)x[i] - (dc >> 16));
+    }
+    stage->dc_block.dc[ch] = dc;
+}
+
+/* Direct form I with first-order error feedback, which keeps low corner frequencies clean */
+static void biquad(const dsp_biquad_coeffs_t* c, dsp_biquad_state_t* s, int32_t* x, size_t frames)
+{
+    int32_t x1 = s->x1, x2 = s->x2, y1 = s->y1, y2 = s->y2;
+    int64_t err = s->err;
+
+    for (size_t i = 0; i < frames; i++) {
+        int64_t acc = err
+            + (int64_t)c->b0 * x[i]
+            + (int64_t)c->b1 * x1
+            + (int64_t)c->b2 * x2
+            - (int64_t)c->a1 * y1
+            - (int64_t)c->a2 * y2;
+        int64_t y = acc >> BIQUAD_FRAC_BITS;
+        err = acc - (y << BIQUAD_FRAC_BITS);
+
+        x2 = x1;
+        x1 = x[i];
+        y2 = y1;
+        y1 = sat32(y);
+        x[i] = y1;
+    }
+
+    s->x1 = x1;
+    s->x2 = x2;
+    s->y1 = y1;
+    s->y2 = y2;
+    s->err = err;
+}
+
+static void gain(int32_t g, int32_t* x, size_t frames)
+{
+    for (size_t i = 0; i < frames; i++) {
+        x[i] = sat32(((int64_t)x[i] * g) >> GAIN_FRAC_BITS);
+    }
+}
+
+#if PIE_SIMD
+/*
+ * PIE kernels for the data movement around the stages and for the mono mix,
+ * four frames per round on 16-byte aligned buffers. The recursive stages
+ * (DC block, biquad) carry state from sample to sample, and the gain needs a
+ * 32x32-bit multiply the vector unit does not have, so those stay scalar.
+ */
+
+static inline bool aligned_16(const void* p)
+{
+    return ((uintptr_t)p & 15) == 0;
+}
+
+/* 4 stereo frames -> 4 samples of each channel */
+static size_t deinterleave_stereo_pie(const int32_t* in, int32_t* l, int32_t* r, size_t frames)
+{
+    if (!aligned_16(in) || !aligned_16(l) || !aligned_16(r)) {
+        return 0;
+    }
+    for (size_t i = 0; i < frames / 4; i++) {
+        PIE_VLD_128_IP(q0, in, 16);
+        PIE_VLD_128_IP(q1, in, 16);
+        PIE_VUNZIP_32(q0, q1);
+        PIE_VST_128_IP(q0, l, 16);
+        PIE_VST_128_IP(q1, r, 16);
+    }
+    return frames / 4 * 4;
+}
+
+static size_t interleave_stereo_pie(const int32_t* l, const int32_t* r, int32_t* out, size_t frames)
+{
+    if (!aligned_16(out) || !aligned_16(l) || !aligned_16(r)) {
+        return 0;
+    }
+    for (size_t i = 0; i < frames / 4; i++) {
+        PIE_VLD_128_IP(q0, l, 16);
+        PIE_VLD_128_IP(q1, r, 16);
+        PIE_VZIP_32(q0, q1);
+        PIE_VST_128_IP(q0, out, 16);
+        PIE_VST_128_IP(q1, out, 16);
+    }
+    return frames / 4 * 4;
+}
+
+/* (a + b) >> 1 without a wider type: (a >> 1) + (b >> 1) + (a & b & 1) */
+static size_t mono_pie(int32_t* a, int32_t* b, size_t frames)
+{
+    static const uint32_t one = 1;
+
+    if (!aligned_16(a) || !aligned_16(b)) {
+        return 0;
+    }
+    PIE_VLDBC_32(q7, &one);
+    for (size_t i = 0; i < frames / 4; i++) {
+        PIE_VLD_128_IP(q0, a, 0);
+        PIE_VLD_128_IP(q1, b, 0);
+        PIE_ANDQ(q2, q0, q1);
+        PIE_ANDQ(q2, q2, q7);
+        PIE_VSR_32(q0, q0, 1);
+        PIE_VSR_32(q1, q1, 1);
+        PIE_VADDS_S32(q0, q0, q1);
+        PIE_VADDS_S32(q0, q0, q2);
+        PIE_VST_128_IP(q0, a, 16);
+        PIE_VST_128_IP(q0, b, 16);
+    }
+    return frames / 4 * 4;
+}
+#endif
+
+static void channel_mode(dsp_channel_mode_t mode, int32_t** ch, size_t frames)
+{
+    int32_t* tmp;
+    size_t done = 0;
+
+    switch (mode) {
+    case DSP_CHANNEL_SWAP:
+        /* Deinterleaved, so swapping is free */
+        tmp = ch[0];
+        ch[0] = ch[1];
+        ch[1] = tmp;
+        break;
+    case DSP_CHANNEL_MONO:
+#if PIE_SIMD
+        done = mono_pie(ch[0], ch[1], frames);
+#endif
+        for (size_t i = done; i < frames; i++) {
+            int32_t m = (int32_t)(((int64_t)ch[0][i] + ch[1][i]) >> 1);
+            ch[0][i] = m;
+            ch[1][i] = m;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+static void run_stage(dsp_stage_t* stage, int32_t** ch, size_t channels, size_t frames)
+{
+    switch (stage->type) {
+    case DSP_STAGE_DC_BLOCK:
+        for (size_t c = 0; c < channels; c++) {
+            dc_block(stage, ch[c], c, frames);
+        }
+        break;
+    case DSP_STAGE_BIQUAD: {
+        const dsp_biquad_coeffs_t* coeffs = &stage->biquad.coeffs[atomic_load_explicit(&stage->biquad.active, memory_order_acquire)];
+        for (size_t c = 0; c < channels; c++) {
+            biquad(coeffs, &stage->biquad.state[c], ch[c], frames);
+        }
+        break;
+    }
+    case DSP_STAGE_GAIN:
+        for (size_t c = 0; c < channels; c++) {
+            gain(stage->gain_q24, ch[c], frames);
+        }
+        break;
+    case DSP_STAGE_CHANNEL_MODE:
+        channel_mode(stage->channel_mode, ch, frames);
+        break;
+    }
+}
+
+static void record_cycles(dsp_stage_t* stage, uint32_t cycles, size_t frames)
+{
+    int32_t avg = (int32_t)stage->cycles_avg_q8;
+
+    stage->blocks++;
+    stage->cycles_avg_q8 = avg + (((int32_t)(cycles << 8) - avg) >> CYCLES_EMA_SHIFT);
+    if (cycles > stage->cycles_max) {
+        stage->cycles_max = cycles;
+    }
+    if (cycles > stage->budget_cycles * frames) {
+        stage->over_budget++;
+    }
+}
+
+void dsp_chain_process(dsp_chain_t* chain, const int32_t* in, int32_t* out, size_t frames)
+{
+    const size_t channels = chain->channels;
+    int32_t* ch[DSP_MAX_CHANNELS];
+    size_t done = 0;
+
+    if (frames > chain->max_frames) {
+        frames = chain->max_frames;
+    }
+
+    for (size_t c = 0; c < channels; c++) {
+        ch[c] = chain->planar[c];
+    }
+#if PIE_SIMD
+    if (channels == 2) {
+        done = deinterleave_stereo_pie(in, ch[0], ch[1], frames);
+    }
+#endif
+    for (size_t c = 0; c < channels; c++) {
+        for (size_t i = done; i < frames; i++) {
+            ch[c][i] = in[i * channels + c];
+        }
+    }
+
+    for (size_t s = 0; s < chain->num_stages; s++) {
+        dsp_stage_t* stage = &chain->stages[s];
+        esp_cpu_cycle_count_t start = esp_cpu_get_cycle_count();
+        run_stage(stage, ch, channels, frames);
+        record_cycles(stage, esp_cpu_get_cycle_count() - start, frames);
+    }
+
+    done = 0;
+#if PIE_SIMD
+    if (channels == 2) {
+        done = interleave_stereo_pie(ch[0], ch[1], out, frames);
+    }
+#endif
+    for (size_t c = 0; c < channels; c++) {
+        for (size_t i = done; i < frames; i++) {
+            out[i * channels + c] = ch[c][i];
+        }
+    }
+}
+
+void dsp_chain_log_stats(const dsp_chain_t* chain)
+{
+    for (size_t s = 0; s < chain->num_stages; s++) {
+        const dsp_stage_t* stage = &chain->stages[s];
+        ESP_LOGI(TAG, "%zu %-12s avg %" PRIu32 " max %" PRIu32 " cyc/block, budget %" PRIu32 " cyc/frame, %" PRIu32 "/%" PRIu32 " blocks over",
+            s, stage_names[stage->type], stage->cycles_avg_q8 >> 8, stage->cycles_max,
+            stage->budget_cycles, stage->over_budget, stage->blocks);
+    }
+}
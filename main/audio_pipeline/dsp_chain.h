@@ -0,0 +1,142 @@
+/**
+ * @file dsp_chain.h
+ * @author your name (you@domain.com)
+ * @brief Block-based fixed-point processing chain
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * Stages run one after another on a whole block, deinterleaved into one
+ * buffer per channel. Samples are Q31 and coefficients Q28 or Q24, designed
+ * in float when a stage is added or the sample rate changes; the block
+ * itself is processed in integers, so a build that runs the producer in the
+ * I2S interrupt can include the chain unchanged.
+ *
+ * On the ESP32-S3 the stereo (de)interleave and the mono mix run on PIE,
+ * four frames per instruction sequence. The DC blocker and the biquad are
+ * recursive and the gain needs a 32x32-bit product, so they remain scalar
+ * loops over one channel buffer. The measured cost of every stage against
+ * its budget is shown by dsp_chain_log_stats().
+ */
+#pragma once
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#define DSP_MAX_STAGES 8
+#define DSP_MAX_CHANNELS 8
+
+typedef enum {
+    DSP_STAGE_DC_BLOCK,
+    DSP_STAGE_BIQUAD,
+    DSP_STAGE_GAIN,
+    DSP_STAGE_CHANNEL_MODE,
+} dsp_stage_type_t;
+
+typedef enum {
+    DSP_BIQUAD_LOWPASS,
+    DSP_BIQUAD_HIGHPASS,
+    DSP_BIQUAD_PEAKING,
+    DSP_BIQUAD_LOWSHELF,
+    DSP_BIQUAD_HIGHSHELF,
+} dsp_biquad_type_t;
+
+typedef enum {
+    DSP_CHANNEL_STEREO, // Pass through
+    DSP_CHANNEL_SWAP, // Swap the first two channels
+    DSP_CHANNEL_MONO, // Average of the first two channels on both
+} dsp_channel_mode_t;
+
+typedef struct {
+    dsp_biquad_type_t type;
+    float freq; // Hz
+    float q;
+    float gain_db; // Peaking and shelving only
+} dsp_biquad_design_t;
+
+typedef struct {
+    int32_t b0, b1, b2, a1, a2; // Q28
+} dsp_biquad_coeffs_t;
+
+typedef struct {
+    int32_t x1, x2, y1, y2;
+    int64_t err; // Truncation error fed back into the next output
+} dsp_biquad_state_t;
+
+typedef struct {
+    dsp_stage_type_t type;
+    uint32_t budget_cycles; // Per frame
+    union {
+        struct {
+            int shift; // Corner at fs / (2 pi 2^shift)
+            int64_t dc[DSP_MAX_CHANNELS]; // Q16
+        } dc_block;
+        struct {
+            dsp_biquad_design_t design;
+            dsp_biquad_coeffs_t coeffs[2]; // Double-buffered for sample rate changes
+            atomic_int active;
+            dsp_biquad_state_t state[DSP_MAX_CHANNELS];
+        } biquad;
+        int32_t gain_q24;
+        dsp_channel_mode_t channel_mode;
+    };
+    /* Written by the processing context */
+    uint32_t blocks;
+    uint32_t cycles_max; // Per block
+    uint32_t cycles_avg_q8; // Per block, exponential moving average
+    uint32_t over_budget; // Blocks exceeding budget_cycles * frames
+} dsp_stage_t;
+
+typedef struct {
+    dsp_stage_t stages[DSP_MAX_STAGES];
+    size_t num_stages;
+    size_t channels;
+    size_t max_frames;
+    uint32_t sample_rate;
+    int32_t* planar[DSP_MAX_CHANNELS]; // Working buffers, one per channel
+} dsp_chain_t;
+
+/**
+ * @brief Allocate the working buffers of an empty chain
+ *
+ * @param channels interleaved channels per frame
+ * @param max_frames largest block passed to dsp_chain_process()
+ * @param sample_rate rate used to design filter coefficients
+ */
+esp_err_t dsp_chain_init(dsp_chain_t* chain, size_t channels, size_t max_frames, uint32_t sample_rate);
+
+/**
+ * @brief Append a stage. Stages may only be added before processing starts.
+ *
+ * @return ESP_OK, ESP_ERR_NO_MEM when the chain is full or ESP_ERR_INVALID_ARG
+ */
+esp_err_t dsp_chain_add_dc_block(dsp_chain_t* chain, int shift);
+esp_err_t dsp_chain_add_biquad(dsp_chain_t* chain, const dsp_biquad_design_t* design);
+esp_err_t dsp_chain_add_gain(dsp_chain_t* chain, float gain_db);
+esp_err_t dsp_chain_add_channel_mode(dsp_chain_t* chain, dsp_channel_mode_t mode);
+
+/**
+ * @brief Redesign filter coefficients for a new sample rate
+ *
+ * Coefficients switch at the next block, filter state is kept.
+ */
+void dsp_chain_set_sample_rate(dsp_chain_t* chain, uint32_t sample_rate);
+
+/**
+ * @brief Run all stages on a block
+ *
+ * @param in interleaved input, frames * channels words
+ * @param out interleaved output, may equal in
+ * @param frames at most max_frames
+ */
+void dsp_chain_process(dsp_chain_t* chain, const int32_t* in, int32_t* out, size_t frames);
+
+/**
+ * @brief Log the cycle cost of every stage against its budget
+ *
+ */
+void dsp_chain_log_stats(const dsp_chain_t* chain);
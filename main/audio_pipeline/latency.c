@@ -0,0 +1,151 @@
+/**
+ * @file latency.c
+ * @author your name (you@domain.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include "latency.h"
+
+#include <stdatomic.h>
+#include <stdbool.h>
+
+#include "esp_timer.h"
+#include "sdkconfig.h"
+#include "telemetry.h"
+
+/*
+ * A packet handed to TinyUSB in the pre-load callback goes out in the next USB
+ * frame. Without zero copy it is read from the ring one callback earlier.
+ */
+#if CONFIG_USB_AUDIO_ZERO_COPY
+#define WIRE_DELAY_US 1000
+#else
+#define WIRE_DELAY_US 2000
+#endif
+
+#define IMPULSE_THRESHOLD (INT32_MAX / 8) // Well above the ADC noise, below the impulse after resampling
+
+typedef struct {
+    audio_ring_t* ring;
+    /* Written by the producer under seq */
+    atomic_uint seq; // Odd while an update is in progress
+    atomic_size_t mark_pos; // Ring write position right after the stamped frame
+    atomic_uint mark_us; // Capture time of that frame, low 32 bits of esp_timer
+#if CONFIG_SIG_GEN_IMPULSE
+    atomic_uint impulse_us; // Capture time of the impulse not yet found, 0 if none
+#endif
+} latency_ctx_t;
+
+static latency_ctx_t ctx = { 0 };
+
+void latency_init(audio_ring_t* ring)
+{
+    ctx.ring = ring;
+}
+
+void latency_mark_capture(int64_t capture_us)
+{
+    size_t pos = atomic_load_explicit(&ctx.ring->head, memory_order_relaxed);
+    unsigned seq = atomic_load_explicit(&ctx.seq, memory_order_relaxed);
+
+    atomic_store_explicit(&ctx.seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&ctx.mark_pos, pos, memory_order_relaxed);
+    atomic_store_explicit(&ctx.mark_us, (uint32_t)capture_us, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&ctx.seq, seq + 2, memory_order_relaxed);
+}
+
+/**
+ * @brief Time from the capture of the frame at a ring read position until now
+ *
+ * @return false if nothing has been stamped at or after the read position
+ */
+static bool age_at(const audio_config_t* audio_config, size_t tail, uint32_t now_us, int32_t* age_us)
+{
+    size_t pos;
+    uint32_t mark_us;
+    unsigned seq;
+
+    do {
+        while ((seq = atomic_load_explicit(&ctx.seq, memory_order_acquire)) & 1) { }
+        pos = atomic_load_explicit(&ctx.mark_pos, memory_order_relaxed);
+        mark_us = atomic_load_explicit(&ctx.mark_us, memory_order_relaxed);
+        atomic_thread_fence(memory_order_acquire);
+    } while (atomic_load_explicit(&ctx.seq, memory_order_relaxed) != seq);
+
+    size_t ahead = pos - tail; // Bytes from the read position to the end of the stamped frame
+    if (ahead == 0 || ahead > ctx.ring->capacity) {
+        return false;
+    }
+
+    /* The stamped frame is the last one before pos */
+    uint32_t frames_ahead = ahead / audio_config->audio_bytes_per_frame - 1;
+    uint32_t capture_us = mark_us - (uint32_t)((uint64_t)frames_ahead * 1000000 / audio_config->sample_rate);
+    *age_us = (int32_t)(now_us - capture_us);
+    return true;
+}
+
+void latency_record_packet(const audio_config_t* audio_config)
+{
+    int32_t age_us;
+
+    size_t tail = atomic_load_explicit(&ctx.ring->tail, memory_order_relaxed);
+    if (age_at(audio_config, tail, (uint32_t)esp_timer_get_time(), &age_us) && age_us >= 0) {
+        telemetry_record_latency(age_us + WIRE_DELAY_US);
+    }
+}
+
+#if CONFIG_SIG_GEN_IMPULSE
+void latency_mark_impulse(int64_t capture_us)
+{
+    atomic_store_explicit(&ctx.impulse_us, (uint32_t)capture_us | 1, memory_order_relaxed);
+}
+
+/**
+ * @brief First channel of a frame as an MSB-aligned 32-bit word
+ *
+ */
+static int32_t first_sample(audio_format_t format, const uint8_t* frame)
+{
+    switch (format) {
+    case PCM_FORMAT_16BIT:
+        return (int32_t)((uint32_t)(frame[0] | frame[1] << 8) << 16);
+    case PCM_FORMAT_24BIT_32BIT:
+        return (int32_t)((uint32_t)frame[0] << 8 | (uint32_t)frame[1] << 16 | (uint32_t)frame[2] << 24);
+    default:
+        return (int32_t)((uint32_t)frame[0] | (uint32_t)frame[1] << 8 | (uint32_t)frame[2] << 16 | (uint32_t)frame[3] << 24);
+    }
+}
+
+void latency_scan_packet(const uint8_t* packet, size_t frames, size_t tail, const audio_config_t* audio_config)
+{
+    uint32_t impulse_us = atomic_load_explicit(&ctx.impulse_us, memory_order_relaxed);
+    if (impulse_us == 0) {
+        return;
+    }
+
+    for (size_t i = 0; i < frames; i++) {
+        if (first_sample(audio_config->audio_format, packet + i * audio_config->audio_bytes_per_frame) < IMPULSE_THRESHOLD) {
+            continue;
+        }
+
+        /* Only once per impulse, resampling may spread it over a few frames */
+        atomic_store_explicit(&ctx.impulse_us, 0, memory_order_relaxed);
+
+        uint32_t now_us = (uint32_t)esp_timer_get_time();
+        uint32_t offset_us = (uint32_t)((uint64_t)i * 1000000 / audio_config->sample_rate);
+        int32_t measured_us = (int32_t)(now_us + WIRE_DELAY_US + offset_us - impulse_us);
+        int32_t estimate_us = -1;
+        if (age_at(audio_config, tail, now_us, &estimate_us)) {
+            estimate_us += WIRE_DELAY_US;
+        }
+        telemetry_record_impulse(measured_us, estimate_us);
+        return;
+    }
+}
+#endif
@@ -0,0 +1,72 @@
+/**
+ * @file latency.h
+ * @author your name (you@domain.com)
+ * @brief Capture-to-wire latency measurement
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * The producer stamps the ring with the capture time of the newest frame it
+ * wrote, as a pair of ring write position and esp_timer time. Frames in the
+ * ring are contiguous at the USB rate, concealed gaps included, so the
+ * consumer can tell the capture time of the frame at its read position from
+ * the latest stamp and the distance between the two positions. Each packet's
+ * latency is that time's distance to the USB frame the packet goes out in,
+ * and is recorded in telemetry.
+ *
+ * Times are measured at the I2S DMA completion, so the ADC's own filter delay
+ * is not included.
+ *
+ * With CONFIG_SIG_GEN_IMPULSE the signal generator injects a full-scale
+ * impulse instead of a tone, and the consumer looks for it in the outgoing
+ * packets. Its arrival gives a second measurement that does not rely on the
+ * stamps.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "audio_ring.h"
+#include "config/audio_config.h"
+
+/**
+ * @brief Set the ring whose positions are stamped
+ *
+ */
+void latency_init(audio_ring_t* ring);
+
+/**
+ * @brief Producer: the newest frame written to the ring was captured at capture_us
+ *
+ * @param capture_us esp_timer time
+ */
+void latency_mark_capture(int64_t capture_us);
+
+/**
+ * @brief Consumer: record the latency of the packet about to be read from the ring
+ *
+ * Call before reading the packet, while streaming.
+ *
+ * @param audio_config format and rate of the ring contents
+ */
+void latency_record_packet(const audio_config_t* audio_config);
+
+#if CONFIG_SIG_GEN_IMPULSE
+/**
+ * @brief Producer: an impulse was generated at capture_us
+ *
+ * Only the latest impulse is looked for.
+ */
+void latency_mark_impulse(int64_t capture_us);
+
+/**
+ * @brief Consumer: look for the impulse in the packet about to be sent
+ *
+ * @param packet packet in the format of audio_config
+ * @param frames frames in the packet
+ * @param tail ring read position of the packet's first frame, taken before reading it
+ */
+void latency_scan_packet(const uint8_t* packet, size_t frames, size_t tail, const audio_config_t* audio_config);
+#endif
@@ -0,0 +1,295 @@
+/**
+ * @file level_meter.c
+ * @author your name (you@domain.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include "level_meter.h"
+
+#include <math.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+
+#include "pie_simd.h"
+
+#define SQUARE_SHIFT 8 // Squares are taken of the top 24 bits so a window sum fits in 64 bits
+
+/* The PIE kernel maps 32-bit lane l to channel l % NUM_CHANNELS */
+#define LEVEL_METER_PIE (PIE_SIMD && 4 % NUM_CHANNELS == 0)
+
+typedef struct {
+    uint32_t peak;
+    uint64_t sum_squares;
+    uint32_t hold;
+    int32_t hold_frames_left;
+    uint32_t clips;
+} channel_state_t;
+
+typedef struct {
+    uint32_t peak;
+    uint32_t clips;
+    uint64_t sum_squares;
+} block_stats_t;
+
+typedef struct {
+    atomic_uint seq; // Odd while the producer publishes
+    level_meter_reading_t published;
+    channel_state_t channel[NUM_CHANNELS]; // Owned by the producer
+    uint32_t window_frames;
+    uint32_t hold_frames;
+    uint32_t frames; // Frames in the current window
+} meter_ctx_t;
+
+static meter_ctx_t ctx = {
+    .window_frames = SAMPLE_RATE / 1000 * LEVEL_METER_WINDOW_MS,
+    .hold_frames = SAMPLE_RATE / 1000 * LEVEL_METER_HOLD_MS,
+};
+
+void level_meter_set_sample_rate(uint32_t sample_rate)
+{
+    ctx.window_frames = sample_rate / 1000 * LEVEL_METER_WINDOW_MS;
+    ctx.hold_frames = sample_rate / 1000 * LEVEL_METER_HOLD_MS;
+}
+
+static uint32_t isqrt64(uint64_t x)
+{
+    uint64_t root = 0;
+    uint64_t bit = 1ull << 62;
+
+    while (bit > x) {
+        bit >>= 2;
+    }
+    while (bit) {
+        if (x >= root + bit) {
+            x -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)root;
+}
+
+static void publish(void)
+{
+    atomic_store_explicit(&ctx.seq, atomic_load_explicit(&ctx.seq, memory_order_relaxed) + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+        channel_state_t* s = &ctx.channel[ch];
+        level_meter_channel_t* out = &ctx.published.channel[ch];
+
+        out->peak = s->peak;
+        out->peak_hold = s->hold;
+        out->rms = isqrt64(s->sum_squares / ctx.frames) << SQUARE_SHIFT;
+        out->clips = s->clips;
+
+        s->peak = 0;
+        s->sum_squares = 0;
+    }
+
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&ctx.seq, atomic_load_explicit(&ctx.seq, memory_order_relaxed) + 1, memory_order_relaxed);
+}
+
+static void measure_scalar(const int32_t* samples, size_t frames, block_stats_t* stats)
+{
+    for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+        const int32_t* x = samples + ch;
+        uint32_t peak = stats[ch].peak;
+        uint32_t clips = 0;
+        uint64_t sum = 0;
+
+        for (size_t i = 0; i < frames; i++, x += NUM_CHANNELS) {
+            /* Unsigned negation, so INT32_MIN maps to 2^31 instead of overflowing */
+            uint32_t mag = *x < 0 ? 0u - (uint32_t)*x : (uint32_t)*x;
+            int32_t top = *x >> SQUARE_SHIFT;
+            peak = mag > peak ? mag : peak;
+            clips += mag >= LEVEL_METER_CLIP_THRESHOLD;
+            sum += (int64_t)top * top;
+        }
+
+        stats[ch].peak = peak;
+        stats[ch].clips += clips;
+        stats[ch].sum_squares += sum;
+    }
+}
+
+#if LEVEL_METER_PIE
+/*
+ * PIE has no 32-bit multiply, so the square of the top 24 bits is built
+ * from 16-bit lanes: with hi = x >> 16 and lo = (x >> 8) & 0xFF,
+ * (x >> 8)^2 = (hi^2 << 16) + (hi * lo << 9) + lo^2, each term a signed
+ * 16 x 16 multiply-accumulate into ACCX. The result equals the scalar sum.
+ */
+#define PIE_CHUNK_SAMPLES 256 // 256 * 2^30 keeps the hi^2 sum of a chunk within the 40-bit ACCX
+
+/* 16-bit lanes of channel c all ones, others zero */
+#define LANE_MASK(c, i) ((i) % NUM_CHANNELS == (c) ? -1 : 0)
+#define LANE_MASKS(c) { LANE_MASK(c, 0), LANE_MASK(c, 1), LANE_MASK(c, 2), LANE_MASK(c, 3), \
+    LANE_MASK(c, 4), LANE_MASK(c, 5), LANE_MASK(c, 6), LANE_MASK(c, 7) }
+
+static _Alignas(16) const int16_t lane_masks[4][8] = { LANE_MASKS(0), LANE_MASKS(1), LANE_MASKS(2), LANE_MASKS(3) };
+static _Alignas(16) int16_t chunk_hi[PIE_CHUNK_SAMPLES];
+static _Alignas(16) int16_t chunk_lo[PIE_CHUNK_SAMPLES];
+
+/* Sum of a[i] * b[i] over the lanes of one channel */
+static int64_t dot_pie(const int16_t* a, const int16_t* b, const int16_t* mask, size_t samples)
+{
+    int64_t sum;
+
+    PIE_VLD_128_IP(q7, mask, 0);
+    PIE_ZERO_ACCX();
+    for (size_t i = 0; i < samples / 8; i++) {
+        PIE_VLD_128_IP(q0, a, 16);
+        PIE_VLD_128_IP(q1, b, 16);
+        PIE_ANDQ(q1, q1, q7);
+        PIE_VMULAS_S16_ACCX(q0, q1);
+    }
+    PIE_RD_ACCX(sum);
+    return sum;
+}
+
+static void sum_squares_pie(const int32_t* x, size_t samples, block_stats_t* stats)
+{
+    static const uint32_t low_byte = 0xFF;
+
+    PIE_VLDBC_32(q7, &low_byte);
+    int16_t* hi = chunk_hi;
+    int16_t* lo = chunk_lo;
+    for (size_t i = 0; i < samples / 8; i++) {
+        PIE_VLD_128_IP(q0, x, 16);
+        PIE_VLD_128_IP(q1, x, 16);
+        PIE_VSR_32(q2, q0, 8);
+        PIE_VSR_32(q3, q1, 8);
+        PIE_ANDQ(q2, q2, q7);
+        PIE_ANDQ(q3, q3, q7);
+        PIE_VUNZIP_16(q0, q1);
+        PIE_VUNZIP_16(q2, q3);
+        PIE_VST_128_IP(q1, hi, 16);
+        PIE_VST_128_IP(q2, lo, 16);
+    }
+
+    for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+        int64_t hh = dot_pie(chunk_hi, chunk_hi, lane_masks[ch], samples);
+        int64_t hl = dot_pie(chunk_hi, chunk_lo, lane_masks[ch], samples);
+        int64_t ll = dot_pie(chunk_lo, chunk_lo, lane_masks[ch], samples);
+        stats[ch].sum_squares += (uint64_t)((hh << 16) + (hl << 9) + ll);
+    }
+}
+
+/**
+ * @brief Measure the whole 8-sample groups of a 16-byte aligned block
+ *
+ * @return frames measured, the rest is left to measure_scalar()
+ */
+static size_t measure_pie(const int32_t* samples, size_t frames, block_stats_t* stats)
+{
+    static const int32_t clip_above = LEVEL_METER_CLIP_THRESHOLD - 1;
+    static const int32_t clip_below = -(LEVEL_METER_CLIP_THRESHOLD - 1);
+    static const int32_t lane_min = INT32_MIN;
+    static const int32_t lane_max = INT32_MAX;
+    static _Alignas(16) int32_t max[4], min[4], clips[4];
+    size_t samples_pie = frames * NUM_CHANNELS / 8 * 8;
+
+    if (((uintptr_t)samples & 15) != 0 || samples_pie == 0) {
+        return 0;
+    }
+
+    /* Peaks and clips lane by lane: a clip subtracts the all-ones compare result */
+    const int32_t* x = samples;
+    PIE_VLDBC_32(q1, &lane_min);
+    PIE_VLDBC_32(q2, &lane_max);
+    PIE_ZERO_Q(q3);
+    PIE_VLDBC_32(q4, &clip_above);
+    PIE_VLDBC_32(q5, &clip_below);
+    for (size_t i = 0; i < samples_pie / 4; i++) {
+        PIE_VLD_128_IP(q0, x, 16);
+        PIE_VMAX_S32(q1, q1, q0);
+        PIE_VMIN_S32(q2, q2, q0);
+        PIE_VCMP_GT_S32(q6, q0, q4);
+        PIE_VSUBS_S32(q3, q3, q6);
+        PIE_VCMP_LT_S32(q6, q0, q5);
+        PIE_VSUBS_S32(q3, q3, q6);
+    }
+    int32_t* lanes = max;
+    PIE_VST_128_IP(q1, lanes, 16);
+    lanes = min;
+    PIE_VST_128_IP(q2, lanes, 16);
+    lanes = clips;
+    PIE_VST_128_IP(q3, lanes, 16);
+
+    for (int l = 0; l < 4; l++) {
+        block_stats_t* s = &stats[l % NUM_CHANNELS];
+        uint32_t pos = max[l] > 0 ? (uint32_t)max[l] : 0;
+        uint32_t neg = min[l] < 0 ? 0u - (uint32_t)min[l] : 0;
+        uint32_t mag = pos > neg ? pos : neg;
+        s->peak = mag > s->peak ? mag : s->peak;
+        s->clips += clips[l];
+    }
+
+    for (size_t done = 0; done < samples_pie; done += PIE_CHUNK_SAMPLES) {
+        size_t chunk = samples_pie - done < PIE_CHUNK_SAMPLES ? samples_pie - done : PIE_CHUNK_SAMPLES;
+        sum_squares_pie(samples + done, chunk, stats);
+    }
+    return samples_pie / NUM_CHANNELS;
+}
+#endif
+
+void level_meter_process(const int32_t* samples, size_t frames)
+{
+    block_stats_t stats[NUM_CHANNELS] = { 0 };
+    size_t done = 0;
+
+#if LEVEL_METER_PIE
+    done = measure_pie(samples, frames, stats);
+#endif
+    measure_scalar(samples + done * NUM_CHANNELS, frames - done, stats);
+
+    for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+        channel_state_t* s = &ctx.channel[ch];
+        uint32_t peak = stats[ch].peak;
+
+        if (peak > s->peak) {
+            s->peak = peak;
+        }
+        s->sum_squares += stats[ch].sum_squares;
+        s->clips += stats[ch].clips;
+
+        s->hold_frames_left -= frames;
+        if (peak >= s->hold || s->hold_frames_left <= 0) {
+            s->hold = peak;
+            s->hold_frames_left = ctx.hold_frames;
+        }
+    }
+
+    ctx.frames += frames;
+    if (ctx.frames >= ctx.window_frames) {
+        publish();
+        ctx.frames = 0;
+    }
+}
+
+void level_meter_get(level_meter_reading_t* reading)
+{
+    uint32_t seq;
+
+    do {
+        while ((seq = atomic_load_explicit(&ctx.seq, memory_order_acquire)) & 1) { }
+        *reading = ctx.published;
+        atomic_thread_fence(memory_order_acquire);
+    } while (atomic_load_explicit(&ctx.seq, memory_order_relaxed) != seq);
+}
+
+int32_t level_meter_to_dbfs_x10(uint32_t level)
+{
+    if (level == 0) {
+        level = 1;
+    }
+    return (int32_t)lroundf(200.0f * log10f((float)level / (float)INT32_MAX));
+}
@@ -0,0 +1,65 @@
+/**
+ * @file level_meter.h
+ * @author your name (you@domain.com)
+ * @brief Per-channel peak, RMS and clip metering of the captured signal
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * Updated block by block from the producer context. Levels are linear in
+ * units of the 32-bit I2S word, full scale is INT32_MAX.
+ *
+ * The per-block pass is integer only: a compare for the peak, a compare for
+ * clipping and the square of the top 24 bits for the RMS per sample. With
+ * 1, 2 or 4 channels on the ESP32-S3 it runs on PIE vector instructions,
+ * four samples per compare and eight per multiply-accumulate, with the same
+ * results as the scalar loop that handles the remainder of a block and the
+ * other builds. The square root runs once per window, outside the block
+ * loop.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "config/audio_config.h"
+
+#define LEVEL_METER_WINDOW_MS 300 // RMS integration window
+#define LEVEL_METER_HOLD_MS 1500 // Peak hold time
+#define LEVEL_METER_CLIP_THRESHOLD 0x7FFFFF00 // Full scale of a 24-bit ADC in a 32-bit slot
+
+typedef struct {
+    uint32_t peak; // Largest magnitude in the last RMS window
+    uint32_t peak_hold; // Largest magnitude, held for LEVEL_METER_HOLD_MS
+    uint32_t rms; // Over the last RMS window
+    uint32_t clips; // Samples at or beyond LEVEL_METER_CLIP_THRESHOLD since boot
+} level_meter_channel_t;
+
+typedef struct {
+    level_meter_channel_t channel[NUM_CHANNELS];
+} level_meter_reading_t;
+
+/**
+ * @brief Set the capture rate the window and hold times are counted in
+ *
+ */
+void level_meter_set_sample_rate(uint32_t sample_rate);
+
+/**
+ * @brief Producer: update the meters with a block of interleaved samples
+ *
+ */
+void level_meter_process(const int32_t* samples, size_t frames);
+
+/**
+ * @brief Consistent copy of the latest readings, callable from any task
+ *
+ */
+void level_meter_get(level_meter_reading_t* reading);
+
+/**
+ * @brief Convert a linear level to tenths of a dB relative to full scale
+ *
+ */
+int32_t level_meter_to_dbfs_x10(uint32_t level);
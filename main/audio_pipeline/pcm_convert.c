@@ -0,0 +1,340 @@
+/**
+ * @file pcm_convert.c
+ * @author your name (you@domain.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include "pcm_convert.h"
+
+#include <string.h>
+
+#include "pie_simd.h"
+#include "sdkconfig.h"
+
+#define LSB_16 (1 << 16)
+
+static inline uint32_t xorshift32(uint32_t* state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+/**
+ * @brief Triangular PDF dither of +-1 LSB at 16-bit resolution
+ *
+ */
+static inline int32_t tpdf_16(pcm_dither_t* dither)
+{
+    int32_t r1 = (int32_t)(xorshift32(&dither->seed) >> 16);
+    int32_t r2 = (int32_t)(xorshift32(&dither->seed) >> 16);
+    return r1 - r2;
+}
+
+static inline int16_t to_16(int32_t s, pcm_dither_t* dither)
+{
+    if (dither != NULL) {
+        int64_t d = (int64_t)s + tpdf_16(dither) + LSB_16 / 2;
+        if (d > INT32_MAX) {
+            d = INT32_MAX;
+        } else if (d < INT32_MIN) {
+            d = INT32_MIN;
+        }
+        s = (int32_t)d;
+    }
+    return (int16_t)(s >> 16);
+}
+
+void pcm_convert_16_ref(const int32_t* in, int16_t* out, size_t samples, pcm_dither_t* dither)
+{
+    for (size_t i = 0; i < samples; i++) {
+        out[i] = to_16(in[i], dither);
+    }
+}
+
+void pcm_convert_24_packed_ref(const int32_t* in, uint8_t* out, size_t samples)
+{
+    for (size_t i = 0; i < samples; i++) {
+        uint32_t s = (uint32_t)in[i];
+        out[3 * i + 0] = (uint8_t)(s >> 8);
+        out[3 * i + 1] = (uint8_t)(s >> 16);
+        out[3 * i + 2] = (uint8_t)(s >> 24);
+    }
+}
+
+void pcm_convert_24_in_32_ref(const int32_t* in, int32_t* out, size_t samples)
+{
+    for (size_t i = 0; i < samples; i++) {
+        out[i] = (int32_t)((uint32_t)in[i] & 0xFFFFFF00u);
+    }
+}
+
+/*
+ * Word-wide packers: whole output words are assembled in registers and
+ * written with aligned 32-bit stores, three stores per four 24-bit samples
+ * instead of twelve byte stores. They produce output bit-identical to the
+ * reference kernels, which handle unaligned output and the tail of a block.
+ * Packed 24-bit output has no PIE kernel: its three-byte stride needs a byte
+ * shuffle the instruction set does not have, and dithered 16-bit output is
+ * serial through the random generator.
+ */
+
+/* 4 samples -> 3 words */
+static size_t convert_24_packed_words(const int32_t* in, uint8_t* out, size_t samples)
+{
+    size_t blocks = samples / 4;
+    uint32_t* dst = (uint32_t*)out;
+
+    if (((uintptr_t)out & 3) != 0) {
+        return 0;
+    }
+
+    for (size_t i = 0; i < blocks; i++) {
+        uint32_t a = (uint32_t)in[0] >> 8;
+        uint32_t b = (uint32_t)in[1] >> 8;
+        uint32_t c = (uint32_t)in[2] >> 8;
+        uint32_t d = (uint32_t)in[3] >> 8;
+        dst[0] = a | (b << 24);
+        dst[1] = (b >> 8) | (c << 16);
+        dst[2] = (c >> 16) | (d << 8);
+        in += 4;
+        dst += 3;
+    }
+    return blocks * 4;
+}
+
+/* 2 samples -> 1 word */
+static size_t convert_16_words(const int32_t* in, int16_t* out, size_t samples, pcm_dither_t* dither)
+{
+    size_t pairs = samples / 2;
+    uint32_t* dst = (uint32_t*)out;
+
+    if (((uintptr_t)out & 3) != 0) {
+        return 0;
+    }
+
+    if (dither == NULL) {
+        for (size_t i = 0; i < pairs; i++) {
+            dst[i] = ((uint32_t)in[0] >> 16) | ((uint32_t)in[1] & 0xFFFF0000u);
+            in += 2;
+        }
+    } else {
+        for (size_t i = 0; i < pairs; i++) {
+            uint16_t lo = (uint16_t)to_16(in[0], dither);
+            uint16_t hi = (uint16_t)to_16(in[1], dither);
+            dst[i] = lo | ((uint32_t)hi << 16);
+            in += 2;
+        }
+    }
+    return pairs * 2;
+}
+
+#if PIE_SIMD
+/*
+ * PIE kernels for the formats that are lane operations on the input words.
+ * Both need 16-byte aligned input and output and leave the remainder of the
+ * block, and unaligned buffers, to the scalar kernels.
+ */
+
+/* 8 samples -> 8 halfwords: the high halves of two vectors of words */
+static size_t convert_16_pie(const int32_t* in, int16_t* out, size_t samples)
+{
+    size_t rounds = samples / 8;
+
+    if ((((uintptr_t)in | (uintptr_t)out) & 15) != 0) {
+        return 0;
+    }
+
+    /* In place the stores trail the loads by 16 bytes a round */
+    for (size_t i = 0; i < rounds; i++) {
+        PIE_VLD_128_IP(q0, in, 16);
+        PIE_VLD_128_IP(q1, in, 16);
+        PIE_VUNZIP_16(q0, q1);
+        PIE_VST_128_IP(q1, out, 16);
+    }
+    return rounds * 8;
+}
+
+/* 4 samples -> 4 words with the low byte cleared */
+static size_t convert_24_in_32_pie(const int32_t* in, int32_t* out, size_t samples)
+{
+    static const uint32_t mask = 0xFFFFFF00u;
+    size_t rounds = samples / 4;
+
+    if ((((uintptr_t)in | (uintptr_t)out) & 15) != 0) {
+        return 0;
+    }
+
+    PIE_VLDBC_32(q7, &mask);
+    for (size_t i = 0; i < rounds; i++) {
+        PIE_VLD_128_IP(q0, in, 16);
+        PIE_ANDQ(q0, q0, q7);
+        PIE_VST_128_IP(q0, out, 16);
+    }
+    return rounds * 4;
+}
+#endif
+
+void pcm_remap(const int32_t* in, size_t slots, const uint8_t* map, size_t channels, int32_t* out, size_t frames)
+{
+    /*
+     * The common layouts keep the map in registers and load a whole output
+     * frame before storing it, so each frame is one pass of aligned word
+     * accesses with no inner loop.
+     */
+    if (channels == 2) {
+        const size_t m0 = map[0], m1 = map[1];
+        for (size_t i = 0; i < frames; i++, in += slots, out += 2) {
+            int32_t a = in[m0];
+            int32_t b = in[m1];
+            out[0] = a;
+            out[1] = b;
+        }
+    } else if (channels == 4) {
+        const size_t m0 = map[0], m1 = map[1], m2 = map[2], m3 = map[3];
+        for (size_t i = 0; i < frames; i++, in += slots, out += 4) {
+            int32_t a = in[m0];
+            int32_t b = in[m1];
+            int32_t c = in[m2];
+            int32_t d = in[m3];
+            out[0] = a;
+            out[1] = b;
+            out[2] = c;
+            out[3] = d;
+        }
+    } else {
+        for (size_t i = 0; i < frames; i++, in += slots) {
+            for (size_t c = 0; c < channels; c++) {
+                *out++ = in[map[c]];
+            }
+        }
+    }
+}
+
+size_t pcm_convert(audio_format_t format, const int32_t* in, void* out, size_t samples, pcm_dither_t* dither)
+{
+    size_t done = 0;
+
+    switch (format) {
+    case PCM_FORMAT_16BIT:
+#if PIE_SIMD
+        if (dither == NULL) {
+            done = convert_16_pie(in, out, samples);
+        }
+#endif
+        done += convert_16_words(in + done, (int16_t*)out + done, samples - done, dither);
+        pcm_convert_16_ref(in + done, (int16_t*)out + done, samples - done, dither);
+        return samples * 2;
+
+    case PCM_FORMAT_24BIT_32BIT:
+        done = convert_24_packed_words(in, out, samples);
+        pcm_convert_24_packed_ref(in + done, (uint8_t*)out + 3 * done, samples - done);
+        return samples * 3;
+
+    case PCM_FORMAT_24BIT_IN_32BIT:
+#if PIE_SIMD
+        done = convert_24_in_32_pie(in, out, samples);
+#endif
+        pcm_convert_24_in_32_ref(in + done, (int32_t*)out + done, samples - done);
+        return samples * 4;
+
+    case PCM_FORMAT_32BIT:
+        if (out != (const void*)in) {
+            memcpy(out, in, samples * 4);
+        }
+        return samples * 4;
+
+    default:
+        return 0;
+    }
+}
+
+size_t pcm_unpack(audio_format_t format, const void* in, size_t bytes, int32_t* out)
+{
+    size_t samples = 0;
+
+    switch (format) {
+    case PCM_FORMAT_16BIT: {
+        const int16_t* src = in;
+        samples = bytes / 2;
+        for (size_t i = 0; i < samples; i++) {
+            out[i] = (int32_t)((uint32_t)(uint16_t)src[i] << 16);
+        }
+        break;
+    }
+    case PCM_FORMAT_24BIT_32BIT: {
+        const uint8_t* src = in;
+        samples = bytes / 3;
+        for (size_t i = 0; i < samples; i++, src += 3) {
+            out[i] = (int32_t)(((uint32_t)src[0] << 8) | ((uint32_t)src[1] << 16) | ((uint32_t)src[2] << 24));
+        }
+        break;
+    }
+    case PCM_FORMAT_24BIT_IN_32BIT:
+        samples = bytes / 4;
+        pcm_convert_24_in_32_ref(in, out, samples);
+        break;
+    case PCM_FORMAT_32BIT:
+        samples = bytes / 4;
+        memcpy(out, in, samples * 4);
+        break;
+    default:
+        break;
+    }
+    return samples;
+}
+
+static inline int32_t scale(int32_t s, uint32_t num, uint32_t den)
+{
+    return (int32_t)((int64_t)s * num / den);
+}
+
+void pcm_fade(audio_format_t format, void* data, size_t frames, size_t channels, bool fade_in)
+{
+    const uint32_t den = frames + 1;
+
+    for (size_t i = 0; i < frames; i++) {
+        uint32_t num = fade_in ? i + 1 : frames - i;
+
+        switch (format) {
+        case PCM_FORMAT_16BIT: {
+            int16_t* s = (int16_t*)data + i * channels;
+            for (size_t c = 0; c < channels; c++) {
+                s[c] = (int16_t)scale(s[c], num, den);
+            }
+            break;
+        }
+        case PCM_FORMAT_24BIT_32BIT: {
+            uint8_t* s = (uint8_t*)data + i * channels * 3;
+            for (size_t c = 0; c < channels; c++, s += 3) {
+                int32_t v = (int32_t)(((uint32_t)s[0] << 8) | ((uint32_t)s[1] << 16) | ((uint32_t)s[2] << 24));
+                v = scale(v, num, den);
+                s[0] = (uint8_t)(v >> 8);
+                s[1] = (uint8_t)(v >> 16);
+                s[2] = (uint8_t)(v >> 24);
+            }
+            break;
+        }
+        case PCM_FORMAT_24BIT_IN_32BIT:
+        case PCM_FORMAT_32BIT: {
+            int32_t* s = (int32_t*)data + i * channels;
+            for (size_t c = 0; c < channels; c++) {
+                s[c] = scale(s[c], num, den);
+            }
+            if (format == PCM_FORMAT_24BIT_IN_32BIT) {
+                pcm_convert_24_in_32_ref(s, s, channels);
+            }
+            break;
+        }
+        default:
+            return;
+        }
+    }
+}
@@ -0,0 +1,95 @@
+/**
+ * @file pcm_convert.h
+ * @author your name (you@domain.com)
+ * @brief Conversion of 32-bit I2S slot words to the USB sample formats
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * I2S always captures MSB-aligned 32-bit words. The kernels below reduce them
+ * to the format selected by the host:
+ *  - PCM_FORMAT_16BIT:            2 bytes, optional TPDF dither
+ *  - PCM_FORMAT_24BIT_32BIT:      3 bytes, packed little-endian
+ *  - PCM_FORMAT_24BIT_IN_32BIT:   4 bytes, 24 significant bits, low byte zero
+ *  - PCM_FORMAT_32BIT:            unchanged
+ *
+ * On the ESP32-S3, undithered 16-bit and 24-in-32 output of 16-byte aligned
+ * buffers is converted with PIE vector instructions (see pie_simd.h); every
+ * other case uses scalar kernels with the same output.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "config/audio_config.h"
+
+typedef struct {
+    uint32_t seed; // xorshift32 state, must be non-zero
+} pcm_dither_t;
+
+/**
+ * @brief Convert interleaved 32-bit samples to the given format
+ *
+ * Input and output may point to the same buffer: every format is at most
+ * as wide as the input, and samples are processed front to back.
+ *
+ * @param format target format
+ * @param in 32-bit samples
+ * @param out destination, must hold samples * bytes-per-sample of the format
+ * @param samples number of samples (frames * channels)
+ * @param dither dither state for 16-bit output, NULL for plain truncation
+ * @return number of bytes written to out
+ */
+size_t pcm_convert(audio_format_t format, const int32_t* in, void* out, size_t samples, pcm_dither_t* dither);
+
+/**
+ * @brief Expand samples received from USB to MSB-aligned 32-bit words
+ *
+ * The inverse of pcm_convert(). Incomplete trailing samples are ignored.
+ *
+ * @param format format of the received samples
+ * @param in received bytes
+ * @param bytes number of bytes in in
+ * @param out destination, room for every complete sample in in
+ * @return number of samples written to out
+ */
+size_t pcm_unpack(audio_format_t format, const void* in, size_t bytes, int32_t* out);
+
+/**
+ * @brief Linear fade over whole frames, in place, in any USB format
+ *
+ * Gains step evenly from just above 0 to just below 1 (fade in) or the
+ * reverse, so a fade out followed by a fade in never repeats a full-scale or
+ * a silent frame.
+ *
+ * @param format format of the samples
+ * @param data interleaved samples
+ * @param frames frames to fade, the whole ramp
+ * @param channels samples per frame
+ * @param fade_in true to ramp up, false to ramp down
+ */
+void pcm_fade(audio_format_t format, void* data, size_t frames, size_t channels, bool fade_in);
+
+/**
+ * @brief Gather USB channels out of interleaved I2S slots
+ *
+ * out[i * channels + c] = in[i * slots + map[c]]. A slot may feed several
+ * channels. Input and output must not overlap.
+ *
+ * @param in captured frames of slots words each
+ * @param slots words per captured frame
+ * @param map slot feeding each output channel, every entry below slots
+ * @param channels number of output channels
+ * @param out destination, frames * channels words
+ * @param frames number of frames
+ */
+void pcm_remap(const int32_t* in, size_t slots, const uint8_t* map, size_t channels, int32_t* out, size_t frames);
+
+/* Reference kernels, one sample at a time. pcm_convert uses them for
+   unaligned output and the tail of a block, tests compare against them. */
+void pcm_convert_16_ref(const int32_t* in, int16_t* out, size_t samples, pcm_dither_t* dither);
+void pcm_convert_24_packed_ref(const int32_t* in, uint8_t* out, size_t samples);
+void pcm_convert_24_in_32_ref(const int32_t* in, int32_t* out, size_t samples);
@@ -0,0 +1,217 @@
+/**
+ * @file pie_simd.h
+ * @author your name (you@domain.com)
+ * @brief ESP32-S3 PIE instructions used by the audio kernels
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * One macro per instruction, operating on the eight 128-bit registers q0..q7
+ * named as bare tokens. PIE_SIMD is 1 where the kernels may use them:
+ *  - on the ESP32-S3 when the pipeline runs in a task. The PIE registers are
+ *    saved lazily on a context switch like the FPU's, so they are not used
+ *    in the I2S interrupt (CONFIG_AUDIO_PROCESS_IN_TASK disabled) and the
+ *    scalar kernels are built instead;
+ *  - on the host when PIE_SIMD_MODEL is defined, where each macro runs a C
+ *    model of the instruction so the kernels can be checked bit for bit
+ *    against their references.
+ *
+ * Loads and stores ignore the low four address bits, as the hardware does;
+ * callers check the alignment of their buffers and fall back to the scalar
+ * kernels. Only the instructions below are modelled.
+ */
+#pragma once
+
+#include <stdint.h>
+
+#include "sdkconfig.h"
+
+#if CONFIG_IDF_TARGET_ESP32S3 && CONFIG_AUDIO_PROCESS_IN_TASK
+
+#define PIE_SIMD 1
+
+/* vld/vst: q <- [ptr], ptr += inc */
+#define PIE_VLD_128_IP(q, ptr, inc) __asm__ volatile("ee.vld.128.ip " #q ", %0, " #inc : "+r"(ptr) : : "memory")
+#define PIE_VST_128_IP(q, ptr, inc) __asm__ volatile("ee.vst.128.ip " #q ", %0, " #inc : "+r"(ptr) : : "memory")
+/* Every 32-bit lane of q <- *(uint32_t*)ptr */
+#define PIE_VLDBC_32(q, ptr) __asm__ volatile("ee.vldbc.32 " #q ", %0" : : "r"(ptr) : "memory")
+#define PIE_ZERO_Q(q) __asm__ volatile("ee.zero.q " #q)
+#define PIE_ANDQ(qa, qx, qy) __asm__ volatile("ee.andq " #qa ", " #qx ", " #qy)
+/* Even 16-bit lanes of qs0:qs1 to qs0, odd lanes to qs1 */
+#define PIE_VUNZIP_16(qs0, qs1) __asm__ volatile("ee.vunzip.16 " #qs0 ", " #qs1)
+/* Even 32-bit lanes of qs0:qs1 to qs0, odd lanes to qs1 */
+#define PIE_VUNZIP_32(qs0, qs1) __asm__ volatile("ee.vunzip.32 " #qs0 ", " #qs1)
+/* Interleave the 32-bit lanes of qs0 and qs1, low half to qs0 */
+#define PIE_VZIP_32(qs0, qs1) __asm__ volatile("ee.vzip.32 " #qs0 ", " #qs1)
+#define PIE_VMAX_S32(qa, qx, qy) __asm__ volatile("ee.vmax.s32 " #qa ", " #qx ", " #qy)
+#define PIE_VMIN_S32(qa, qx, qy) __asm__ volatile("ee.vmin.s32 " #qa ", " #qx ", " #qy)
+/* Lanes of qa all ones where the comparison holds, zero elsewhere */
+#define PIE_VCMP_GT_S32(qa, qx, qy) __asm__ volatile("ee.vcmp.gt.s32 " #qa ", " #qx ", " #qy)
+#define PIE_VCMP_LT_S32(qa, qx, qy) __asm__ volatile("ee.vcmp.lt.s32 " #qa ", " #qx ", " #qy)
+/* Saturating lane arithmetic */
+#define PIE_VADDS_S32(qa, qx, qy) __asm__ volatile("ee.vadds.s32 " #qa ", " #qx ", " #qy)
+#define PIE_VSUBS_S32(qa, qx, qy) __asm__ volatile("ee.vsubs.s32 " #qa ", " #qx ", " #qy)
+/*
+ * Arithmetic shift right of every 32-bit lane by a constant. SAR is set in
+ * the same statement because the compiler uses it for its own shifts.
+ */
+#define PIE_VSR_32(qa, qs, n) __asm__ volatile("ssai " #n "\n\tee.vsr.32 " #qa ", " #qs)
+/* ACCX (40 bits) += sum of the products of the eight signed 16-bit lanes */
+#define PIE_ZERO_ACCX() __asm__ volatile("ee.zero.accx")
+#define PIE_VMULAS_S16_ACCX(qx, qy) __asm__ volatile("ee.vmulas.s16.accx " #qx ", " #qy)
+#define PIE_RD_ACCX(v)                                                      \
+    do {                                                                    \
+        uint32_t accx_lo_, accx_hi_;                                        \
+        __asm__ volatile("rur.accx_0 %0" : "=r"(accx_lo_));                 \
+        __asm__ volatile("rur.accx_1 %0" : "=r"(accx_hi_));                 \
+        (v) = (int64_t)((uint64_t)accx_hi_ << 56 | (uint64_t)accx_lo_ << 24) >> 24; \
+    } while (0)
+
+#elif PIE_SIMD_MODEL
+
+#include <string.h>
+
+#define PIE_SIMD 1
+
+typedef union {
+    uint8_t u8[16];
+    int16_t s16[8];
+    int32_t s32[4];
+    uint32_t u32[4];
+} pie_model_q_t;
+
+enum { PIE_Q_q0, PIE_Q_q1, PIE_Q_q2, PIE_Q_q3, PIE_Q_q4, PIE_Q_q5, PIE_Q_q6, PIE_Q_q7 };
+
+static struct {
+    pie_model_q_t q[8];
+    int64_t accx;
+} pie_model;
+
+#define PIE_MODEL_Q(reg) (&pie_model.q[PIE_Q_##reg])
+#define PIE_MODEL_ALIGN(ptr) ((void*)((uintptr_t)(ptr) & ~(uintptr_t)15))
+
+static inline int32_t pie_model_sat32(int64_t v)
+{
+    return v > INT32_MAX ? INT32_MAX : v < INT32_MIN ? INT32_MIN : (int32_t)v;
+}
+
+static inline void pie_model_unzip_16(pie_model_q_t* a, pie_model_q_t* b)
+{
+    pie_model_q_t even, odd;
+    for (int i = 0; i < 4; i++) {
+        even.s16[i] = a->s16[2 * i];
+        even.s16[i + 4] = b->s16[2 * i];
+        odd.s16[i] = a->s16[2 * i + 1];
+        odd.s16[i + 4] = b->s16[2 * i + 1];
+    }
+    *a = even;
+    *b = odd;
+}
+
+static inline void pie_model_unzip_32(pie_model_q_t* a, pie_model_q_t* b)
+{
+    pie_model_q_t even = { .s32 = { a->s32[0], a->s32[2], b->s32[0], b->s32[2] } };
+    pie_model_q_t odd = { .s32 = { a->s32[1], a->s32[3], b->s32[1], b->s32[3] } };
+    *a = even;
+    *b = odd;
+}
+
+static inline void pie_model_zip_32(pie_model_q_t* a, pie_model_q_t* b)
+{
+    pie_model_q_t lo = { .s32 = { a->s32[0], b->s32[0], a->s32[1], b->s32[1] } };
+    pie_model_q_t hi = { .s32 = { a->s32[2], b->s32[2], a->s32[3], b->s32[3] } };
+    *a = lo;
+    *b = hi;
+}
+
+enum { PIE_MODEL_MAX, PIE_MODEL_MIN, PIE_MODEL_GT, PIE_MODEL_LT, PIE_MODEL_ADDS, PIE_MODEL_SUBS };
+
+static inline void pie_model_lanes_32(int op, pie_model_q_t* a, const pie_model_q_t* x, const pie_model_q_t* y)
+{
+    pie_model_q_t r;
+    for (int i = 0; i < 4; i++) {
+        int32_t u = x->s32[i], v = y->s32[i];
+        switch (op) {
+        case PIE_MODEL_MAX:
+            r.s32[i] = u > v ? u : v;
+            break;
+        case PIE_MODEL_MIN:
+            r.s32[i] = u < v ? u : v;
+            break;
+        case PIE_MODEL_GT:
+            r.s32[i] = u > v ? -1 : 0;
+            break;
+        case PIE_MODEL_LT:
+            r.s32[i] = u < v ? -1 : 0;
+            break;
+        case PIE_MODEL_ADDS:
+            r.s32[i] = pie_model_sat32((int64_t)u + v);
+            break;
+        default:
+            r.s32[i] = pie_model_sat32((int64_t)u - v);
+            break;
+        }
+    }
+    *a = r;
+}
+
+static inline void pie_model_vmulas_s16_accx(const pie_model_q_t* x, const pie_model_q_t* y)
+{
+    int64_t acc = pie_model.accx;
+    for (int i = 0; i < 8; i++) {
+        acc += (int32_t)x->s16[i] * y->s16[i];
+    }
+    /* Wrap to 40 bits */
+    pie_model.accx = (int64_t)((uint64_t)acc << 24) >> 24;
+}
+
+#define PIE_VLD_128_IP(q, ptr, inc)                            \
+    do {                                                       \
+        memcpy(PIE_MODEL_Q(q), PIE_MODEL_ALIGN(ptr), 16);      \
+        (ptr) = (void*)((uintptr_t)(ptr) + (inc));             \
+    } while (0)
+#define PIE_VST_128_IP(q, ptr, inc)                            \
+    do {                                                       \
+        memcpy(PIE_MODEL_ALIGN(ptr), PIE_MODEL_Q(q), 16);      \
+        (ptr) = (void*)((uintptr_t)(ptr) + (inc));             \
+    } while (0)
+#define PIE_VLDBC_32(q, ptr)                                               \
+    do {                                                                   \
+        uint32_t bc_;                                                      \
+        memcpy(&bc_, (const void*)((uintptr_t)(ptr) & ~(uintptr_t)3), 4); \
+        for (int i_ = 0; i_ < 4; i_++) {                                   \
+            PIE_MODEL_Q(q)->u32[i_] = bc_;                                 \
+        }                                                                  \
+    } while (0)
+#define PIE_ZERO_Q(q) memset(PIE_MODEL_Q(q), 0, 16)
+#define PIE_ANDQ(qa, qx, qy)                                                     \
+    do {                                                                         \
+        for (int i_ = 0; i_ < 4; i_++) {                                         \
+            PIE_MODEL_Q(qa)->u32[i_] = PIE_MODEL_Q(qx)->u32[i_] & PIE_MODEL_Q(qy)->u32[i_]; \
+        }                                                                        \
+    } while (0)
+#define PIE_VUNZIP_16(qs0, qs1) pie_model_unzip_16(PIE_MODEL_Q(qs0), PIE_MODEL_Q(qs1))
+#define PIE_VUNZIP_32(qs0, qs1) pie_model_unzip_32(PIE_MODEL_Q(qs0), PIE_MODEL_Q(qs1))
+#define PIE_VZIP_32(qs0, qs1) pie_model_zip_32(PIE_MODEL_Q(qs0), PIE_MODEL_Q(qs1))
+#define PIE_VMAX_S32(qa, qx, qy) pie_model_lanes_32(PIE_MODEL_MAX, PIE_MODEL_Q(qa), PIE_MODEL_Q(qx), PIE_MODEL_Q(qy))
+#define PIE_VMIN_S32(qa, qx, qy) pie_model_lanes_32(PIE_MODEL_MIN, PIE_MODEL_Q(qa), PIE_MODEL_Q(qx), PIE_MODEL_Q(qy))
+#define PIE_VCMP_GT_S32(qa, qx, qy) pie_model_lanes_32(PIE_MODEL_GT, PIE_MODEL_Q(qa), PIE_MODEL_Q(qx), PIE_MODEL_Q(qy))
+#define PIE_VCMP_LT_S32(qa, qx, qy) pie_model_lanes_32(PIE_MODEL_LT, PIE_MODEL_Q(qa), PIE_MODEL_Q(qx), PIE_MODEL_Q(qy))
+#define PIE_VADDS_S32(qa, qx, qy) pie_model_lanes_32(PIE_MODEL_ADDS, PIE_MODEL_Q(qa), PIE_MODEL_Q(qx), PIE_MODEL_Q(qy))
+#define PIE_VSUBS_S32(qa, qx, qy) pie_model_lanes_32(PIE_MODEL_SUBS, PIE_MODEL_Q(qa), PIE_MODEL_Q(qx), PIE_MODEL_Q(qy))
+#define PIE_VSR_32(qa, qs, n)                                                 \
+    do {                                                                      \
+        for (int i_ = 0; i_ < 4; i_++) {                                      \
+            PIE_MODEL_Q(qa)->s32[i_] = PIE_MODEL_Q(qs)->s32[i_] >> (n);       \
+        }                                                                     \
+    } while (0)
+#define PIE_ZERO_ACCX() (pie_model.accx = 0)
+#define PIE_VMULAS_S16_ACCX(qx, qy) pie_model_vmulas_s16_accx(PIE_MODEL_Q(qx), PIE_MODEL_Q(qy))
+#define PIE_RD_ACCX(v) ((v) = pie_model.accx)
+
+#else
+
+#define PIE_SIMD 0
+
+#endif
@@ -0,0 +1,226 @@
+/**
+ * @file playback.c
+ * @author your name (you@domain.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include "playback.h"
+
+#include "sdkconfig.h"
+
+#if CONFIG_AUDIO_PLAYBACK
+
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "audio_ring.h"
+#include "esp_log.h"
+#include "pcm_convert.h"
+#include "rt_log.h"
+#include "telemetry.h"
+
+#define FRAME_BYTES (NUM_CHANNELS * sizeof(int32_t))
+#define CONCEAL_REPEAT_BLOCKS 2 // Blocks repeated while prebuffering again, then silence
+
+_Static_assert(CONFIG_AUDIO_PLAYBACK_PREBUFFER_MS * MIN_SAMPLE_RATE >= (AUDIO_DMA_FRAME_NUM + MIN_SAMPLE_RATE / 1000 + 1) * 1000,
+    "Playback prebuffer shorter than one DMA block plus one USB packet");
+_Static_assert(AUDIO_PLAYBACK_RING_BYTES <= AUDIO_RING_MAX_BYTES, "Playback ring exceeds the RAM budget");
+
+static const char* TAG = "playback";
+
+typedef enum {
+    PLAYBACK_STOPPED,
+    PLAYBACK_BUFFERING,
+    PLAYBACK_RUNNING,
+} playback_state_t;
+
+typedef struct {
+    audio_ring_t ring; // USB OUT -> I2S TX, interleaved 32-bit words of the USB channels
+    atomic_bool active; // Host has the OUT interface open
+    atomic_bool restart_pending;
+    atomic_uint sample_rate;
+    /* Owned by the TinyUSB task */
+    audio_format_t format;
+    int32_t unpacked[MAX_AUDIO_BYTES_PER_MS / 2]; // One packet of 16-bit samples, the densest format
+    /* Owned by the I2S TX interrupt */
+    playback_state_t state;
+    bool played; // Ran since the last start, gaps from here on are concealed
+    uint32_t concealed_run; // Blocks concealed since the ring ran dry
+    int32_t last_block[AUDIO_DMA_FRAME_NUM * NUM_CHANNELS];
+} playback_ctx_t;
+
+static playback_ctx_t ctx = { 0 };
+
+esp_err_t playback_init(uint32_t sample_rate)
+{
+    esp_err_t ret = audio_ring_init(&ctx.ring, AUDIO_PLAYBACK_RING_BYTES, "playback ring");
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    atomic_init(&ctx.active, false);
+    atomic_init(&ctx.restart_pending, false);
+    atomic_init(&ctx.sample_rate, sample_rate);
+    ctx.format = PCM_FORMAT_UNKNOWN;
+    ctx.state = PLAYBACK_STOPPED;
+
+    ESP_LOGI(TAG, "Ring %u bytes, latency %" PRIu32 " frames", (unsigned)ctx.ring.capacity, playback_get_latency_frames());
+    return ESP_OK;
+}
+
+void playback_start(audio_format_t format)
+{
+    ctx.format = format;
+    atomic_store_explicit(&ctx.restart_pending, true, memory_order_relaxed);
+    atomic_store_explicit(&ctx.active, true, memory_order_release);
+}
+
+void playback_stop(void)
+{
+    atomic_store_explicit(&ctx.active, false, memory_order_release);
+    ctx.format = PCM_FORMAT_UNKNOWN;
+}
+
+void playback_set_sample_rate(uint32_t sample_rate)
+{
+    atomic_store_explicit(&ctx.sample_rate, sample_rate, memory_order_relaxed);
+    atomic_store_explicit(&ctx.restart_pending, true, memory_order_release);
+}
+
+uint32_t playback_get_latency_frames(void)
+{
+    uint32_t sample_rate = atomic_load_explicit(&ctx.sample_rate, memory_order_relaxed);
+    return CONFIG_AUDIO_PLAYBACK_PREBUFFER_MS * sample_rate / 1000 + (AUDIO_DMA_DESC_NUM - 1) * AUDIO_DMA_FRAME_NUM;
+}
+
+void playback_write(const void* data, size_t len)
+{
+    if (ctx.format == PCM_FORMAT_UNKNOWN) {
+        return;
+    }
+    if (len > MAX_AUDIO_BYTES_PER_MS) {
+        len = MAX_AUDIO_BYTES_PER_MS;
+    }
+
+    size_t samples = pcm_unpack(ctx.format, data, len, ctx.unpacked);
+    size_t bytes = (samples - samples % NUM_CHANNELS) * sizeof(int32_t);
+
+    /* Whole packets only, so the ring always holds whole frames */
+    if (bytes > audio_ring_free(&ctx.ring)) {
+        telemetry_record_playback_overrun(bytes);
+        return;
+    }
+    audio_ring_write(&ctx.ring, ctx.unpacked, bytes);
+}
+
+/**
+ * @brief Spread USB channels over the port's slots
+ *
+ * @param block NUM_CHANNELS words per frame, NULL for silence
+ */
+static void expand(const int32_t* block, int32_t* slots, size_t frames)
+{
+    if (block == NULL) {
+        memset(slots, 0, frames * AUDIO_I2S_FRAME_BYTES);
+    } else if (NUM_CHANNELS == AUDIO_I2S_PORT_SLOTS) {
+        memcpy(slots, block, frames * AUDIO_I2S_FRAME_BYTES);
+    } else {
+        for (size_t i = 0; i < frames; i++) {
+            for (int s = 0; s < AUDIO_I2S_PORT_SLOTS; s++) {
+                *slots++ = s < NUM_CHANNELS ? block[s] : 0;
+            }
+            block += NUM_CHANNELS;
+        }
+    }
+}
+
+/**
+ * @brief Start running once the prebuffer is reached, with exactly the prebuffer queued
+ *
+ */
+static void try_start(size_t fill)
+{
+    uint32_t sample_rate = atomic_load_explicit(&ctx.sample_rate, memory_order_relaxed);
+    size_t target = CONFIG_AUDIO_PLAYBACK_PREBUFFER_MS * sample_rate / 1000 * FRAME_BYTES;
+
+    if (fill < target) {
+        return;
+    }
+    audio_ring_consume(&ctx.ring, fill - target);
+    ctx.state = PLAYBACK_RUNNING;
+    ctx.played = true;
+}
+
+void playback_fill(int32_t* slots, size_t frames)
+{
+    if (frames > AUDIO_DMA_FRAME_NUM) {
+        frames = AUDIO_DMA_FRAME_NUM;
+    }
+
+    if (atomic_exchange_explicit(&ctx.restart_pending, false, memory_order_acquire)) {
+        audio_ring_flush(&ctx.ring);
+        ctx.state = PLAYBACK_STOPPED;
+    }
+    if (!atomic_load_explicit(&ctx.active, memory_order_acquire)) {
+        if (ctx.state != PLAYBACK_STOPPED) {
+            audio_ring_flush(&ctx.ring);
+            ctx.state = PLAYBACK_STOPPED;
+        }
+        expand(NULL, slots, frames);
+        return;
+    }
+
+    size_t fill = audio_ring_fill(&ctx.ring);
+    size_t bytes = frames * FRAME_BYTES;
+
+    if (ctx.state == PLAYBACK_STOPPED) {
+        ctx.state = PLAYBACK_BUFFERING;
+        ctx.played = false;
+    }
+    if (ctx.state == PLAYBACK_BUFFERING) {
+        try_start(fill);
+        fill = audio_ring_fill(&ctx.ring);
+    }
+
+    if (ctx.state == PLAYBACK_RUNNING && fill >= bytes) {
+        audio_ring_read(&ctx.ring, ctx.last_block, bytes);
+        ctx.concealed_run = 0;
+        expand(ctx.last_block, slots, frames);
+        telemetry_record_playback_block(false);
+        return;
+    }
+
+    if (ctx.state == PLAYBACK_RUNNING) {
+        /* Prebuffer again so the delay is the same as before the gap. The
+         * partial block left over is from before the gap: drop it, or it
+         * would play spliced to whatever the host sends next. */
+        audio_ring_consume(&ctx.ring, fill);
+        ctx.state = PLAYBACK_BUFFERING;
+        telemetry_record_playback_underrun();
+        rt_log(RT_LOG_PLAYBACK_UNDERRUN, 0, 0, 0);
+    }
+
+    if (!ctx.played) {
+        expand(NULL, slots, frames);
+        return;
+    }
+
+#if CONFIG_AUDIO_PLAYBACK_CONCEAL_REPEAT
+    if (ctx.concealed_run++ < CONCEAL_REPEAT_BLOCKS) {
+        expand(ctx.last_block, slots, frames);
+    } else {
+        expand(NULL, slots, frames);
+    }
+#else
+    expand(NULL, slots, frames);
+#endif
+    telemetry_record_playback_block(true);
+}
+
+#endif
@@ -0,0 +1,83 @@
+/**
+ * @file playback.h
+ * @author your name (you@domain.com)
+ * @brief USB OUT -> I2S TX playback path
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * Samples received on the USB OUT endpoint are expanded to 32-bit words and
+ * queued in a ring of their own. The I2S TX interrupt takes one DMA block at a
+ * time from it. TX runs on the capture controller, so playback and capture
+ * share BCLK and WS and never drift against each other.
+ *
+ * Playback starts once the ring holds the prebuffer depth, and at that point
+ * anything queued beyond it is dropped. Every start therefore has the same
+ * delay between a USB packet arriving and its first frame leaving the DAC
+ * pin, which makes the USB-to-USB round trip through an external loopback
+ * the same every time. When the ring runs dry the missing blocks are
+ * concealed and playback prebuffers again, restoring the same delay.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "config/audio_config.h"
+#include "esp_err.h"
+
+/**
+ * @brief Allocate the playback ring
+ *
+ * @param sample_rate rate the host starts streaming at, in Hz
+ */
+esp_err_t playback_init(uint32_t sample_rate);
+
+/**
+ * @brief Start accepting samples, called when the host opens the OUT interface
+ *
+ * @param format sample format of the selected alternate setting
+ */
+void playback_start(audio_format_t format);
+
+/**
+ * @brief Stop playback and output silence, called when the host closes the OUT interface
+ *
+ */
+void playback_stop(void);
+
+/**
+ * @brief Follow a sample rate change, prebuffering again at the new rate
+ *
+ */
+void playback_set_sample_rate(uint32_t sample_rate);
+
+/**
+ * @brief Queue one received USB packet
+ *
+ * Must be called from a single task, the TinyUSB task. A packet that does not
+ * fit in the ring is dropped whole and counted in telemetry.
+ *
+ * @param data packet in the format given to playback_start()
+ * @param len packet length in bytes
+ */
+void playback_write(const void* data, size_t len);
+
+/**
+ * @brief Fill one I2S TX DMA buffer
+ *
+ * Called from the I2S TX interrupt only. USB channel n goes to slot n, slots
+ * beyond NUM_CHANNELS are silent.
+ *
+ * @param slots DMA buffer, AUDIO_I2S_PORT_SLOTS 32-bit words per frame
+ * @param frames number of frames, at most AUDIO_DMA_FRAME_NUM
+ */
+void playback_fill(int32_t* slots, size_t frames);
+
+/**
+ * @brief Frames between a received USB packet and its output, once playback is running
+ *
+ * The prebuffer plus the TX DMA buffers queued ahead of the one being filled.
+ */
+uint32_t playback_get_latency_frames(void);
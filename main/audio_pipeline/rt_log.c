@@ -0,0 +1,197 @@
+/**
+ * @file rt_log.c
+ * @author your name (you@domain.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include "rt_log.h"
+
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "config/audio_config.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#ifndef CONFIG_AUDIO_RT_LOG_RECORDS
+#define CONFIG_AUDIO_RT_LOG_RECORDS 64
+#endif
+#ifndef CONFIG_AUDIO_RT_LOG_BURST
+#define CONFIG_AUDIO_RT_LOG_BURST 5
+#endif
+
+#define NUM_RECORDS AUDIO_POW2_CEIL(CONFIG_AUDIO_RT_LOG_RECORDS)
+#define DRAIN_INTERVAL_MS 50
+#define RATE_WINDOW_US 1000000
+
+static const char* TAG = "rt-log";
+
+typedef struct {
+    atomic_uint seq; // Position + 1 once written, position + NUM_RECORDS once read
+    rt_log_event_t event;
+    int64_t time_us;
+    uint32_t args[RT_LOG_ARGS];
+} rt_log_record_t;
+
+typedef struct {
+    int64_t window_start_us;
+    uint32_t printed; // Lines in the current window
+    uint32_t suppressed;
+} rt_log_limit_t;
+
+typedef struct {
+    rt_log_record_t records[NUM_RECORDS];
+    atomic_uint head; // Next position to claim, shared by all producers
+    atomic_uint dropped;
+    /* Owned by the log task */
+    uint32_t tail;
+    uint32_t dropped_reported;
+    rt_log_limit_t limit[RT_LOG_EVENT_COUNT];
+} rt_log_ctx_t;
+
+static const struct {
+    esp_log_level_t level;
+    const char* name;
+    const char* format;
+} events[RT_LOG_EVENT_COUNT] = {
+    [RT_LOG_UNDERRUN] = { ESP_LOG_WARN, "underrun", "USB ran dry, %" PRIu32 " bytes short" },
+    [RT_LOG_RECOVERY] = { ESP_LOG_WARN, "recovery", "Streaming resumed at usb frame %" PRIu32 ", %" PRIu32 " frames skipped" },
+    [RT_LOG_RESYNC] = { ESP_LOG_WARN, "resync", "Underrun too long (%" PRIu32 " bytes owed), prebuffering again" },
+    [RT_LOG_OVERRUN] = { ESP_LOG_WARN, "overrun", "Audio ring full, %" PRIu32 " bytes dropped" },
+    [RT_LOG_CAPTURE_GAP] = { ESP_LOG_WARN, "capture gap", "Capture gap at frame %" PRIu32 ", %" PRIu32 " frames concealed" },
+    [RT_LOG_CAPTURE_LOST] = { ESP_LOG_WARN, "capture loss", "Capture gap at frame %" PRIu32 ", %" PRIu32 " frames too long to conceal" },
+    [RT_LOG_DMA_OVERFLOW] = { ESP_LOG_WARN, "dma overflow", "I2S port %" PRIu32 " DMA overflow" },
+    [RT_LOG_PORT_SLIP] = { ESP_LOG_WARN, "port slip", "I2S ports lost alignment, heads %" PRId32 " frames apart" },
+    [RT_LOG_PLAYBACK_UNDERRUN] = { ESP_LOG_WARN, "playback underrun", "Playback ran dry, prebuffering again" },
+    [RT_LOG_FLUSH] = { ESP_LOG_WARN, "flush", "Flushing pipeline" },
+    [RT_LOG_FORMAT] = { ESP_LOG_INFO, "format", "Format changed to %" PRIu32 },
+    [RT_LOG_LATENCY_PROFILE] = { ESP_LOG_INFO, "latency profile", "Latency profile %" PRIu32 " (%" PRIu32 " ms)" },
+    [RT_LOG_CLOCK_TRIM] = { ESP_LOG_DEBUG, "clock trim", "fill error %" PRId32 "/10 frames, trim %" PRId32 "/10 ppm" },
+};
+
+static rt_log_ctx_t ctx = { 0 };
+
+void rt_log_init(void)
+{
+    for (uint32_t i = 0; i < NUM_RECORDS; i++) {
+        atomic_init(&ctx.records[i].seq, i);
+    }
+    atomic_init(&ctx.head, 0);
+    atomic_init(&ctx.dropped, 0);
+}
+
+void rt_log(rt_log_event_t event, uint32_t a0, uint32_t a1, uint32_t a2)
+{
+    uint32_t pos = atomic_load_explicit(&ctx.head, memory_order_relaxed);
+    rt_log_record_t* record;
+
+    /* Claim a free record; a CAS that loses to another producer retries with the position it saw */
+    while (1) {
+        record = &ctx.records[pos % NUM_RECORDS];
+        int32_t diff = (int32_t)(atomic_load_explicit(&record->seq, memory_order_acquire) - pos);
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&ctx.head, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            /* Not read yet, the ring is full */
+            atomic_fetch_add_explicit(&ctx.dropped, 1, memory_order_relaxed);
+            return;
+        } else {
+            pos = atomic_load_explicit(&ctx.head, memory_order_relaxed);
+        }
+    }
+
+    record->event = event;
+    record->time_us = esp_timer_get_time();
+    record->args[0] = a0;
+    record->args[1] = a1;
+    record->args[2] = a2;
+    atomic_store_explicit(&record->seq, pos + 1, memory_order_release);
+}
+
+static bool take(rt_log_record_t* out)
+{
+    rt_log_record_t* record = &ctx.records[ctx.tail % NUM_RECORDS];
+
+    if (atomic_load_explicit(&record->seq, memory_order_acquire) != ctx.tail + 1) {
+        return false; // Empty, or the next record is still being written
+    }
+    out->event = record->event;
+    out->time_us = record->time_us;
+    for (int i = 0; i < RT_LOG_ARGS; i++) {
+        out->args[i] = record->args[i];
+    }
+    atomic_store_explicit(&record->seq, ctx.tail + NUM_RECORDS, memory_order_release);
+    ctx.tail++;
+    return true;
+}
+
+static void print(const rt_log_record_t* record)
+{
+    char line[96];
+    snprintf(line, sizeof(line), events[record->event].format, record->args[0], record->args[1], record->args[2]);
+
+    uint32_t ms = (uint32_t)(record->time_us / 1000);
+    ESP_LOG_LEVEL(events[record->event].level, TAG, "[%" PRIu32 " ms] %s", ms, line);
+}
+
+/**
+ * @brief Close rate windows that ran out and summarise what they held back
+ *
+ */
+static void close_windows(int64_t now_us)
+{
+    for (int e = 0; e < RT_LOG_EVENT_COUNT; e++) {
+        rt_log_limit_t* limit = &ctx.limit[e];
+        if (now_us - limit->window_start_us < RATE_WINDOW_US) {
+            continue;
+        }
+        if (limit->suppressed > 0) {
+            /* At the event's own level, so routine events held back do not show up as warnings */
+            ESP_LOG_LEVEL(events[e].level, TAG, "%" PRIu32 " more %s events suppressed", limit->suppressed, events[e].name);
+        }
+        limit->window_start_us = now_us;
+        limit->printed = 0;
+        limit->suppressed = 0;
+    }
+}
+
+void rt_log_task(void* pvParam)
+{
+    rt_log_record_t record;
+
+    while (1) {
+        vTaskDelay(pdMS_TO_TICKS(DRAIN_INTERVAL_MS));
+
+        close_windows(esp_timer_get_time());
+        while (take(&record)) {
+            if (record.event >= RT_LOG_EVENT_COUNT) {
+                continue;
+            }
+            rt_log_limit_t* limit = &ctx.limit[record.event];
+            if (limit->printed < CONFIG_AUDIO_RT_LOG_BURST) {
+                limit->printed++;
+                print(&record);
+            } else {
+                limit->suppressed++;
+            }
+        }
+
+        uint32_t dropped = atomic_load_explicit(&ctx.dropped, memory_order_relaxed);
+        if (dropped != ctx.dropped_reported) {
+            ESP_LOGW(TAG, "%" PRIu32 " records dropped, ring full", dropped - ctx.dropped_reported);
+            ctx.dropped_reported = dropped;
+        }
+    }
+}
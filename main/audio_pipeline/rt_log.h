@@ -0,0 +1,61 @@
+/**
+ * @file rt_log.h
+ * @author your name (you@domain.com)
+ * @brief Deferred logging for the interrupt and USB callback paths
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * Formatting and printing a log line takes far longer than a DMA or USB
+ * callback may, and the UART driver can block. Hot paths therefore only
+ * queue a fixed-size binary record (event, time, arguments) in a lock-free
+ * multi-producer ring; rt_log_task() formats the records later from a
+ * low-priority task. A record that finds the ring full is dropped and
+ * counted. Each event is limited to CONFIG_AUDIO_RT_LOG_BURST lines per
+ * second, the rest are counted and summarised.
+ */
+#pragma once
+
+#include <stdint.h>
+
+#define RT_LOG_ARGS 3
+
+/**
+ * Events the hot paths can log. The format of each is in rt_log.c.
+ */
+typedef enum {
+    RT_LOG_UNDERRUN, // bytes short
+    RT_LOG_RECOVERY, // USB frame, frames skipped
+    RT_LOG_RESYNC, // bytes owed
+    RT_LOG_OVERRUN, // bytes dropped
+    RT_LOG_CAPTURE_GAP, // capture frame, frames concealed
+    RT_LOG_CAPTURE_LOST, // capture frame, frames lost
+    RT_LOG_DMA_OVERFLOW, // I2S port
+    RT_LOG_PORT_SLIP, // frames apart, 0 if a block was lost
+    RT_LOG_PLAYBACK_UNDERRUN,
+    RT_LOG_FLUSH,
+    RT_LOG_FORMAT, // audio_format_t
+    RT_LOG_LATENCY_PROFILE, // audio_latency_profile_t, prebuffer ms
+    RT_LOG_CLOCK_TRIM, // fill error in 1/10 frames, trim in 1/10 ppm
+    RT_LOG_EVENT_COUNT,
+} rt_log_event_t;
+
+/**
+ * @brief Prepare the ring, before any producer runs
+ *
+ */
+void rt_log_init(void);
+
+/**
+ * @brief Queue one event. Never blocks, callable from interrupts.
+ *
+ * @param a0 first argument, see rt_log_event_t; unused arguments are ignored
+ */
+void rt_log(rt_log_event_t event, uint32_t a0, uint32_t a1, uint32_t a2);
+
+/**
+ * @brief Format queued events, rate limited, and report dropped records
+ *
+ */
+void rt_log_task(void* pvParam);
@@ -0,0 +1,138 @@
+/**
+ * @file src_polyphase.c
+ * @author your name (you@domain.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include "src_polyphase.h"
+
+#include <math.h>
+#include <string.h>
+
+#define STEP_FRAC_BITS 24
+#define STEP_ONE (1u << STEP_FRAC_BITS)
+#define PHASE_BITS 6 // log2(SRC_PHASES)
+#define INTERP_BITS 15
+#define COEF_ONE (1 << 30)
+
+_Static_assert((1 << PHASE_BITS) == SRC_PHASES, "PHASE_BITS must match SRC_PHASES");
+
+static double blackman(double x)
+{
+    /* x in [0, 1] over the filter span */
+    return 0.42 - 0.5 * cos(2.0 * M_PI * x) + 0.08 * cos(4.0 * M_PI * x);
+}
+
+static double sinc(double x)
+{
+    return x == 0.0 ? 1.0 : sin(M_PI * x) / (M_PI * x);
+}
+
+esp_err_t src_init(src_t* src, uint32_t in_rate, uint32_t out_rate)
+{
+    if (in_rate == 0 || out_rate == 0 || (uint64_t)out_rate * 2 > (uint64_t)in_rate * 5 || in_rate / out_rate >= 255) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    /* Cut off below the lower of the two Nyquist frequencies, in units of the input rate */
+    double cutoff = 0.5 * (out_rate < in_rate ? (double)out_rate / in_rate : 1.0) * 0.91;
+
+    for (int p = 0; p <= SRC_PHASES; p++) {
+        double frac = (double)p / SRC_PHASES;
+        double h[SRC_TAPS];
+        double sum = 0;
+
+        for (int k = 0; k < SRC_TAPS; k++) {
+            /* Tap k sits t input samples from the output position */
+            double t = (SRC_TAPS / 2 - 1) + frac - k;
+            double w = blackman((t + SRC_TAPS / 2) / SRC_TAPS);
+            h[k] = 2.0 * cutoff * sinc(2.0 * cutoff * t) * w;
+            sum += h[k];
+        }
+
+        /* Unity DC gain for every phase */
+        for (int k = 0; k < SRC_TAPS; k++) {
+            src->coef[p][k] = (int32_t)lround(h[k] / sum * COEF_ONE);
+        }
+    }
+
+    src->nominal_step = (uint32_t)(((uint64_t)in_rate << STEP_FRAC_BITS) / out_rate);
+    src->step = src->nominal_step;
+    src->pos = 0;
+    memset(src->work, 0, sizeof(src->work));
+    return ESP_OK;
+}
+
+void src_set_trim_ppb(src_t* src, int32_t ppb)
+{
+    src->step = (uint32_t)((int64_t)src->nominal_step - (int64_t)src->nominal_step * ppb / 1000000000);
+}
+
+static inline int64_t dot(const int32_t* x, const int32_t* c)
+{
+    int64_t acc = 0;
+    for (int k = 0; k < SRC_TAPS; k++) {
+        acc += (int64_t)x[k] * c[k];
+    }
+    return acc;
+}
+
+static inline int32_t saturate(int64_t v)
+{
+    if (v > INT32_MAX) {
+        return INT32_MAX;
+    }
+    if (v < INT32_MIN) {
+        return INT32_MIN;
+    }
+    return (int32_t)v;
+}
+
+size_t src_process(src_t* src, const int32_t* in, size_t in_frames, int32_t* out)
+{
+    if (in_frames > SRC_MAX_BLOCK_FRAMES) {
+        in_frames = SRC_MAX_BLOCK_FRAMES;
+    }
+
+    /* Deinterleave behind the history */
+    for (size_t i = 0; i < in_frames; i++) {
+        for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+            src->work[ch][SRC_TAPS + i] = in[i * NUM_CHANNELS + ch];
+        }
+    }
+
+    const uint64_t end = (uint64_t)in_frames << STEP_FRAC_BITS;
+    const uint32_t step = src->step;
+    uint64_t pos = src->pos;
+    size_t out_frames = 0;
+
+    /* The window for position pos starts at work[pos + 1] and must lie inside history + block */
+    while (pos < end) {
+        uint32_t index = (uint32_t)(pos >> STEP_FRAC_BITS) + 1;
+        uint32_t frac = (uint32_t)pos & (STEP_ONE - 1);
+        uint32_t phase = frac >> (STEP_FRAC_BITS - PHASE_BITS);
+        int64_t interp = (frac >> (STEP_FRAC_BITS - PHASE_BITS - INTERP_BITS)) & ((1 << INTERP_BITS) - 1);
+
+        for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+            const int32_t* x = &src->work[ch][index];
+            int64_t a = dot(x, src->coef[phase]) >> 15;
+            int64_t b = dot(x, src->coef[phase + 1]) >> 15;
+            int64_t y = a + (((b - a) * interp) >> INTERP_BITS);
+            out[out_frames * NUM_CHANNELS + ch] = saturate(y >> 15);
+        }
+        out_frames++;
+        pos += step;
+    }
+
+    /* Keep the last SRC_TAPS input frames as history for the next block */
+    for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+        memmove(&src->work[ch][0], &src->work[ch][in_frames], SRC_TAPS * sizeof(int32_t));
+    }
+    src->pos = pos - end;
+
+    return out_frames;
+}
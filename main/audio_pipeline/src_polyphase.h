@@ -0,0 +1,74 @@
+/**
+ * @file src_polyphase.h
+ * @author your name (you@domain.com)
+ * @brief Fixed-point polyphase sample-rate converter
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * Windowed-sinc interpolator with SRC_PHASES sub-sample phases of SRC_TAPS
+ * taps each. Output samples between two phases are linearly interpolated
+ * from the two neighbouring dot products, so any ratio (and a slowly varying
+ * one) is supported. Coefficients are Q30 and accumulation is 64-bit
+ * integer. src_init designs the filter in floating point and is called from
+ * tasks; src_set_trim_ppb is integer only, so the producer can apply a trim
+ * between two blocks even when it runs in the I2S interrupt.
+ *
+ * Each output frame costs two SRC_TAPS-tap dot products per channel,
+ * computed with scalar 32x32->64-bit multiply-accumulates. There is no PIE
+ * kernel: the vector multipliers take at most 16-bit operands, and rounding
+ * the taps to 16 bits would give up the stopband the Q30 coefficients are
+ * designed for.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#include "config/audio_config.h"
+
+#define SRC_TAPS 32
+#define SRC_PHASES 64
+#define SRC_MAX_BLOCK_FRAMES AUDIO_DMA_FRAME_NUM // One DMA block
+
+/* Worst-case number of output frames for one input block, for output/input ratios up to 2.5 */
+#define SRC_MAX_OUT_FRAMES(in_frames) ((in_frames) * 5 / 2 + 2)
+
+typedef struct {
+    uint32_t step; // Input frames per output frame, 8.24 fixed point
+    uint32_t nominal_step;
+    uint64_t pos; // Next output position in the working buffer, 40.24 fixed point
+    int32_t coef[SRC_PHASES + 1][SRC_TAPS]; // Q30
+    int32_t work[NUM_CHANNELS][SRC_TAPS + SRC_MAX_BLOCK_FRAMES]; // History followed by the current block
+} src_t;
+
+/**
+ * @brief Compute the filter for a conversion ratio and clear the history
+ *
+ * @param in_rate input sample rate in Hz
+ * @param out_rate output sample rate in Hz
+ * @return ESP_OK, or ESP_ERR_INVALID_ARG if the ratio is out of range
+ */
+esp_err_t src_init(src_t* src, uint32_t in_rate, uint32_t out_rate);
+
+/**
+ * @brief Adjust the ratio by a small amount without recomputing the filter
+ *
+ * Must be called from the context that runs src_process().
+ *
+ * @param ppb output rate deviation in parts per billion, positive produces more output frames
+ */
+void src_set_trim_ppb(src_t* src, int32_t ppb);
+
+/**
+ * @brief Resample one block of interleaved frames
+ *
+ * @param in input frames, at most SRC_MAX_BLOCK_FRAMES
+ * @param in_frames number of input frames
+ * @param out output buffer for at least SRC_MAX_OUT_FRAMES(in_frames) frames
+ * @return number of output frames
+ */
+size_t src_process(src_t* src, const int32_t* in, size_t in_frames, int32_t* out);
@@ -0,0 +1,217 @@
+/**
+ * @file tap_codec.c
+ * @author your name (you@domain.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include "tap_codec.h"
+
+#include <stdbool.h>
+
+typedef struct {
+    uint8_t* out;
+    uint64_t acc;
+    int bits; // Bits pending in acc
+} bit_writer_t;
+
+static void put_bits(bit_writer_t* bw, uint32_t value, int n)
+{
+    if (n == 0) {
+        return;
+    }
+    if (n < 32) {
+        value &= (1u << n) - 1;
+    }
+    bw->acc = (bw->acc << n) | value;
+    bw->bits += n;
+    while (bw->bits >= 8) {
+        bw->bits -= 8;
+        *bw->out++ = (uint8_t)(bw->acc >> bw->bits);
+    }
+}
+
+static void put_ones(bit_writer_t* bw, int n)
+{
+    while (n >= 16) {
+        put_bits(bw, 0xFFFF, 16);
+        n -= 16;
+    }
+    put_bits(bw, (1u << n) - 1, n);
+}
+
+static void flush_bits(bit_writer_t* bw)
+{
+    if (bw->bits) {
+        put_bits(bw, 0, 8 - bw->bits);
+    }
+}
+
+static inline int64_t predict(const int32_t* x, size_t i, size_t stride, int order)
+{
+    int64_t a = order > 0 ? x[(i - 1) * stride] : 0;
+    int64_t b = order > 1 ? x[(i - 2) * stride] : 0;
+    int64_t c = order > 2 ? x[(i - 3) * stride] : 0;
+    int64_t d = order > 3 ? x[(i - 4) * stride] : 0;
+
+    switch (order) {
+    case 1:
+        return a;
+    case 2:
+        return 2 * a - b;
+    case 3:
+        return 3 * a - 3 * b + c;
+    case 4:
+        return 4 * a - 6 * b + 4 * c - d;
+    default:
+        return 0;
+    }
+}
+
+static inline uint64_t zigzag(int64_t r)
+{
+    return r >= 0 ? (uint64_t)r << 1 : ((uint64_t)(-(r + 1)) << 1) | 1;
+}
+
+static inline uint32_t rice_bits(uint32_t u, int k)
+{
+    uint32_t q = u >> k;
+    return q < TAP_CODEC_RICE_ESCAPE ? q + 1 + k : TAP_CODEC_RICE_ESCAPE + 32;
+}
+
+/**
+ * @brief Residuals of a channel, shifted right by shift, for the given order
+ *
+ * @return false if a residual does not fit the 32-bit escape code
+ */
+static bool residuals(const int32_t* x, size_t frames, size_t stride, int shift, int order, uint32_t* u)
+{
+    static int32_t shifted[TAP_CODEC_MAX_FRAMES];
+
+    for (size_t i = 0; i < frames; i++) {
+        shifted[i] = x[i * stride] >> shift;
+    }
+    for (size_t i = order; i < frames; i++) {
+        uint64_t z = zigzag((int64_t)shifted[i] - predict(shifted, i, 1, order));
+        if (z > UINT32_MAX) {
+            return false;
+        }
+        u[i] = (uint32_t)z;
+    }
+    return true;
+}
+
+static int best_rice_k(const uint32_t* u, size_t from, size_t to, uint32_t* cost)
+{
+    uint64_t sum = 0;
+    for (size_t i = from; i < to; i++) {
+        sum += u[i];
+    }
+
+    /* k close to log2 of the mean residual, then refine by one step either way */
+    uint64_t mean = to > from ? sum / (to - from) : 0;
+    int k = 0;
+    while (k < 30 && (mean >> (k + 1)) > 0) {
+        k++;
+    }
+
+    int best_k = k;
+    *cost = UINT32_MAX;
+    for (int kk = k > 0 ? k - 1 : 0; kk <= k + 1 && kk <= 31; kk++) {
+        uint32_t bits = 0;
+        for (size_t i = from; i < to; i++) {
+            bits += rice_bits(u[i], kk);
+        }
+        if (bits < *cost) {
+            *cost = bits;
+            best_k = kk;
+        }
+    }
+    return best_k;
+}
+
+static void encode_channel(bit_writer_t* bw, const int32_t* x, size_t frames, size_t stride)
+{
+    static uint32_t u[TAP_CODEC_MAX_FRAMES];
+
+    uint32_t any = 0;
+    for (size_t i = 0; i < frames; i++) {
+        any |= (uint32_t)x[i * stride];
+    }
+    int shift = 0;
+    while (any && !(any & (1u << shift))) {
+        shift++;
+    }
+    const int width = 32 - shift;
+
+    uint32_t best_cost = width * frames;
+    int best_order = TAP_CODEC_ORDER_VERBATIM;
+    int best_k = 0;
+    for (int order = 0; order <= TAP_CODEC_MAX_ORDER && (size_t)order < frames; order++) {
+        if (!residuals(x, frames, stride, shift, order, u)) {
+            continue;
+        }
+        uint32_t cost;
+        int k = best_rice_k(u, order, frames, &cost);
+        cost += order * width + 5;
+        if (cost < best_cost) {
+            best_cost = cost;
+            best_order = order;
+            best_k = k;
+        }
+    }
+
+    put_bits(bw, best_order, 3);
+    put_bits(bw, shift, 5);
+
+    if (best_order == TAP_CODEC_ORDER_VERBATIM) {
+        for (size_t i = 0; i < frames; i++) {
+            put_bits(bw, (uint32_t)(x[i * stride] >> shift), width);
+        }
+        return;
+    }
+
+    residuals(x, frames, stride, shift, best_order, u);
+    for (int i = 0; i < best_order; i++) {
+        put_bits(bw, (uint32_t)(x[i * stride] >> shift), width);
+    }
+    put_bits(bw, best_k, 5);
+    for (size_t i = best_order; i < frames; i++) {
+        uint32_t q = u[i] >> best_k;
+        if (q < TAP_CODEC_RICE_ESCAPE) {
+            put_ones(bw, q);
+            put_bits(bw, 0, 1);
+            put_bits(bw, u[i], best_k);
+        } else {
+            put_ones(bw, TAP_CODEC_RICE_ESCAPE);
+            put_bits(bw, u[i], 32);
+        }
+    }
+}
+
+size_t tap_codec_encode(const int32_t* samples, size_t frames, size_t channels, uint32_t frame_index, uint8_t* out)
+{
+    if (frames == 0 || frames > TAP_CODEC_MAX_FRAMES || channels == 0 || channels > TAP_CODEC_MAX_CHANNELS) {
+        return 0;
+    }
+
+    out[0] = frame_index & 0xFF;
+    out[1] = (frame_index >> 8) & 0xFF;
+    out[2] = (frame_index >> 16) & 0xFF;
+    out[3] = frame_index >> 24;
+    out[4] = frames & 0xFF;
+    out[5] = frames >> 8;
+    out[6] = channels;
+    out[7] = 0;
+
+    bit_writer_t bw = { .out = out + TAP_CODEC_HEADER_SIZE };
+    for (size_t ch = 0; ch < channels; ch++) {
+        encode_channel(&bw, samples + ch, frames, channels);
+    }
+    flush_bits(&bw);
+
+    return bw.out - out;
+}
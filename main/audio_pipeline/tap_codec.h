@@ -0,0 +1,60 @@
+/**
+ * @file tap_codec.h
+ * @author your name (you@domain.com)
+ * @brief Lossless block codec for the raw capture tap
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * FLAC-style fixed polynomial predictors with Rice coded residuals. A block
+ * holds up to TAP_CODEC_MAX_FRAMES interleaved frames and encodes to:
+ *
+ *   | frame index (4, LE) | frames (2, LE) | channels (1) | reserved (1) | subframes |
+ *
+ * followed by one bit-packed subframe per channel, MSB first, with the last
+ * byte zero padded. A subframe starts with:
+ *
+ *   order (3): 0..4 fixed predictor order, 7 verbatim
+ *   shift (5): zero LSBs common to all samples of the channel, removed before coding
+ *
+ * Samples below are the channel samples arithmetically shifted right by
+ * shift, stored as (32 - shift) bit two's complement when written raw.
+ *
+ *   verbatim: frames raw samples
+ *   order n:  n raw warm-up samples, rice k (5), then frames - n residuals
+ *
+ * A residual r = x[i] - prediction is zigzag mapped, u = r >= 0 ? 2r : -2r - 1,
+ * and written as q = u >> k ones followed by a zero and the k low bits of u.
+ * A quotient of TAP_CODEC_RICE_ESCAPE or more is written as TAP_CODEC_RICE_ESCAPE
+ * ones followed by u as 32 raw bits. Predictions of order 1..4 are
+ * x[i-1], 2x[i-1] - x[i-2], 3x[i-1] - 3x[i-2] + x[i-3] and
+ * 4x[i-1] - 6x[i-2] + 4x[i-3] - x[i-4], computed with 64-bit arithmetic.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define TAP_CODEC_MAX_FRAMES 64
+#define TAP_CODEC_MAX_CHANNELS 8
+#define TAP_CODEC_HEADER_SIZE 8
+#define TAP_CODEC_MAX_ORDER 4
+#define TAP_CODEC_ORDER_VERBATIM 7
+#define TAP_CODEC_RICE_ESCAPE 24
+
+/* Verbatim is chosen whenever it is smaller, which bounds the encoded size */
+#define TAP_CODEC_MAX_BLOCK_SIZE(frames, channels) \
+    (TAP_CODEC_HEADER_SIZE + ((8 + 32 * (frames)) * (channels) + 7) / 8)
+
+/**
+ * @brief Encode one block of interleaved samples
+ *
+ * @param samples interleaved samples, frames * channels words
+ * @param frames number of frames, at most TAP_CODEC_MAX_FRAMES
+ * @param channels number of channels, at most TAP_CODEC_MAX_CHANNELS
+ * @param frame_index stream position of the first frame, lets the host detect gaps
+ * @param out destination, at least TAP_CODEC_MAX_BLOCK_SIZE(frames, channels) bytes
+ * @return encoded size in bytes, or 0 on invalid arguments
+ */
+size_t tap_codec_encode(const int32_t* samples, size_t frames, size_t channels, uint32_t frame_index, uint8_t* out);
@@ -0,0 +1,506 @@
+/**
+ * @file telemetry.c
+ * @author your name (you@domain.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include "telemetry.h"
+
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <stdio.h>
+
+#include "audio_pipeline.h"
+#include "esp_log.h"
+#include "level_meter.h"
+#include "sdkconfig.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#ifndef CONFIG_AUDIO_TELEMETRY_REPORT_INTERVAL_MS
+#define CONFIG_AUDIO_TELEMETRY_REPORT_INTERVAL_MS 1000
+#endif
+
+#define EMA_SHIFT 6
+#define FILL_WINDOW_PACKETS 1000 // 1 s of packets
+
+static const char* TAG = "telemetry";
+
+typedef struct {
+    atomic_uint seq; // Odd while an update is in progress
+    atomic_uint blocks;
+    atomic_uint overruns;
+    atomic_uint overrun_bytes;
+    atomic_uint isr_cycles_max;
+    atomic_uint isr_cycles_avg_q8;
+    atomic_uint port_locks;
+    atomic_uint port_slips;
+    atomic_uint port_skew;
+    atomic_uint gaps;
+    atomic_uint gap_frames;
+    atomic_uint gap_position;
+    atomic_uint gaps_unconcealed;
+} producer_stats_t;
+
+typedef struct {
+    atomic_uint seq; // Odd while an update is in progress
+    atomic_uint packets;
+    atomic_uint short_reads;
+    atomic_uint underruns;
+    atomic_uint underrun_bytes;
+    atomic_uint fill_last;
+    atomic_uint fill_min;
+    atomic_uint fill_max;
+    atomic_uint fill_avg_q8;
+    atomic_uint fill_window_min;
+    atomic_uint fill_window_max;
+    atomic_uint fill_histogram[TELEMETRY_FILL_BINS];
+    atomic_uint usb_cycles_max;
+    atomic_uint usb_cycles_avg_q8;
+    atomic_uint playback_overruns;
+    atomic_uint playback_overrun_bytes;
+    atomic_uint recoveries;
+    atomic_uint recovery_skipped_frames;
+    atomic_uint recovery_position;
+    atomic_uint resyncs;
+    atomic_uint latency_last_us;
+    atomic_uint latency_min_us;
+    atomic_uint latency_max_us;
+    atomic_uint latency_avg_q8;
+    atomic_uint latency_histogram[TELEMETRY_LATENCY_BINS];
+    atomic_uint impulses;
+    atomic_uint impulse_latency_us;
+    atomic_uint impulse_estimate_us;
+    /* Private to the consumer, not part of the snapshot */
+    uint32_t window_min;
+    uint32_t window_max;
+    uint32_t window_count;
+    bool latency_seeded; // The moving average has its first value
+} consumer_stats_t;
+
+typedef struct {
+    atomic_uint seq; // Odd while an update is in progress
+    atomic_uint blocks;
+    atomic_uint concealed;
+    atomic_uint underruns;
+} playback_stats_t;
+
+static producer_stats_t producer = { 0 };
+static consumer_stats_t consumer = { .window_min = UINT32_MAX };
+static playback_stats_t playback = { 0 };
+/* Bumped from the I2S interrupt, which may preempt the producer mid-update, so it lives outside the seqlock */
+static atomic_uint dma_overflows = 0;
+static size_t ring_capacity = 1;
+
+#define LOAD(field) atomic_load_explicit(&(field), memory_order_relaxed)
+#define STORE(field, value) atomic_store_explicit(&(field), (value), memory_order_relaxed)
+#define INC(field, value) STORE(field, LOAD(field) + (value)) // Single writer, no RMW needed
+
+static inline void write_begin(atomic_uint* seq)
+{
+    STORE(*seq, LOAD(*seq) + 1);
+    atomic_thread_fence(memory_order_release);
+}
+
+static inline void write_end(atomic_uint* seq)
+{
+    atomic_thread_fence(memory_order_release);
+    STORE(*seq, LOAD(*seq) + 1);
+}
+
+static inline void update_max(atomic_uint* max, uint32_t value)
+{
+    if (value > LOAD(*max)) {
+        STORE(*max, value);
+    }
+}
+
+static inline void update_ema(atomic_uint* avg_q8, uint32_t value)
+{
+    int32_t avg = (int32_t)LOAD(*avg_q8);
+    STORE(*avg_q8, (uint32_t)(avg + (((int32_t)(value << 8) - avg) >> EMA_SHIFT)));
+}
+
+void telemetry_init(size_t capacity)
+{
+    ring_capacity = capacity;
+    STORE(consumer.fill_min, UINT32_MAX);
+    STORE(consumer.latency_min_us, UINT32_MAX);
+}
+
+void telemetry_record_block(uint32_t cycles)
+{
+    write_begin(&producer.seq);
+    INC(producer.blocks, 1);
+    update_max(&producer.isr_cycles_max, cycles);
+    update_ema(&producer.isr_cycles_avg_q8, cycles);
+    write_end(&producer.seq);
+}
+
+void telemetry_record_dma_overflow(void)
+{
+    atomic_fetch_add_explicit(&dma_overflows, 1, memory_order_relaxed);
+}
+
+void telemetry_record_port_lock(int32_t skew_frames)
+{
+    write_begin(&producer.seq);
+    INC(producer.port_locks, 1);
+    STORE(producer.port_skew, (uint32_t)skew_frames);
+    write_end(&producer.seq);
+}
+
+void telemetry_record_port_slip(void)
+{
+    write_begin(&producer.seq);
+    INC(producer.port_slips, 1);
+    write_end(&producer.seq);
+}
+
+void telemetry_record_gap(uint32_t position, uint32_t frames, bool concealed)
+{
+    write_begin(&producer.seq);
+    if (concealed) {
+        INC(producer.gaps, 1);
+        INC(producer.gap_frames, frames);
+    } else {
+        INC(producer.gaps_unconcealed, 1);
+    }
+    STORE(producer.gap_position, position);
+    write_end(&producer.seq);
+}
+
+void telemetry_record_overrun(size_t bytes_dropped)
+{
+    write_begin(&producer.seq);
+    INC(producer.overruns, 1);
+    INC(producer.overrun_bytes, bytes_dropped);
+    write_end(&producer.seq);
+}
+
+void telemetry_record_underrun(size_t bytes_missing)
+{
+    write_begin(&consumer.seq);
+    INC(consumer.underruns, 1);
+    INC(consumer.underrun_bytes, bytes_missing);
+    write_end(&consumer.seq);
+}
+
+void telemetry_record_recovery(uint32_t position, uint32_t skipped_frames)
+{
+    write_begin(&consumer.seq);
+    INC(consumer.recoveries, 1);
+    INC(consumer.recovery_skipped_frames, skipped_frames);
+    STORE(consumer.recovery_position, position);
+    write_end(&consumer.seq);
+}
+
+void telemetry_record_resync(void)
+{
+    write_begin(&consumer.seq);
+    INC(consumer.resyncs, 1);
+    write_end(&consumer.seq);
+}
+
+void telemetry_record_latency(uint32_t latency_us)
+{
+    uint32_t bin = latency_us / TELEMETRY_LATENCY_BIN_US;
+    if (bin >= TELEMETRY_LATENCY_BINS) {
+        bin = TELEMETRY_LATENCY_BINS - 1;
+    }
+
+    write_begin(&consumer.seq);
+    STORE(consumer.latency_last_us, latency_us);
+    if (latency_us < LOAD(consumer.latency_min_us)) {
+        STORE(consumer.latency_min_us, latency_us);
+    }
+    update_max(&consumer.latency_max_us, latency_us);
+    if (consumer.latency_seeded) {
+        update_ema(&consumer.latency_avg_q8, latency_us);
+    } else {
+        STORE(consumer.latency_avg_q8, latency_us << 8);
+        consumer.latency_seeded = true;
+    }
+    INC(consumer.latency_histogram[bin], 1);
+    write_end(&consumer.seq);
+}
+
+void telemetry_reset_latency(void)
+{
+    write_begin(&consumer.seq);
+    STORE(consumer.latency_min_us, UINT32_MAX);
+    STORE(consumer.latency_max_us, 0);
+    STORE(consumer.latency_avg_q8, 0);
+    for (int i = 0; i < TELEMETRY_LATENCY_BINS; i++) {
+        STORE(consumer.latency_histogram[i], 0);
+    }
+    consumer.latency_seeded = false;
+    write_end(&consumer.seq);
+}
+
+void telemetry_record_impulse(int32_t measured_us, int32_t estimate_us)
+{
+    write_begin(&consumer.seq);
+    INC(consumer.impulses, 1);
+    STORE(consumer.impulse_latency_us, (uint32_t)measured_us);
+    STORE(consumer.impulse_estimate_us, (uint32_t)estimate_us);
+    write_end(&consumer.seq);
+}
+
+void telemetry_record_packet(size_t fill, bool short_read, uint32_t cycles)
+{
+    size_t bin = fill * TELEMETRY_FILL_BINS / ring_capacity;
+    if (bin >= TELEMETRY_FILL_BINS) {
+        bin = TELEMETRY_FILL_BINS - 1;
+    }
+
+    if (fill < consumer.window_min) {
+        consumer.window_min = fill;
+    }
+    if (fill > consumer.window_max) {
+        consumer.window_max = fill;
+    }
+
+    write_begin(&consumer.seq);
+    INC(consumer.packets, 1);
+    if (short_read) {
+        INC(consumer.short_reads, 1);
+    }
+    STORE(consumer.fill_last, fill);
+    if (fill < LOAD(consumer.fill_min)) {
+        STORE(consumer.fill_min, fill);
+    }
+    update_max(&consumer.fill_max, fill);
+    update_ema(&consumer.fill_avg_q8, fill);
+    INC(consumer.fill_histogram[bin], 1);
+    update_max(&consumer.usb_cycles_max, cycles);
+    update_ema(&consumer.usb_cycles_avg_q8, cycles);
+    if (++consumer.window_count == FILL_WINDOW_PACKETS) {
+        STORE(consumer.fill_window_min, consumer.window_min);
+        STORE(consumer.fill_window_max, consumer.window_max);
+        consumer.window_min = UINT32_MAX;
+        consumer.window_max = 0;
+        consumer.window_count = 0;
+    }
+    write_end(&consumer.seq);
+}
+
+void telemetry_record_playback_block(bool concealed)
+{
+    write_begin(&playback.seq);
+    INC(playback.blocks, 1);
+    if (concealed) {
+        INC(playback.concealed, 1);
+    }
+    write_end(&playback.seq);
+}
+
+void telemetry_record_playback_underrun(void)
+{
+    write_begin(&playback.seq);
+    INC(playback.underruns, 1);
+    write_end(&playback.seq);
+}
+
+void telemetry_record_playback_overrun(size_t bytes_dropped)
+{
+    write_begin(&consumer.seq);
+    INC(consumer.playback_overruns, 1);
+    INC(consumer.playback_overrun_bytes, bytes_dropped);
+    write_end(&consumer.seq);
+}
+
+static inline uint32_t read_begin(atomic_uint* seq)
+{
+    uint32_t s;
+    while ((s = atomic_load_explicit(seq, memory_order_acquire)) & 1) { }
+    return s;
+}
+
+static inline bool read_retry(atomic_uint* seq, uint32_t s)
+{
+    atomic_thread_fence(memory_order_acquire);
+    return LOAD(*seq) != s;
+}
+
+void telemetry_get_snapshot(telemetry_snapshot_t* snapshot)
+{
+    uint32_t s;
+
+    do {
+        s = read_begin(&producer.seq);
+        snapshot->blocks = LOAD(producer.blocks);
+        snapshot->overruns = LOAD(producer.overruns);
+        snapshot->overrun_bytes = LOAD(producer.overrun_bytes);
+        snapshot->isr_cycles_max = LOAD(producer.isr_cycles_max);
+        snapshot->isr_cycles_avg = LOAD(producer.isr_cycles_avg_q8) >> 8;
+        snapshot->port_locks = LOAD(producer.port_locks);
+        snapshot->port_slips = LOAD(producer.port_slips);
+        snapshot->port_skew = (int32_t)LOAD(producer.port_skew);
+        snapshot->gaps = LOAD(producer.gaps);
+        snapshot->gap_frames = LOAD(producer.gap_frames);
+        snapshot->gap_position = LOAD(producer.gap_position);
+        snapshot->gaps_unconcealed = LOAD(producer.gaps_unconcealed);
+    } while (read_retry(&producer.seq, s));
+    snapshot->dma_overflows = LOAD(dma_overflows);
+
+    do {
+        s = read_begin(&consumer.seq);
+        snapshot->packets = LOAD(consumer.packets);
+        snapshot->short_reads = LOAD(consumer.short_reads);
+        snapshot->underruns = LOAD(consumer.underruns);
+        snapshot->underrun_bytes = LOAD(consumer.underrun_bytes);
+        snapshot->fill_last = LOAD(consumer.fill_last);
+        snapshot->fill_min = LOAD(consumer.fill_min);
+        snapshot->fill_max = LOAD(consumer.fill_max);
+        snapshot->fill_avg = LOAD(consumer.fill_avg_q8) >> 8;
+        snapshot->fill_window_min = LOAD(consumer.fill_window_min);
+        snapshot->fill_window_max = LOAD(consumer.fill_window_max);
+        for (int i = 0; i < TELEMETRY_FILL_BINS; i++) {
+            snapshot->fill_histogram[i] = LOAD(consumer.fill_histogram[i]);
+        }
+        snapshot->usb_cycles_max = LOAD(consumer.usb_cycles_max);
+        snapshot->usb_cycles_avg = LOAD(consumer.usb_cycles_avg_q8) >> 8;
+        snapshot->playback_overruns = LOAD(consumer.playback_overruns);
+        snapshot->playback_overrun_bytes = LOAD(consumer.playback_overrun_bytes);
+        snapshot->recoveries = LOAD(consumer.recoveries);
+        snapshot->recovery_skipped_frames = LOAD(consumer.recovery_skipped_frames);
+        snapshot->recovery_position = LOAD(consumer.recovery_position);
+        snapshot->resyncs = LOAD(consumer.resyncs);
+        snapshot->latency_last_us = LOAD(consumer.latency_last_us);
+        snapshot->latency_min_us = LOAD(consumer.latency_min_us);
+        snapshot->latency_max_us = LOAD(consumer.latency_max_us);
+        snapshot->latency_avg_us = LOAD(consumer.latency_avg_q8) >> 8;
+        for (int i = 0; i < TELEMETRY_LATENCY_BINS; i++) {
+            snapshot->latency_histogram[i] = LOAD(consumer.latency_histogram[i]);
+        }
+        snapshot->impulses = LOAD(consumer.impulses);
+        snapshot->impulse_latency_us = (int32_t)LOAD(consumer.impulse_latency_us);
+        snapshot->impulse_estimate_us = (int32_t)LOAD(consumer.impulse_estimate_us);
+    } while (read_retry(&consumer.seq, s));
+
+    do {
+        s = read_begin(&playback.seq);
+        snapshot->playback_blocks = LOAD(playback.blocks);
+        snapshot->playback_concealed = LOAD(playback.concealed);
+        snapshot->playback_underruns = LOAD(playback.underruns);
+    } while (read_retry(&playback.seq, s));
+
+    if (snapshot->fill_min == UINT32_MAX) {
+        snapshot->fill_min = 0;
+    }
+    if (snapshot->latency_min_us == UINT32_MAX) {
+        snapshot->latency_min_us = 0;
+    }
+}
+
+/**
+ * @brief Upper edge of the latency bin holding the given fraction of packets
+ *
+ * @param permille fraction in 1/1000
+ * @return latency in us, 0 if nothing was recorded
+ */
+static uint32_t latency_percentile_us(const telemetry_snapshot_t* snapshot, uint32_t permille)
+{
+    uint64_t total = 0;
+    for (int i = 0; i < TELEMETRY_LATENCY_BINS; i++) {
+        total += snapshot->latency_histogram[i];
+    }
+    if (total == 0) {
+        return 0;
+    }
+
+    uint64_t target = (total * permille + 999) / 1000;
+    uint64_t count = 0;
+    for (int i = 0; i < TELEMETRY_LATENCY_BINS - 1; i++) {
+        count += snapshot->latency_histogram[i];
+        if (count >= target) {
+            return (i + 1) * TELEMETRY_LATENCY_BIN_US;
+        }
+    }
+    return snapshot->latency_max_us;
+}
+
+void telemetry_report_task(void* pvParam)
+{
+    TickType_t last_wake = xTaskGetTickCount();
+    static telemetry_snapshot_t snapshot;
+    uint32_t gaps = 0;
+    uint32_t recoveries = 0;
+    uint32_t impulses = 0;
+
+    while (1) {
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(CONFIG_AUDIO_TELEMETRY_REPORT_INTERVAL_MS));
+
+        telemetry_get_snapshot(&snapshot);
+
+        ESP_LOGI(TAG, "fill %" PRIu32 " [%" PRIu32 "..%" PRIu32 "] avg %" PRIu32 " B | dma ovf %" PRIu32 " | overruns %" PRIu32 " (%" PRIu32 " B) | underruns %" PRIu32 " (%" PRIu32 " B) | short %" PRIu32 "/%" PRIu32,
+            snapshot.fill_last, snapshot.fill_window_min, snapshot.fill_window_max, snapshot.fill_avg,
+            snapshot.dma_overflows,
+            snapshot.overruns, snapshot.overrun_bytes,
+            snapshot.underruns, snapshot.underrun_bytes,
+            snapshot.short_reads, snapshot.packets);
+        ESP_LOGI(TAG, "isr %" PRIu32 "/%" PRIu32 " cyc | usb %" PRIu32 "/%" PRIu32 " cyc (avg/max)",
+            snapshot.isr_cycles_avg, snapshot.isr_cycles_max,
+            snapshot.usb_cycles_avg, snapshot.usb_cycles_max);
+
+        ESP_LOGI(TAG, "latency %" PRIu32 " us | min %" PRIu32 " p50 <%" PRIu32 " p99 <%" PRIu32 " max %" PRIu32 " avg %" PRIu32 " us",
+            snapshot.latency_last_us, snapshot.latency_min_us,
+            latency_percentile_us(&snapshot, 500), latency_percentile_us(&snapshot, 990),
+            snapshot.latency_max_us, snapshot.latency_avg_us);
+        if (snapshot.impulses != impulses) {
+            impulses = snapshot.impulses;
+            ESP_LOGI(TAG, "impulse arrived after %" PRId32 " us, stamps estimate %" PRId32 " us (%" PRIu32 " impulses)",
+                snapshot.impulse_latency_us, snapshot.impulse_estimate_us, snapshot.impulses);
+        }
+
+        char histogram[TELEMETRY_FILL_BINS * 11 + 1];
+        size_t len = 0;
+        for (int i = 0; i < TELEMETRY_FILL_BINS; i++) {
+            len += snprintf(histogram + len, sizeof(histogram) - len, " %" PRIu32, snapshot.fill_histogram[i]);
+        }
+        ESP_LOGI(TAG, "fill histogram:%s", histogram);
+
+        /* Splices are rare, report the position of the latest one whenever there were new ones */
+        if (snapshot.gaps + snapshot.gaps_unconcealed != gaps) {
+            gaps = snapshot.gaps + snapshot.gaps_unconcealed;
+            ESP_LOGW(TAG, "capture gap at frame %" PRIu32 " | %" PRIu32 " gaps, %" PRIu32 " frames concealed, %" PRIu32 " too long",
+                snapshot.gap_position, snapshot.gaps, snapshot.gap_frames, snapshot.gaps_unconcealed);
+        }
+        if (snapshot.recoveries + snapshot.resyncs != recoveries) {
+            recoveries = snapshot.recoveries + snapshot.resyncs;
+            ESP_LOGW(TAG, "underrun recovered at usb frame %" PRIu32 " | %" PRIu32 " recoveries, %" PRIu32 " frames skipped, %" PRIu32 " resyncs",
+                snapshot.recovery_position, snapshot.recoveries, snapshot.recovery_skipped_frames, snapshot.resyncs);
+        }
+
+#if CONFIG_AUDIO_I2S_DUAL
+        ESP_LOGI(TAG, "i2s ports: %" PRIu32 " locks, %" PRIu32 " slips, skew %" PRId32 " frames",
+            snapshot.port_locks, snapshot.port_slips, snapshot.port_skew);
+#endif
+
+#if CONFIG_AUDIO_PLAYBACK
+        ESP_LOGI(TAG, "playback: %" PRIu32 " blocks, %" PRIu32 " concealed | underruns %" PRIu32 " | overruns %" PRIu32 " (%" PRIu32 " B)",
+            snapshot.playback_blocks, snapshot.playback_concealed, snapshot.playback_underruns,
+            snapshot.playback_overruns, snapshot.playback_overrun_bytes);
+#endif
+
+#if CONFIG_AUDIO_LEVEL_METER
+        static level_meter_reading_t levels;
+        level_meter_get(&levels);
+        for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+            const level_meter_channel_t* l = &levels.channel[ch];
+            ESP_LOGI(TAG, "ch%d peak %.1f rms %.1f dBFS, %" PRIu32 " clipped", ch,
+                level_meter_to_dbfs_x10(l->peak_hold) / 10.0f, level_meter_to_dbfs_x10(l->rms) / 10.0f, l->clips);
+        }
+#endif
+
+#if CONFIG_AUDIO_DSP_CHAIN
+        audio_pipeline_log_dsp_stats();
+#endif
+    }
+}
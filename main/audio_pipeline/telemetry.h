@@ -0,0 +1,214 @@
+/**
+ * @file telemetry.h
+ * @author your name (you@domain.com)
+ * @brief Always-on statistics for the I2S -> ring -> USB path
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * Counters are split into a producer block, written only by the audio
+ * source, and a consumer block, written only from the USB callbacks.
+ * Each block has its own sequence counter, so both writers update with
+ * relaxed atomics and never wait, and a reader can take a consistent
+ * snapshot of each block by retrying when a write overlapped the copy.
+ * Playback has a third block, written only by the I2S TX interrupt.
+ * DMA overflows are reported from the I2S RX interrupt, which can preempt
+ * the producer, so they are a plain atomic counter outside the blocks.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define TELEMETRY_FILL_BINS 16 // Fill-level histogram bins, each 1/16 of the ring capacity
+#define TELEMETRY_LATENCY_BINS 32 // Latency histogram bins
+#define TELEMETRY_LATENCY_BIN_US 5000 // Width of one latency bin, the last one also counts everything above
+
+typedef struct {
+    /* Producer (audio source) */
+    uint32_t blocks; // DMA blocks received
+    uint32_t dma_overflows; // DMA buffers the process task fell too far behind to pick up
+    uint32_t overruns; // Blocks that did not fit in the ring
+    uint32_t overrun_bytes;
+    uint32_t isr_cycles_max;
+    uint32_t isr_cycles_avg; // Exponential moving average
+
+    /* Consumer (USB callbacks) */
+    uint32_t packets; // USB packets sent
+    uint32_t short_reads; // Packets padded with silence
+    uint32_t underruns; // Transitions from running back to buffering
+    uint32_t underrun_bytes;
+    uint32_t fill_last; // Ring fill level in bytes
+    uint32_t fill_min;
+    uint32_t fill_max;
+    uint32_t fill_avg; // Exponential moving average
+    uint32_t fill_window_min; // Range over the last completed 1 s window
+    uint32_t fill_window_max;
+    uint32_t fill_histogram[TELEMETRY_FILL_BINS]; // Packets per fill level bin
+    uint32_t usb_cycles_max;
+    uint32_t usb_cycles_avg; // Exponential moving average
+
+    /* Producer, dual I2S port alignment. Last so the CDC telemetry layout stays compatible. */
+    uint32_t port_locks; // Times the two ports were aligned
+    uint32_t port_slips; // Alignment losses, a block dropped on one port or the ports drifting apart
+    int32_t port_skew; // Frames port 0 was ahead of port 1 at the last alignment
+
+    /* Playback, USB OUT -> I2S TX */
+    uint32_t playback_blocks; // TX blocks filled while playing
+    uint32_t playback_concealed; // TX blocks filled by concealment
+    uint32_t playback_underruns; // Transitions from running back to prebuffering
+    uint32_t playback_overruns; // OUT packets dropped for lack of ring space (USB callbacks)
+    uint32_t playback_overrun_bytes;
+
+    /* Splices that keep later audio time-aligned after a hiccup */
+    uint32_t gaps; // Capture gaps filled with concealment (producer)
+    uint32_t gap_frames;
+    uint32_t gap_position; // Capture frame the last gap started at
+    uint32_t gaps_unconcealed; // Gaps too long to fill, the stream shifted
+    uint32_t recoveries; // Underruns recovered by skipping the frames sent as silence (consumer)
+    uint32_t recovery_skipped_frames;
+    uint32_t recovery_position; // USB frame the last recovery resumed at
+    uint32_t resyncs; // Underruns too long to recover, prebuffered again
+
+    /* Capture-to-wire latency of the packets sent while streaming (consumer), since the last profile change */
+    uint32_t latency_last_us;
+    uint32_t latency_min_us;
+    uint32_t latency_max_us;
+    uint32_t latency_avg_us; // Exponential moving average
+    uint32_t latency_histogram[TELEMETRY_LATENCY_BINS]; // Packets per TELEMETRY_LATENCY_BIN_US
+    uint32_t impulses; // Calibration impulses found in the stream
+    int32_t impulse_latency_us; // Measured arrival of the last impulse
+    int32_t impulse_estimate_us; // Latency the stamps gave for the same packet, -1 if none
+} telemetry_snapshot_t;
+
+/**
+ * @brief Set the ring capacity the fill-level histogram is scaled to
+ *
+ */
+void telemetry_init(size_t ring_capacity);
+
+/**
+ * @brief Producer: record one processed DMA block
+ *
+ * @param cycles CPU cycles spent in the I2S receive callback
+ */
+void telemetry_record_block(uint32_t cycles);
+
+/**
+ * @brief Record a DMA buffer lost before processing picked it up, from any context
+ *
+ */
+void telemetry_record_dma_overflow(void);
+
+/**
+ * @brief Producer: record that the two I2S ports were aligned
+ *
+ * @param skew_frames frames port 0 was ahead of port 1, negative if behind
+ */
+void telemetry_record_port_lock(int32_t skew_frames);
+
+/**
+ * @brief Producer: record that the two I2S ports lost alignment
+ *
+ */
+void telemetry_record_port_slip(void);
+
+/**
+ * @brief Producer: record frames the source lost
+ *
+ * @param position capture frame the gap starts at
+ * @param frames number of frames lost
+ * @param concealed false if the gap was too long to fill
+ */
+void telemetry_record_gap(uint32_t position, uint32_t frames, bool concealed);
+
+/**
+ * @brief Producer: record a block that did not fit in the audio ring
+ *
+ * @param bytes_dropped number of bytes that were not written
+ */
+void telemetry_record_overrun(size_t bytes_dropped);
+
+/**
+ * @brief Consumer: record the ring running dry while streaming
+ *
+ * @param bytes_missing number of bytes short of a full packet
+ */
+void telemetry_record_underrun(size_t bytes_missing);
+
+/**
+ * @brief Consumer: record streaming resuming after an underrun
+ *
+ * @param position USB frame streaming resumed at
+ * @param skipped_frames frames dropped from the ring to stay time-aligned
+ */
+void telemetry_record_recovery(uint32_t position, uint32_t skipped_frames);
+
+/**
+ * @brief Consumer: record an underrun that lasted too long to recover from
+ *
+ */
+void telemetry_record_resync(void);
+
+/**
+ * @brief Consumer: record the capture-to-wire latency of one packet
+ *
+ */
+void telemetry_record_latency(uint32_t latency_us);
+
+/**
+ * @brief Consumer: restart the latency statistics, e.g. when the buffering depth changes
+ *
+ */
+void telemetry_reset_latency(void);
+
+/**
+ * @brief Consumer: record a calibration impulse found in the stream
+ *
+ * @param measured_us time from generating the impulse to its USB frame
+ * @param estimate_us latency from the capture stamps for the same packet, -1 if none
+ */
+void telemetry_record_impulse(int32_t measured_us, int32_t estimate_us);
+
+/**
+ * @brief Consumer: record one USB packet
+ *
+ * @param fill bytes in the audio ring after the packet was taken
+ * @param short_read true if the packet was padded with silence
+ * @param cycles CPU cycles spent in the USB callback
+ */
+void telemetry_record_packet(size_t fill, bool short_read, uint32_t cycles);
+
+/**
+ * @brief Playback: record one TX block filled while playing
+ *
+ * @param concealed true if the block was concealment instead of received audio
+ */
+void telemetry_record_playback_block(bool concealed);
+
+/**
+ * @brief Playback: record the playback ring running dry
+ *
+ */
+void telemetry_record_playback_underrun(void);
+
+/**
+ * @brief Consumer: record an OUT packet that did not fit in the playback ring
+ *
+ * @param bytes_dropped number of bytes that were not written
+ */
+void telemetry_record_playback_overrun(size_t bytes_dropped);
+
+/**
+ * @brief Take a consistent copy of all counters without stopping the stream
+ *
+ */
+void telemetry_get_snapshot(telemetry_snapshot_t* snapshot);
+
+/**
+ * @brief Periodically log counters and the fill-level trajectory
+ *
+ */
+void telemetry_report_task(void* pvParam);
@@ -0,0 +1,93 @@
+/**
+ * @file volume.c
+ * @author your name (you@domain.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include "volume.h"
+
+#include <math.h>
+#include <stdatomic.h>
+
+typedef struct {
+    atomic_int target[NUM_CHANNELS]; // Written by the control side
+    /* Owned by the producer */
+    int32_t gain[NUM_CHANNELS];
+    int32_t step[NUM_CHANNELS];
+    int32_t ramp_target[NUM_CHANNELS];
+    uint32_t ramp_frames_left[NUM_CHANNELS];
+} volume_ctx_t;
+
+static volume_ctx_t ctx = {
+    .target = { [0 ... NUM_CHANNELS - 1] = VOLUME_UNITY },
+    .gain = { [0 ... NUM_CHANNELS - 1] = VOLUME_UNITY },
+    .ramp_target = { [0 ... NUM_CHANNELS - 1] = VOLUME_UNITY },
+};
+
+void volume_set_gain(size_t channel, int32_t gain)
+{
+    if (channel < NUM_CHANNELS) {
+        atomic_store_explicit(&ctx.target[channel], gain < 0 ? 0 : gain, memory_order_relaxed);
+    }
+}
+
+int32_t volume_db_q8_to_gain(int32_t db_q8)
+{
+    float gain = powf(10.0f, db_q8 / (256.0f * 20.0f)) * VOLUME_UNITY;
+    return gain >= (float)INT32_MAX ? INT32_MAX : (int32_t)lroundf(gain);
+}
+
+static inline int32_t sat32(int64_t x)
+{
+    if (x > INT32_MAX) {
+        return INT32_MAX;
+    }
+    if (x < INT32_MIN) {
+        return INT32_MIN;
+    }
+    return (int32_t)x;
+}
+
+bool volume_process(const int32_t* in, int32_t* out, size_t frames)
+{
+    bool unity = true;
+
+    for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+        int32_t target = atomic_load_explicit(&ctx.target[ch], memory_order_relaxed);
+        if (target != ctx.ramp_target[ch]) {
+            ctx.ramp_target[ch] = target;
+            ctx.step[ch] = (target - ctx.gain[ch]) / VOLUME_RAMP_FRAMES;
+            ctx.ramp_frames_left[ch] = VOLUME_RAMP_FRAMES;
+        }
+        unity &= ctx.gain[ch] == VOLUME_UNITY && ctx.ramp_frames_left[ch] == 0;
+    }
+
+    if (unity) {
+        return false;
+    }
+
+    for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+        const int32_t* x = in + ch;
+        int32_t* y = out + ch;
+        int32_t gain = ctx.gain[ch];
+        size_t i = 0;
+
+        /* Ramp, one gain step per frame */
+        for (; i < frames && ctx.ramp_frames_left[ch] > 0; i++, x += NUM_CHANNELS, y += NUM_CHANNELS) {
+            gain = --ctx.ramp_frames_left[ch] ? gain + ctx.step[ch] : ctx.ramp_target[ch];
+            *y = sat32(((int64_t)*x * gain) >> VOLUME_GAIN_FRAC_BITS);
+        }
+
+        /* Steady state */
+        for (; i < frames; i++, x += NUM_CHANNELS, y += NUM_CHANNELS) {
+            *y = sat32(((int64_t)*x * gain) >> VOLUME_GAIN_FRAC_BITS);
+        }
+
+        ctx.gain[ch] = gain;
+    }
+    return true;
+}
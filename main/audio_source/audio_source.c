@@ -0,0 +1,147 @@
+/**
+ * @file audio_source.c
+ * @author your name (you@domain.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include "audio_source.h"
+
+#include <stdatomic.h>
+#include <stdbool.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "audio_pipeline/audio_arena.h"
+#include "audio_pipeline/audio_pipeline.h"
+#include "audio_pipeline/latency.h"
+
+#define PACED_TASK_PRIORITY 6
+#define PACED_TASK_STACK 3072
+#define UNITS_PER_FRAME 1000000000ull // Elapsed us times rate in mHz
+
+static const char* TAG = "audio-source";
+
+#if CONFIG_SIG_GEN_AUDIO_SOURCE
+static const audio_source_t* const source = &audio_source_siggen;
+#elif CONFIG_AUDIO_SOURCE_FILE
+static const audio_source_t* const source = &audio_source_file;
+#else
+static const audio_source_t* const source = &audio_source_i2s;
+#endif
+
+esp_err_t audio_source_init(audio_config_t* audio_config)
+{
+    ESP_LOGI(TAG, "Audio source: %s", source->name);
+    return source->init(audio_config);
+}
+
+esp_err_t audio_source_start(void)
+{
+    return source->start();
+}
+
+esp_err_t audio_source_stop(void)
+{
+    return source->stop();
+}
+
+esp_err_t audio_source_set_sample_rate(uint32_t sample_rate)
+{
+    return source->set_sample_rate(sample_rate);
+}
+
+esp_err_t audio_source_trim_ppm(float ppm)
+{
+    return source->trim_ppm != NULL ? source->trim_ppm(ppm) : ESP_ERR_NOT_SUPPORTED;
+}
+
+const char* audio_source_name(void)
+{
+    return source->name;
+}
+
+typedef struct {
+    TaskHandle_t task;
+    audio_source_fill_t fill;
+    int32_t* block;
+    size_t block_frames;
+    atomic_bool running;
+    uint32_t rate_mhz; // Effective rate in mHz, includes the ppm trim
+    int64_t block_end_us; // Time the last frame of the current block is due
+} paced_ctx_t;
+
+static paced_ctx_t paced = { 0 };
+
+static void paced_task(void* pvParam)
+{
+    const uint64_t block_units = paced.block_frames * UNITS_PER_FRAME;
+    int64_t last = esp_timer_get_time();
+    uint64_t owed = 0; // Frames owed in UNITS_PER_FRAME, the remainder carries over so the rate stays exact
+
+    while (1) {
+        vTaskDelay(1);
+
+        int64_t now = esp_timer_get_time();
+        uint64_t elapsed = now - last;
+        last = now;
+
+        if (!atomic_load(&paced.running)) {
+            owed = 0;
+            continue;
+        }
+
+        owed += elapsed * paced.rate_mhz;
+        while (owed >= block_units) {
+            owed -= block_units;
+            /* What is still owed after this block has been due for that long */
+            paced.block_end_us = now - (int64_t)(owed / paced.rate_mhz);
+            paced.fill(paced.block, paced.block_frames);
+            if (audio_pipeline_write_block(paced.block, paced.block_frames * NUM_CHANNELS)) {
+                latency_mark_capture(paced.block_end_us);
+            }
+        }
+    }
+}
+
+int64_t audio_source_paced_block_end_us(void)
+{
+    return paced.block_end_us;
+}
+
+void audio_source_paced_set_rate(uint32_t sample_rate, float ppm)
+{
+    paced.rate_mhz = (uint32_t)(sample_rate * 1000.0 * (1.0 + ppm * 1e-6));
+}
+
+esp_err_t audio_source_paced_start(audio_source_fill_t fill, uint32_t sample_rate, size_t block_frames)
+{
+    if (paced.task == NULL) {
+        paced.block = audio_arena_alloc("source block", block_frames * NUM_CHANNELS * sizeof(int32_t));
+        if (paced.block == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+        paced.fill = fill;
+        paced.block_frames = block_frames;
+        audio_source_paced_set_rate(sample_rate, 0);
+        if (xTaskCreate(paced_task, "paced source", PACED_TASK_STACK, NULL, PACED_TASK_PRIORITY, &paced.task) != pdPASS) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    atomic_store(&paced.running, true);
+    return ESP_OK;
+}
+
+void audio_source_paced_stop(void)
+{
+    atomic_store(&paced.running, false);
+}
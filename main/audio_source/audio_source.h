@@ -0,0 +1,78 @@
+/**
+ * @file audio_source.h
+ * @author your name (you@domain.com)
+ * @brief Producers feeding the audio pipeline
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * Exactly one source is active, selected in Kconfig. Every source pushes
+ * interleaved int32 blocks of at most AUDIO_DMA_FRAME_NUM frames into the
+ * pipeline and is its only producer. The I2S source hands over raw slots
+ * through audio_pipeline_write_capture(), the others write USB channels
+ * directly with audio_pipeline_write_block().
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "config/audio_config.h"
+#include "esp_err.h"
+
+typedef struct {
+    const char* name;
+    esp_err_t (*init)(audio_config_t* audio_config);
+    esp_err_t (*start)(void);
+    esp_err_t (*stop)(void);
+    esp_err_t (*set_sample_rate)(uint32_t sample_rate);
+    esp_err_t (*trim_ppm)(float ppm); // Fine rate adjustment for drift compensation
+} audio_source_t;
+
+extern const audio_source_t audio_source_i2s;
+extern const audio_source_t audio_source_siggen;
+extern const audio_source_t audio_source_file;
+
+/**
+ * @brief Initialize the source selected in Kconfig
+ *
+ */
+esp_err_t audio_source_init(audio_config_t* audio_config);
+
+/**
+ * @brief Start/stop delivering blocks to the pipeline
+ *
+ */
+esp_err_t audio_source_start(void);
+esp_err_t audio_source_stop(void);
+
+/**
+ * @brief Change the rate blocks are produced at
+ *
+ */
+esp_err_t audio_source_set_sample_rate(uint32_t sample_rate);
+
+/**
+ * @brief Speed the source up or down by a few ppm without interrupting it
+ *
+ */
+esp_err_t audio_source_trim_ppm(float ppm);
+
+const char* audio_source_name(void);
+
+/*
+ * Helpers for sources without a hardware clock. A task paced by esp_timer
+ * calls fill() for whole blocks whenever the elapsed time is owed a block.
+ */
+typedef void (*audio_source_fill_t)(int32_t* samples, size_t frames);
+
+esp_err_t audio_source_paced_start(audio_source_fill_t fill, uint32_t sample_rate, size_t block_frames);
+void audio_source_paced_stop(void);
+void audio_source_paced_set_rate(uint32_t sample_rate, float ppm);
+
+/**
+ * @brief Time the last frame of the block being filled is due, for use inside fill()
+ *
+ */
+int64_t audio_source_paced_block_end_us(void);
@@ -0,0 +1,97 @@
+/**
+ * @file source_file.c
+ * @author your name (you@domain.com)
+ * @brief Raw PCM file replay for host builds
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * Replays interleaved little-endian int32 frames, as captured from the I2S
+ * words, in a loop at the configured rate. Only built for the linux target
+ * and the host build in host_test.
+ */
+#include "sdkconfig.h"
+
+#if CONFIG_AUDIO_SOURCE_FILE
+#include "audio_source.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "esp_log.h"
+
+static const char* TAG = "source-file";
+
+typedef struct {
+    FILE* file;
+    uint32_t sample_rate;
+    size_t block_frames;
+} file_ctx_t;
+
+static file_ctx_t ctx = { 0 };
+
+static void fill(int32_t* samples, size_t frames)
+{
+    size_t done = 0;
+
+    while (done < frames) {
+        done += fread(samples + done * NUM_CHANNELS, NUM_CHANNELS * sizeof(int32_t), frames - done, ctx.file);
+        if (done < frames) {
+            if (ftell(ctx.file) < (long)(NUM_CHANNELS * sizeof(int32_t))) {
+                /* Shorter than one frame, nothing to loop over */
+                memset(samples + done * NUM_CHANNELS, 0, (frames - done) * NUM_CHANNELS * sizeof(int32_t));
+                return;
+            }
+            rewind(ctx.file);
+        }
+    }
+}
+
+static esp_err_t init(audio_config_t* audio_config)
+{
+    ctx.file = fopen(CONFIG_AUDIO_SOURCE_FILE_PATH, "rb");
+    if (ctx.file == NULL) {
+        ESP_LOGE(TAG, "Cannot open %s", CONFIG_AUDIO_SOURCE_FILE_PATH);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    ctx.sample_rate = audio_config->i2s_sample_rate;
+    ctx.block_frames = AUDIO_DMA_FRAME_NUM;
+    ESP_LOGI(TAG, "Replaying %s", CONFIG_AUDIO_SOURCE_FILE_PATH);
+    return ESP_OK;
+}
+
+static esp_err_t start(void)
+{
+    return audio_source_paced_start(fill, ctx.sample_rate, ctx.block_frames);
+}
+
+static esp_err_t stop(void)
+{
+    audio_source_paced_stop();
+    return ESP_OK;
+}
+
+static esp_err_t set_sample_rate(uint32_t sample_rate)
+{
+    ctx.sample_rate = sample_rate;
+    audio_source_paced_set_rate(sample_rate, 0);
+    return ESP_OK;
+}
+
+static esp_err_t trim_ppm(float ppm)
+{
+    audio_source_paced_set_rate(ctx.sample_rate, ppm);
+    return ESP_OK;
+}
+
+const audio_source_t audio_source_file = {
+    .name = "file replay",
+    .init = init,
+    .start = start,
+    .stop = stop,
+    .set_sample_rate = set_sample_rate,
+    .trim_ppm = trim_ppm,
+};
+#endif // CONFIG_AUDIO_SOURCE_FILE
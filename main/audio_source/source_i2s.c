@@ -0,0 +1,41 @@
+/**
+ * @file source_i2s.c
+ * @author your name (you@domain.com)
+ * @brief I2S ADC capture, blocks are pushed from the DMA receive interrupt
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include "sdkconfig.h"
+
+#if CONFIG_AUDIO_SOURCE_I2S
+#include "audio_source.h"
+
+#include "esp_check.h"
+
+#include "i2s/i2s.h"
+
+static const char* TAG = "source-i2s";
+
+static esp_err_t start(void)
+{
+    ESP_RETURN_ON_ERROR(i2s_enable_async_read(), TAG, "Failed to register the receive callback");
+    return i2s_enable_clk();
+}
+
+static esp_err_t stop(void)
+{
+    return i2s_disable_clk();
+}
+
+const audio_source_t audio_source_i2s = {
+    .name = "i2s",
+    .init = i2s_init,
+    .start = start,
+    .stop = stop,
+    .set_sample_rate = i2s_set_sample_rate,
+    .trim_ppm = i2s_trim_clk_ppm,
+};
+#endif // CONFIG_AUDIO_SOURCE_I2S
@@ -0,0 +1,147 @@
+/**
+ * @file source_siggen.c
+ * @author your name (you@domain.com)
+ * @brief Deterministic test tone from a precomputed sine table
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * One tone per channel from a 32-bit phase accumulator, linearly
+ * interpolated between table entries and truncated to 24 bits like the ADC
+ * words. The output only depends on the configuration and sample count, so
+ * runs can be compared bit for bit.
+ */
+#include "sdkconfig.h"
+
+#if CONFIG_SIG_GEN_AUDIO_SOURCE
+#include "audio_source.h"
+
+#include <math.h>
+
+#include "esp_log.h"
+
+#if CONFIG_SIG_GEN_IMPULSE
+#include "audio_pipeline/latency.h"
+#endif
+
+#define TABLE_BITS 10
+#define TABLE_SIZE (1 << TABLE_BITS)
+#define FRAC_BITS (32 - TABLE_BITS)
+#define ADC_MASK 0xFFFFFF00 // 24-bit samples in a 32-bit slot
+#define IMPULSE_LEVEL (INT32_MAX & ADC_MASK)
+
+static const char* TAG = "source-siggen";
+
+typedef struct {
+    int32_t table[TABLE_SIZE + 1]; // Extra entry so interpolation never wraps
+    uint32_t phase[NUM_CHANNELS];
+    uint32_t phase_inc[NUM_CHANNELS];
+    uint32_t sample_rate;
+    size_t block_frames;
+#if CONFIG_SIG_GEN_IMPULSE
+    uint32_t impulse_countdown; // Frames until the next impulse
+#endif
+} siggen_ctx_t;
+
+static siggen_ctx_t ctx = { 0 };
+
+static const uint32_t tone_hz[2] = { CONFIG_SIG_GEN_FREQ_LEFT, CONFIG_SIG_GEN_FREQ_RIGHT };
+
+static void set_rate(uint32_t sample_rate)
+{
+    ctx.sample_rate = sample_rate;
+    for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+        ctx.phase_inc[ch] = (uint32_t)(((uint64_t)tone_hz[ch % 2] << 32) / sample_rate);
+    }
+}
+
+#if CONFIG_SIG_GEN_IMPULSE
+static void fill(int32_t* samples, size_t frames)
+{
+    int64_t end_us = audio_source_paced_block_end_us();
+
+    for (size_t i = 0; i < frames; i++) {
+        int32_t value = 0;
+
+        if (ctx.impulse_countdown == 0) {
+            ctx.impulse_countdown = CONFIG_SIG_GEN_IMPULSE_INTERVAL_MS * ctx.sample_rate / 1000;
+            value = IMPULSE_LEVEL;
+            latency_mark_impulse(end_us - (int64_t)(frames - 1 - i) * 1000000 / ctx.sample_rate);
+        }
+        ctx.impulse_countdown--;
+
+        for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+            *samples++ = value;
+        }
+    }
+}
+#else
+static void fill(int32_t* samples, size_t frames)
+{
+    for (size_t i = 0; i < frames; i++) {
+        for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+            uint32_t phase = ctx.phase[ch];
+            uint32_t idx = phase >> FRAC_BITS;
+            int32_t frac = (phase >> (FRAC_BITS - 15)) & 0x7FFF;
+            int32_t a = ctx.table[idx];
+            int32_t b = ctx.table[idx + 1];
+
+            *samples++ = (int32_t)((a + (((int64_t)(b - a) * frac) >> 15)) & ADC_MASK);
+            ctx.phase[ch] = phase + ctx.phase_inc[ch];
+        }
+    }
+}
+#endif
+
+static esp_err_t init(audio_config_t* audio_config)
+{
+    const double amplitude = pow(10.0, CONFIG_SIG_GEN_LEVEL_DBFS / 20.0) * INT32_MAX;
+
+    for (int i = 0; i <= TABLE_SIZE; i++) {
+        ctx.table[i] = (int32_t)lround(amplitude * sin(2.0 * M_PI * i / TABLE_SIZE));
+    }
+    set_rate(audio_config->i2s_sample_rate);
+    ctx.block_frames = AUDIO_DMA_FRAME_NUM;
+
+#if CONFIG_SIG_GEN_IMPULSE
+    ESP_LOGI(TAG, "Calibration impulse every %d ms", CONFIG_SIG_GEN_IMPULSE_INTERVAL_MS);
+#else
+    ESP_LOGI(TAG, "%d/%d Hz at %d dBFS", CONFIG_SIG_GEN_FREQ_LEFT, CONFIG_SIG_GEN_FREQ_RIGHT, CONFIG_SIG_GEN_LEVEL_DBFS);
+#endif
+    return ESP_OK;
+}
+
+static esp_err_t start(void)
+{
+    return audio_source_paced_start(fill, ctx.sample_rate, ctx.block_frames);
+}
+
+static esp_err_t stop(void)
+{
+    audio_source_paced_stop();
+    return ESP_OK;
+}
+
+static esp_err_t set_sample_rate(uint32_t sample_rate)
+{
+    set_rate(sample_rate);
+    audio_source_paced_set_rate(sample_rate, 0);
+    return ESP_OK;
+}
+
+static esp_err_t trim_ppm(float ppm)
+{
+    audio_source_paced_set_rate(ctx.sample_rate, ppm);
+    return ESP_OK;
+}
+
+const audio_source_t audio_source_siggen = {
+    .name = "signal generator",
+    .init = init,
+    .start = start,
+    .stop = stop,
+    .set_sample_rate = set_sample_rate,
+    .trim_ppm = trim_ppm,
+};
+#endif // CONFIG_SIG_GEN_AUDIO_SOURCE
@@ -11,13 +11,148 @@
 
 #include <stdint.h>
 
-#include "freertos/FreeRTOS.h"
-#include "freertos/stream_buffer.h"
+#include "audio_pipeline/audio_ring.h"
+#include "sdkconfig.h"
 
-#define SAMPLE_RATE 48000
-#define NUM_CHANNELS 2
-#define SAMPLES_PER_MS (SAMPLE_RATE / 1000)
-#define STREAMBUFFER_TOTAL_LEN_MS 300
+#define SAMPLE_RATE 48000 // Rate at boot, the host may change it at runtime
+#define MIN_SAMPLE_RATE 44100
+#define NUM_CHANNELS CONFIG_TINYUSB_AUDIO_CHANNELS // USB channels, must match the descriptors
+#define MAX_SAMPLE_RATE (NUM_CHANNELS > 2 ? 48000 : 96000) // Limited by the full-speed isochronous bandwidth
+
+#if CONFIG_AUDIO_I2S_TDM
+#define AUDIO_I2S_PORT_SLOTS CONFIG_AUDIO_I2S_TDM_SLOTS
+#else
+#define AUDIO_I2S_PORT_SLOTS 2
+#endif
+#if CONFIG_AUDIO_I2S_DUAL
+#define AUDIO_I2S_PORTS 2
+#else
+#define AUDIO_I2S_PORTS 1
+#endif
+#define AUDIO_I2S_SLOTS (AUDIO_I2S_PORTS * AUDIO_I2S_PORT_SLOTS) // Slots per captured frame, all ports merged
+
+/* Prebuffer depth of the latency profiles */
+#define AUDIO_LATENCY_LOW_MS 10
+#define AUDIO_LATENCY_BALANCED_MS 40
+#define AUDIO_LATENCY_SAFE_MS 150
+
+/*
+ * Buffer geometry, derived at compile time from the values above. The
+ * assertions below reject combinations that would not fit the hardware or
+ * would starve the USB side, instead of producing short packets at runtime.
+ */
+#define AUDIO_I2S_SLOT_BYTES 4 // 32-bit I2S slots, whatever the USB format
+#define AUDIO_I2S_FRAME_BYTES (AUDIO_I2S_PORT_SLOTS * AUDIO_I2S_SLOT_BYTES) // One frame of one port
+#define AUDIO_DMA_FRAME_NUM (AUDIO_I2S_PORT_SLOTS <= 2 ? 320 : 960 / AUDIO_I2S_PORT_SLOTS) // Frames per DMA buffer, one block through the pipeline
+#define AUDIO_DMA_BUFFER_BYTES (AUDIO_DMA_FRAME_NUM * AUDIO_I2S_FRAME_BYTES)
+#define AUDIO_DMA_STALL_MS 15 // How long block processing may lag before captured audio is lost
+#define AUDIO_BLOCK_BYTES (AUDIO_DMA_FRAME_NUM * NUM_CHANNELS * sizeof(int32_t)) // One block after channel mapping
+
+#define AUDIO_DIV_CEIL(a, b) (((a) + (b) - 1) / (b))
+#define AUDIO_SMEAR_(x, s) ((x) | (x) >> (s))
+#define AUDIO_SMEAR(x) AUDIO_SMEAR_(AUDIO_SMEAR_(AUDIO_SMEAR_(AUDIO_SMEAR_(AUDIO_SMEAR_(x, 1), 2), 4), 8), 16)
+#define AUDIO_POW2_CEIL(x) (AUDIO_SMEAR((uint32_t)(x) - 1) + 1)
+
+/* A power of two so the free-running block indices in the I2S driver wrap cleanly */
+#define AUDIO_DMA_DESC_NUM AUDIO_POW2_CEIL(AUDIO_DIV_CEIL(AUDIO_DMA_STALL_MS * (MAX_SAMPLE_RATE / 1000), AUDIO_DMA_FRAME_NUM) + 1)
+
+/* Largest packet of any rate/format, incl. one async adjustment frame */
+#define MAX_AUDIO_BYTES_PER_MS ((MAX_SAMPLE_RATE / 1000 + 1) * NUM_CHANNELS * sizeof(int32_t))
+
+/* Deepest prebuffer at the highest rate, plus room for a DMA block in flight and jitter */
+#define AUDIO_RING_HEADROOM_MS 15
+#define AUDIO_RING_BYTES AUDIO_POW2_CEIL((AUDIO_LATENCY_SAFE_MS + AUDIO_RING_HEADROOM_MS) * (MAX_SAMPLE_RATE / 1000) * NUM_CHANNELS * sizeof(int32_t))
+#define AUDIO_RING_MAX_BYTES (128 * 1024) // Internal RAM budget for the ring
+
+/* Crossfade length where audio is inserted into or dropped from the stream to stay time-aligned */
+#define AUDIO_SPLICE_FADE_FRAMES 32
+/* Longest capture gap concealed in place, longer ones are left for the USB side to resynchronise */
+#define AUDIO_SPLICE_MAX_GAP_MS AUDIO_LATENCY_SAFE_MS
+
+/*
+ * Every buffer is carved from one arena at boot (audio_pipeline/audio_arena.h).
+ * The terms below are what each part of the configured pipeline takes, each
+ * rounded up to the arena alignment; their sum is the arena size.
+ */
+#define AUDIO_ARENA_ALIGN AUDIO_RING_CACHE_LINE // Also satisfies GDMA and the cache line for PSRAM-backed buffers
+#define AUDIO_ARENA_ROUND(x) (AUDIO_DIV_CEIL(x, AUDIO_ARENA_ALIGN) * AUDIO_ARENA_ALIGN)
+#define AUDIO_ARENA_MAX_BYTES (256 * 1024) // Internal RAM left for audio next to IDF, TinyUSB and the task stacks
+
+#define AUDIO_SRC_MAX_OUT_FRAMES (AUDIO_DMA_FRAME_NUM * 5 / 2 + 2) // One block resampled by a ratio up to 2.5
+#define AUDIO_ALIGN_FIFO_FRAMES (3 * AUDIO_DMA_FRAME_NUM) // Per-port FIFO of the dual I2S aligner
+#define AUDIO_TAP_RING_MS 32
+#define AUDIO_TAP_RING_BYTES AUDIO_POW2_CEIL(AUDIO_TAP_RING_MS * (MAX_SAMPLE_RATE / 1000) * NUM_CHANNELS * sizeof(int32_t))
+
+#if CONFIG_AUDIO_SRC
+#define AUDIO_OUT_BLOCK_BYTES (AUDIO_SRC_MAX_OUT_FRAMES * NUM_CHANNELS * sizeof(int32_t)) // One block after resampling
+#define AUDIO_ARENA_SRC_BYTES AUDIO_ARENA_ROUND(AUDIO_OUT_BLOCK_BYTES)
+#else
+#define AUDIO_OUT_BLOCK_BYTES AUDIO_BLOCK_BYTES
+#define AUDIO_ARENA_SRC_BYTES 0
+#endif
+
+#if CONFIG_AUDIO_DSP_CHAIN
+#define AUDIO_ARENA_DSP_BYTES AUDIO_ARENA_ROUND(NUM_CHANNELS * AUDIO_DMA_FRAME_NUM * sizeof(int32_t))
+#else
+#define AUDIO_ARENA_DSP_BYTES 0
+#endif
+
+#if CONFIG_AUDIO_I2S_DUAL
+#define AUDIO_ARENA_ALIGN_BYTES (AUDIO_I2S_PORTS * AUDIO_ARENA_ROUND(AUDIO_ALIGN_FIFO_FRAMES * AUDIO_I2S_FRAME_BYTES) \
+    + AUDIO_ARENA_ROUND(AUDIO_DMA_FRAME_NUM * AUDIO_I2S_SLOTS * sizeof(int32_t)))
+#else
+#define AUDIO_ARENA_ALIGN_BYTES 0
+#endif
+
+#define AUDIO_ARENA_USB_BYTES AUDIO_ARENA_ROUND(MAX_AUDIO_BYTES_PER_MS) // Packet staging, or spliced packets with zero copy
+
+#if CONFIG_AUDIO_SOURCE_I2S
+#define AUDIO_ARENA_SOURCE_BYTES 0
+#else
+#define AUDIO_ARENA_SOURCE_BYTES AUDIO_ARENA_ROUND(AUDIO_BLOCK_BYTES) // Block of the timer-paced source
+#endif
+
+#if CONFIG_AUDIO_PLAYBACK
+#define AUDIO_PLAYBACK_RING_BYTES AUDIO_POW2_CEIL((CONFIG_AUDIO_PLAYBACK_PREBUFFER_MS + AUDIO_RING_HEADROOM_MS) * (MAX_SAMPLE_RATE / 1000) * NUM_CHANNELS * sizeof(int32_t))
+#define AUDIO_ARENA_PLAYBACK_BYTES AUDIO_ARENA_ROUND(AUDIO_PLAYBACK_RING_BYTES)
+#define AUDIO_I2S_DMA_TOTAL_BYTES ((AUDIO_I2S_PORTS + 1) * AUDIO_DMA_DESC_NUM * AUDIO_DMA_BUFFER_BYTES) // Allocated by the driver, incl. TX
+#else
+#define AUDIO_ARENA_PLAYBACK_BYTES 0
+#define AUDIO_I2S_DMA_TOTAL_BYTES (AUDIO_I2S_PORTS * AUDIO_DMA_DESC_NUM * AUDIO_DMA_BUFFER_BYTES) // Allocated by the driver
+#endif
+
+#if CONFIG_AUDIO_TAP
+#define AUDIO_ARENA_TAP_BYTES AUDIO_ARENA_ROUND(AUDIO_TAP_RING_BYTES)
+#else
+#define AUDIO_ARENA_TAP_BYTES 0
+#endif
+
+#define AUDIO_ARENA_BYTES (AUDIO_ARENA_ROUND(AUDIO_RING_BYTES) \
+    + AUDIO_ARENA_ROUND(AUDIO_BLOCK_BYTES) /* Channel mapping and processing */ \
+    + AUDIO_ARENA_ROUND(AUDIO_OUT_BLOCK_BYTES) /* Format conversion */ \
+    + AUDIO_ARENA_SRC_BYTES + AUDIO_ARENA_DSP_BYTES + AUDIO_ARENA_ALIGN_BYTES + AUDIO_ARENA_USB_BYTES \
+    + AUDIO_ARENA_SOURCE_BYTES + AUDIO_ARENA_PLAYBACK_BYTES + AUDIO_ARENA_TAP_BYTES)
+
+#define AUDIO_I2S_DMA_MAX_BYTES 4092 // Largest buffer one GDMA descriptor can address
+#define AUDIO_USB_FS_ISO_MAX_BYTES 1023 // Full-speed isochronous max packet size
+
+_Static_assert(AUDIO_DMA_BUFFER_BYTES <= AUDIO_I2S_DMA_MAX_BYTES, "DMA buffer exceeds what one descriptor can address");
+_Static_assert(AUDIO_DMA_DESC_NUM >= 2 && AUDIO_DMA_DESC_NUM <= 128, "DMA descriptor count out of range");
+_Static_assert((AUDIO_DMA_DESC_NUM - 1) * AUDIO_DMA_FRAME_NUM >= AUDIO_DMA_STALL_MS * (MAX_SAMPLE_RATE / 1000),
+    "DMA ring shorter than the allowed processing stall");
+_Static_assert(MAX_AUDIO_BYTES_PER_MS <= AUDIO_USB_FS_ISO_MAX_BYTES, "Largest USB packet exceeds the full-speed isochronous limit");
+_Static_assert(AUDIO_RING_BYTES <= AUDIO_RING_MAX_BYTES, "Audio ring exceeds the RAM budget");
+_Static_assert(AUDIO_LATENCY_SAFE_MS * (MAX_SAMPLE_RATE / 1000) * NUM_CHANNELS * sizeof(int32_t) + 2 * AUDIO_BLOCK_BYTES <= AUDIO_RING_BYTES,
+    "Audio ring cannot hold the deepest prebuffer plus a DMA block in flight");
+_Static_assert(AUDIO_LATENCY_LOW_MS * MIN_SAMPLE_RATE >= (AUDIO_DMA_FRAME_NUM + MIN_SAMPLE_RATE / 1000 + 1) * 1000,
+    "Lowest prebuffer shorter than one DMA block plus one USB packet, packets would run short");
+_Static_assert(AUDIO_LATENCY_LOW_MS < AUDIO_LATENCY_BALANCED_MS && AUDIO_LATENCY_BALANCED_MS < AUDIO_LATENCY_SAFE_MS,
+    "Latency profiles out of order");
+_Static_assert(AUDIO_SPLICE_FADE_FRAMES <= MIN_SAMPLE_RATE / 1000 && AUDIO_SPLICE_FADE_FRAMES <= AUDIO_DMA_FRAME_NUM,
+    "Splice crossfade longer than one USB packet or DMA block");
+_Static_assert(AUDIO_ARENA_BYTES <= AUDIO_ARENA_MAX_BYTES, "Audio buffers exceed the internal RAM budget");
+_Static_assert(NUM_CHANNELS >= 1 && NUM_CHANNELS <= 4, "More than 4 USB channels at 48 kHz exceed a full-speed isochronous packet");
+_Static_assert(SAMPLE_RATE >= MIN_SAMPLE_RATE && SAMPLE_RATE <= MAX_SAMPLE_RATE, "Boot sample rate out of range");
 
 typedef enum {
     BITS_PER_SAMPLE_16BIT = 16,
@@ -28,8 +163,9 @@ typedef enum {
 typedef enum {
     PCM_FORMAT_UNKNOWN,
     PCM_FORMAT_16BIT,
-    PCM_FORMAT_24BIT_32BIT,
-    PCM_FORMAT_32BIT
+    PCM_FORMAT_24BIT_32BIT, // 24-bit packed in 3 bytes
+    PCM_FORMAT_32BIT,
+    PCM_FORMAT_24BIT_IN_32BIT, // 24-bit MSB-aligned in 4 bytes
 } audio_format_t;
 
 /**
@@ -37,19 +173,23 @@ typedef enum {
  */
 typedef struct {
     audio_format_t audio_format;
-    uint32_t audio_bytes_per_ms; // Size in bytes of total audio data stream per ms
-    uint32_t i2s_dma_size;
-    uint32_t stream_buffer_total_size; // Total size of the StreamBuffer in bytes
-    StreamBufferHandle_t stream_buffer_handle; // Handle of the StreamBuffer
+    uint32_t sample_rate; // Rate delivered to USB
+    uint32_t i2s_sample_rate; // Capture rate, differs from sample_rate when resampling
+    uint32_t audio_bytes_per_frame; // Size in bytes of one sample for all channels
+    uint32_t audio_bytes_per_ms; // Size in bytes of the largest 1 ms packet (rounded up to whole frames)
+    uint32_t i2s_dma_size; // One DMA buffer of one port
+    uint32_t ring_total_size; // Requested size of the audio ring in bytes
+    audio_ring_t* ring; // I2S -> USB audio ring
 } audio_config_t;
 
 /**
  * @brief Create a configuration struct with various audio parameters.
  *        Some values are given as parameters and others are calculated based on these.
  * @param format audio format (16/24/32bit)
+ * @param sample_rate sample rate in Hz
  * @return Struct with configuration values
  */
-static inline audio_config_t create_audio_config(audio_format_t format)
+static inline audio_config_t create_audio_config(audio_format_t format, uint32_t sample_rate)
 {
     // default values
     uint8_t BYTES_PER_SAMPLE_PIPELINE = 3;
@@ -62,20 +202,29 @@ static inline audio_config_t create_audio_config(audio_format_t format)
         BYTES_PER_SAMPLE_PIPELINE = 3;
         break;
     case PCM_FORMAT_32BIT:
+    case PCM_FORMAT_24BIT_IN_32BIT:
         BYTES_PER_SAMPLE_PIPELINE = 4;
         break;
     default:
         break;
     }
 
-    const uint32_t audio_bytes_per_ms = (SAMPLES_PER_MS * BYTES_PER_SAMPLE_PIPELINE * NUM_CHANNELS); // number of audio BYTES per ms audio for pipeline
+    const uint32_t audio_bytes_per_frame = BYTES_PER_SAMPLE_PIPELINE * NUM_CHANNELS;
+    const uint32_t audio_bytes_per_ms = ((sample_rate + 999) / 1000) * audio_bytes_per_frame; // number of audio BYTES per ms audio for pipeline
 
     audio_config_t audio_config = {
         .audio_format = format,
+        .sample_rate = sample_rate,
+#if CONFIG_AUDIO_SRC
+        .i2s_sample_rate = CONFIG_AUDIO_SRC_CAPTURE_RATE,
+#else
+        .i2s_sample_rate = sample_rate,
+#endif
+        .audio_bytes_per_frame = audio_bytes_per_frame,
         .audio_bytes_per_ms = audio_bytes_per_ms,
-        .i2s_dma_size = 2560,
-        .stream_buffer_total_size = audio_bytes_per_ms * STREAMBUFFER_TOTAL_LEN_MS,
-        .stream_buffer_handle = NULL,
+        .i2s_dma_size = AUDIO_DMA_BUFFER_BYTES,
+        .ring_total_size = AUDIO_RING_BYTES,
+        .ring = NULL,
     };
 
     return audio_config;
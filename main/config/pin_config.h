@@ -24,6 +24,8 @@
 #define I2S_BCLK_IO GPIO_NUM_48
 #define I2S_LRCLK_IO GPIO_NUM_47
 #define I2S_ADC_DATA_IO GPIO_NUM_45
+#define I2S_ADC2_DATA_IO GPIO_NUM_5 // Expansion header pin 10, second ADC when capturing from both I2S ports
+#define I2S_DAC_DATA_IO GPIO_NUM_16 // Expansion header pin 13, DAC for USB playback
 
 /* MasterLink Control */
 #define ML_UART_RX GPIO_NUM_38
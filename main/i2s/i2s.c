@@ -11,18 +11,45 @@
 
 #include "i2s.h"
 
+#include "driver/gpio.h"
 #include "driver/i2s_std.h"
+#include "driver/i2s_tdm.h"
+#include "esp_check.h"
 #include "esp_err.h"
+#include "esp_idf_version.h"
 #include "esp_log.h"
+#include "hal/i2s_ll.h"
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/portmacro.h"
 #include "freertos/queue.h"
+#include "freertos/task.h"
 
+#include "audio_pipeline/audio_pipeline.h"
+#include "audio_pipeline/latency.h"
+#include "audio_pipeline/playback.h"
+#include "audio_pipeline/rt_log.h"
+#include "audio_pipeline/telemetry.h"
 #include "config/pin_config.h"
+#include "esp_cpu.h"
+#include "esp_timer.h"
+#include "i2s_align.h"
+#include <inttypes.h>
+#include <stdatomic.h>
 #include <stdint.h>
 
-#define I2S_READ_TIMEOUT_MS 1000
+#define I2S_SCLK_HZ 160000000 // PLL_F160M, the default I2S clock source on ESP32-S3
+#if CONFIG_AUDIO_I2S_TDM
+#define I2S_MCLK_MULTIPLE (AUDIO_I2S_PORT_SLOTS > 4 ? 512 : 256) // At least twice the BCLK, 32 bits per slot
+#define I2S_TDM_SLOT_MASK ((1u << AUDIO_I2S_PORT_SLOTS) - 1)
+#define I2S_CHANNEL_INIT_MODE i2s_channel_init_tdm_mode
+#define I2S_CHANNEL_RECONFIG_CLOCK i2s_channel_reconfig_tdm_clock
+#else
+#define I2S_MCLK_MULTIPLE 256 // I2S_STD_CLK_DEFAULT_CONFIG
+#define I2S_CHANNEL_INIT_MODE i2s_channel_init_std_mode
+#define I2S_CHANNEL_RECONFIG_CLOCK i2s_channel_reconfig_std_clock
+#endif
+#define I2S_PROCESS_TASK_STACK 4096
 
 static const char* TAG = "i2s";
 
@@ -33,73 +60,293 @@ typedef enum {
 } i2s_status_t;
 
 typedef struct {
-    i2s_chan_handle_t i2s_chan_rx_handle;
+    const int32_t* data;
+    size_t num_samples;
+    int64_t end_us; // Completion time, reveals lost blocks and aligns the ports
+} i2s_block_t;
+
+/*
+ * Completed DMA buffers of one port, written by the ISR and drained by the
+ * process task. A buffer stays valid until the DMA wraps around to it, so the
+ * task has AUDIO_DMA_DESC_NUM - 1 block periods to pick it up.
+ */
+typedef struct {
+    i2s_block_t blocks[AUDIO_DMA_DESC_NUM];
+    atomic_uint head;
+    atomic_uint tail;
+} i2s_block_queue_t;
+
+typedef struct {
+    i2s_chan_handle_t i2s_chan_rx_handle[AUDIO_I2S_PORTS]; // Port 0 is the clock master
+    i2s_dev_t* hw; // Registers of port 0's controller, looked up once so trimming needs no driver lock
+#if CONFIG_AUDIO_PLAYBACK
+    i2s_chan_handle_t i2s_chan_tx_handle; // Full duplex with port 0
+#endif
     audio_config_t audio_config;
     QueueSetHandle_t status_queue;
+#if CONFIG_AUDIO_PROCESS_IN_TASK
+    i2s_block_queue_t queue[AUDIO_I2S_PORTS];
+    TaskHandle_t process_task;
+#endif
+    int64_t last_end_us[AUDIO_I2S_PORTS]; // Completion of each port's previous block, owned by block processing
+    atomic_bool restarted; // Channels were restarted, the next block starts a new timeline
 } i2s_ctx_t;
 
 static i2s_ctx_t ctx = { 0 };
 
+/**
+ * @brief Start of the DMA buffer that just completed
+ *
+ * Before IDF 5.4 the event carries the address of the descriptor's buffer
+ * pointer rather than the buffer itself.
+ */
+static inline const int32_t* event_block(const i2s_event_data_t* event)
+{
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 4, 0)
+    return (const int32_t*)event->dma_buf;
+#else
+    return *(const int32_t* const*)event->data;
+#endif
+}
+
+/**
+ * @brief Frames lost on a port before the block that completed at end_us
+ *
+ * A block goes missing when processing falls so far behind that the DMA
+ * overwrites it, or when the interrupt is held off so long that the driver
+ * skips a descriptor. Blocks complete once per block period, so the
+ * completion times tell how many are missing.
+ */
+static size_t lost_frames(int port, int64_t end_us, size_t frames)
+{
+    if (atomic_exchange_explicit(&ctx.restarted, false, memory_order_acquire)) {
+        for (int p = 0; p < AUDIO_I2S_PORTS; p++) {
+            ctx.last_end_us[p] = 0;
+        }
+    }
+
+    int64_t last_end_us = ctx.last_end_us[port];
+    ctx.last_end_us[port] = end_us;
+    if (last_end_us == 0 || frames == 0) {
+        return 0;
+    }
+
+    int64_t period_us = (int64_t)frames * 1000000 / ctx.audio_config.i2s_sample_rate;
+    int64_t blocks = (end_us - last_end_us + period_us / 2) / period_us;
+    return blocks > 1 ? (blocks - 1) * frames : 0;
+}
+
+#if CONFIG_AUDIO_PROCESS_IN_TASK
 static bool post_status(i2s_status_t status)
 {
     BaseType_t xHigherPriorityTaskWoken = pdFALSE;
     if (ctx.status_queue != NULL) {
         xQueueSendFromISR(ctx.status_queue, &status, &xHigherPriorityTaskWoken);
-    }   
+    }
     return xHigherPriorityTaskWoken;
 }
 
-static bool i2s_rx_q_ovf(i2s_chan_handle_t handle, i2s_event_data_t *event, void *user_ctx)
-{
-    return post_status(I2S_ERROR_DMA_OVERFLOW);
-}
-
 static bool i2s_rx_callback(i2s_chan_handle_t handle, i2s_event_data_t* event, void* user_ctx)
 {
-    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    i2s_block_queue_t* queue = &ctx.queue[(intptr_t)user_ctx];
+    unsigned head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+
+    if (head - tail >= AUDIO_DMA_DESC_NUM - 1) {
+        /* The task is so far behind that the DMA is about to overwrite the oldest pending buffer */
+        telemetry_record_dma_overflow();
+        rt_log(RT_LOG_DMA_OVERFLOW, (intptr_t)user_ctx, 0, 0);
+        return post_status(I2S_ERROR_DMA_OVERFLOW);
+    }
 
-    uint8_t* audio_data = (event->data)+12; //! Workaround. 
+    queue->blocks[head % AUDIO_DMA_DESC_NUM] = (i2s_block_t) {
+        .data = event_block(event),
+        .num_samples = event->size / sizeof(int32_t),
+        .end_us = esp_timer_get_time(),
+    };
+    atomic_store_explicit(&queue->head, head + 1, memory_order_release);
 
-    xStreamBufferSendFromISR(
-        ctx.audio_config.stream_buffer_handle,
-        audio_data,
-        event->size,
-        &xHigherPriorityTaskWoken);
-        
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    vTaskNotifyGiveFromISR(ctx.process_task, &xHigherPriorityTaskWoken);
     return xHigherPriorityTaskWoken;
 }
 
-esp_err_t i2s_init(audio_config_t* audio_cfg)
+/**
+ * @brief Oldest pending block over all ports
+ *
+ * Taking blocks in completion order keeps the port alignment FIFOs at their
+ * minimum depth.
+ */
+static int next_port(void)
 {
-    esp_err_t result = ESP_FAIL;
+    int next = -1;
+#if CONFIG_AUDIO_I2S_DUAL
+    int64_t next_end_us = 0;
+#endif
 
-    ctx.audio_config = *audio_cfg;
+    for (int port = 0; port < AUDIO_I2S_PORTS; port++) {
+        i2s_block_queue_t* queue = &ctx.queue[port];
+        unsigned tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+        if (tail == atomic_load_explicit(&queue->head, memory_order_acquire)) {
+            continue;
+        }
+#if CONFIG_AUDIO_I2S_DUAL
+        int64_t end_us = queue->blocks[tail % AUDIO_DMA_DESC_NUM].end_us;
+        if (next >= 0 && end_us >= next_end_us) {
+            continue;
+        }
+        next_end_us = end_us;
+#endif
+        next = port;
+    }
+    return next;
+}
 
-    if (ctx.audio_config.stream_buffer_handle == NULL) {
-        ESP_LOGE(TAG, "Streambuffer NULL");
-        return ESP_FAIL;
+static void i2s_process_task(void* pvParam)
+{
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        /* Drain every block completed since the last wakeup */
+        int port;
+        while ((port = next_port()) >= 0) {
+            i2s_block_queue_t* queue = &ctx.queue[port];
+            unsigned tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+            const i2s_block_t* block = &queue->blocks[tail % AUDIO_DMA_DESC_NUM];
+            esp_cpu_cycle_count_t start = esp_cpu_get_cycle_count();
+            size_t frames = block->num_samples / AUDIO_I2S_PORT_SLOTS;
+            size_t lost = lost_frames(port, block->end_us, frames);
+
+#if CONFIG_AUDIO_I2S_DUAL
+            if (lost > 0) {
+                i2s_align_mark_gap();
+            }
+            i2s_align_push(port, block->data, frames, block->end_us);
+#else
+            if (lost > 0) {
+                audio_pipeline_write_gap(lost);
+            }
+            if (audio_pipeline_write_capture(block->data, block->num_samples)) {
+                latency_mark_capture(block->end_us);
+            }
+#endif
+
+            telemetry_record_block(esp_cpu_get_cycle_count() - start);
+            atomic_store_explicit(&queue->tail, tail + 1, memory_order_release);
+        }
     }
+}
+#else
+static bool i2s_rx_callback(i2s_chan_handle_t handle, i2s_event_data_t* event, void* user_ctx)
+{
+    esp_cpu_cycle_count_t start = esp_cpu_get_cycle_count();
+    int64_t end_us = esp_timer_get_time();
+    size_t lost = lost_frames(0, end_us, event->size / AUDIO_I2S_FRAME_BYTES);
 
-    /* Make sure a valid Audio format has been set */
-    if (ctx.audio_config.audio_format == PCM_FORMAT_UNKNOWN) {
-        return ESP_FAIL;
+    if (lost > 0) {
+        audio_pipeline_write_gap(lost);
+    }
+    if (audio_pipeline_write_capture(event_block(event), event->size / sizeof(int32_t))) {
+        latency_mark_capture(end_us);
     }
 
+    telemetry_record_block(esp_cpu_get_cycle_count() - start);
+    return false; // The pipeline never wakes a task
+}
+#endif
+
+#if CONFIG_AUDIO_PLAYBACK
+static bool i2s_tx_callback(i2s_chan_handle_t handle, i2s_event_data_t* event, void* user_ctx)
+{
+    playback_fill((int32_t*)event_block(event), event->size / AUDIO_I2S_FRAME_BYTES);
+    return false;
+}
+
+/**
+ * @brief Fill the TX DMA buffers with silence before the channel starts
+ *
+ * The buffers still hold the last blocks played before the channel was
+ * stopped, and the first ones go out before the interrupt refills them.
+ */
+static void preload_silence(void)
+{
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 1, 0)
+    static const int32_t silence[AUDIO_DMA_FRAME_NUM * AUDIO_I2S_PORT_SLOTS] = { 0 };
+    size_t loaded;
+
+    do {
+        if (i2s_channel_preload_data(ctx.i2s_chan_tx_handle, silence, sizeof(silence), &loaded) != ESP_OK) {
+            break;
+        }
+    } while (loaded == sizeof(silence));
+#endif
+}
+#endif
+
+#if CONFIG_AUDIO_I2S_TDM
+static i2s_tdm_clk_config_t tdm_clk_config(uint32_t sample_rate)
+{
+    i2s_tdm_clk_config_t clk_cfg = I2S_TDM_CLK_DEFAULT_CONFIG(sample_rate);
+    clk_cfg.mclk_multiple = I2S_MCLK_MULTIPLE;
+    return clk_cfg;
+}
+#endif
+
+/**
+ * @brief Create and configure the RX channel of one port
+ *
+ * With playback, port 0 also gets the controller's TX channel, on the same
+ * clocks as capture.
+ *
+ * @param port index into the channel handles, also the controller when both are used
+ * @param role master drives BCLK and WS, a slave follows the master's
+ * @param din data input pin
+ */
+static esp_err_t init_port(int port, i2s_role_t role, gpio_num_t din)
+{
+    esp_err_t result = ESP_FAIL;
+
     i2s_chan_config_t rx_chan_cfg = {
-        .id = I2S_NUM_AUTO,
-        .role = I2S_ROLE_MASTER,
-        .dma_desc_num = 8,
-        .dma_frame_num = 320,
+        .id = AUDIO_I2S_PORTS > 1 ? (i2s_port_t)port : I2S_NUM_AUTO,
+        .role = role,
+        .dma_desc_num = AUDIO_DMA_DESC_NUM,
+        .dma_frame_num = AUDIO_DMA_FRAME_NUM,
         .auto_clear = false,
     };
-    result = i2s_new_channel(&rx_chan_cfg, NULL, &ctx.i2s_chan_rx_handle);
+    i2s_chan_handle_t* tx_handle = NULL;
+#if CONFIG_AUDIO_PLAYBACK
+    if (port == 0) {
+        tx_handle = &ctx.i2s_chan_tx_handle;
+    }
+#endif
+    result = i2s_new_channel(&rx_chan_cfg, tx_handle, &ctx.i2s_chan_rx_handle[port]);
     if (result != ESP_OK) {
-        i2s_del_channel(ctx.i2s_chan_rx_handle);
+        i2s_del_channel(ctx.i2s_chan_rx_handle[port]);
         return result;
     }
 
+#if CONFIG_AUDIO_I2S_TDM
+    i2s_tdm_config_t i2s_cfg = {
+        .clk_cfg = tdm_clk_config(ctx.audio_config.i2s_sample_rate),
+        .slot_cfg = I2S_TDM_PHILIPS_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_32BIT, I2S_SLOT_MODE_STEREO, I2S_TDM_SLOT_MASK),
+        .gpio_cfg = {
+            .mclk = I2S_GPIO_UNUSED,
+            .bclk = I2S_BCLK_IO,
+            .ws = I2S_LRCLK_IO,
+            .dout = I2S_GPIO_UNUSED,
+            .din = din,
+            .invert_flags = {
+                .mclk_inv = false,
+                .bclk_inv = false,
+                .ws_inv = false,
+            },
+        },
+    };
+    result = I2S_CHANNEL_INIT_MODE(ctx.i2s_chan_rx_handle[port], &i2s_cfg);
+    ESP_LOGI(TAG, "Port %d: TDM capture, %d slots", port, AUDIO_I2S_PORT_SLOTS);
+#else
     i2s_std_config_t i2s_cfg = {
-        .clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(48000),
+        .clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(ctx.audio_config.i2s_sample_rate),
         .slot_cfg = {
             .data_bit_width = I2S_DATA_BIT_WIDTH_32BIT,
             .slot_bit_width = I2S_SLOT_BIT_WIDTH_32BIT,
@@ -116,7 +363,7 @@ esp_err_t i2s_init(audio_config_t* audio_cfg)
             .bclk = I2S_BCLK_IO,
             .ws = I2S_LRCLK_IO,
             .dout = I2S_GPIO_UNUSED,
-            .din = I2S_ADC_DATA_IO,
+            .din = din,
             .invert_flags = {
                 .mclk_inv = false,
                 .bclk_inv = false,
@@ -124,61 +371,231 @@ esp_err_t i2s_init(audio_config_t* audio_cfg)
             },
         },
     };
-    result = i2s_channel_init_std_mode(ctx.i2s_chan_rx_handle, &i2s_cfg);
+    result = I2S_CHANNEL_INIT_MODE(ctx.i2s_chan_rx_handle[port], &i2s_cfg);
+#endif
 
-    i2s_event_callbacks_t cbs = {
-        .on_recv_q_ovf = i2s_rx_q_ovf
-    };
-    esp_err_t ovf_monitor = i2s_channel_register_event_callback(ctx.i2s_chan_rx_handle, &cbs, NULL);
-    if (ovf_monitor == ESP_OK) {
-        ESP_LOGI(TAG, "I2S DMA overflow monitoring registered");
+#if CONFIG_AUDIO_PLAYBACK
+    if (result == ESP_OK && tx_handle != NULL) {
+        i2s_cfg.gpio_cfg.din = I2S_GPIO_UNUSED;
+        i2s_cfg.gpio_cfg.dout = I2S_DAC_DATA_IO;
+        result = I2S_CHANNEL_INIT_MODE(*tx_handle, &i2s_cfg);
     }
+    if (result == ESP_OK && tx_handle != NULL) {
+        i2s_event_callbacks_t tx_cbs = {
+            .on_sent = i2s_tx_callback,
+        };
+        result = i2s_channel_register_event_callback(*tx_handle, &tx_cbs, NULL);
+    }
+#endif
 
     return result;
 }
 
-esp_err_t i2s_deinit(void)
+esp_err_t i2s_init(audio_config_t* audio_cfg)
 {
     esp_err_t result = ESP_FAIL;
-    result = i2s_del_channel(ctx.i2s_chan_rx_handle);
+
+    ctx.audio_config = *audio_cfg;
+
+    if (ctx.audio_config.ring == NULL) {
+        ESP_LOGE(TAG, "Audio ring NULL");
+        return ESP_FAIL;
+    }
+
+    /* Make sure a valid Audio format has been set */
+    if (ctx.audio_config.audio_format == PCM_FORMAT_UNKNOWN) {
+        return ESP_FAIL;
+    }
+
+#if CONFIG_AUDIO_I2S_DUAL
+    /*
+     * The slave connects BCLK and WS as inputs first. Setting up the master
+     * afterwards turns the same pads into outputs, which clears their input
+     * enable, so that is restored once both ports are configured.
+     */
+    ESP_RETURN_ON_ERROR(init_port(1, I2S_ROLE_SLAVE, I2S_ADC2_DATA_IO), TAG, "Failed to set up port 1");
+#endif
+    result = init_port(0, I2S_ROLE_MASTER, I2S_ADC_DATA_IO);
+    if (result == ESP_OK) {
+        i2s_chan_info_t info;
+        result = i2s_channel_get_info(ctx.i2s_chan_rx_handle[0], &info);
+        ctx.hw = result == ESP_OK ? I2S_LL_GET_HW(info.id) : NULL;
+    }
+#if CONFIG_AUDIO_I2S_DUAL
+    if (result == ESP_OK) {
+        gpio_input_enable(I2S_BCLK_IO);
+        gpio_input_enable(I2S_LRCLK_IO);
+        result = i2s_align_init(ctx.audio_config.i2s_sample_rate);
+    }
+#endif
+
+    return result;
+}
+
+esp_err_t i2s_deinit(void)
+{
+    esp_err_t result = ESP_OK;
+    ctx.hw = NULL;
+    for (int port = 0; port < AUDIO_I2S_PORTS; port++) {
+        esp_err_t ret = i2s_del_channel(ctx.i2s_chan_rx_handle[port]);
+        result = result != ESP_OK ? result : ret;
+    }
+#if CONFIG_AUDIO_PLAYBACK
+    esp_err_t ret = i2s_del_channel(ctx.i2s_chan_tx_handle);
+    result = result != ESP_OK ? result : ret;
+#endif
+    return result;
+}
+
+/**
+ * @brief Start every port, the slaves first so they see the master's first frame
+ *
+ * Playback starts right before capture on the same controller, so the two
+ * DMA streams start within a few frames of each other.
+ */
+static esp_err_t enable_ports(void)
+{
+    atomic_store_explicit(&ctx.restarted, true, memory_order_release);
+#if CONFIG_AUDIO_PLAYBACK
+    preload_silence();
+    ESP_RETURN_ON_ERROR(i2s_channel_enable(ctx.i2s_chan_tx_handle), TAG, "Failed to enable playback");
+#endif
+    for (int port = AUDIO_I2S_PORTS - 1; port >= 0; port--) {
+        ESP_RETURN_ON_ERROR(i2s_channel_enable(ctx.i2s_chan_rx_handle[port]), TAG, "Failed to enable port %d", port);
+    }
+#if CONFIG_AUDIO_I2S_DUAL
+    i2s_align_reset(ctx.audio_config.i2s_sample_rate);
+#endif
+    return ESP_OK;
+}
+
+static esp_err_t disable_ports(void)
+{
+    esp_err_t result = ESP_OK;
+    for (int port = 0; port < AUDIO_I2S_PORTS; port++) {
+        esp_err_t ret = i2s_channel_disable(ctx.i2s_chan_rx_handle[port]);
+        result = result != ESP_OK ? result : ret;
+    }
+#if CONFIG_AUDIO_PLAYBACK
+    esp_err_t ret = i2s_channel_disable(ctx.i2s_chan_tx_handle);
+    result = result != ESP_OK ? result : ret;
+#endif
     return result;
 }
 
 esp_err_t i2s_enable_clk(void)
 {
-    esp_err_t ret = ESP_FAIL;
     ESP_LOGI(TAG, "Enabling I2S clock");
-    ret = i2s_channel_enable(ctx.i2s_chan_rx_handle);
-    return ret;
+    return enable_ports();
 }
 
 esp_err_t i2s_disable_clk(void)
 {
-    esp_err_t ret = ESP_OK;
     ESP_LOGI(TAG, "Disabling I2S clock");
-    ret = i2s_channel_disable(ctx.i2s_chan_rx_handle);
-    return ret;
+    return disable_ports();
 }
 
-esp_err_t i2s_read(uint8_t* audio_data, size_t* bytes_read)
+esp_err_t i2s_set_sample_rate(uint32_t sample_rate)
 {
-    return i2s_channel_read(
-        ctx.i2s_chan_rx_handle,
-        audio_data,
-        ctx.audio_config.i2s_dma_size,
-        bytes_read,
-        pdMS_TO_TICKS(I2S_READ_TIMEOUT_MS));
+    esp_err_t ret = ESP_FAIL;
+#if CONFIG_AUDIO_I2S_TDM
+    i2s_tdm_clk_config_t clk_cfg = tdm_clk_config(sample_rate);
+#else
+    i2s_std_clk_config_t clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(sample_rate);
+#endif
+
+    ESP_LOGI(TAG, "Changing sample rate to %" PRIu32 " Hz", sample_rate);
+    ret = disable_ports();
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    for (int port = 0; port < AUDIO_I2S_PORTS && ret == ESP_OK; port++) {
+        ret = I2S_CHANNEL_RECONFIG_CLOCK(ctx.i2s_chan_rx_handle[port], &clk_cfg);
+    }
+#if CONFIG_AUDIO_PLAYBACK
+    if (ret == ESP_OK) {
+        ret = I2S_CHANNEL_RECONFIG_CLOCK(ctx.i2s_chan_tx_handle, &clk_cfg);
+    }
+#endif
+    if (ret == ESP_OK) {
+        ctx.audio_config.i2s_sample_rate = sample_rate;
+    }
+
+    /* Restart even if the new rate was rejected, so capture continues at the old rate */
+    esp_err_t enable_ret = enable_ports();
+    return ret != ESP_OK ? ret : enable_ret;
+}
+
+esp_err_t i2s_trim_clk_ppm(float ppm)
+{
+    i2s_dev_t* hw = ctx.hw;
+    if (hw == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    /*
+     * The driver has no API for a fine rate change, so the RX MCLK divider is
+     * rewritten directly, without going through the driver and its channel
+     * mutex: this is called from the USB task and must not block. BCLK and WS are derived from MCLK and follow along,
+     * and with them a slave port. In full duplex the pins carry the TX clock,
+     * so with playback both dividers are trimmed.
+     * The fractional divider only approximates the requested frequency; the
+     * steering loop's integrator averages out the quantization.
+     */
+    uint32_t mclk = (uint32_t)((double)ctx.audio_config.i2s_sample_rate * I2S_MCLK_MULTIPLE * (1.0 + ppm * 1e-6));
+
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 2, 0)
+    hal_utils_clk_info_t clk_info = {
+        .src_freq_hz = I2S_SCLK_HZ,
+        .exp_freq_hz = mclk,
+        .max_integ = I2S_LL_CLK_FRAC_DIV_N_MAX,
+        .min_integ = 1,
+        .max_fract = I2S_LL_CLK_FRAC_DIV_AB_MAX,
+    };
+    hal_utils_clk_div_t mclk_div = { 0 };
+    hal_utils_calc_clk_div_frac_accurate(&clk_info, &mclk_div);
+    i2s_ll_rx_set_mclk(hw, &mclk_div);
+#if CONFIG_AUDIO_PLAYBACK
+    i2s_ll_tx_set_mclk(hw, &mclk_div);
+#endif
+#else
+    i2s_ll_rx_set_mclk(hw, I2S_SCLK_HZ, mclk, I2S_SCLK_HZ / mclk);
+#if CONFIG_AUDIO_PLAYBACK
+    i2s_ll_tx_set_mclk(hw, I2S_SCLK_HZ, mclk, I2S_SCLK_HZ / mclk);
+#endif
+#endif
+    return ESP_OK;
 }
 
 esp_err_t i2s_enable_async_read(void)
 {
+#if CONFIG_AUDIO_PROCESS_IN_TASK
+    if (ctx.process_task == NULL) {
+        BaseType_t ret = xTaskCreatePinnedToCore(i2s_process_task, "i2s process task", I2S_PROCESS_TASK_STACK, NULL,
+            CONFIG_AUDIO_PROCESS_TASK_PRIORITY, &ctx.process_task, CONFIG_AUDIO_PROCESS_TASK_CORE);
+        if (ret != pdPASS) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+#endif
+
+    /*
+     * Blocks are taken in on_recv, never through i2s_channel_read(), so the
+     * driver's message queue fills up and would report a queue overflow for
+     * every block. Overflows are detected on the block queue instead.
+     */
     i2s_event_callbacks_t cbs = {
         .on_recv = i2s_rx_callback,
         .on_recv_q_ovf = NULL,
         .on_send_q_ovf = NULL,
         .on_sent = NULL
     };
-    return i2s_channel_register_event_callback(ctx.i2s_chan_rx_handle, &cbs, NULL);
+    for (int port = 0; port < AUDIO_I2S_PORTS; port++) {
+        ESP_RETURN_ON_ERROR(i2s_channel_register_event_callback(ctx.i2s_chan_rx_handle[port], &cbs, (void*)(intptr_t)port),
+            TAG, "Failed to register port %d", port);
+    }
+    return ESP_OK;
 }
 
 esp_err_t i2s_disable_async_read(void)
@@ -186,7 +603,11 @@ esp_err_t i2s_disable_async_read(void)
     i2s_event_callbacks_t cbs = {
         .on_recv = NULL,
     };
-    return i2s_channel_register_event_callback(ctx.i2s_chan_rx_handle, &cbs, NULL);
+    for (int port = 0; port < AUDIO_I2S_PORTS; port++) {
+        ESP_RETURN_ON_ERROR(i2s_channel_register_event_callback(ctx.i2s_chan_rx_handle[port], &cbs, NULL),
+            TAG, "Failed to unregister port %d", port);
+    }
+    return ESP_OK;
 }
 
 void i2s_monitor_task(void* pvParam)
@@ -44,11 +44,23 @@ esp_err_t i2s_enable_clk(void);
 esp_err_t i2s_disable_clk(void);
 
 /**
- * @brief Blocking read of audio data from the DMA buffers
+ * @brief Change the capture sample rate. The channel is briefly stopped while the clock is reprogrammed.
  *
- * @return esp_err_t
+ * @param sample_rate new rate in Hz
+ * @return ESP_OK on success, error from the I2S driver otherwise
  */
-esp_err_t i2s_read(uint8_t* audio_data, size_t* bytes_read);
+esp_err_t i2s_set_sample_rate(uint32_t sample_rate);
+
+/**
+ * @brief Fine-tune the capture clock without stopping the channel
+ *
+ * Only writes the clock divider registers, so it never blocks and may be
+ * called from the USB task.
+ *
+ * @param ppm deviation from the nominal sample rate, positive is faster
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE before i2s_init()
+ */
+esp_err_t i2s_trim_clk_ppm(float ppm);
 
 /**
  * @brief 
@@ -0,0 +1,241 @@
+/**
+ * @file i2s_align.c
+ * @author your name (you@domain.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include "i2s_align.h"
+
+#include "sdkconfig.h"
+
+#if CONFIG_AUDIO_I2S_DUAL
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "audio_pipeline/audio_pipeline.h"
+#include "audio_pipeline/rt_log.h"
+#include "audio_pipeline/latency.h"
+#include "audio_pipeline/telemetry.h"
+#include "audio_pipeline/audio_arena.h"
+
+#define FIFO_FRAMES AUDIO_ALIGN_FIFO_FRAMES
+#define SLIP_FRAMES (AUDIO_DMA_FRAME_NUM / 2) // Head offset that counts as lost alignment, well above timestamp jitter
+#define FRAME_BYTES (AUDIO_I2S_PORT_SLOTS * sizeof(int32_t))
+
+_Static_assert(AUDIO_I2S_PORTS == 2, "Port alignment needs both I2S controllers");
+
+typedef struct {
+    int32_t* fifo[AUDIO_I2S_PORTS]; // Oldest frame first
+    size_t fill[AUDIO_I2S_PORTS]; // Frames
+    int64_t end_us[AUDIO_I2S_PORTS]; // Capture time of the newest queued frame, 0 if none since the last reset
+    int32_t* merged; // Up to one block of merged frames
+    int64_t merged_us; // Capture time of the last merged frame, 0 if none since the last reset
+    uint32_t sample_rate;
+    bool locked;
+    atomic_bool reset_pending;
+    atomic_uint sample_rate_pending;
+} align_ctx_t;
+
+static align_ctx_t ctx = { 0 };
+
+esp_err_t i2s_align_init(uint32_t sample_rate)
+{
+    static const char* const fifo_names[AUDIO_I2S_PORTS] = { "align fifo 0", "align fifo 1" };
+
+    for (int port = 0; port < AUDIO_I2S_PORTS; port++) {
+        ctx.fifo[port] = audio_arena_alloc(fifo_names[port], FIFO_FRAMES * FRAME_BYTES);
+        if (ctx.fifo[port] == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    ctx.merged = audio_arena_alloc("align merged", AUDIO_DMA_FRAME_NUM * AUDIO_I2S_SLOTS * sizeof(int32_t));
+    if (ctx.merged == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    ctx.sample_rate = sample_rate;
+    atomic_init(&ctx.sample_rate_pending, sample_rate);
+    atomic_init(&ctx.reset_pending, false);
+    return ESP_OK;
+}
+
+void i2s_align_reset(uint32_t sample_rate)
+{
+    atomic_store_explicit(&ctx.sample_rate_pending, sample_rate, memory_order_relaxed);
+    atomic_store_explicit(&ctx.reset_pending, true, memory_order_release);
+}
+
+static void unlock(void)
+{
+    for (int port = 0; port < AUDIO_I2S_PORTS; port++) {
+        ctx.fill[port] = 0;
+        ctx.end_us[port] = 0;
+    }
+    ctx.locked = false;
+}
+
+static void drop(int port, size_t frames)
+{
+    ctx.fill[port] -= frames;
+    memmove(ctx.fifo[port], ctx.fifo[port] + frames * AUDIO_I2S_PORT_SLOTS, ctx.fill[port] * FRAME_BYTES);
+}
+
+static void append(int port, const int32_t* slots, size_t frames)
+{
+    /* Only while waiting for the other port to start: keep the newest frames */
+    if (ctx.fill[port] + frames > FIFO_FRAMES) {
+        drop(port, ctx.fill[port] + frames - FIFO_FRAMES);
+    }
+    memcpy(ctx.fifo[port] + ctx.fill[port] * AUDIO_I2S_PORT_SLOTS, slots, frames * FRAME_BYTES);
+    ctx.fill[port] += frames;
+}
+
+/**
+ * @brief Frames the oldest queued frame of port 0 was captured before port 1's
+ *
+ * Derived from the capture times of the newest frames. Accurate to a frame
+ * as long as the interrupt latency jitter between the ports stays below half
+ * a frame period.
+ */
+static int32_t head_offset(void)
+{
+    int64_t dt_us = ctx.end_us[1] - ctx.end_us[0];
+    int32_t phase = (int32_t)((dt_us * ctx.sample_rate + (dt_us >= 0 ? 500000 : -500000)) / 1000000);
+
+    return phase + (int32_t)ctx.fill[0] - (int32_t)ctx.fill[1];
+}
+
+/**
+ * @brief Capture time of a queued frame
+ *
+ */
+static int64_t frame_us(int port, size_t index)
+{
+    return ctx.end_us[port] - (int64_t)(ctx.fill[port] - 1 - index) * 1000000 / ctx.sample_rate;
+}
+
+/**
+ * @brief Fill the frames lost between the last merged frame and the new head of port 0
+ *
+ */
+static void fill_gap(void)
+{
+    if (ctx.merged_us == 0) {
+        return;
+    }
+    int64_t dt_us = frame_us(0, 0) - ctx.merged_us;
+    int64_t gap = (dt_us * ctx.sample_rate + 500000) / 1000000 - 1;
+    if (gap > 0) {
+        audio_pipeline_write_gap(gap);
+    }
+}
+
+/**
+ * @brief Align the FIFO heads by dropping the leading port's surplus
+ *
+ */
+static bool try_lock(void)
+{
+    if (ctx.fill[0] == 0 || ctx.fill[1] == 0) {
+        return false;
+    }
+
+    int32_t lead = head_offset();
+    int port = lead > 0 ? 0 : 1;
+    size_t surplus = lead > 0 ? lead : -lead;
+
+    if (surplus >= ctx.fill[port]) {
+        /* No overlap yet, wait for the next block of the lagging port */
+        ctx.fill[port] = 0;
+        return false;
+    }
+    drop(port, surplus);
+    fill_gap();
+
+    ctx.locked = true;
+    telemetry_record_port_lock(lead);
+    return true;
+}
+
+static void merge(void)
+{
+    size_t frames = ctx.fill[0] < ctx.fill[1] ? ctx.fill[0] : ctx.fill[1];
+    if (frames == 0) {
+        return;
+    }
+
+    bool written = false;
+    for (size_t done = 0; done < frames;) {
+        size_t n = frames - done < AUDIO_DMA_FRAME_NUM ? frames - done : AUDIO_DMA_FRAME_NUM;
+        const int32_t* a = ctx.fifo[0] + done * AUDIO_I2S_PORT_SLOTS;
+        const int32_t* b = ctx.fifo[1] + done * AUDIO_I2S_PORT_SLOTS;
+        int32_t* out = ctx.merged;
+
+        for (size_t i = 0; i < n; i++) {
+            for (int s = 0; s < AUDIO_I2S_PORT_SLOTS; s++) {
+                *out++ = *a++;
+            }
+            for (int s = 0; s < AUDIO_I2S_PORT_SLOTS; s++) {
+                *out++ = *b++;
+            }
+        }
+        written = audio_pipeline_write_capture(ctx.merged, n * AUDIO_I2S_SLOTS);
+        done += n;
+    }
+    ctx.merged_us = frame_us(0, frames - 1);
+    if (written) {
+        latency_mark_capture(ctx.merged_us);
+    }
+
+    drop(0, frames);
+    drop(1, frames);
+}
+
+void i2s_align_mark_gap(void)
+{
+    if (ctx.locked) {
+        telemetry_record_port_slip();
+        rt_log(RT_LOG_PORT_SLIP, 0, 0, 0);
+        unlock();
+    }
+}
+
+void i2s_align_push(int port, const int32_t* slots, size_t frames, int64_t end_us)
+{
+    if (atomic_exchange_explicit(&ctx.reset_pending, false, memory_order_acquire)) {
+        ctx.sample_rate = atomic_load_explicit(&ctx.sample_rate_pending, memory_order_relaxed);
+        ctx.merged_us = 0;
+        unlock();
+    }
+
+    if (frames > AUDIO_DMA_FRAME_NUM) {
+        frames = AUDIO_DMA_FRAME_NUM;
+    }
+    append(port, slots, frames);
+    ctx.end_us[port] = end_us;
+
+    if (ctx.locked && ctx.fill[0] > 0 && ctx.fill[1] > 0) {
+        /* Aligned heads stay aligned unless a block went missing or the clocks differ */
+        int32_t offset = head_offset();
+        if (offset > SLIP_FRAMES || offset < -SLIP_FRAMES) {
+            telemetry_record_port_slip();
+            rt_log(RT_LOG_PORT_SLIP, (uint32_t)offset, 0, 0);
+            unlock();
+            return;
+        }
+    }
+
+    if (!ctx.locked && !try_lock()) {
+        return;
+    }
+
+    merge();
+}
+
+#endif
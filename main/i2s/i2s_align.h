@@ -0,0 +1,68 @@
+/**
+ * @file i2s_align.h
+ * @author your name (you@domain.com)
+ * @brief Frame-aligned merging of the two I2S ports
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * Both controllers run on the same BCLK and WS, so they capture the same
+ * frames, but their DMA blocks complete at different points in the stream
+ * depending on when each channel was started. Every port's blocks are queued
+ * in a FIFO stamped with the capture time of the newest frame. Once both
+ * ports have delivered a block, the timestamps give the offset between the
+ * streams in frames; the leading port's surplus frames are dropped and from
+ * then on frames are merged pairwise, port 0 slots first.
+ *
+ * With a shared clock the FIFO levels can only differ by less than two
+ * blocks. Anything more means a block was lost on one port or the ports are
+ * not clocked together; that is counted as a slip and the ports are aligned
+ * again from the next blocks. The frames skipped while aligning again are
+ * filled with concealment, judged from the capture times, so the merged
+ * stream keeps its timeline to within a frame.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "config/audio_config.h"
+#include "esp_err.h"
+
+/**
+ * @brief Allocate the port FIFOs
+ *
+ * @param sample_rate capture rate in Hz, converts timestamps to frames
+ */
+esp_err_t i2s_align_init(uint32_t sample_rate);
+
+/**
+ * @brief Drop queued frames and align the ports again from the next blocks
+ *
+ * Call whenever the channels are restarted. Safe from any task, takes effect
+ * at the next i2s_align_push().
+ *
+ * @param sample_rate capture rate in Hz from now on
+ */
+void i2s_align_reset(uint32_t sample_rate);
+
+/**
+ * @brief Blocks went missing on a port: align again and fill the frames lost
+ *
+ * Needed when both ports lost the same blocks, which leaves their offset
+ * unchanged. Must be called from the same task as i2s_align_push().
+ */
+void i2s_align_mark_gap(void);
+
+/**
+ * @brief Queue one captured block and pass every frame both ports have delivered to the pipeline
+ *
+ * Must be called from a single task, the pipeline's producer.
+ *
+ * @param port 0 or 1
+ * @param slots interleaved 32-bit I2S words, AUDIO_I2S_PORT_SLOTS per frame
+ * @param frames number of frames, at most AUDIO_DMA_FRAME_NUM
+ * @param end_us esp_timer time at which the last frame of the block was captured
+ */
+void i2s_align_push(int port, const int32_t* slots, size_t frames, int64_t end_us);
@@ -6,28 +6,49 @@
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "freertos/stream_buffer.h"
 
+#include "audio_source/audio_source.h"
 #include "i2s/i2s.h"
 #include "usb/usb.h"
 #include "usb/usb_audio.h"
+#include "usb/cdc_tap.h"
 #include "config/audio_config.h"
+#include "audio_pipeline/audio_arena.h"
 #include "audio_pipeline/audio_pipeline.h"
+#include "audio_pipeline/playback.h"
+#include "audio_pipeline/rt_log.h"
+#include "audio_pipeline/telemetry.h"
 
 
 void app_main(void)
 {
+    rt_log_init();
     usb_init();
     
-    audio_config_t audio_config = create_audio_config(PCM_FORMAT_32BIT);
+    audio_config_t audio_config = create_audio_config(PCM_FORMAT_32BIT, SAMPLE_RATE);
     ESP_ERROR_CHECK(audio_pipeline_init(&audio_config));
     
+    xTaskCreate(rt_log_task, "rt log task", 3072, NULL, 1, NULL);
+    xTaskCreate(audio_pipeline_monitor_task, "pipeline mon task", 3072, NULL, 1, NULL);
+#if CONFIG_AUDIO_SOURCE_I2S
     xTaskCreate(i2s_monitor_task, "i2s mon task", 4096, NULL, 1, NULL);
+#endif
+#if CONFIG_AUDIO_TELEMETRY_REPORT
+    xTaskCreate(telemetry_report_task, "telemetry task", 3072, NULL, 1, NULL);
+#endif
+#if CONFIG_AUDIO_TAP
+    ESP_ERROR_CHECK(cdc_tap_init());
+    xTaskCreate(cdc_tap_task, "cdc tap task", 3072, NULL, 1, NULL);
+#endif
+#if CONFIG_AUDIO_PLAYBACK
+    ESP_ERROR_CHECK(playback_init(audio_config.sample_rate));
+#endif
     
-    ESP_ERROR_CHECK(i2s_init(&audio_config));
-    ESP_ERROR_CHECK(i2s_enable_async_read());
-    ESP_ERROR_CHECK(i2s_enable_clk());
+    ESP_ERROR_CHECK(audio_source_init(&audio_config));
+    ESP_ERROR_CHECK(audio_source_start());
     ESP_ERROR_CHECK(usb_audio_start(&audio_config));
 
-    // xTaskCreate(audio_pipeline_task, "pipeline task", 4096, NULL, 6, NULL);
+    /* Every audio buffer exists now, nothing on the audio path allocates from here on */
+    audio_arena_seal();
+    audio_arena_log_budget();
 }
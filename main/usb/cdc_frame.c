@@ -0,0 +1,128 @@
+/**
+ * @file cdc_frame.c
+ * @author your name (you@domain.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include "cdc_frame.h"
+
+#include <string.h>
+
+uint16_t cdc_frame_crc16(uint16_t crc, const uint8_t* data, size_t len)
+{
+    while (len--) {
+        crc ^= (uint16_t)(*data++) << 8;
+        for (int i = 0; i < 8; i++) {
+            crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+void cdc_frame_parser_reset(cdc_frame_parser_t* parser)
+{
+    parser->state = CDC_PARSE_SYNC;
+    parser->idx = 0;
+}
+
+static void deliver(cdc_frame_parser_t* parser, cdc_frame_handler_t handler, void* arg)
+{
+    uint16_t crc = cdc_frame_crc16(0xFFFF, parser->header, sizeof(parser->header));
+    crc = cdc_frame_crc16(crc, parser->payload, parser->len);
+
+    if (crc != (parser->crc[0] | (parser->crc[1] << 8))) {
+        parser->crc_errors++;
+        return;
+    }
+
+    cdc_frame_t frame = {
+        .type = parser->header[0],
+        .seq = parser->header[1],
+        .len = parser->len,
+        .payload = parser->payload,
+    };
+    parser->frames++;
+    handler(&frame, arg);
+}
+
+void cdc_frame_parse(cdc_frame_parser_t* parser, const uint8_t* data, size_t len, cdc_frame_handler_t handler, void* arg)
+{
+    const uint8_t* end = data + len;
+
+    while (data < end) {
+        size_t n;
+
+        switch (parser->state) {
+        case CDC_PARSE_SYNC:
+            if (*data++ == CDC_FRAME_SOF) {
+                parser->state = CDC_PARSE_HEADER;
+                parser->idx = 0;
+            } else {
+                parser->dropped_bytes++;
+            }
+            break;
+
+        case CDC_PARSE_HEADER:
+            parser->header[parser->idx++] = *data++;
+            if (parser->idx == sizeof(parser->header)) {
+                parser->len = parser->header[2] | (parser->header[3] << 8);
+                parser->idx = 0;
+                if (parser->len > CDC_FRAME_MAX_PAYLOAD) {
+                    parser->length_errors++;
+                    parser->state = CDC_PARSE_SYNC;
+                } else {
+                    parser->state = parser->len ? CDC_PARSE_PAYLOAD : CDC_PARSE_CRC;
+                }
+            }
+            break;
+
+        case CDC_PARSE_PAYLOAD:
+            n = parser->len - parser->idx;
+            if (n > (size_t)(end - data)) {
+                n = end - data;
+            }
+            memcpy(parser->payload + parser->idx, data, n);
+            parser->idx += n;
+            data += n;
+            if (parser->idx == parser->len) {
+                parser->idx = 0;
+                parser->state = CDC_PARSE_CRC;
+            }
+            break;
+
+        case CDC_PARSE_CRC:
+            parser->crc[parser->idx++] = *data++;
+            if (parser->idx == CDC_FRAME_CRC_SIZE) {
+                deliver(parser, handler, arg);
+                cdc_frame_parser_reset(parser);
+            }
+            break;
+        }
+    }
+}
+
+size_t cdc_frame_encode(uint8_t type, uint8_t seq, const uint8_t* payload, size_t len, uint8_t* out, size_t out_size)
+{
+    size_t size = CDC_FRAME_HEADER_SIZE + len + CDC_FRAME_CRC_SIZE;
+    if (len > CDC_FRAME_MAX_PAYLOAD || size > out_size) {
+        return 0;
+    }
+
+    out[0] = CDC_FRAME_SOF;
+    out[1] = type;
+    out[2] = seq;
+    out[3] = len & 0xFF;
+    out[4] = len >> 8;
+    if (len) {
+        memcpy(out + CDC_FRAME_HEADER_SIZE, payload, len);
+    }
+
+    uint16_t crc = cdc_frame_crc16(0xFFFF, out + 1, CDC_FRAME_HEADER_SIZE - 1 + len);
+    out[CDC_FRAME_HEADER_SIZE + len] = crc & 0xFF;
+    out[CDC_FRAME_HEADER_SIZE + len + 1] = crc >> 8;
+    return size;
+}
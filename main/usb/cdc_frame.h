@@ -0,0 +1,98 @@
+/**
+ * @file cdc_frame.h
+ * @author your name (you@domain.com)
+ * @brief Framing for the binary control protocol on the CDC port
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * Frame layout, multi-byte fields little-endian:
+ *
+ *   | 0xA5 | type | seq | len (2) | payload (len) | crc16 (2) |
+ *
+ * The CRC is CRC-16/CCITT-FALSE over type, seq, len and payload. A response
+ * carries the request type with CDC_FRAME_RESPONSE set, the same seq, and a
+ * status byte as the first payload byte.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define CDC_FRAME_SOF 0xA5
+#define CDC_FRAME_HEADER_SIZE 5
+#define CDC_FRAME_CRC_SIZE 2
+#define CDC_FRAME_MAX_PAYLOAD 1024
+#define CDC_FRAME_MAX_SIZE (CDC_FRAME_HEADER_SIZE + CDC_FRAME_MAX_PAYLOAD + CDC_FRAME_CRC_SIZE)
+#define CDC_FRAME_RESPONSE 0x80
+
+typedef struct {
+    uint8_t type;
+    uint8_t seq;
+    uint16_t len;
+    const uint8_t* payload;
+} cdc_frame_t;
+
+typedef void (*cdc_frame_handler_t)(const cdc_frame_t* frame, void* arg);
+
+typedef enum {
+    CDC_PARSE_SYNC,
+    CDC_PARSE_HEADER,
+    CDC_PARSE_PAYLOAD,
+    CDC_PARSE_CRC,
+} cdc_parse_state_t;
+
+/**
+ * Streaming parser state. Frames may be split across any number of calls
+ * to cdc_frame_parse(). Nothing is allocated and a frame announcing more
+ * than CDC_FRAME_MAX_PAYLOAD bytes is discarded before its payload is read.
+ */
+typedef struct {
+    cdc_parse_state_t state;
+    uint8_t header[CDC_FRAME_HEADER_SIZE - 1]; // Header without the start of frame byte
+    uint8_t payload[CDC_FRAME_MAX_PAYLOAD];
+    uint8_t crc[CDC_FRAME_CRC_SIZE];
+    uint16_t len;
+    uint16_t idx;
+    uint32_t frames; // Valid frames delivered
+    uint32_t crc_errors;
+    uint32_t length_errors; // Frames announcing more than CDC_FRAME_MAX_PAYLOAD
+    uint32_t dropped_bytes; // Bytes skipped while searching for a start of frame
+} cdc_frame_parser_t;
+
+/**
+ * @brief Reset the parser to search for the next start of frame
+ *
+ */
+void cdc_frame_parser_reset(cdc_frame_parser_t* parser);
+
+/**
+ * @brief Feed received bytes to the parser
+ *
+ * The handler is called once for every complete frame with a valid CRC. The
+ * frame payload points into the parser and is only valid during the call.
+ *
+ * @param parser parser state
+ * @param data received bytes
+ * @param len number of bytes
+ * @param handler called for every valid frame
+ * @param arg passed to the handler
+ */
+void cdc_frame_parse(cdc_frame_parser_t* parser, const uint8_t* data, size_t len, cdc_frame_handler_t handler, void* arg);
+
+/**
+ * @brief Build a frame
+ *
+ * @param out destination buffer
+ * @param out_size size of out, at least len + CDC_FRAME_HEADER_SIZE + CDC_FRAME_CRC_SIZE
+ * @return size of the frame in bytes, or 0 if it does not fit in out_size
+ */
+size_t cdc_frame_encode(uint8_t type, uint8_t seq, const uint8_t* payload, size_t len, uint8_t* out, size_t out_size);
+
+/**
+ * @brief CRC-16/CCITT-FALSE
+ *
+ * @param crc initial value, 0xFFFF for a new checksum
+ */
+uint16_t cdc_frame_crc16(uint16_t crc, const uint8_t* data, size_t len);
@@ -0,0 +1,173 @@
+/**
+ * @file cdc_tap.c
+ * @author your name (you@domain.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include "sdkconfig.h"
+
+#if CONFIG_AUDIO_TAP
+#include "cdc_tap.h"
+
+#include <inttypes.h>
+#include <stdatomic.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "audio_pipeline/audio_pipeline.h"
+#include "audio_pipeline/audio_ring.h"
+#include "audio_pipeline/tap_codec.h"
+#include "cdc_frame.h"
+#include "config/audio_config.h"
+#include "usb_cdc.h"
+
+#define TAP_SEND_TIMEOUT_MS 8 // How long an encoded frame may wait for room in the CDC FIFO
+#define TAP_BLOCK_FRAMES (NUM_CHANNELS > 2 ? TAP_CODEC_MAX_FRAMES * 2 / NUM_CHANNELS : TAP_CODEC_MAX_FRAMES) // Fits one CDC frame
+
+/*
+ * Blocks captured per tick at the highest rate: a record, at most one DMA
+ * block, splits into whole tap blocks and one short one. The budget is twice
+ * that so the task catches up after being held off.
+ */
+#define TAP_FRAMES_PER_TICK AUDIO_DIV_CEIL(MAX_SAMPLE_RATE, configTICK_RATE_HZ)
+#define TAP_BLOCKS_PER_TICK (AUDIO_DIV_CEIL(TAP_FRAMES_PER_TICK, TAP_BLOCK_FRAMES) + AUDIO_DIV_CEIL(TAP_FRAMES_PER_TICK, AUDIO_DMA_FRAME_NUM))
+#define TAP_BUDGET_PER_TICK (2 * TAP_BLOCKS_PER_TICK)
+
+_Static_assert(NUM_CHANNELS <= TAP_CODEC_MAX_CHANNELS, "Tap codec does not support this many channels");
+_Static_assert(TAP_CODEC_MAX_BLOCK_SIZE(TAP_BLOCK_FRAMES, NUM_CHANNELS) <= CDC_FRAME_MAX_PAYLOAD,
+    "Tap block does not fit in a CDC frame");
+_Static_assert((AUDIO_TAP_RING_MS - TAP_SEND_TIMEOUT_MS) * configTICK_RATE_HZ >= 2 * 1000,
+    "Tap ring does not cover two ticks while a frame waits for the CDC port");
+
+typedef struct {
+    audio_ring_t ring;
+    atomic_bool enabled;
+    bool active; // Ring attached to the pipeline
+    uint8_t seq;
+    uint32_t frame_index; // Next frame of the current record
+    uint32_t remaining; // Frames of the current record not yet encoded
+    uint32_t dropped; // Encoded blocks the CDC port had no room for
+    size_t pending_size; // Encoded frame waiting for the CDC port, 0 if none
+    int64_t pending_since_us;
+    int32_t samples[TAP_BLOCK_FRAMES * NUM_CHANNELS];
+    uint8_t block[TAP_CODEC_MAX_BLOCK_SIZE(TAP_BLOCK_FRAMES, NUM_CHANNELS)];
+    uint8_t frame[CDC_FRAME_MAX_SIZE];
+} tap_ctx_t;
+
+static tap_ctx_t ctx = { 0 };
+
+static const char* TAG = "cdc-tap";
+
+esp_err_t cdc_tap_init(void)
+{
+    atomic_init(&ctx.enabled, false);
+    return audio_ring_init(&ctx.ring, AUDIO_TAP_RING_BYTES, "tap ring");
+}
+
+void cdc_tap_enable(bool enable)
+{
+    atomic_store(&ctx.enabled, enable);
+}
+
+/**
+ * @brief Hand the pending frame to the CDC port, or drop it once it has waited TAP_SEND_TIMEOUT_MS
+ *
+ * Never sleeps: a frame the port has no room for is retried at the next tick.
+ *
+ * @return false while the frame is still waiting
+ */
+static bool flush_pending(void)
+{
+    if (ctx.pending_size == 0) {
+        return true;
+    }
+    if (usb_cdc_write_frame(ctx.frame, ctx.pending_size) != ESP_OK) {
+        if (esp_timer_get_time() - ctx.pending_since_us < TAP_SEND_TIMEOUT_MS * 1000) {
+            return false;
+        }
+        ctx.dropped++;
+    }
+    ctx.pending_size = 0;
+    return true;
+}
+
+/**
+ * @brief Encode and send the next block from the tap ring
+ *
+ * @return false when not enough captured audio is available yet
+ */
+static bool encode_next(void)
+{
+    if (!flush_pending()) {
+        return false;
+    }
+
+    if (ctx.remaining == 0) {
+        audio_tap_record_t record;
+        if (audio_ring_fill(&ctx.ring) < sizeof(record)) {
+            return false;
+        }
+        audio_ring_read(&ctx.ring, &record, sizeof(record));
+        ctx.frame_index = record.frame_index;
+        ctx.remaining = record.frames;
+    }
+
+    size_t frames = ctx.remaining < TAP_BLOCK_FRAMES ? ctx.remaining : TAP_BLOCK_FRAMES;
+    size_t bytes = frames * NUM_CHANNELS * sizeof(int32_t);
+
+    /* The producer may still be writing the samples following a record header */
+    if (audio_ring_fill(&ctx.ring) < bytes) {
+        return false;
+    }
+    audio_ring_read(&ctx.ring, ctx.samples, bytes);
+
+    size_t size = tap_codec_encode(ctx.samples, frames, NUM_CHANNELS, ctx.frame_index, ctx.block);
+    ctx.pending_size = cdc_frame_encode(CDC_STREAM_TAP, ctx.seq++, ctx.block, size, ctx.frame, sizeof(ctx.frame));
+    ctx.pending_since_us = esp_timer_get_time();
+    flush_pending();
+
+    ctx.frame_index += frames;
+    ctx.remaining -= frames;
+    return true;
+}
+
+static void set_active(bool active)
+{
+    if (active) {
+        audio_ring_flush(&ctx.ring);
+        ctx.remaining = 0;
+        ctx.pending_size = 0;
+        audio_pipeline_set_tap(&ctx.ring);
+    } else {
+        audio_pipeline_set_tap(NULL);
+    }
+    ctx.active = active;
+    ESP_LOGI(TAG, "Tap %s, %" PRIu32 " blocks dropped so far", active ? "started" : "stopped", ctx.dropped);
+}
+
+void cdc_tap_task(void* pvParam)
+{
+    while (1) {
+        bool enabled = atomic_load(&ctx.enabled);
+        if (enabled != ctx.active) {
+            set_active(enabled);
+        }
+
+        if (!ctx.active) {
+            vTaskDelay(pdMS_TO_TICKS(100));
+            continue;
+        }
+
+        for (int budget = TAP_BUDGET_PER_TICK; budget > 0 && encode_next(); budget--) { }
+        vTaskDelay(1);
+    }
+}
+#endif // CONFIG_AUDIO_TAP
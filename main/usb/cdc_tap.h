@@ -0,0 +1,39 @@
+/**
+ * @file cdc_tap.h
+ * @author your name (you@domain.com)
+ * @brief Lossless raw capture stream on the CDC port
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * Captured blocks are copied to a dedicated ring by the pipeline producer and
+ * compressed by a low-priority task into CDC_STREAM_TAP frames, see
+ * tap_codec.h for the block format. The host detects lost frames from the
+ * frame sequence number and dropped audio from gaps in the block frame index.
+ */
+#pragma once
+
+#include <stdbool.h>
+
+#include "esp_err.h"
+
+/**
+ * @brief Allocate the tap ring
+ *
+ */
+esp_err_t cdc_tap_init(void);
+
+/**
+ * @brief Request the tap task to start or stop streaming
+ *
+ */
+void cdc_tap_enable(bool enable);
+
+/**
+ * @brief Encoder task, runs at low priority and wakes every tick
+ *
+ * Each wake encodes up to twice the blocks captured per tick at the highest
+ * sample rate, so the budget follows configTICK_RATE_HZ.
+ */
+void cdc_tap_task(void* pvParam);
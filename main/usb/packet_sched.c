@@ -0,0 +1,64 @@
+/**
+ * @file packet_sched.c
+ * @author your name (you@domain.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include "packet_sched.h"
+
+#define FILL_FILTER_SHIFT 6 // ~64 ms time constant, well above the 6.7 ms DMA block sawtooth
+#define FILL_HYSTERESIS_FRAMES 8
+#define ADJUST_HOLDOFF_MS 16 // Limits the correction to one frame per 16 ms
+
+void packet_sched_init(packet_sched_t* sched, uint32_t sample_rate)
+{
+    sched->frames_per_ms = sample_rate / 1000;
+    sched->remainder = sample_rate % 1000;
+    sched->accumulator = 0;
+    sched->fill_avg_q8 = sched->target_frames << 8;
+    sched->holdoff = 0;
+}
+
+uint32_t packet_sched_next(packet_sched_t* sched)
+{
+    uint32_t frames = sched->frames_per_ms;
+
+    sched->accumulator += sched->remainder;
+    if (sched->accumulator >= 1000) {
+        sched->accumulator -= 1000;
+        frames++;
+    }
+    return frames;
+}
+
+void packet_sched_set_target(packet_sched_t* sched, uint32_t target_frames)
+{
+    sched->target_frames = target_frames;
+    sched->fill_avg_q8 = target_frames << 8;
+}
+
+uint32_t packet_sched_next_async(packet_sched_t* sched, uint32_t fill_frames)
+{
+    uint32_t frames = packet_sched_next(sched);
+    int32_t delta = (int32_t)(fill_frames << 8) - (int32_t)sched->fill_avg_q8;
+    sched->fill_avg_q8 += delta >> FILL_FILTER_SHIFT;
+
+    if (sched->holdoff > 0) {
+        sched->holdoff--;
+        return frames;
+    }
+
+    uint32_t fill_avg = sched->fill_avg_q8 >> 8;
+    if (fill_avg > sched->target_frames + FILL_HYSTERESIS_FRAMES) {
+        frames++;
+        sched->holdoff = ADJUST_HOLDOFF_MS;
+    } else if (fill_avg + FILL_HYSTERESIS_FRAMES < sched->target_frames) {
+        frames--;
+        sched->holdoff = ADJUST_HOLDOFF_MS;
+    }
+    return frames;
+}
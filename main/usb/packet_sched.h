@@ -0,0 +1,54 @@
+/**
+ * @file packet_sched.h
+ * @author your name (you@domain.com)
+ * @brief Frames-per-packet schedule for 1 ms USB audio packets
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * Rates that are not a multiple of 1 kHz cannot be sent as a fixed number of
+ * frames per packet. The scheduler spreads the remainder over the packets, e.g.
+ * 44.1 kHz is sent as nine packets of 44 frames followed by one of 45.
+ *
+ * In asynchronous mode the device additionally adds or drops one frame in a
+ * packet when the low-pass filtered ring fill level leaves a band around the
+ * target, so the host follows the I2S clock instead of the ring drifting.
+ */
+#pragma once
+
+#include <stdint.h>
+
+typedef struct {
+    uint32_t frames_per_ms; // Whole frames in every packet
+    uint32_t remainder; // Fractional frames per packet, in 1/1000 frame
+    uint32_t accumulator; // Accumulated fractional frames, in 1/1000 frame
+    uint32_t target_frames; // Asynchronous mode: fill level to hold
+    uint32_t fill_avg_q8; // Asynchronous mode: filtered fill level, 24.8 fixed point
+    uint32_t holdoff; // Asynchronous mode: packets until the next adjustment is allowed
+} packet_sched_t;
+
+/**
+ * @brief Set up the schedule for a sample rate
+ *
+ */
+void packet_sched_init(packet_sched_t* sched, uint32_t sample_rate);
+
+/**
+ * @brief Number of frames to send in the next packet
+ *
+ */
+uint32_t packet_sched_next(packet_sched_t* sched);
+
+/**
+ * @brief Set the fill level the asynchronous mode steers towards
+ *
+ */
+void packet_sched_set_target(packet_sched_t* sched, uint32_t target_frames);
+
+/**
+ * @brief Number of frames to send in the next packet, +-1 frame to hold the ring fill level
+ *
+ * @param fill_frames current ring fill level in frames
+ */
+uint32_t packet_sched_next_async(packet_sched_t* sched, uint32_t fill_frames);
@@ -13,6 +13,7 @@
 #include "tusb_tasks.h"
 #include "usb_audio.h"
 #include "usb_cdc.h"
+#include "usb_descriptors.h"
 
 #include "esp_log.h"
 
@@ -32,11 +33,16 @@ void tud_umount_cb(void)
 
 void usb_init(void)
 {
+    int string_count;
+
+    usb_descriptors_init();
+    const char** strings = usb_descriptors_strings(&string_count);
     const tinyusb_config_t tusb_cfg = {
-        .device_descriptor = NULL,
-        .string_descriptor = NULL,
+        .device_descriptor = usb_descriptors_device(),
+        .string_descriptor = strings,
+        .string_descriptor_count = string_count,
         .external_phy = false,
-        .configuration_descriptor = NULL,
+        .configuration_descriptor = usb_descriptors_configuration(),
     };
     tinyusb_driver_install(&tusb_cfg);
 
@@ -8,48 +8,260 @@
  * @copyright Copyright (c) 2023
  *
  */
+#include <inttypes.h>
 #include <stdint.h>
+#include <string.h>
 
 #include "freertos/portmacro.h"
 #include "projdefs.h"
+#include "tusb.h"
 #include "tusb_audio.h"
 #include "usb_audio.h"
+#include "usb_descriptors.h"
 
+#include "audio_pipeline/audio_arena.h"
+#include "audio_pipeline/audio_pipeline.h"
+#include "audio_pipeline/audio_ring.h"
+#include "audio_pipeline/clock_steer.h"
+#include "audio_pipeline/latency.h"
+#include "audio_pipeline/pcm_convert.h"
+#include "audio_pipeline/playback.h"
+#include "audio_pipeline/rt_log.h"
 #include "freertos/FreeRTOS.h"
-#include "freertos/stream_buffer.h"
 
+#include "audio_pipeline/telemetry.h"
+#include "audio_pipeline/volume.h"
+#include "audio_source/audio_source.h"
+#include "packet_sched.h"
+#include "esp_cpu.h"
 #include "esp_log.h"
 
 static const char* TAG = "USB-AUDIO";
 
+/* Sample format of each streaming interface alternate setting. Alt 0 is the zero-bandwidth setting. */
+static const audio_format_t alt_setting_formats[] = {
+    PCM_FORMAT_UNKNOWN,
+    PCM_FORMAT_16BIT,
+    PCM_FORMAT_24BIT_32BIT,
+    PCM_FORMAT_24BIT_IN_32BIT,
+    PCM_FORMAT_32BIT,
+};
+
+static const uint32_t supported_sample_rates[] = { 44100, 48000, 88200, 96000 };
+
+/* Feature Unit volume range in 1/256 dB */
+#define VOLUME_MIN (-96 * 256)
+#define VOLUME_MAX (12 * 256)
+#define VOLUME_RES (256 / 2)
+
 static audio_config_t audio_config;
-static uint8_t* audio_data = NULL;
+static packet_sched_t packet_sched;
+static size_t packet_len; // Bytes in the packet currently being sent
 static size_t audio_bytes_read;
+static audio_pipeline_message_t pipeline_state = PIPELINE_STATE_STOPPED;
+static audio_splice_t splice; // Fade applied to the packet being sent
+static uint32_t stream_frames; // Frames sent since boot, silence included
 static bool usb_audio_stream_running = false;
+static int16_t volume[NUM_CHANNELS + 1]; // Index 0 is the master channel
+static bool mute[NUM_CHANNELS + 1];
+
+#if CONFIG_SIG_GEN_IMPULSE
+#define SCAN_PACKETS true // Calibration looks at every packet, so none is sent straight from the ring
+#else
+#define SCAN_PACKETS false
+#endif
+
+#if CONFIG_USB_AUDIO_ZERO_COPY
+static const uint8_t silence[MAX_AUDIO_BYTES_PER_MS] = { 0 };
+static uint8_t* splice_packet = NULL; // Spliced packets are faded on a copy, not in the ring
+#else
+static uint8_t* audio_data = NULL;
+#endif
+
+/**
+ * @brief Restart the packet schedule, aiming at the fill level of the latency profile from the first packet
+ *
+ */
+static void reset_packet_sched(uint32_t sample_rate)
+{
+    packet_sched_init(&packet_sched, sample_rate);
+#if CONFIG_AUDIO_DRIFT_ASYNC_PACKETS
+    packet_sched_set_target(&packet_sched, audio_pipeline_get_latency_ms() * sample_rate / 1000);
+#endif
+}
+
+static void apply_config(audio_format_t format, uint32_t sample_rate)
+{
+    audio_ring_t* ring = audio_config.ring;
+
+    audio_config = create_audio_config(format, sample_rate);
+    audio_config.ring = ring;
+    reset_packet_sched(sample_rate);
+}
+
+/**
+ * @brief Hold the fill level of the latency profile once streaming (re)starts
+ *
+ */
+static void reset_drift_compensation(void)
+{
+    uint32_t target_frames = audio_pipeline_get_latency_ms() * audio_config.sample_rate / 1000;
+#if CONFIG_AUDIO_DRIFT_CLOCK_STEER
+    clock_steer_reset(target_frames);
+#elif CONFIG_AUDIO_DRIFT_ASYNC_PACKETS
+    packet_sched_set_target(&packet_sched, target_frames);
+#else
+    (void)target_frames;
+#endif
+}
+
+/**
+ * @brief Size the next packet and advance the pipeline state machine
+ *
+ * @return bytes to take from the ring, 0 while prebuffering or recovering
+ */
+static size_t begin_packet(void)
+{
+    size_t fill = audio_ring_fill(audio_config.ring);
+
+#if CONFIG_AUDIO_DRIFT_ASYNC_PACKETS
+    /* The fill level only means something once prebuffering is over, until then packets stay nominal */
+    uint32_t frames = pipeline_state == PIPELINE_STATE_RUNNING
+        ? packet_sched_next_async(&packet_sched, fill / audio_config.audio_bytes_per_frame)
+        : packet_sched_next(&packet_sched);
+#else
+    uint32_t frames = packet_sched_next(&packet_sched);
+#endif
+    packet_len = frames * audio_config.audio_bytes_per_frame;
+
+    audio_pipeline_message_t state = audio_pipeline_update_state(fill, packet_len, &splice);
+    if (state == PIPELINE_STATE_RUNNING && pipeline_state == PIPELINE_STATE_BUFFERING) {
+        reset_drift_compensation();
+    }
+    if (splice.kind == AUDIO_SPLICE_FADE_IN) {
+        telemetry_record_recovery(stream_frames, splice.skipped / audio_config.audio_bytes_per_frame);
+        rt_log(RT_LOG_RECOVERY, stream_frames, splice.skipped / audio_config.audio_bytes_per_frame, 0);
+    }
+    pipeline_state = state;
+    stream_frames += frames;
+
+    if (state == PIPELINE_STATE_RUNNING) {
+        latency_record_packet(&audio_config);
+    }
+
+    return state == PIPELINE_STATE_RUNNING || splice.kind == AUDIO_SPLICE_FADE_OUT ? packet_len : 0;
+}
+
+/**
+ * @brief Fade a packet out where the ring ran dry, or in where streaming resumed
+ *
+ * @param data packet, audio_bytes_read bytes from the ring followed by silence
+ */
+static void apply_splice(uint8_t* data)
+{
+    size_t frames = audio_bytes_read / audio_config.audio_bytes_per_frame;
+    size_t n = frames < AUDIO_SPLICE_FADE_FRAMES ? frames : AUDIO_SPLICE_FADE_FRAMES;
+
+    if (splice.kind == AUDIO_SPLICE_FADE_OUT) {
+        pcm_fade(audio_config.audio_format, data + (frames - n) * audio_config.audio_bytes_per_frame, n, NUM_CHANNELS, false);
+    } else if (splice.kind == AUDIO_SPLICE_FADE_IN) {
+        pcm_fade(audio_config.audio_format, data, n, NUM_CHANNELS, true);
+    }
+}
+
+static void end_packet(esp_cpu_cycle_count_t start)
+{
+    size_t fill = audio_ring_fill(audio_config.ring);
+#if CONFIG_AUDIO_DRIFT_CLOCK_STEER
+    if (pipeline_state == PIPELINE_STATE_RUNNING) {
+        clock_steer_update(fill / audio_config.audio_bytes_per_frame);
+    }
+#endif
+    telemetry_record_packet(fill, audio_bytes_read < packet_len, esp_cpu_get_cycle_count() - start);
+}
+
+#if CONFIG_USB_AUDIO_ZERO_COPY
+/**
+ * @brief Hand ring memory straight to the TinyUSB FIFO, in two pieces if the region wraps
+ *
+ */
+static size_t write_from_ring(size_t len)
+{
+    size_t written = 0;
+
+    while (written < len) {
+        const uint8_t* data;
+        size_t n = audio_ring_peek(audio_config.ring, &data, len - written);
+        if (n == 0) {
+            break;
+        }
+        tud_audio_write(data, n);
+        audio_ring_consume(audio_config.ring, n);
+        written += n;
+    }
+    return written;
+}
+#endif
 
 esp_err_t usb_audio_transfer_data()
 {
     if (usb_audio_stream_running) {
-        tud_audio_write(audio_data, CFG_TUD_AUDIO_EP_SZ_IN);
+#if CONFIG_USB_AUDIO_ZERO_COPY
+        esp_cpu_cycle_count_t start = esp_cpu_get_cycle_count();
+
+        size_t len = begin_packet();
+        if (SCAN_PACKETS || splice.kind != AUDIO_SPLICE_NONE) {
+#if CONFIG_SIG_GEN_IMPULSE
+            /* Read position of the packet's first frame, the latency estimate is taken there */
+            size_t tail = atomic_load_explicit(&audio_config.ring->tail, memory_order_relaxed);
+#endif
+            audio_bytes_read = audio_ring_read(audio_config.ring, splice_packet, len);
+            memset(splice_packet + audio_bytes_read, 0, packet_len - audio_bytes_read);
+            apply_splice(splice_packet);
+#if CONFIG_SIG_GEN_IMPULSE
+            latency_scan_packet(splice_packet, audio_bytes_read / audio_config.audio_bytes_per_frame, tail, &audio_config);
+#endif
+            tud_audio_write(splice_packet, packet_len);
+        } else {
+            audio_bytes_read = write_from_ring(len);
+            if (audio_bytes_read < packet_len) {
+                tud_audio_write(silence, packet_len - audio_bytes_read);
+            }
+        }
+
+        end_packet(start);
+#else
+        tud_audio_write(audio_data, packet_len);
+#endif
     }
     return ESP_OK;
 }
 
 esp_err_t usb_audio_prepare_data()
 {
+#if !CONFIG_USB_AUDIO_ZERO_COPY
     if (usb_audio_stream_running) {
-        audio_bytes_read = xStreamBufferReceive(
-            audio_config.stream_buffer_handle, 
-            (void*)audio_data,
-            audio_config.audio_bytes_per_ms,
-            0);
-        
-        if (audio_bytes_read != audio_config.audio_bytes_per_ms) {
-            ESP_LOGW(TAG, "Expected %lu bytes from StreamBuffer, Sending %zu bytes to USB",
-                audio_config.audio_bytes_per_ms,
-                audio_bytes_read);
+        esp_cpu_cycle_count_t start = esp_cpu_get_cycle_count();
+        size_t len = begin_packet();
+#if CONFIG_SIG_GEN_IMPULSE
+        size_t tail = atomic_load_explicit(&audio_config.ring->tail, memory_order_relaxed);
+#endif
+
+        audio_bytes_read = audio_ring_read(
+            audio_config.ring,
+            audio_data,
+            len);
+        if (audio_bytes_read < packet_len) {
+            memset(audio_data + audio_bytes_read, 0, packet_len - audio_bytes_read);
         }
+        apply_splice(audio_data);
+#if CONFIG_SIG_GEN_IMPULSE
+        latency_scan_packet(audio_data, audio_bytes_read / audio_config.audio_bytes_per_frame, tail, &audio_config);
+#endif
+
+        end_packet(start);
     }
+#endif
     return ESP_OK;
 }
 
@@ -64,20 +276,350 @@ void usb_audio_init()
 
 esp_err_t usb_audio_start(audio_config_t* audio_cfg)
 {
-    esp_err_t ret = ESP_FAIL;
     audio_config = *audio_cfg;
-    audio_data = pvPortMalloc(audio_config.audio_bytes_per_ms);
-    ESP_LOGI(TAG, "Created audio_data buffer of size: %lu", audio_config.audio_bytes_per_ms);
-    if (audio_data != NULL) {
-        usb_audio_stream_running = true;
-        ret = ESP_OK;
+    reset_packet_sched(audio_config.sample_rate);
+
+    /* Sized for the largest packet so format and rate changes never reallocate */
+#if CONFIG_USB_AUDIO_ZERO_COPY
+    if (splice_packet == NULL) {
+        splice_packet = audio_arena_alloc("usb splice", MAX_AUDIO_BYTES_PER_MS);
+        if (splice_packet == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+#else
+    if (audio_data == NULL) {
+        audio_data = audio_arena_alloc("usb staging", MAX_AUDIO_BYTES_PER_MS);
+        if (audio_data == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+        memset(audio_data, 0, MAX_AUDIO_BYTES_PER_MS);
     }
-    memset(audio_data, 0, audio_config.audio_bytes_per_ms);
-    return ret;
+#endif
+
+    audio_pipeline_start();
+    usb_audio_stream_running = true;
+    return ESP_OK;
 }
 
 esp_err_t usb_audio_stop()
 {
     usb_audio_stream_running = false;
+    audio_pipeline_stop();
     return ESP_OK;
 }
+
+esp_err_t usb_audio_set_alt_setting(uint8_t alt)
+{
+    if (alt >= sizeof(alt_setting_formats) / sizeof(alt_setting_formats[0])) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (alt == 0) {
+        return ESP_OK;
+    }
+
+    audio_format_t format = alt_setting_formats[alt];
+
+    apply_config(format, audio_config.sample_rate);
+    ESP_LOGI(TAG, "Alt setting %u: %" PRIu32 " bytes per ms", alt, audio_config.audio_bytes_per_ms);
+
+    return audio_pipeline_set_format(format);
+}
+
+/**
+ * @brief TinyUSB: the host selected an alternate setting of a streaming interface
+ *
+ */
+bool tud_audio_set_itf_cb(uint8_t rhport, tusb_control_request_t const* p_request)
+{
+    (void)rhport;
+    uint8_t itf = TU_U16_LOW(p_request->wIndex);
+    uint8_t alt = TU_U16_LOW(p_request->wValue);
+
+    if (itf == ITF_NUM_AUDIO_STREAMING_IN) {
+        return usb_audio_set_alt_setting(alt) == ESP_OK;
+    }
+#if CONFIG_AUDIO_PLAYBACK
+    if (itf == ITF_NUM_AUDIO_STREAMING_OUT) {
+        return usb_audio_set_playback_alt_setting(alt) == ESP_OK;
+    }
+#endif
+    return false;
+}
+
+#if CONFIG_AUDIO_PLAYBACK
+esp_err_t usb_audio_set_playback_alt_setting(uint8_t alt)
+{
+    if (alt >= sizeof(alt_setting_formats) / sizeof(alt_setting_formats[0])) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (alt == 0) {
+        playback_stop();
+        return ESP_OK;
+    }
+
+    playback_start(alt_setting_formats[alt]);
+    ESP_LOGI(TAG, "Playback alt setting %u, latency %" PRIu32 " frames", alt, playback_get_latency_frames());
+    return ESP_OK;
+}
+
+esp_err_t usb_audio_receive_data(void)
+{
+    static uint8_t packet[MAX_AUDIO_BYTES_PER_MS];
+
+    uint16_t len = tud_audio_read(packet, sizeof(packet));
+    playback_write(packet, len);
+    return ESP_OK;
+}
+
+/**
+ * @brief TinyUSB: a packet arrived on the OUT endpoint
+ *
+ */
+bool tud_audio_rx_done_post_read_cb(uint8_t rhport, uint16_t n_bytes_received, uint8_t func_id, uint8_t ep_out, uint8_t cur_alt_setting)
+{
+    (void)rhport;
+    (void)n_bytes_received;
+    (void)func_id;
+    (void)ep_out;
+    (void)cur_alt_setting;
+    return usb_audio_receive_data() == ESP_OK;
+}
+#endif
+
+esp_err_t usb_audio_set_sample_rate(uint32_t sample_rate)
+{
+    bool supported = false;
+    for (size_t i = 0; i < sizeof(supported_sample_rates) / sizeof(supported_sample_rates[0]); i++) {
+        if (supported_sample_rates[i] == sample_rate && sample_rate <= MAX_SAMPLE_RATE) {
+            supported = true;
+        }
+    }
+    if (!supported) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    if (sample_rate == audio_config.sample_rate) {
+        return ESP_OK;
+    }
+
+#if CONFIG_AUDIO_SRC
+    esp_err_t ret = audio_pipeline_set_output_rate(sample_rate);
+#else
+    esp_err_t ret = audio_source_set_sample_rate(sample_rate);
+    if (ret == ESP_OK) {
+        audio_pipeline_set_capture_rate(sample_rate);
+    }
+#endif
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    apply_config(audio_config.audio_format, sample_rate);
+#if CONFIG_AUDIO_PLAYBACK
+    playback_set_sample_rate(sample_rate);
+#endif
+    ESP_LOGI(TAG, "Sample rate %" PRIu32 " Hz: up to %" PRIu32 " bytes per ms", sample_rate, audio_config.audio_bytes_per_ms);
+
+    /* Drop everything captured at the old rate */
+    return audio_pipeline_flush();
+}
+
+uint32_t usb_audio_get_sample_rate(void)
+{
+    return audio_config.sample_rate;
+}
+
+static size_t put_le(uint8_t* out, uint32_t value, size_t bytes)
+{
+    for (size_t i = 0; i < bytes; i++) {
+        out[i] = (value >> (8 * i)) & 0xFF;
+    }
+    return bytes;
+}
+
+/**
+ * @brief Clock source GET_CUR and GET_RANGE: the current rate, the supported ones, and always valid
+ *
+ */
+static bool get_clock_request(uint8_t rhport, tusb_control_request_t const* p_request)
+{
+    const size_t num_rates = sizeof(supported_sample_rates) / sizeof(supported_sample_rates[0]);
+    uint8_t response[2 + 12 * sizeof(supported_sample_rates) / sizeof(supported_sample_rates[0])];
+    uint8_t control = TU_U16_HIGH(p_request->wValue);
+    size_t len = 0;
+
+    if (control == UAC2_CS_SAM_FREQ_CONTROL && p_request->bRequest == UAC2_REQ_CUR) {
+        len = put_le(response, audio_config.sample_rate, 4);
+    } else if (control == UAC2_CS_SAM_FREQ_CONTROL && p_request->bRequest == UAC2_REQ_RANGE) {
+        /* One discrete subrange per rate: minimum, maximum and a resolution of 0 */
+        uint16_t num_ranges = 0;
+        len = 2;
+        for (size_t i = 0; i < num_rates; i++) {
+            if (supported_sample_rates[i] <= MAX_SAMPLE_RATE) {
+                len += put_le(response + len, supported_sample_rates[i], 4);
+                len += put_le(response + len, supported_sample_rates[i], 4);
+                len += put_le(response + len, 0, 4);
+                num_ranges++;
+            }
+        }
+        put_le(response, num_ranges, 2);
+    } else if (control == UAC2_CS_CLOCK_VALID_CONTROL && p_request->bRequest == UAC2_REQ_CUR) {
+        response[0] = 1;
+        len = 1;
+    } else {
+        return false;
+    }
+    return tud_audio_buffer_and_schedule_control_xfer(rhport, p_request, response, len);
+}
+
+static bool set_clock_request(tusb_control_request_t const* p_request, const uint8_t* data)
+{
+    if (TU_U16_HIGH(p_request->wValue) != UAC2_CS_SAM_FREQ_CONTROL || p_request->bRequest != UAC2_REQ_CUR
+        || p_request->wLength != 4) {
+        return false;
+    }
+    uint32_t sample_rate = data[0] | data[1] << 8 | data[2] << 16 | (uint32_t)data[3] << 24;
+    return usb_audio_set_sample_rate(sample_rate) == ESP_OK;
+}
+
+/**
+ * @brief Push the combined master and channel level of every channel to the pipeline
+ *
+ */
+static void apply_volume(void)
+{
+    for (uint8_t ch = 1; ch <= NUM_CHANNELS; ch++) {
+        int32_t gain = 0;
+        if (!mute[0] && !mute[ch]) {
+            gain = volume_db_q8_to_gain(volume[0] + volume[ch]);
+        }
+        volume_set_gain(ch - 1, gain);
+    }
+}
+
+esp_err_t usb_audio_set_volume(uint8_t channel, int16_t level)
+{
+    if (channel > NUM_CHANNELS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (level < VOLUME_MIN) {
+        level = VOLUME_MIN;
+    } else if (level > VOLUME_MAX) {
+        level = VOLUME_MAX;
+    }
+    volume[channel] = level;
+    apply_volume();
+    return ESP_OK;
+}
+
+int16_t usb_audio_get_volume(uint8_t channel)
+{
+    return channel <= NUM_CHANNELS ? volume[channel] : 0;
+}
+
+void usb_audio_get_volume_range(int16_t* min, int16_t* max, uint16_t* resolution)
+{
+    *min = VOLUME_MIN;
+    *max = VOLUME_MAX;
+    *resolution = VOLUME_RES;
+}
+
+esp_err_t usb_audio_set_mute(uint8_t channel, bool muted)
+{
+    if (channel > NUM_CHANNELS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    mute[channel] = muted;
+    apply_volume();
+    return ESP_OK;
+}
+
+bool usb_audio_get_mute(uint8_t channel)
+{
+    return channel <= NUM_CHANNELS && mute[channel];
+}
+
+/**
+ * @brief Feature unit GET_CUR of mute and volume, GET_RANGE of volume
+ *
+ */
+static bool get_feature_unit_request(uint8_t rhport, tusb_control_request_t const* p_request)
+{
+    uint8_t control = TU_U16_HIGH(p_request->wValue);
+    uint8_t channel = TU_U16_LOW(p_request->wValue);
+    uint8_t response[8];
+    size_t len = 0;
+
+    if (channel > NUM_CHANNELS) {
+        return false;
+    }
+    if (control == UAC2_FU_MUTE_CONTROL && p_request->bRequest == UAC2_REQ_CUR) {
+        response[0] = usb_audio_get_mute(channel);
+        len = 1;
+    } else if (control == UAC2_FU_VOLUME_CONTROL && p_request->bRequest == UAC2_REQ_CUR) {
+        len = put_le(response, (uint16_t)usb_audio_get_volume(channel), 2);
+    } else if (control == UAC2_FU_VOLUME_CONTROL && p_request->bRequest == UAC2_REQ_RANGE) {
+        int16_t min, max;
+        uint16_t resolution;
+        usb_audio_get_volume_range(&min, &max, &resolution);
+        len = put_le(response, 1, 2); // One subrange
+        len += put_le(response + len, (uint16_t)min, 2);
+        len += put_le(response + len, (uint16_t)max, 2);
+        len += put_le(response + len, resolution, 2);
+    } else {
+        return false;
+    }
+    return tud_audio_buffer_and_schedule_control_xfer(rhport, p_request, response, len);
+}
+
+static bool set_feature_unit_request(tusb_control_request_t const* p_request, const uint8_t* data)
+{
+    uint8_t control = TU_U16_HIGH(p_request->wValue);
+    uint8_t channel = TU_U16_LOW(p_request->wValue);
+
+    if (p_request->bRequest != UAC2_REQ_CUR) {
+        return false;
+    }
+    if (control == UAC2_FU_MUTE_CONTROL && p_request->wLength == 1) {
+        return usb_audio_set_mute(channel, data[0] != 0) == ESP_OK;
+    }
+    if (control == UAC2_FU_VOLUME_CONTROL && p_request->wLength == 2) {
+        return usb_audio_set_volume(channel, (int16_t)(data[0] | data[1] << 8)) == ESP_OK;
+    }
+    return false;
+}
+
+/**
+ * @brief TinyUSB: GET request to an entity of the audio function
+ *
+ */
+bool tud_audio_get_req_entity_cb(uint8_t rhport, tusb_control_request_t const* p_request)
+{
+    switch (TU_U16_HIGH(p_request->wIndex)) {
+    case UAC2_ENTITY_CLOCK:
+        return get_clock_request(rhport, p_request);
+    case UAC2_ENTITY_FEATURE_UNIT:
+        return get_feature_unit_request(rhport, p_request);
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief TinyUSB: SET request to an entity of the audio function, its data stage received
+ *
+ */
+bool tud_audio_set_req_entity_cb(uint8_t rhport, tusb_control_request_t const* p_request, uint8_t* pBuff)
+{
+    (void)rhport;
+    switch (TU_U16_HIGH(p_request->wIndex)) {
+    case UAC2_ENTITY_CLOCK:
+        return set_clock_request(p_request, pBuff);
+    case UAC2_ENTITY_FEATURE_UNIT:
+        return set_feature_unit_request(p_request, pBuff);
+    default:
+        return false;
+    }
+}
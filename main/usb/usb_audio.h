@@ -10,6 +10,8 @@
  */
 #pragma once
 
+#include <stdbool.h>
+
 #include "config/audio_config.h"
 #include "esp_err.h"
 
@@ -22,3 +24,92 @@ void usb_audio_init();
 esp_err_t usb_audio_start(audio_config_t* audio_cfg);
 
 esp_err_t usb_audio_stop();
+
+/**
+ * @brief Switch the stream to the sample format of a streaming interface alternate setting
+ *
+ * Alt 1..4 select 16-bit, 24-bit packed, 24-in-32-bit and 32-bit samples,
+ * as listed in usb_descriptors.c. Called from tud_audio_set_itf_cb().
+ *
+ * @param alt alternate setting chosen by the host, 0 is zero-bandwidth
+ * @return ESP_OK, or ESP_ERR_INVALID_ARG for an unknown alternate setting
+ */
+esp_err_t usb_audio_set_alt_setting(uint8_t alt);
+
+#if CONFIG_AUDIO_PLAYBACK
+/**
+ * @brief Start or stop playback for an alternate setting of the OUT streaming interface
+ *
+ * Takes the same alternate settings as usb_audio_set_alt_setting(), as
+ * listed for the OUT streaming interface in usb_descriptors.c. Called from
+ * tud_audio_set_itf_cb().
+ *
+ * @param alt alternate setting chosen by the host, 0 stops playback
+ * @return ESP_OK, or ESP_ERR_INVALID_ARG for an unknown alternate setting
+ */
+esp_err_t usb_audio_set_playback_alt_setting(uint8_t alt);
+
+/**
+ * @brief Take one received packet from the OUT endpoint and queue it for playback
+ *
+ * Called from tud_audio_rx_done_post_read_cb().
+ */
+esp_err_t usb_audio_receive_data(void);
+#endif
+
+/**
+ * @brief Switch capture and streaming to a new sample rate
+ *
+ * Supports 44.1, 48, 88.2 and 96 kHz. Called for a clock source SET_CUR
+ * from tud_audio_set_req_entity_cb().
+ *
+ * @param sample_rate new rate in Hz
+ * @return ESP_OK, ESP_ERR_NOT_SUPPORTED for other rates, or an I2S driver error
+ */
+esp_err_t usb_audio_set_sample_rate(uint32_t sample_rate);
+
+/**
+ * @brief Current sample rate, as the clock source reports it to GET_CUR
+ *
+ */
+uint32_t usb_audio_get_sample_rate(void);
+
+/**
+ * @brief Feature Unit volume, set by a volume control SET_CUR
+ *
+ * The Feature Unit in usb_descriptors.c declares host-programmable mute and
+ * volume controls on the master channel and on each logical channel, and
+ * tud_audio_set_req_entity_cb() passes them here. Master and channel levels
+ * add up.
+ *
+ * @param channel 0 for the master channel, 1..NUM_CHANNELS for a single channel
+ * @param volume level in 1/256 dB, clamped to the range of usb_audio_get_volume_range()
+ * @return ESP_OK, or ESP_ERR_INVALID_ARG for an unknown channel
+ */
+esp_err_t usb_audio_set_volume(uint8_t channel, int16_t volume);
+
+/**
+ * @brief Volume of a channel in 1/256 dB, for the GET_CUR handler
+ *
+ */
+int16_t usb_audio_get_volume(uint8_t channel);
+
+/**
+ * @brief Volume range, for the GET_RANGE handler
+ *
+ */
+void usb_audio_get_volume_range(int16_t* min, int16_t* max, uint16_t* resolution);
+
+/**
+ * @brief Feature Unit mute, set by a mute control SET_CUR
+ *
+ * @param channel 0 for the master channel, 1..NUM_CHANNELS for a single channel
+ * @return ESP_OK, or ESP_ERR_INVALID_ARG for an unknown channel
+ */
+esp_err_t usb_audio_set_mute(uint8_t channel, bool mute);
+
+/**
+ * @brief Mute state of a channel, for the GET_CUR handler
+ *
+ */
+bool usb_audio_get_mute(uint8_t channel);
@@ -8,57 +8,275 @@
  * @copyright Copyright (c) 2023
  *
  */
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
 
 #include "esp_err.h"
 #include "esp_log.h"
 #include "sdkconfig.h"
 
 #include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
 #include "freertos/task.h"
 
 #include "tinyusb.h"
 #include "tusb_cdc_acm.h"
 
+#include "audio_pipeline/audio_pipeline.h"
+#include "audio_pipeline/level_meter.h"
+#include "audio_pipeline/telemetry.h"
+#include "cdc_frame.h"
+#include "cdc_tap.h"
+#include "usb_audio.h"
 #include "usb_cdc.h"
 
 static const char* TAG = "USB-CDC";
 
-static uint8_t buf[CONFIG_TINYUSB_CDC_RX_BUFSIZE + 1];
+typedef struct {
+    cdc_frame_parser_t parser;
+    uint8_t rx_buf[CONFIG_TINYUSB_CDC_RX_BUFSIZE];
+    uint8_t tx_frame[CDC_FRAME_MAX_SIZE]; // Encoded response, read by whichever task queues it
+    uint8_t response[CDC_FRAME_MAX_PAYLOAD];
+    uint32_t tx_frames;
+    uint32_t tx_dropped; // Frames dropped because the TX FIFO was full
+    uint32_t tx_busy_dropped; // Responses dropped because an earlier one was still deferred. Owned by the TinyUSB task.
+    bool tx_pending; // Responses queued or deferred since the last flush
+    atomic_size_t tx_deferred; // Size of the response in tx_frame waiting for tx_lock, 0 if none
+    SemaphoreHandle_t tx_lock; // Keeps frames from different tasks from interleaving
+} cdc_ctx_t;
 
-static bool wanted_char_flag = false;
-static uint8_t message[2048] = { 0 };
-static size_t msg_idx = 0;
+static cdc_ctx_t ctx = { 0 };
 
-esp_err_t tusb_serial_write(const char* buffer, size_t length)
+static void put_u32(uint8_t* out, uint32_t value)
 {
-    ESP_LOGD(TAG, "Send:    %s", buffer);
-    tinyusb_cdcacm_write_queue(TINYUSB_CDC_ACM_0, (uint8_t*)buffer, length);
+    out[0] = value & 0xFF;
+    out[1] = (value >> 8) & 0xFF;
+    out[2] = (value >> 16) & 0xFF;
+    out[3] = value >> 24;
+}
+
+static bool queue_frame(int itf, const uint8_t* frame, size_t size)
+{
+    if (tud_cdc_n_write_available(itf) < size) {
+        ctx.tx_dropped++;
+        return false;
+    }
+
+    tinyusb_cdcacm_write_queue(itf, frame, size);
+    ctx.tx_frames++;
+    return true;
+}
+
+/**
+ * @brief Queue the response the TinyUSB task left in tx_frame, if any. Call with tx_lock held.
+ *
+ */
+static void queue_deferred(int itf)
+{
+    size_t size = atomic_load_explicit(&ctx.tx_deferred, memory_order_acquire);
+    if (size > 0) {
+        queue_frame(itf, ctx.tx_frame, size);
+        atomic_store_explicit(&ctx.tx_deferred, 0, memory_order_release);
+    }
+}
+
+esp_err_t usb_cdc_write_frame(const uint8_t* frame, size_t size)
+{
+    esp_err_t ret = ESP_ERR_NO_MEM;
+
+    xSemaphoreTake(ctx.tx_lock, portMAX_DELAY);
+    if (queue_frame(TINYUSB_CDC_ACM_0, frame, size)) {
+        ret = ESP_OK;
+    }
+    /* A response deferred while this task held the lock goes out with its frame */
+    queue_deferred(TINYUSB_CDC_ACM_0);
     tinyusb_cdcacm_write_flush(TINYUSB_CDC_ACM_0, 0);
-    return ESP_OK;
+    xSemaphoreGive(ctx.tx_lock);
+    return ret;
+}
+
+/**
+ * @brief Queue the deferred response if tx_lock is free right now
+ *
+ * @return false if another task holds the lock, the response stays deferred
+ */
+static bool try_send_deferred(int itf)
+{
+    if (xSemaphoreTake(ctx.tx_lock, 0) != pdTRUE) {
+        return false;
+    }
+    queue_deferred(itf);
+    xSemaphoreGive(ctx.tx_lock);
+    return true;
+}
+
+/**
+ * @brief Queue a response frame without blocking. A frame that does not fit
+ *        in the TX FIFO is dropped whole, never truncated.
+ *
+ * The TinyUSB task never waits for tx_lock, the audio callbacks run in it.
+ * While the tap task holds the lock the response is deferred: the tap task
+ * queues it before releasing the lock, or the flush after this USB packet
+ * does. A second response while one is still deferred is dropped, and the
+ * host times out and asks again as it does for a full FIFO.
+ */
+static void send_response(int itf, const cdc_frame_t* request, cdc_status_t status, const uint8_t* data, size_t len)
+{
+    ctx.tx_pending = true;
+    if (atomic_load_explicit(&ctx.tx_deferred, memory_order_acquire) > 0 && !try_send_deferred(itf)) {
+        ctx.tx_busy_dropped++;
+        return;
+    }
+
+    if (len > CDC_FRAME_MAX_PAYLOAD - 1) {
+        len = CDC_FRAME_MAX_PAYLOAD - 1;
+        status = CDC_STATUS_INVALID_ARG;
+    }
+
+    ctx.response[0] = status;
+    if (len) {
+        memmove(ctx.response + 1, data, len);
+    }
+
+    size_t size = cdc_frame_encode(request->type | CDC_FRAME_RESPONSE, request->seq,
+        ctx.response, len + 1, ctx.tx_frame, sizeof(ctx.tx_frame));
+
+    atomic_store_explicit(&ctx.tx_deferred, size, memory_order_release);
+    try_send_deferred(itf);
+}
+
+static size_t encode_u32_fields(uint8_t* out, const void* fields, size_t size)
+{
+    for (size_t i = 0; i < size / sizeof(uint32_t); i++) {
+        put_u32(out + 4 * i, ((const uint32_t*)fields)[i]);
+    }
+    return size;
+}
+
+static size_t encode_telemetry(uint8_t* out)
+{
+    static telemetry_snapshot_t snapshot;
+    telemetry_get_snapshot(&snapshot);
+
+    return encode_u32_fields(out, &snapshot, sizeof(snapshot));
+}
+
+static size_t encode_link_stats(uint8_t* out)
+{
+    const uint32_t stats[] = {
+        ctx.parser.frames,
+        ctx.parser.crc_errors,
+        ctx.parser.length_errors,
+        ctx.parser.dropped_bytes,
+        ctx.tx_frames,
+        ctx.tx_dropped + ctx.tx_busy_dropped,
+    };
+    return encode_u32_fields(out, stats, sizeof(stats));
+}
+
+/*
+ * Runs in the TinyUSB task, the same context as the audio callbacks, so the
+ * pipeline consumer-side calls below need no further synchronisation.
+ */
+static void handle_frame(const cdc_frame_t* frame, void* arg)
+{
+    int itf = (int)(intptr_t)arg;
+    static uint8_t data[CDC_FRAME_MAX_PAYLOAD - 1];
+    size_t len = 0;
+    cdc_status_t status = CDC_STATUS_OK;
+
+    switch (frame->type) {
+    case CDC_CMD_PING:
+        send_response(itf, frame, CDC_STATUS_OK, frame->payload, frame->len);
+        return;
+
+    case CDC_CMD_GET_TELEMETRY:
+        _Static_assert(sizeof(telemetry_snapshot_t) <= sizeof(data), "Telemetry does not fit in a response");
+        len = encode_telemetry(data);
+        break;
+
+    case CDC_CMD_SET_LATENCY_PROFILE:
+        if (frame->len != 1 || audio_pipeline_set_latency_profile(frame->payload[0]) != ESP_OK) {
+            status = CDC_STATUS_INVALID_ARG;
+        }
+        break;
+
+    case CDC_CMD_GET_LATENCY:
+        put_u32(data, audio_pipeline_get_latency_ms());
+        len = 4;
+        break;
+
+    case CDC_CMD_SET_GAIN:
+        if (frame->len != 2 || usb_audio_set_volume(0, (int16_t)(frame->payload[0] | (frame->payload[1] << 8))) != ESP_OK) {
+            status = CDC_STATUS_INVALID_ARG;
+        }
+        break;
+
+    case CDC_CMD_STREAM_START:
+        audio_pipeline_start();
+        break;
+
+    case CDC_CMD_STREAM_STOP:
+        audio_pipeline_stop();
+        break;
+
+    case CDC_CMD_GET_LINK_STATS:
+        len = encode_link_stats(data);
+        break;
+
+    case CDC_CMD_GET_LEVELS:
+#if CONFIG_AUDIO_LEVEL_METER
+    {
+        level_meter_reading_t reading;
+        level_meter_get(&reading);
+        len = encode_u32_fields(data, &reading, sizeof(reading));
+        break;
+    }
+#else
+        status = CDC_STATUS_NOT_SUPPORTED;
+        break;
+#endif
+
+    case CDC_CMD_TAP_START:
+    case CDC_CMD_TAP_STOP:
+#if CONFIG_AUDIO_TAP
+        cdc_tap_enable(frame->type == CDC_CMD_TAP_START);
+#else
+        status = CDC_STATUS_NOT_SUPPORTED;
+#endif
+        break;
+
+    default:
+        status = CDC_STATUS_UNKNOWN_CMD;
+        break;
+    }
+
+    send_response(itf, frame, status, data, len);
 }
 
 void tinyusb_cdc_rx_callback(int itf, cdcacm_event_t* event)
 {
-    /* initialization */
     size_t rx_size = 0;
 
-    /* read */
-    esp_err_t ret = tinyusb_cdcacm_read(itf, buf, CONFIG_TINYUSB_CDC_RX_BUFSIZE, &rx_size);
-    if (ret == ESP_OK) {
-        if (wanted_char_flag) {
-            wanted_char_flag = false;
-            ESP_LOGI(TAG, "Message: %s", message);
-            tusb_serial_write((char*)message, msg_idx);
-            msg_idx = 0;
-            memset(message, 0, sizeof(message));
-        } else {
-            memcpy(message + msg_idx, buf, rx_size);
-            msg_idx += rx_size;
-        }
-    } else {
+    esp_err_t ret = tinyusb_cdcacm_read(itf, ctx.rx_buf, sizeof(ctx.rx_buf), &rx_size);
+    if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Read error");
+        return;
+    }
+
+    cdc_frame_parse(&ctx.parser, ctx.rx_buf, rx_size, handle_frame, (void*)(intptr_t)itf);
+
+    /*
+     * One flush per received USB packet, however many responses it produced.
+     * A busy lock is left to its holder, which flushes before releasing it.
+     */
+    if (ctx.tx_pending && xSemaphoreTake(ctx.tx_lock, 0) == pdTRUE) {
+        ctx.tx_pending = false;
+        queue_deferred(itf);
+        tinyusb_cdcacm_write_flush(itf, 0);
+        xSemaphoreGive(ctx.tx_lock);
     }
 }
 
@@ -67,11 +285,9 @@ void tinyusb_cdc_line_state_changed_callback(int itf, cdcacm_event_t* event)
     int dtr = event->line_state_changed_data.dtr;
     int rts = event->line_state_changed_data.rts;
     ESP_LOGI(TAG, "Line state changed on channel %d: DTR:%d, RTS:%d", itf, dtr, rts);
-}
 
-void wanted_char_cb(int itf, cdcacm_event_t* event)
-{
-    wanted_char_flag = true;
+    /* A reopened port must not continue a frame from the previous session */
+    cdc_frame_parser_reset(&ctx.parser);
 }
 
 void usb_cdc_init(void)
@@ -80,12 +296,15 @@ void usb_cdc_init(void)
         .usb_dev = TINYUSB_USBDEV_0,
         .cdc_port = TINYUSB_CDC_ACM_0,
         .callback_rx = &tinyusb_cdc_rx_callback,
-        .callback_rx_wanted_char = &wanted_char_cb,
+        .callback_rx_wanted_char = NULL,
         .callback_line_state_changed = &tinyusb_cdc_line_state_changed_callback,
         .callback_line_coding_changed = NULL
     };
 
-    ESP_ERROR_CHECK(tusb_cdc_acm_init(&acm_cfg));
+    cdc_frame_parser_reset(&ctx.parser);
+    atomic_init(&ctx.tx_deferred, 0);
+    ctx.tx_lock = xSemaphoreCreateMutex();
+    configASSERT(ctx.tx_lock);
 
-    tud_cdc_n_set_wanted_char(TINYUSB_CDC_ACM_0, '\r');
-}
\ No newline at end of file
+    ESP_ERROR_CHECK(tusb_cdc_acm_init(&acm_cfg));
+}
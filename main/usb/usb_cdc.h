@@ -7,7 +7,50 @@
  *
  * @copyright Copyright (c) 2023
  *
+ * The CDC port carries the framed protocol described in cdc_frame.h. Every
+ * request is answered with one response frame whose first payload byte is a
+ * cdc_status_t.
  */
 #pragma once
 
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+typedef enum {
+    CDC_CMD_PING = 0x01, // Echoes the request payload
+    CDC_CMD_GET_TELEMETRY = 0x02, // Returns telemetry_snapshot_t as little-endian uint32 fields
+    CDC_CMD_SET_LATENCY_PROFILE = 0x03, // payload: uint8 audio_latency_profile_t
+    CDC_CMD_GET_LATENCY = 0x04, // Returns uint32 prebuffer target in ms
+    CDC_CMD_SET_GAIN = 0x05, // payload: int16 master volume in 1/256 dB, same as the Feature Unit control
+    CDC_CMD_STREAM_START = 0x06,
+    CDC_CMD_STREAM_STOP = 0x07,
+    CDC_CMD_GET_LINK_STATS = 0x08, // Returns parser and transmit counters as uint32 fields
+    CDC_CMD_TAP_START = 0x09, // Start streaming CDC_STREAM_TAP frames
+    CDC_CMD_TAP_STOP = 0x0A,
+    CDC_CMD_GET_LEVELS = 0x0B, // Returns level_meter_channel_t per channel as uint32 fields
+} cdc_cmd_t;
+
+typedef enum {
+    CDC_STREAM_TAP = 0x40, // Unsolicited, payload is one tap_codec block. seq counts tap frames.
+} cdc_stream_t;
+
+typedef enum {
+    CDC_STATUS_OK = 0,
+    CDC_STATUS_UNKNOWN_CMD = 1,
+    CDC_STATUS_INVALID_ARG = 2,
+    CDC_STATUS_NOT_SUPPORTED = 3,
+    CDC_STATUS_BUSY = 4,
+} cdc_status_t;
+
 void usb_cdc_init(void);
+
+/**
+ * @brief Queue an encoded frame and start transmitting it, without blocking
+ *
+ * Safe to call from any task. The frame is either queued whole or not at all.
+ *
+ * @return ESP_OK, or ESP_ERR_NO_MEM if the TX FIFO has no room for the frame
+ */
+esp_err_t usb_cdc_write_frame(const uint8_t* frame, size_t size);
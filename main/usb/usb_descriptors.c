@@ -0,0 +1,379 @@
+/**
+ * @file usb_descriptors.c
+ * @author your name (you@domain.com)
+ * @brief Device, string and configuration descriptors of the UAC2 + CDC-ACM device
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * The configuration descriptor is written out once at boot, as the number
+ * of channels and packet sizes come from Kconfig.
+ */
+#include "usb_descriptors.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "esp_log.h"
+
+#define USB_VID 0x303A // Espressif, with the esp_tinyusb default PID
+#define USB_PID 0x4002
+#define USB_MAX_POWER_MA 100
+
+#define UAC2_FUNCTION_SUBCLASS_UNDEFINED 0x00
+#define UAC2_FUNCTION_PROTOCOL_V2 0x20
+#define UAC2_SUBCLASS_AUDIOCONTROL 0x01
+#define UAC2_SUBCLASS_AUDIOSTREAMING 0x02
+#define UAC2_AC_HEADER 0x01
+#define UAC2_AC_INPUT_TERMINAL 0x02
+#define UAC2_AC_OUTPUT_TERMINAL 0x03
+#define UAC2_AC_FEATURE_UNIT 0x06
+#define UAC2_AC_CLOCK_SOURCE 0x0A
+#define UAC2_AS_GENERAL 0x01
+#define UAC2_AS_FORMAT_TYPE 0x02
+#define UAC2_EP_GENERAL 0x01
+#define UAC2_CATEGORY_CONVERTER 0x06
+#define UAC2_FORMAT_TYPE_I 0x01
+#define UAC2_FORMAT_PCM 0x00000001
+#define UAC2_TERMINAL_USB_STREAMING 0x0101
+#define UAC2_TERMINAL_LINE_CONNECTOR 0x0603
+#define UAC2_CLOCK_INTERNAL_PROGRAMMABLE 0x03
+#define UAC2_CLOCK_CONTROLS 0x07 // Sampling frequency read/write, validity read-only
+#define UAC2_FU_CONTROLS 0x0000000F // Mute and volume read/write
+#define UAC2_CHANNEL_CONFIG (NUM_CHANNELS == 2 ? 0x00000003 : 0) // Front left/right, otherwise unassigned
+
+#define USB_EP_ISO_ASYNC 0x05
+#define USB_EP_ISO_ADAPTIVE 0x09
+#define USB_EP_BULK 0x02
+#define USB_EP_INTERRUPT 0x03
+#define USB_CONFIG_BUS_POWERED 0x80
+
+#define CDC_SUBCLASS_ACM 0x02
+#define CDC_FUNC_HEADER 0x00
+#define CDC_FUNC_CALL_MANAGEMENT 0x01
+#define CDC_FUNC_ACM 0x02
+#define CDC_FUNC_UNION 0x06
+#define CDC_ACM_LINE_CODING_AND_STATE 0x02
+#define CDC_NOTIF_EP_SIZE 8
+#define CDC_DATA_EP_SIZE 64
+
+enum {
+    STRID_LANGID = 0,
+    STRID_MANUFACTURER,
+    STRID_PRODUCT,
+    STRID_SERIAL,
+    STRID_AUDIO,
+    STRID_CDC,
+    STRID_COUNT,
+};
+
+static const char* TAG = "USB-DESC";
+
+/* Subslot size and resolution of each streaming alternate setting, as in usb_audio.c */
+static const struct {
+    uint8_t subslot_bytes;
+    uint8_t bits;
+} alt_formats[USB_AUDIO_ALT_COUNT] = {
+    { 0, 0 },
+    { 2, 16 },
+    { 3, 24 },
+    { 4, 24 },
+    { 4, 32 },
+};
+
+static const tusb_desc_device_t device_descriptor = {
+    .bLength = sizeof(tusb_desc_device_t),
+    .bDescriptorType = TUSB_DESC_DEVICE,
+    .bcdUSB = 0x0200,
+    .bDeviceClass = TUSB_CLASS_MISC, // Interface association descriptors
+    .bDeviceSubClass = 0x02,
+    .bDeviceProtocol = 0x01,
+    .bMaxPacketSize0 = 64,
+    .idVendor = USB_VID,
+    .idProduct = USB_PID,
+    .bcdDevice = 0x0100,
+    .iManufacturer = STRID_MANUFACTURER,
+    .iProduct = STRID_PRODUCT,
+    .iSerialNumber = STRID_SERIAL,
+    .bNumConfigurations = 1,
+};
+
+static const char* string_descriptors[STRID_COUNT] = {
+    [STRID_LANGID] = (const char[]) { 0x09, 0x04 }, // English (United States)
+    [STRID_MANUFACTURER] = "Bang & Olufsen",
+    [STRID_PRODUCT] = "Classics Adapter",
+    [STRID_SERIAL] = "000001",
+    [STRID_AUDIO] = "Classics Adapter Audio",
+    [STRID_CDC] = "Classics Adapter Control",
+};
+
+typedef struct {
+    uint8_t data[USB_CONFIG_DESC_LEN];
+    size_t len;
+    bool overflow;
+} desc_writer_t;
+
+static desc_writer_t config = { 0 };
+
+static void put8(uint8_t value)
+{
+    if (config.len < sizeof(config.data)) {
+        config.data[config.len++] = value;
+    } else {
+        config.overflow = true;
+    }
+}
+
+static void put16(uint16_t value)
+{
+    put8(value & 0xFF);
+    put8(value >> 8);
+}
+
+static void put32(uint32_t value)
+{
+    put16(value & 0xFFFF);
+    put16(value >> 16);
+}
+
+static void put_interface(uint8_t number, uint8_t alt, uint8_t num_endpoints, uint8_t class, uint8_t subclass,
+    uint8_t protocol, uint8_t string)
+{
+    put8(USB_DESC_INTERFACE_LEN);
+    put8(TUSB_DESC_INTERFACE);
+    put8(number);
+    put8(alt);
+    put8(num_endpoints);
+    put8(class);
+    put8(subclass);
+    put8(protocol);
+    put8(string);
+}
+
+static void put_endpoint(uint8_t address, uint8_t attributes, uint16_t max_packet, uint8_t interval)
+{
+    put8(USB_DESC_ENDPOINT_LEN);
+    put8(TUSB_DESC_ENDPOINT);
+    put8(address);
+    put8(attributes);
+    put16(max_packet);
+    put8(interval);
+}
+
+static void put_iad(uint8_t first, uint8_t count, uint8_t class, uint8_t subclass, uint8_t protocol, uint8_t string)
+{
+    put8(USB_DESC_IAD_LEN);
+    put8(TUSB_DESC_INTERFACE_ASSOCIATION);
+    put8(first);
+    put8(count);
+    put8(class);
+    put8(subclass);
+    put8(protocol);
+    put8(string);
+}
+
+static void put_input_terminal(uint8_t id, uint16_t type)
+{
+    put8(UAC2_DESC_INPUT_TERMINAL_LEN);
+    put8(TUSB_DESC_CS_INTERFACE);
+    put8(UAC2_AC_INPUT_TERMINAL);
+    put8(id);
+    put16(type);
+    put8(0); // bAssocTerminal
+    put8(UAC2_ENTITY_CLOCK);
+    put8(NUM_CHANNELS);
+    put32(UAC2_CHANNEL_CONFIG);
+    put8(0); // iChannelNames
+    put16(0); // bmControls
+    put8(0); // iTerminal
+}
+
+static void put_output_terminal(uint8_t id, uint16_t type, uint8_t source)
+{
+    put8(UAC2_DESC_OUTPUT_TERMINAL_LEN);
+    put8(TUSB_DESC_CS_INTERFACE);
+    put8(UAC2_AC_OUTPUT_TERMINAL);
+    put8(id);
+    put16(type);
+    put8(0); // bAssocTerminal
+    put8(source);
+    put8(UAC2_ENTITY_CLOCK);
+    put16(0); // bmControls
+    put8(0); // iTerminal
+}
+
+/**
+ * @brief Clock source and the units and terminals of the capture path, then of the playback path
+ *
+ */
+static void put_audio_control(void)
+{
+    put8(UAC2_DESC_CLOCK_SOURCE_LEN);
+    put8(TUSB_DESC_CS_INTERFACE);
+    put8(UAC2_AC_CLOCK_SOURCE);
+    put8(UAC2_ENTITY_CLOCK);
+    put8(UAC2_CLOCK_INTERNAL_PROGRAMMABLE);
+    put8(UAC2_CLOCK_CONTROLS);
+    put8(0); // bAssocTerminal
+    put8(0); // iClockSource
+
+    put_input_terminal(UAC2_ENTITY_INPUT_TERMINAL, UAC2_TERMINAL_LINE_CONNECTOR);
+
+    put8(UAC2_DESC_FEATURE_UNIT_LEN);
+    put8(TUSB_DESC_CS_INTERFACE);
+    put8(UAC2_AC_FEATURE_UNIT);
+    put8(UAC2_ENTITY_FEATURE_UNIT);
+    put8(UAC2_ENTITY_INPUT_TERMINAL);
+    for (int ch = 0; ch <= NUM_CHANNELS; ch++) {
+        put32(UAC2_FU_CONTROLS); // Master channel first
+    }
+    put8(0); // iFeature
+
+    put_output_terminal(UAC2_ENTITY_OUTPUT_TERMINAL, UAC2_TERMINAL_USB_STREAMING, UAC2_ENTITY_FEATURE_UNIT);
+
+#if CONFIG_AUDIO_PLAYBACK
+    put_input_terminal(UAC2_ENTITY_PLAYBACK_INPUT_TERMINAL, UAC2_TERMINAL_USB_STREAMING);
+    put_output_terminal(UAC2_ENTITY_PLAYBACK_OUTPUT_TERMINAL, UAC2_TERMINAL_LINE_CONNECTOR, UAC2_ENTITY_PLAYBACK_INPUT_TERMINAL);
+#endif
+}
+
+/**
+ * @brief Streaming interface with a zero-bandwidth alt 0 and one alt per sample format
+ *
+ */
+static void put_audio_streaming(uint8_t interface, uint8_t terminal, uint8_t endpoint, uint8_t attributes)
+{
+    put_interface(interface, 0, 0, TUSB_CLASS_AUDIO, UAC2_SUBCLASS_AUDIOSTREAMING, UAC2_FUNCTION_PROTOCOL_V2, 0);
+
+    for (uint8_t alt = 1; alt < USB_AUDIO_ALT_COUNT; alt++) {
+        put_interface(interface, alt, 1, TUSB_CLASS_AUDIO, UAC2_SUBCLASS_AUDIOSTREAMING, UAC2_FUNCTION_PROTOCOL_V2, 0);
+
+        put8(UAC2_DESC_AS_GENERAL_LEN);
+        put8(TUSB_DESC_CS_INTERFACE);
+        put8(UAC2_AS_GENERAL);
+        put8(terminal);
+        put8(0); // bmControls
+        put8(UAC2_FORMAT_TYPE_I);
+        put32(UAC2_FORMAT_PCM);
+        put8(NUM_CHANNELS);
+        put32(UAC2_CHANNEL_CONFIG);
+        put8(0); // iChannelNames
+
+        put8(UAC2_DESC_FORMAT_TYPE_I_LEN);
+        put8(TUSB_DESC_CS_INTERFACE);
+        put8(UAC2_AS_FORMAT_TYPE);
+        put8(UAC2_FORMAT_TYPE_I);
+        put8(alt_formats[alt].subslot_bytes);
+        put8(alt_formats[alt].bits);
+
+        /* The largest packet at MAX_SAMPLE_RATE, incl. the frame an async adjustment adds */
+        put_endpoint(endpoint, attributes, (MAX_SAMPLE_RATE / 1000 + 1) * NUM_CHANNELS * alt_formats[alt].subslot_bytes, 1);
+
+        put8(UAC2_DESC_AS_ENDPOINT_LEN);
+        put8(TUSB_DESC_CS_ENDPOINT);
+        put8(UAC2_EP_GENERAL);
+        put8(0); // bmAttributes
+        put8(0); // bmControls
+        put8(0); // bLockDelayUnits
+        put16(0); // wLockDelay
+    }
+}
+
+static void put_audio_function(void)
+{
+    put_iad(ITF_NUM_AUDIO_CONTROL, ITF_NUM_CDC - ITF_NUM_AUDIO_CONTROL, TUSB_CLASS_AUDIO, UAC2_FUNCTION_SUBCLASS_UNDEFINED,
+        UAC2_FUNCTION_PROTOCOL_V2, STRID_AUDIO);
+    put_interface(ITF_NUM_AUDIO_CONTROL, 0, 0, TUSB_CLASS_AUDIO, UAC2_SUBCLASS_AUDIOCONTROL, UAC2_FUNCTION_PROTOCOL_V2, STRID_AUDIO);
+
+    put8(UAC2_DESC_AC_HEADER_LEN);
+    put8(TUSB_DESC_CS_INTERFACE);
+    put8(UAC2_AC_HEADER);
+    put16(0x0200); // bcdADC
+    put8(UAC2_CATEGORY_CONVERTER);
+    put16(UAC2_DESC_AC_HEADER_LEN + UAC2_AC_UNITS_LEN);
+    put8(0); // bmControls
+
+    put_audio_control();
+    put_audio_streaming(ITF_NUM_AUDIO_STREAMING_IN, UAC2_ENTITY_OUTPUT_TERMINAL, EP_AUDIO_IN, USB_EP_ISO_ASYNC);
+#if CONFIG_AUDIO_PLAYBACK
+    /*
+     * Adaptive, without a feedback endpoint: the DAC runs on the capture
+     * clock, which follows the host when steered, and otherwise the
+     * playback ring absorbs the drift.
+     */
+    put_audio_streaming(ITF_NUM_AUDIO_STREAMING_OUT, UAC2_ENTITY_PLAYBACK_INPUT_TERMINAL, EP_AUDIO_OUT, USB_EP_ISO_ADAPTIVE);
+#endif
+}
+
+static void put_cdc_function(void)
+{
+    put_iad(ITF_NUM_CDC, 2, TUSB_CLASS_CDC, CDC_SUBCLASS_ACM, 0, STRID_CDC);
+    put_interface(ITF_NUM_CDC, 0, 1, TUSB_CLASS_CDC, CDC_SUBCLASS_ACM, 0, STRID_CDC);
+
+    put8(5);
+    put8(TUSB_DESC_CS_INTERFACE);
+    put8(CDC_FUNC_HEADER);
+    put16(0x0120); // bcdCDC
+
+    put8(5);
+    put8(TUSB_DESC_CS_INTERFACE);
+    put8(CDC_FUNC_CALL_MANAGEMENT);
+    put8(0); // bmCapabilities
+    put8(ITF_NUM_CDC_DATA);
+
+    put8(4);
+    put8(TUSB_DESC_CS_INTERFACE);
+    put8(CDC_FUNC_ACM);
+    put8(CDC_ACM_LINE_CODING_AND_STATE);
+
+    put8(5);
+    put8(TUSB_DESC_CS_INTERFACE);
+    put8(CDC_FUNC_UNION);
+    put8(ITF_NUM_CDC);
+    put8(ITF_NUM_CDC_DATA);
+
+    put_endpoint(EP_CDC_NOTIF, USB_EP_INTERRUPT, CDC_NOTIF_EP_SIZE, 16);
+
+    put_interface(ITF_NUM_CDC_DATA, 0, 2, TUSB_CLASS_CDC_DATA, 0, 0, 0);
+    put_endpoint(EP_CDC_OUT, USB_EP_BULK, CDC_DATA_EP_SIZE, 0);
+    put_endpoint(EP_CDC_IN, USB_EP_BULK, CDC_DATA_EP_SIZE, 0);
+}
+
+void usb_descriptors_init(void)
+{
+    config.len = 0;
+    config.overflow = false;
+
+    put8(9);
+    put8(TUSB_DESC_CONFIGURATION);
+    put16(USB_CONFIG_DESC_LEN);
+    put8(ITF_NUM_TOTAL);
+    put8(1); // bConfigurationValue
+    put8(0); // iConfiguration
+    put8(USB_CONFIG_BUS_POWERED);
+    put8(USB_MAX_POWER_MA / 2);
+
+    put_audio_function();
+    put_cdc_function();
+
+    if (config.overflow || config.len != USB_CONFIG_DESC_LEN) {
+        ESP_LOGE(TAG, "Configuration descriptor is %zu bytes, expected %d", config.len, USB_CONFIG_DESC_LEN);
+    }
+}
+
+const tusb_desc_device_t* usb_descriptors_device(void)
+{
+    return &device_descriptor;
+}
+
+const uint8_t* usb_descriptors_configuration(void)
+{
+    return config.data;
+}
+
+const char** usb_descriptors_strings(int* count)
+{
+    *count = STRID_COUNT;
+    return string_descriptors;
+}
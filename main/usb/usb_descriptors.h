@@ -0,0 +1,131 @@
+/**
+ * @file usb_descriptors.h
+ * @author your name (you@domain.com)
+ * @brief Device, string and configuration descriptors of the UAC2 + CDC-ACM device
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * One UAC2 function for capture (clock source -> input terminal -> feature
+ * unit -> USB streaming output terminal) and one CDC-ACM function. With
+ * CONFIG_AUDIO_PLAYBACK the audio function also has a playback path (USB
+ * streaming input terminal -> output terminal) on the same clock. Each
+ * audio streaming interface has one alternate setting per sample format,
+ * numbered as in usb_audio_set_alt_setting(), each sized for the largest
+ * packet at MAX_SAMPLE_RATE.
+ *
+ * The audio class of esp_tinyusb parses this descriptor with the sizes of
+ * its tusb_config.h: CFG_TUD_AUDIO_FUNC_1_DESC_LEN must equal
+ * USB_AUDIO_FUNC_DESC_LEN, CFG_TUD_AUDIO_FUNC_1_N_AS_INT must equal
+ * USB_AUDIO_NUM_AS_INTERFACES and the endpoint sizes must be at least
+ * USB_AUDIO_EP_IN_SIZE_MAX and USB_AUDIO_EP_OUT_SIZE_MAX.
+ */
+#pragma once
+
+#include <stdint.h>
+
+#include "config/audio_config.h"
+#include "tusb.h"
+
+enum {
+    ITF_NUM_AUDIO_CONTROL = 0,
+    ITF_NUM_AUDIO_STREAMING_IN,
+#if CONFIG_AUDIO_PLAYBACK
+    ITF_NUM_AUDIO_STREAMING_OUT,
+#endif
+    ITF_NUM_CDC,
+    ITF_NUM_CDC_DATA,
+    ITF_NUM_TOTAL,
+};
+
+#define EP_AUDIO_IN 0x81
+#define EP_AUDIO_OUT 0x01
+#define EP_CDC_NOTIF 0x82
+#define EP_CDC_OUT 0x03
+#define EP_CDC_IN 0x83
+
+/* Entity IDs of the audio function, the high byte of wIndex in its class requests */
+#define UAC2_ENTITY_CLOCK 0x04
+#define UAC2_ENTITY_INPUT_TERMINAL 0x01
+#define UAC2_ENTITY_FEATURE_UNIT 0x02
+#define UAC2_ENTITY_OUTPUT_TERMINAL 0x03
+#define UAC2_ENTITY_PLAYBACK_INPUT_TERMINAL 0x05
+#define UAC2_ENTITY_PLAYBACK_OUTPUT_TERMINAL 0x06
+
+/* UAC2 class request codes and control selectors */
+#define UAC2_REQ_CUR 0x01
+#define UAC2_REQ_RANGE 0x02
+#define UAC2_CS_SAM_FREQ_CONTROL 0x01
+#define UAC2_CS_CLOCK_VALID_CONTROL 0x02
+#define UAC2_FU_MUTE_CONTROL 0x01
+#define UAC2_FU_VOLUME_CONTROL 0x02
+
+#define USB_AUDIO_ALT_COUNT 5 // Zero-bandwidth alt 0 and one per sample format
+
+/* Descriptor lengths, for the esp_tinyusb configuration */
+#define USB_DESC_IAD_LEN 8
+#define USB_DESC_INTERFACE_LEN 9
+#define USB_DESC_ENDPOINT_LEN 7
+#define UAC2_DESC_AC_HEADER_LEN 9
+#define UAC2_DESC_CLOCK_SOURCE_LEN 8
+#define UAC2_DESC_INPUT_TERMINAL_LEN 17
+#define UAC2_DESC_FEATURE_UNIT_LEN (6 + (NUM_CHANNELS + 1) * 4)
+#define UAC2_DESC_OUTPUT_TERMINAL_LEN 12
+#define UAC2_DESC_AS_GENERAL_LEN 16
+#define UAC2_DESC_FORMAT_TYPE_I_LEN 6
+#define UAC2_DESC_AS_ENDPOINT_LEN 8
+
+#if CONFIG_AUDIO_PLAYBACK
+#define USB_AUDIO_NUM_AS_INTERFACES 2
+#define UAC2_PLAYBACK_UNITS_LEN (UAC2_DESC_INPUT_TERMINAL_LEN + UAC2_DESC_OUTPUT_TERMINAL_LEN)
+#else
+#define USB_AUDIO_NUM_AS_INTERFACES 1
+#define UAC2_PLAYBACK_UNITS_LEN 0
+#endif
+
+#define UAC2_AC_UNITS_LEN (UAC2_DESC_CLOCK_SOURCE_LEN + UAC2_DESC_INPUT_TERMINAL_LEN + UAC2_DESC_FEATURE_UNIT_LEN \
+    + UAC2_DESC_OUTPUT_TERMINAL_LEN + UAC2_PLAYBACK_UNITS_LEN)
+#define UAC2_AS_ALT_LEN (USB_DESC_INTERFACE_LEN + UAC2_DESC_AS_GENERAL_LEN + UAC2_DESC_FORMAT_TYPE_I_LEN \
+    + USB_DESC_ENDPOINT_LEN + UAC2_DESC_AS_ENDPOINT_LEN)
+#define UAC2_AS_INTERFACE_LEN (USB_DESC_INTERFACE_LEN + (USB_AUDIO_ALT_COUNT - 1) * UAC2_AS_ALT_LEN)
+
+/* Everything after the IAD of the audio function */
+#define USB_AUDIO_FUNC_DESC_LEN (USB_DESC_INTERFACE_LEN + UAC2_DESC_AC_HEADER_LEN + UAC2_AC_UNITS_LEN \
+    + USB_AUDIO_NUM_AS_INTERFACES * UAC2_AS_INTERFACE_LEN)
+#define USB_CDC_DESC_LEN (USB_DESC_IAD_LEN + USB_DESC_INTERFACE_LEN + 5 + 5 + 4 + 5 + USB_DESC_ENDPOINT_LEN \
+    + USB_DESC_INTERFACE_LEN + 2 * USB_DESC_ENDPOINT_LEN)
+#define USB_CONFIG_DESC_LEN (9 + USB_DESC_IAD_LEN + USB_AUDIO_FUNC_DESC_LEN + USB_CDC_DESC_LEN)
+
+/* Largest isochronous packet of the widest format, incl. one async adjustment frame */
+#define USB_AUDIO_EP_IN_SIZE_MAX MAX_AUDIO_BYTES_PER_MS
+#define USB_AUDIO_EP_OUT_SIZE_MAX MAX_AUDIO_BYTES_PER_MS
+#define USB_FS_ISO_MAX_PACKET 1023
+
+_Static_assert(USB_AUDIO_EP_IN_SIZE_MAX <= USB_FS_ISO_MAX_PACKET, "Audio packets exceed the full-speed isochronous maximum");
+
+/**
+ * @brief Build the configuration descriptor for the Kconfig in use
+ *
+ * To be called once before tinyusb_driver_install(), which keeps pointers
+ * to the descriptors.
+ */
+void usb_descriptors_init(void);
+
+/**
+ * @brief Device descriptor
+ *
+ */
+const tusb_desc_device_t* usb_descriptors_device(void);
+
+/**
+ * @brief Configuration descriptor, USB_CONFIG_DESC_LEN bytes
+ *
+ */
+const uint8_t* usb_descriptors_configuration(void);
+
+/**
+ * @brief String descriptors in the order of their indices, the first being the language ID
+ *
+ */
+const char** usb_descriptors_strings(int* count);